@@ -0,0 +1,116 @@
+#pragma once
+
+#include <esp_adc/adc_oneshot.h>
+#include <esp_adc/adc_cali.h>
+#include <esp_adc/adc_cali_scheme.h>
+#include <esp_log.h>
+
+#include "check.hpp"
+
+namespace lumina
+{
+
+/**
+ * Calibrated oneshot reading of one ADC1 pin.
+ *
+ * ADC2 is shared with the Wi-Fi radio on the ESP32-S3, so only ADC1 pins
+ * (GPIO 1-10) are accepted. Each instance owns its ADC unit.
+ */
+class adc
+{
+public:
+
+    adc(int pin, adc_atten_t attenuation = ADC_ATTEN_DB_12)
+    :   _unit(nullptr),
+        _calibration(nullptr)
+    {
+        adc_unit_t unit;
+        ESP_CHECK(adc_oneshot_io_to_channel(pin, &unit, &_channel));
+        if (unit != ADC_UNIT_1)
+        {
+            ESP_LOGE("ADC", "GPIO %d is not an ADC1 pin", pin);
+            return;
+        }
+
+        adc_oneshot_unit_init_cfg_t unit_config = {};
+        unit_config.unit_id = unit;
+        unit_config.ulp_mode = ADC_ULP_MODE_DISABLE;
+        ESP_CHECK(adc_oneshot_new_unit(&unit_config, &_unit));
+
+        adc_oneshot_chan_cfg_t channel_config = {};
+        channel_config.atten = attenuation;
+        channel_config.bitwidth = ADC_BITWIDTH_DEFAULT;
+        ESP_CHECK(adc_oneshot_config_channel(_unit, _channel, &channel_config));
+
+        adc_cali_curve_fitting_config_t calibration_config = {};
+        calibration_config.unit_id = unit;
+        calibration_config.chan = _channel;
+        calibration_config.atten = attenuation;
+        calibration_config.bitwidth = ADC_BITWIDTH_DEFAULT;
+        ESP_CHECK(adc_cali_create_scheme_curve_fitting(&calibration_config, &_calibration));
+    }
+
+    adc(const adc&) = delete;
+    adc& operator= (const adc&) = delete;
+
+    ~adc()
+    {
+        if (_calibration)
+            ESP_CHECK(adc_cali_delete_scheme_curve_fitting(_calibration));
+        if (_unit)
+            ESP_CHECK(adc_oneshot_del_unit(_unit));
+    }
+
+    /**
+     * Reads the pin voltage in millivolts, or -1 if the read failed.
+     */
+    int read_mv()
+    {
+        int raw = 0, mv = -1;
+        if (!_unit || adc_oneshot_read(_unit, _channel, &raw) != ESP_OK)
+            return -1;
+        if (!_calibration || adc_cali_raw_to_voltage(_calibration, raw, &mv) != ESP_OK)
+            return -1;
+        return mv;
+    }
+
+protected:
+
+    adc_oneshot_unit_handle_t _unit;
+    adc_channel_t _channel;
+    adc_cali_handle_t _calibration;
+};
+
+
+/**
+ * Battery voltage behind a resistor divider.
+ */
+class battery
+{
+public:
+
+    /**
+     * @param pin ADC1 pin connected to the divider tap.
+     * @param divider Ratio of pack voltage to tap voltage, e.g. (R1 + R2) / R2.
+     */
+    battery(int pin, float divider)
+    :   _adc(pin),
+        _divider(divider)
+    {}
+
+    /**
+     * Pack voltage in volts, or 0 if the read failed.
+     */
+    float voltage()
+    {
+        int mv = _adc.read_mv();
+        return mv < 0 ? 0 : mv * _divider / 1000.f;
+    }
+
+protected:
+
+    adc _adc;
+    float _divider;
+};
+
+}
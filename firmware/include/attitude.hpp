@@ -0,0 +1,258 @@
+#pragma once
+
+#include "math.hpp"
+#include "vec.hpp"
+#include "quat.hpp"
+#include "rotation.hpp"
+#include "placement.hpp"
+
+namespace lumina
+{
+
+namespace detail
+{
+
+/**
+ * Attitude with zero yaw that puts the measured specific force along -z.
+ * Body axes are NED, so a level, resting accelerometer reads {0, 0, -g}.
+ */
+constexpr quat level(const vec3& accel)
+{
+    float roll = math::atan2(-accel[1], -accel[2]);
+    float pitch = math::atan2(accel[0], math::sqrt(accel[1] * accel[1] + accel[2] * accel[2]));
+    return euler_to_quaternion(vec3{roll, pitch, 0});
+}
+
+/**
+ * Unit gravity direction in the body frame if `accel` is usable for
+ * correction, or a zero vector while the vehicle accelerates hard.
+ */
+constexpr vec3 down(const vec3& accel, float rejection)
+{
+    constexpr float g = 9.80665f;
+
+    float norm = accel.length();
+    if (norm < (1 - rejection) * g || norm > (1 + rejection) * g)
+        return vec3{};
+    return accel * (-1 / norm);
+}
+
+/**
+ * Integrates a body rate over `dt` and renormalizes.
+ */
+constexpr quat integrate(const quat& q, const vec3& rate, float dt)
+{
+    quat dq = q * quat{0, rate[0], rate[1], rate[2]} * (dt / 2);
+    return (q + dq).normalized();
+}
+
+}
+
+
+/**
+ * Mahony complementary filter with gyro bias estimation.
+ *
+ * The cross product of measured and estimated gravity is the tilt error; it
+ * is fed back into the gyro rate through a proportional term and an integral
+ * term, and the integral converges to the negated gyro bias. Yaw is not
+ * observable from gravity and drifts with the residual yaw bias.
+ *
+ * An update is one quaternion product, two cross products and two square
+ * roots; nothing loops or branches on the data except accel rejection.
+ */
+class mahony
+{
+public:
+
+    /**
+     * @param kp Proportional gain in rad/s per unit of tilt error.
+     * @param ki Integral gain, the bias estimation bandwidth.
+     * @param rejection Relative deviation of |accel| from 1 g beyond which accel is ignored.
+     */
+    constexpr mahony(float kp = 1.f, float ki = 0.05f, float rejection = 0.2f)
+    :   _q(quat::identity()),
+        _integral{},
+        _kp(kp),
+        _ki(ki),
+        _rejection(rejection),
+        _initialized(false)
+    {}
+
+    /**
+     * @param gyro Body rate in rad/s.
+     * @param accel Specific force in m/s^2.
+     * @param dt Time since the previous sample in seconds.
+     */
+    constexpr void LUMINA_HOT update(const vec3& gyro, const vec3& accel, float dt)
+    {
+        if (!_initialized)
+        {
+            reset(accel);
+            return;
+        }
+
+        vec3 rate = gyro;
+
+        vec3 down = detail::down(accel, _rejection);
+        if (down[0] != 0 || down[1] != 0 || down[2] != 0)
+        {
+            vec3 estimate = _q.conjugate().rotate(vec3{0, 0, 1});
+            vec3 error = down.cross(estimate);
+
+            _integral += error * (_ki * dt);
+            rate += error * _kp + _integral;
+        }
+
+        _q = detail::integrate(_q, rate, dt);
+    }
+
+    /**
+     * Snaps roll and pitch to the given accel sample and clears the bias.
+     */
+    constexpr void reset(const vec3& accel)
+    {
+        _q = detail::level(accel);
+        _integral = vec3{};
+        _initialized = true;
+    }
+
+    /**
+     * Body to NED rotation.
+     */
+    constexpr const quat& attitude() const
+    {
+        return _q;
+    }
+
+    /**
+     * Estimated gyro bias in rad/s.
+     */
+    constexpr vec3 bias() const
+    {
+        return -_integral;
+    }
+
+protected:
+
+    quat _q;
+    vec3 _integral;
+
+    float _kp;
+    float _ki;
+    float _rejection;
+    bool _initialized;
+};
+
+
+/**
+ * Madgwick gradient-descent filter.
+ *
+ * Each update takes one normalized gradient step of the gravity alignment
+ * error, scaled by `beta`, against the gyro-propagated attitude. It has a
+ * single gain and no bias state, which makes it a cheaper alternative when
+ * the gyro is well calibrated.
+ */
+class madgwick
+{
+public:
+
+    /**
+     * @param beta Gradient step in rad/s, roughly the gyro error it can absorb.
+     * @param rejection Relative deviation of |accel| from 1 g beyond which accel is ignored.
+     */
+    constexpr madgwick(float beta = 0.05f, float rejection = 0.2f)
+    :   _q(quat::identity()),
+        _beta(beta),
+        _rejection(rejection),
+        _initialized(false)
+    {}
+
+    constexpr void LUMINA_HOT update(const vec3& gyro, const vec3& accel, float dt)
+    {
+        if (!_initialized)
+        {
+            reset(accel);
+            return;
+        }
+
+        quat dq = _q * quat{0, gyro[0], gyro[1], gyro[2]} * 0.5f;
+
+        vec3 a = detail::down(accel, _rejection);
+        if (a[0] != 0 || a[1] != 0 || a[2] != 0)
+        {
+            float w = _q.w(), x = _q.x(), y = _q.y(), z = _q.z();
+
+            // Estimated minus measured gravity and its Jacobian-transposed product.
+            float f0 = 2 * (x * z - w * y) - a[0];
+            float f1 = 2 * (w * x + y * z) - a[1];
+            float f2 = 1 - 2 * (x * x + y * y) - a[2];
+
+            quat step = {
+                -2 * y * f0 + 2 * x * f1,
+                 2 * z * f0 + 2 * w * f1 - 4 * x * f2,
+                -2 * w * f0 + 2 * z * f1 - 4 * y * f2,
+                 2 * x * f0 + 2 * y * f1
+            };
+
+            float norm = step.norm();
+            if (norm > 0)
+                dq += step * (-_beta / norm);
+        }
+
+        _q = (_q + dq * dt).normalized();
+    }
+
+    constexpr void reset(const vec3& accel)
+    {
+        _q = detail::level(accel);
+        _initialized = true;
+    }
+
+    constexpr const quat& attitude() const
+    {
+        return _q;
+    }
+
+    constexpr vec3 bias() const
+    {
+        return vec3{};
+    }
+
+protected:
+
+    quat _q;
+
+    float _beta;
+    float _rejection;
+    bool _initialized;
+};
+
+static_assert([] {
+    // Level, rotated 90 degrees in roll: right side down.
+    quat q = detail::level(vec3{0, -9.80665f, 0});
+    vec3 e = quaternion_to_euler(q);
+    return math::abs(e[0] - math::pi<float> / 2) < 1e-3f && math::abs(e[1]) < 1e-3f;
+}());
+
+static_assert([] {
+    // A constant gyro bias on a resting vehicle is learned and tilt stays put.
+    mahony m(2.f, 0.5f);
+    vec3 bias{0.02f, -0.01f, 0};
+    for (int i = 0; i < 1000; i++)
+        m.update(bias, vec3{0, 0, -9.80665f}, 0.01f);
+    vec3 e = quaternion_to_euler(m.attitude());
+    return math::abs(e[0]) < 2e-3f && math::abs(e[1]) < 2e-3f
+        && math::abs(m.bias()[0] - bias[0]) < 2e-3f && math::abs(m.bias()[1] - bias[1]) < 2e-3f;
+}());
+
+static_assert([] {
+    // Starting 30 degrees off in pitch, accel pulls the estimate back to level.
+    madgwick m(0.5f);
+    m.reset(vec3{0, 0, -9.80665f});
+    m.update(vec3{0, math::radians(30.f) * 10, 0}, vec3{0, 0, -9.80665f}, 0.1f);
+    for (int i = 0; i < 200; i++)
+        m.update(vec3{}, vec3{0, 0, -9.80665f}, 0.01f);
+    return math::abs(quaternion_to_euler(m.attitude())[1]) < 1e-2f;
+}());
+
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <esp_err.h>
+#include <esp_log.h>
+
+#define ESP_CHECK_TAG(tag, x) if(auto err = x; err != ESP_OK) { ESP_LOGE(tag, "Error on " #x": %s", esp_err_to_name(err)); }
+
+#ifndef ESP_CHECK
+#define ESP_CHECK(x) ESP_CHECK_TAG("LUMINA", x)
+#endif
@@ -0,0 +1,370 @@
+#pragma once
+
+#include <array>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../placement.hpp"
+
+namespace lumina::crsf
+{
+
+/**
+ * CRSF (Crossfire / ExpressLRS) serial protocol between receiver and flight
+ * controller: [address] [length] [type] [payload...] [crc8], where `length`
+ * counts type, payload and CRC, and the CRC covers type and payload.
+ */
+
+constexpr uint32_t BAUD_RATE = 420'000;
+
+constexpr uint8_t ADDRESS_FLIGHT_CONTROLLER = 0xC8;
+constexpr uint8_t ADDRESS_RECEIVER = 0xEC;
+
+constexpr size_t MAX_FRAME = 64;
+constexpr size_t MAX_PAYLOAD = MAX_FRAME - 4;
+
+constexpr size_t CHANNELS = 16;
+
+enum class type : uint8_t
+{
+    BATTERY = 0x08,
+    LINK_STATISTICS = 0x14,
+    RC_CHANNELS = 0x16,
+    ATTITUDE = 0x1E,
+    FLIGHT_MODE = 0x21,
+};
+
+namespace detail
+{
+
+constexpr std::array<uint8_t, 256> crc8_table()
+{
+    std::array<uint8_t, 256> table{};
+    for (size_t i = 0; i < table.size(); i++)
+    {
+        uint8_t crc = static_cast<uint8_t>(i);
+        for (int bit = 0; bit < 8; bit++)
+            crc = crc & 0x80 ? static_cast<uint8_t>(crc << 1 ^ 0xD5) : static_cast<uint8_t>(crc << 1);
+        table[i] = crc;
+    }
+    return table;
+}
+
+// In DRAM, since the parser looks up every received byte.
+LUMINA_HOT_DATA inline constexpr std::array<uint8_t, 256> CRC8_TABLE = crc8_table();
+
+}
+
+/**
+ * CRC-8/DVB-S2, polynomial 0xD5.
+ */
+constexpr uint8_t LUMINA_HOT crc8(const uint8_t* data, size_t size, uint8_t crc = 0)
+{
+    for (size_t i = 0; i < size; i++)
+        crc = detail::CRC8_TABLE[crc ^ data[i]];
+    return crc;
+}
+
+struct link_statistics
+{
+    uint8_t uplink_rssi[2];         // -dBm, per antenna
+    uint8_t uplink_quality;         // %
+    int8_t  uplink_snr;             // dB
+    uint8_t active_antenna;
+    uint8_t rf_mode;
+    uint8_t uplink_power;           // enum, 0 = 0 mW
+    uint8_t downlink_rssi;          // -dBm
+    uint8_t downlink_quality;       // %
+    int8_t  downlink_snr;           // dB
+
+    static constexpr size_t SIZE = 10;
+
+    static constexpr link_statistics parse(const uint8_t* p)
+    {
+        return {
+            { p[0], p[1] }, p[2], static_cast<int8_t>(p[3]), p[4], p[5], p[6],
+            p[7], p[8], static_cast<int8_t>(p[9])
+        };
+    }
+};
+
+/**
+ * 16 channels of 11 bits, packed LSB first into 22 bytes.
+ */
+using channels = std::array<uint16_t, CHANNELS>;
+
+constexpr size_t CHANNELS_SIZE = 22;
+
+constexpr channels LUMINA_HOT unpack(const uint8_t* p)
+{
+    channels c{};
+    uint32_t bits = 0;
+    int available = 0;
+    for (size_t i = 0; i < CHANNELS; i++)
+    {
+        while (available < 11)
+        {
+            bits |= uint32_t(*p++) << available;
+            available += 8;
+        }
+        c[i] = bits & 0x7FF;
+        bits >>= 11;
+        available -= 11;
+    }
+    return c;
+}
+
+constexpr std::array<uint8_t, CHANNELS_SIZE> pack(const channels& c)
+{
+    std::array<uint8_t, CHANNELS_SIZE> p{};
+    uint32_t bits = 0;
+    int available = 0;
+    size_t n = 0;
+    for (size_t i = 0; i < CHANNELS; i++)
+    {
+        bits |= uint32_t(c[i] & 0x7FF) << available;
+        available += 11;
+        for (; available >= 8; available -= 8, bits >>= 8)
+            p[n++] = bits & 0xFF;
+    }
+    return p;
+}
+
+/**
+ * Channel value in microseconds of the equivalent servo pulse:
+ * 172..1811 maps to 988..2012 us, 992 is center.
+ */
+constexpr uint16_t to_us(uint16_t value)
+{
+    return static_cast<uint16_t>(988 + (static_cast<int>(value) - 172) * 1024 / 1639);
+}
+
+
+/**
+ * One outgoing frame, addressed to the receiver.
+ */
+struct frame
+{
+    std::array<uint8_t, MAX_FRAME> bytes;
+    size_t size;
+
+    constexpr frame(type t, const uint8_t* payload, size_t length, uint8_t address = ADDRESS_RECEIVER)
+    :   bytes{},
+        size(length + 4)
+    {
+        bytes[0] = address;
+        bytes[1] = static_cast<uint8_t>(length + 2);
+        bytes[2] = static_cast<uint8_t>(t);
+        for (size_t i = 0; i < length; i++)
+            bytes[3 + i] = payload[i];
+        bytes[3 + length] = crc8(bytes.data() + 2, length + 1);
+    }
+
+    const uint8_t* data() const
+    {
+        return bytes.data();
+    }
+};
+
+/**
+ * Battery sensor: voltage and current in 0.1 units, used capacity in mAh
+ * and remaining charge in %, all big-endian.
+ */
+constexpr frame battery(float volts, float amps, uint32_t used_mah, uint8_t remaining)
+{
+    uint16_t v = static_cast<uint16_t>(volts * 10 + 0.5f);
+    uint16_t a = static_cast<uint16_t>(amps * 10 + 0.5f);
+    uint8_t payload[8] = {
+        uint8_t(v >> 8), uint8_t(v), uint8_t(a >> 8), uint8_t(a),
+        uint8_t(used_mah >> 16), uint8_t(used_mah >> 8), uint8_t(used_mah), remaining
+    };
+    return frame(type::BATTERY, payload, sizeof(payload));
+}
+
+/**
+ * Attitude in 1/10000 rad, big-endian, in pitch, roll, yaw order.
+ */
+constexpr frame attitude(float roll, float pitch, float yaw)
+{
+    int16_t values[3] = {
+        static_cast<int16_t>(pitch * 10000), static_cast<int16_t>(roll * 10000), static_cast<int16_t>(yaw * 10000)
+    };
+    uint8_t payload[6] = {};
+    for (int i = 0; i < 3; i++)
+    {
+        payload[2 * i] = static_cast<uint8_t>(static_cast<uint16_t>(values[i]) >> 8);
+        payload[2 * i + 1] = static_cast<uint8_t>(values[i]);
+    }
+    return frame(type::ATTITUDE, payload, sizeof(payload));
+}
+
+/**
+ * Null-terminated flight mode name, shown on the transmitter.
+ */
+constexpr frame flight_mode(const char* name)
+{
+    uint8_t payload[16] = {};
+    size_t length = 0;
+    for (; name[length] && length < sizeof(payload) - 1; length++)
+        payload[length] = static_cast<uint8_t>(name[length]);
+    return frame(type::FLIGHT_MODE, payload, length + 1);
+}
+
+
+/**
+ * Incremental frame parser for the receiver's byte stream.
+ *
+ * Bytes can arrive in any split; `feed()` calls `on_frame(type, payload,
+ * length)` for every complete frame with a valid CRC. A frame with a bad
+ * length or CRC only costs its address byte: the parser resynchronizes on
+ * the next flight-controller address byte, searching the dropped frame's
+ * own bytes first, so a corrupted length that swallowed the start of the
+ * following frame does not lose that frame too.
+ */
+class parser
+{
+public:
+
+    constexpr parser()
+    :   _buffer{},
+        _size(0),
+        _rescan(0),
+        _frames(0),
+        _errors(0)
+    {}
+
+    template <typename F>
+    constexpr void LUMINA_HOT feed(const uint8_t* data, size_t size, F&& on_frame)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            if (_size == 0 && data[i] != ADDRESS_FLIGHT_CONTROLLER)
+                continue;
+
+            // Once the length is checked, only a complete frame needs parsing.
+            _buffer[_size++] = data[i];
+            if (_size == 1 || (_size > 2 && _size < size_t(_buffer[1]) + 2))
+                continue;
+            _parse(on_frame);
+        }
+    }
+
+    constexpr uint32_t frames() const
+    {
+        return _frames;
+    }
+
+    /**
+     * Frames dropped for a bad length or CRC.
+     */
+    constexpr uint32_t errors() const
+    {
+        return _errors;
+    }
+
+protected:
+
+    /**
+     * Delivers or drops the frame at the start of the buffer once its length
+     * byte is invalid or all its bytes are in. False starts found among the
+     * bytes of a dropped frame are not counted as errors again.
+     */
+    template <typename F>
+    constexpr void LUMINA_HOT _parse(F& on_frame)
+    {
+        for (;;)
+        {
+            size_t start = 0;
+            while (start < _size && _buffer[start] != ADDRESS_FLIGHT_CONTROLLER)
+                start++;
+            _drop(start);
+
+            if (_size < 2)
+                return;
+
+            size_t total = size_t(_buffer[1]) + 2;
+            bool valid = _buffer[1] >= 2 && total <= MAX_FRAME;
+            if (valid && _size < total)
+                return;
+
+            if (valid && crc8(_buffer.data() + 2, total - 3) == _buffer[total - 1])
+            {
+                _frames++;
+                on_frame(static_cast<type>(_buffer[2]), _buffer.data() + 3, total - 4);
+                _drop(total);
+            }
+            else
+            {
+                _errors += _rescan == 0;
+                _rescan = _size;
+                _drop(1);
+            }
+        }
+    }
+
+    constexpr void LUMINA_HOT _drop(size_t n)
+    {
+        for (size_t i = n; i < _size; i++)
+            _buffer[i - n] = _buffer[i];
+        _size -= n;
+        _rescan = _rescan > n ? _rescan - n : 0;
+    }
+
+protected:
+
+    std::array<uint8_t, MAX_FRAME> _buffer;
+    size_t _size;
+    size_t _rescan;                 // leading bytes that belonged to a dropped frame
+    uint32_t _frames;
+    uint32_t _errors;
+};
+
+static_assert([] {
+    // CRC-8/DVB-S2 check value.
+    const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    return crc8(check, sizeof(check)) == 0xBC;
+}());
+
+static_assert([] {
+    channels c{};
+    for (size_t i = 0; i < CHANNELS; i++)
+        c[i] = static_cast<uint16_t>(172 + i * 109);
+    return unpack(pack(c).data()) == c && to_us(172) == 988 && to_us(992) == 1500 && to_us(1811) == 2012;
+}());
+
+static_assert([] {
+    // An RC frame split at an awkward point behind line noise, a corrupted
+    // copy and a link statistics frame: two good frames, one error.
+    channels c{};
+    c[0] = 992;
+    c[2] = 1811;
+    auto payload = pack(c);
+    frame f(type::RC_CHANNELS, payload.data(), payload.size(), ADDRESS_FLIGHT_CONTROLLER);
+    frame bad = f;
+    bad.bytes[10] ^= 0x40;
+    const uint8_t stats[link_statistics::SIZE] = { 40, 45, 100, 9, 0, 5, 2, 50, 98, 7 };
+    frame link(type::LINK_STATISTICS, stats, sizeof(stats), ADDRESS_FLIGHT_CONTROLLER);
+
+    parser p;
+    channels received{};
+    link_statistics statistics{};
+    auto on_frame = [&](type t, const uint8_t* data, size_t length) {
+        if (t == type::RC_CHANNELS && length == CHANNELS_SIZE)
+            received = unpack(data);
+        if (t == type::LINK_STATISTICS && length == link_statistics::SIZE)
+            statistics = link_statistics::parse(data);
+    };
+
+    const uint8_t noise[] = { 0x00, 0x13, 0xFF };
+    p.feed(noise, sizeof(noise), on_frame);
+    p.feed(f.bytes.data(), 7, on_frame);
+    p.feed(f.bytes.data() + 7, f.size - 7, on_frame);
+    p.feed(bad.bytes.data(), bad.size, on_frame);
+    p.feed(link.bytes.data(), link.size, on_frame);
+
+    return received == c && statistics.uplink_quality == 100 && statistics.downlink_snr == 7
+        && p.frames() == 2 && p.errors() == 1;
+}());
+
+}
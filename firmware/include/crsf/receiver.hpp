@@ -0,0 +1,264 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/uart.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#include "check.hpp"
+#include "seqlock.hpp"
+#include "histogram.hpp"
+#include "profile.hpp"
+#include "trace.hpp"
+#include "placement.hpp"
+#include "crsf/crsf.hpp"
+
+namespace lumina::crsf
+{
+
+/**
+ * Latest stick input, in servo microseconds.
+ */
+struct input
+{
+    std::array<uint16_t, CHANNELS> channels;
+    int64_t timestamp;              // esp_timer time the frame was parsed
+};
+
+/**
+ * CRSF receiver on a UART.
+ *
+ * The UART raises its receive interrupt on line idle (one byte time of
+ * silence after a frame) rather than waiting for a FIFO threshold, so each
+ * frame reaches the driver task as one chunk, a few tens of microseconds
+ * after its last byte. The task parses it and publishes channels through a
+ * seqlock that the control task polls without blocking, and can wake the
+ * control task on every new frame.
+ *
+ * Link statistics are kept for reporting. `failsafe()` trips when no valid
+ * channel frame arrived within the timeout. Telemetry frames go back over
+ * the same UART.
+ */
+class receiver
+{
+public:
+
+    static constexpr int64_t FAILSAFE_US = 250'000;
+
+public:
+
+    /**
+     * @param core Core the driver task is pinned to.
+     * @param priority Driver task priority; it should preempt the control loop.
+     */
+    receiver(uart_port_t port, int tx, int rx, int core = 1, UBaseType_t priority = configMAX_PRIORITIES - 1)
+    :   _port(port),
+        _task(nullptr),
+        _consumer(nullptr),
+        _link{},
+        _read_sequence(0)
+    {
+        uart_config_t config = {};
+        config.baud_rate = BAUD_RATE;
+        config.data_bits = UART_DATA_8_BITS;
+        config.parity = UART_PARITY_DISABLE;
+        config.stop_bits = UART_STOP_BITS_1;
+        config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+        config.source_clk = UART_SCLK_DEFAULT;
+
+        ESP_CHECK(uart_driver_install(port, 4 * MAX_FRAME, 4 * MAX_FRAME, 16, &_events, 0));
+        ESP_CHECK(uart_param_config(port, &config));
+        ESP_CHECK(uart_set_pin(port, tx, rx, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE));
+
+        // Interrupt after one idle byte time, and only fall back to the FIFO
+        // threshold for frames longer than the protocol allows.
+        ESP_CHECK(uart_set_rx_timeout(port, 1));
+        ESP_CHECK(uart_set_rx_full_threshold(port, MAX_FRAME + 16));
+
+        xTaskCreatePinnedToCore(&receiver::_run, "crsf", 3072, this, priority, &_task, core);
+
+        ESP_LOGI("CRSF", "UART %d at %lu baud", port, static_cast<unsigned long>(BAUD_RATE));
+    }
+
+    receiver(const receiver&) = delete;
+    receiver& operator= (const receiver&) = delete;
+
+    ~receiver()
+    {
+        if (_task)
+            vTaskDelete(_task);
+        ESP_CHECK(uart_driver_delete(_port));
+    }
+
+    /**
+     * Copies the latest channels and returns true if they are newer than
+     * at the previous call. Records the frame's age for `latency()`. Call
+     * from a single consumer task only.
+     */
+    bool read(input& in)
+    {
+        uint32_t sequence = _input.read(in);
+        if (sequence == _read_sequence)
+            return false;
+
+        _read_sequence = sequence;
+        _latency.record(static_cast<uint32_t>(esp_timer_get_time() - in.timestamp));
+        return true;
+    }
+
+    /**
+     * Latest channels, for reporting from any task; does not count as a read.
+     */
+    input latest() const
+    {
+        input in;
+        _input.read(in);
+        return in;
+    }
+
+    /**
+     * Wakes `task` through its notification count on every channel frame.
+     */
+    void notify(TaskHandle_t task)
+    {
+        _consumer = task;
+    }
+
+    /**
+     * True while no valid channel frame arrived for `timeout_us`.
+     */
+    bool failsafe(int64_t timeout_us = FAILSAFE_US) const
+    {
+        int64_t last = _last_frame.load(std::memory_order_relaxed);
+        return last == 0 || esp_timer_get_time() - last > timeout_us;
+    }
+
+    link_statistics link() const
+    {
+        link_statistics link;
+        _link.read(link);
+        return link;
+    }
+
+    /**
+     * Microseconds from parsing a frame to the consumer's `read()`.
+     */
+    const histogram<>& latency() const
+    {
+        return _latency;
+    }
+
+    TaskHandle_t task() const
+    {
+        return _task;
+    }
+
+    uint32_t frames() const
+    {
+        return _frames.load(std::memory_order_relaxed);
+    }
+
+    uint32_t errors() const
+    {
+        return _errors.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Queues a telemetry frame for transmission to the receiver.
+     */
+    void send(const frame& f)
+    {
+        uart_write_bytes(_port, f.data(), f.size);
+    }
+
+protected:
+
+    static void LUMINA_HOT _run(void* arg)
+    {
+        receiver& self = *static_cast<receiver*>(arg);
+        std::array<uint8_t, 4 * MAX_FRAME> buffer;
+
+        auto on_frame = [&](type t, const uint8_t* payload, size_t length) {
+            if (t == type::RC_CHANNELS && length == CHANNELS_SIZE)
+            {
+                input in;
+                in.timestamp = esp_timer_get_time();
+                channels raw = unpack(payload);
+                for (size_t i = 0; i < CHANNELS; i++)
+                    in.channels[i] = to_us(raw[i]);
+
+                self._input.write(in);
+                self._last_frame.store(in.timestamp, std::memory_order_relaxed);
+
+                if (TaskHandle_t consumer = self._consumer)
+                    xTaskNotifyGive(consumer);
+            }
+            else if (t == type::LINK_STATISTICS && length == link_statistics::SIZE)
+            {
+                self._link.write(link_statistics::parse(payload));
+            }
+        };
+
+        for (;;)
+        {
+            uart_event_t event;
+            if (xQueueReceive(self._events, &event, portMAX_DELAY) != pdTRUE)
+                continue;
+
+            switch (event.type)
+            {
+                case UART_DATA:
+                {
+                    size_t size = event.size < buffer.size() ? event.size : buffer.size();
+                    int read = uart_read_bytes(self._port, buffer.data(), size, 0);
+                    if (read > 0)
+                    {
+                        LUMINA_PROFILE_SCOPE("crsf");
+                        LUMINA_TRACE_SCOPE("crsf");
+                        self._parser.feed(buffer.data(), read, on_frame);
+                    }
+
+                    self._frames.store(self._parser.frames(), std::memory_order_relaxed);
+                    self._errors.store(self._parser.errors(), std::memory_order_relaxed);
+                    break;
+                }
+
+                case UART_FIFO_OVF:
+                case UART_BUFFER_FULL:
+                    uart_flush_input(self._port);
+                    xQueueReset(self._events);
+                    break;
+
+                default:
+                    break;
+            }
+        }
+    }
+
+protected:
+
+    uart_port_t _port;
+    QueueHandle_t _events;
+    TaskHandle_t _task;
+    TaskHandle_t volatile _consumer;
+
+    parser _parser;
+    seqlock<input> _input;
+    seqlock<link_statistics> _link;
+    std::atomic<int64_t> _last_frame;
+    std::atomic<uint32_t> _frames;
+    std::atomic<uint32_t> _errors;
+
+    uint32_t _read_sequence;
+    histogram<> _latency;
+};
+
+}
@@ -0,0 +1,306 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#else
+#include <chrono>
+#include <thread>
+#endif
+
+namespace lumina
+{
+
+/**
+ * Components a component needs initialized before its own `init()`.
+ */
+template <typename... Components>
+struct depends {};
+
+
+namespace detail
+{
+
+template <typename C>
+struct dependencies_of
+{
+    using type = depends<>;
+};
+
+template <typename C> requires requires { typename C::depends; }
+struct dependencies_of<C>
+{
+    using type = typename C::depends;
+};
+
+template <typename C, size_t DEPTH = 0>
+constexpr size_t init_level();
+
+template <size_t DEPTH, typename... Ds>
+constexpr size_t deepest(depends<Ds...>)
+{
+    return std::max({ size_t(0), (init_level<Ds, DEPTH + 1>() + 1)... });
+}
+
+// Longest dependency chain below `C`; components on the same level do not
+// depend on each other.
+template <typename C, size_t DEPTH>
+constexpr size_t init_level()
+{
+    static_assert(DEPTH < 32, "component dependency cycle");
+    return deepest<DEPTH>(typename dependencies_of<C>::type{});
+}
+
+template <typename T, typename... Ts>
+constexpr bool one_of = (std::is_same_v<T, Ts> || ...);
+
+template <typename... Cs, typename... Ds>
+constexpr bool provided(depends<Ds...>)
+{
+    return (one_of<Ds, Cs...> && ...);
+}
+
+template <typename C>
+constexpr int init_core()
+{
+    if constexpr (requires { C::CORE; })
+        return C::CORE;
+    else
+        return -1;
+}
+
+inline int64_t now_us()
+{
+#ifdef ESP_PLATFORM
+    return esp_timer_get_time();
+#else
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+struct job
+{
+    void (*run)(void*);
+    void* arg;
+    int core;                       // -1 for the caller's core
+};
+
+/**
+ * Runs `jobs` concurrently and returns when all are done. The first job
+ * that is not pinned to a core runs on the calling task, the others on
+ * short-lived tasks of the same priority.
+ */
+template <size_t N>
+void run_parallel(const std::array<job, N>& jobs, size_t count)
+{
+    if (count == 0)
+        return;
+
+    size_t local = 0;
+    while (local < count && jobs[local].core >= 0)
+        local++;
+
+#ifdef ESP_PLATFORM
+    static constexpr uint32_t STACK = 4096;
+
+    struct worker
+    {
+        job work;
+        TaskHandle_t parent;
+
+        static void run(void* arg)
+        {
+            worker& self = *static_cast<worker*>(arg);
+            self.work.run(self.work.arg);
+            xTaskNotifyGive(self.parent);
+            vTaskDelete(nullptr);
+        }
+    };
+
+    std::array<worker, N> workers;
+    UBaseType_t priority = uxTaskPriorityGet(nullptr);
+    size_t spawned = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (i == local)
+            continue;
+        workers[i] = { jobs[i], xTaskGetCurrentTaskHandle() };
+        BaseType_t core = jobs[i].core < 0 ? xPortGetCoreID() : jobs[i].core;
+        xTaskCreatePinnedToCore(&worker::run, "init", STACK, &workers[i], priority, nullptr, core);
+        spawned++;
+    }
+
+    if (local < count)
+        jobs[local].run(jobs[local].arg);
+    for (size_t done = 0; done < spawned; )
+        done += ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+#else
+    std::array<std::thread, N> threads;
+    for (size_t i = 0; i < count; i++)
+        if (i != local)
+            threads[i] = std::thread(jobs[i].run, jobs[i].arg);
+
+    if (local < count)
+        jobs[local].run(jobs[local].arg);
+    for (size_t i = 0; i < count; i++)
+        if (threads[i].joinable())
+            threads[i].join();
+#endif
+}
+
+}
+
+
+/**
+ * A drone as a fixed list of components.
+ *
+ * Each component is a plain type with a `NAME`, an optional `depends` list
+ * and any of `init(drone&)`, `start(drone&)`, `update(drone&)` and
+ * `stop(drone&)`. The lifecycle is dispatched at compile time: there is no
+ * base class, no virtual call, and components without a hook cost nothing.
+ * Components reach each other through `get<C>()`.
+ *
+ * `init()` runs in dependency order. Components whose dependencies are all
+ * initialized go together, each on its own task, so slow independent
+ * bring-up such as Wi-Fi and sensor resets overlap. A component can pin its
+ * init with `static constexpr int CORE`, which matters for drivers that
+ * allocate interrupts on the initializing core; otherwise init runs on the
+ * caller's core. `start()` and `update()` follow dependency order on the
+ * calling task, `stop()` the reverse.
+ */
+template <typename... Components>
+class drone
+{
+    static_assert((detail::provided<Components...>(typename detail::dependencies_of<Components>::type{}) && ...),
+                  "a component depends on one that is not part of the drone");
+
+public:
+
+    static constexpr size_t COMPONENTS = sizeof...(Components);
+    static constexpr size_t LEVELS = std::max({ size_t(0), (detail::init_level<Components>() + 1)... });
+
+public:
+
+    drone()
+    :   _init_us{},
+        _ready_us(0)
+    {}
+
+    drone(const drone&) = delete;
+    drone& operator= (const drone&) = delete;
+
+    template <typename C>
+    C& get()
+    {
+        return std::get<C>(_components);
+    }
+
+    void init()
+    {
+        int64_t begin = detail::now_us();
+        for (size_t level = 0; level < LEVELS; level++)
+            _init_level(level, std::index_sequence_for<Components...>{});
+        _ready_us = detail::now_us() - begin;
+    }
+
+    void start()
+    {
+        int64_t begin = detail::now_us();
+        _for_each_ordered([&](auto& component) {
+            if constexpr (requires { component.start(*this); })
+                component.start(*this);
+        });
+        _ready_us += detail::now_us() - begin;
+    }
+
+    void update()
+    {
+        _for_each_ordered([&](auto& component) {
+            if constexpr (requires { component.update(*this); })
+                component.update(*this);
+        });
+    }
+
+    void stop()
+    {
+        _for_each_ordered([&](auto& component) {
+            if constexpr (requires { component.stop(*this); })
+                component.stop(*this);
+        }, true);
+    }
+
+    /**
+     * Time spent in `init()` and `start()`, i.e. until the drone is ready to arm.
+     */
+    int64_t ready_us() const
+    {
+        return _ready_us;
+    }
+
+    /**
+     * Calls `f(name, init_us)` for every component, in declaration order.
+     */
+    template <typename F>
+    void timings(F&& f) const
+    {
+        size_t i = 0;
+        ((f(Components::NAME, _init_us[i++])), ...);
+    }
+
+protected:
+
+    template <size_t I>
+    static void _init_one(void* arg)
+    {
+        drone& self = *static_cast<drone*>(arg);
+        auto& component = std::get<I>(self._components);
+
+        int64_t begin = detail::now_us();
+        if constexpr (requires { component.init(self); })
+            component.init(self);
+        self._init_us[I] = detail::now_us() - begin;
+    }
+
+    template <size_t... I>
+    void _init_level(size_t level, std::index_sequence<I...>)
+    {
+        std::array<detail::job, COMPONENTS> jobs;
+        size_t count = 0;
+        ((detail::init_level<Components>() == level
+            ? void(jobs[count++] = { &drone::_init_one<I>, this, detail::init_core<Components>() })
+            : void()), ...);
+
+        detail::run_parallel(jobs, count);
+    }
+
+    template <typename F>
+    void _for_each_ordered(F&& f, bool reverse = false)
+    {
+        for (size_t step = 0; step < LEVELS; step++)
+        {
+            size_t level = reverse ? LEVELS - 1 - step : step;
+            std::apply([&](auto&... components) {
+                ((detail::init_level<std::remove_reference_t<decltype(components)>>() == level ? f(components) : void()), ...);
+            }, _components);
+        }
+    }
+
+protected:
+
+    std::tuple<Components...> _components;
+    std::array<int64_t, COMPONENTS> _init_us;
+    int64_t _ready_us;
+};
+
+}
@@ -0,0 +1,488 @@
+#pragma once
+
+#include <array>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "math.hpp"
+#include "vec.hpp"
+#include "mat.hpp"
+#include "quat.hpp"
+#include "rotation.hpp"
+#include "attitude.hpp"
+#include "placement.hpp"
+
+namespace lumina
+{
+
+/**
+ * Noise model and timing of the navigation filter. Noises are 1-sigma per
+ * second, applied as (noise * dt)^2 per prediction step.
+ */
+struct ekf_params
+{
+    float gyro_noise = 0.015f;          // rad/s
+    float accel_noise = 0.35f;          // m/s^2
+    float gyro_bias_noise = 1e-3f;      // rad/s^2
+    float accel_bias_noise = 3e-3f;     // m/s^3
+
+    float period = 0.005f;              // s between covariance predictions
+    float delay = 0.1f;                 // s the filter runs behind the IMU
+    float gate = 5.f;                   // innovation gate in standard deviations
+};
+
+/**
+ * Aiding measurement, stamped with the time it was taken rather than the time
+ * it arrived.
+ */
+struct ekf_measurement
+{
+    enum kind : uint8_t
+    {
+        POSITION,                       // NED position, m (vision, GNSS)
+        VELOCITY,                       // NED velocity, m/s
+        HEIGHT,                         // value[0]: height above origin, m (barometer)
+        BODY_VELOCITY,                  // value[0..1]: body-frame horizontal velocity, m/s (optical flow times range)
+        YAW,                            // value[0]: heading, rad (vision, compass)
+    };
+
+    kind type;
+    int64_t timestamp;                  // us
+    vec3 value;
+    float variance;                     // per axis
+};
+
+
+/**
+ * Error-state extended Kalman filter for attitude, velocity, position and
+ * gyro/accel biases in a local NED frame.
+ *
+ * The nominal state is integrated from IMU deltas; the filter tracks the
+ * covariance of a 15-element error state (body-frame attitude error,
+ * velocity, position, gyro bias, accel bias). Every measurement axis is fused
+ * as a scalar update, so no matrix is ever inverted, and the error is folded
+ * back into the nominal state right after each update.
+ *
+ * IMU samples are accumulated into deltas of `period` and the filter runs
+ * `delay` behind them, so measurements that arrive late are still fused at
+ * the time they were taken. The outputs are brought back to the present by
+ * re-integrating the buffered deltas on top of the delayed estimate.
+ *
+ * @tparam HISTORY Buffered IMU deltas; must cover `delay / period`.
+ * @tparam MEASUREMENTS Pending measurements waiting for the filter to reach them.
+ */
+template <size_t HISTORY = 32, size_t MEASUREMENTS = 16>
+class ekf
+{
+public:
+
+    static constexpr int N = 15;
+
+    enum index : int
+    {
+        ATTITUDE   = 0,
+        VELOCITY   = 3,
+        POSITION   = 6,
+        GYRO_BIAS  = 9,
+        ACCEL_BIAS = 12,
+    };
+
+    using covariance_type = mat<N, N, float>;
+
+    static constexpr float GRAVITY = 9.80665f;
+
+protected:
+
+    struct state
+    {
+        quat attitude;
+        vec3 velocity;
+        vec3 position;
+        vec3 gyro_bias;
+        vec3 accel_bias;
+    };
+
+    struct delta
+    {
+        int64_t timestamp;
+        vec3 angle;
+        vec3 velocity;
+        float dt;
+    };
+
+public:
+
+    constexpr ekf(const ekf_params& params = {})
+    :   _params(params),
+        _delayed{quat::identity(), {}, {}, {}, {}},
+        _current{quat::identity(), {}, {}, {}, {}},
+        _covariance{},
+        _time(0),
+        _accumulated{0, {}, {}, 0},
+        _history{},
+        _history_head(0),
+        _history_size(0),
+        _measurements{},
+        _measurement_count(0),
+        _rejected(0),
+        _aided(0),
+        _initialized(false)
+    {
+        constexpr float attitude = 0.1f, velocity = 0.5f, position = 0.5f, gyro_bias = 0.01f, accel_bias = 0.2f;
+
+        for (int i = 0; i < 3; i++)
+        {
+            _covariance[ATTITUDE + i][ATTITUDE + i]     = attitude * attitude;
+            _covariance[VELOCITY + i][VELOCITY + i]     = velocity * velocity;
+            _covariance[POSITION + i][POSITION + i]     = position * position;
+            _covariance[GYRO_BIAS + i][GYRO_BIAS + i]   = gyro_bias * gyro_bias;
+            _covariance[ACCEL_BIAS + i][ACCEL_BIAS + i] = accel_bias * accel_bias;
+        }
+    }
+
+    /**
+     * Feeds one IMU sample.
+     *
+     * @param timestamp Sample time in microseconds.
+     * @param gyro Body rate in rad/s.
+     * @param accel Specific force in m/s^2.
+     * @param dt Time since the previous sample in seconds.
+     */
+    constexpr void LUMINA_HOT update(int64_t timestamp, const vec3& gyro, const vec3& accel, float dt)
+    {
+        if (!_initialized)
+        {
+            _delayed.attitude = _current.attitude = detail::level(accel);
+            _time = timestamp;
+            _initialized = true;
+            return;
+        }
+
+        _accumulated.angle += gyro * dt;
+        _accumulated.velocity += accel * dt;
+        _accumulated.dt += dt;
+        _accumulated.timestamp = timestamp;
+
+        if (_accumulated.dt < _params.period)
+            return;
+
+        if (_history_size == HISTORY)
+            _advance();
+        _history[(_history_head + _history_size++) % HISTORY] = _accumulated;
+        _accumulated = {timestamp, {}, {}, 0};
+
+        int64_t horizon = timestamp - static_cast<int64_t>(_params.delay * 1e6f);
+        while (_history_size && _history[_history_head].timestamp <= horizon)
+            _advance();
+
+        _current = _delayed;
+        for (size_t i = 0; i < _history_size; i++)
+            _integrate(_current, _history[(_history_head + i) % HISTORY]);
+    }
+
+    /**
+     * Queues a measurement. It is fused once the delayed filter reaches its
+     * timestamp; measurements older than the filter time are dropped.
+     */
+    constexpr bool fuse(const ekf_measurement& m)
+    {
+        if (!_initialized || m.timestamp < _time || _measurement_count == MEASUREMENTS)
+            return false;
+
+        size_t i = _measurement_count++;
+        for (; i > 0 && _measurements[i - 1].timestamp > m.timestamp; i--)
+            _measurements[i] = _measurements[i - 1];
+        _measurements[i] = m;
+        return true;
+    }
+
+    /**
+     * Body to NED rotation at the latest IMU sample.
+     */
+    constexpr const quat& attitude() const { return _current.attitude; }
+    constexpr const vec3& velocity() const { return _current.velocity; }
+    constexpr const vec3& position() const { return _current.position; }
+
+    constexpr const vec3& gyro_bias() const { return _delayed.gyro_bias; }
+    constexpr const vec3& accel_bias() const { return _delayed.accel_bias; }
+
+    /**
+     * Error-state covariance at the delayed filter time.
+     */
+    constexpr const covariance_type& covariance() const
+    {
+        return _covariance;
+    }
+
+    /**
+     * Diagonal of the 3x3 covariance block of the error state starting at
+     * `block`, e.g. the position variances for POSITION.
+     */
+    constexpr vec3 variance(index block) const
+    {
+        return { _covariance[block][block], _covariance[block + 1][block + 1], _covariance[block + 2][block + 2] };
+    }
+
+    /**
+     * Measurement axes refused by the innovation gate.
+     */
+    constexpr uint32_t rejected() const
+    {
+        return _rejected;
+    }
+
+    /**
+     * Timestamp of the last fused position, velocity or body velocity, 0 if
+     * there was none. Until then, and once aiding stops, position and
+     * velocity are integrated from the accelerometer alone and drift
+     * without bound, so they must not be reported as an estimate.
+     */
+    constexpr int64_t aided() const
+    {
+        return _aided;
+    }
+
+protected:
+
+    /**
+     * Moves the delayed filter over the oldest buffered delta, then fuses the
+     * measurements it has caught up with.
+     */
+    constexpr void LUMINA_HOT _advance()
+    {
+        const delta& d = _history[_history_head];
+        _predict(d);
+        _integrate(_delayed, d);
+        _time = d.timestamp;
+
+        _history_head = (_history_head + 1) % HISTORY;
+        _history_size--;
+
+        size_t fused = 0;
+        while (fused < _measurement_count && _measurements[fused].timestamp <= _time)
+            _correct(_measurements[fused++]);
+
+        for (size_t i = fused; i < _measurement_count; i++)
+            _measurements[i - fused] = _measurements[i];
+        _measurement_count -= fused;
+    }
+
+    static constexpr void LUMINA_HOT _integrate(state& s, const delta& d)
+    {
+        vec3 angle = d.angle - s.gyro_bias * d.dt;
+        vec3 dv = s.attitude.rotate(d.velocity - s.accel_bias * d.dt) + vec3{0, 0, GRAVITY * d.dt};
+
+        s.position += (s.velocity + dv * 0.5f) * d.dt;
+        s.velocity += dv;
+        s.attitude = (s.attitude * quat{1, angle[0] / 2, angle[1] / 2, angle[2] / 2}).normalized();
+    }
+
+    /**
+     * P = F P F^T + Q with F = I + A dt. F is applied block by block since
+     * only five of its 3x3 blocks off the diagonal are non-zero.
+     */
+    constexpr void LUMINA_HOT _predict(const delta& d)
+    {
+        mat3 R = quaternion_to_dcm(_delayed.attitude);
+        vec3 angle = d.angle - _delayed.gyro_bias * d.dt;
+        vec3 velocity = d.velocity - _delayed.accel_bias * d.dt;
+
+        mat3 theta = mat3::identity() - skew(angle);
+        mat3 v_theta = R * skew(velocity) * -1.f;
+        mat3 v_ba = R * -d.dt;
+
+        auto left = [&](const covariance_type& P) {
+            covariance_type out = P;
+            for (int c = 0; c < N; c++)
+            {
+                for (int i = 0; i < 3; i++)
+                {
+                    float t = -d.dt * P[GYRO_BIAS + i][c];
+                    float v = 0, p = d.dt * P[VELOCITY + i][c];
+                    for (int j = 0; j < 3; j++)
+                    {
+                        t += theta[i][j] * P[ATTITUDE + j][c];
+                        v += v_theta[i][j] * P[ATTITUDE + j][c] + v_ba[i][j] * P[ACCEL_BIAS + j][c];
+                    }
+                    out[ATTITUDE + i][c] = t;
+                    out[VELOCITY + i][c] += v;
+                    out[POSITION + i][c] += p;
+                }
+            }
+            return out;
+        };
+
+        _covariance = left(left(_covariance).transposed());
+
+        float dt = d.dt;
+        float q[] = {
+            _params.gyro_noise * dt, _params.accel_noise * dt, 0,
+            _params.gyro_bias_noise * dt, _params.accel_bias_noise * dt
+        };
+        for (int b = 0; b < 5; b++)
+            for (int i = 0; i < 3; i++)
+                _covariance[3 * b + i][3 * b + i] += q[b] * q[b];
+
+        for (int i = 0; i < N; i++)
+            for (int j = i + 1; j < N; j++)
+                _covariance[i][j] = _covariance[j][i] = (_covariance[i][j] + _covariance[j][i]) / 2;
+    }
+
+    constexpr void _correct(const ekf_measurement& m)
+    {
+        mat3 R = quaternion_to_dcm(_delayed.attitude);
+
+        switch (m.type)
+        {
+        case ekf_measurement::POSITION:
+        case ekf_measurement::VELOCITY:
+            for (int i = 0; i < 3; i++)
+            {
+                int k = (m.type == ekf_measurement::POSITION ? POSITION : VELOCITY) + i;
+                const vec3& x = m.type == ekf_measurement::POSITION ? _delayed.position : _delayed.velocity;
+                std::array<float, N> H{};
+                H[k] = 1;
+                if (_scalar(H, m.value[i] - x[i], m.variance))
+                    _aided = m.timestamp;
+            }
+            break;
+
+        case ekf_measurement::HEIGHT:
+        {
+            std::array<float, N> H{};
+            H[POSITION + 2] = -1;
+            _scalar(H, m.value[0] + _delayed.position[2], m.variance);
+            break;
+        }
+
+        case ekf_measurement::BODY_VELOCITY:
+        {
+            // v_body = R^T v; a body-frame attitude error rotates it by [v_body]x.
+            vec3 body = R.transposed() * _delayed.velocity;
+            mat3 S = skew(body);
+            for (int i = 0; i < 2; i++)
+            {
+                std::array<float, N> H{};
+                for (int j = 0; j < 3; j++)
+                {
+                    H[ATTITUDE + j] = S[i][j];
+                    H[VELOCITY + j] = R[j][i];
+                }
+                if (_scalar(H, m.value[i] - body[i], m.variance))
+                    _aided = m.timestamp;
+            }
+            break;
+        }
+
+        case ekf_measurement::YAW:
+        {
+            // Small-tilt approximation: a body attitude error changes heading
+            // by the down component of its NED projection.
+            std::array<float, N> H{};
+            for (int j = 0; j < 3; j++)
+                H[ATTITUDE + j] = R[2][j];
+
+            float residual = m.value[0] - math::atan2(R[1][0], R[0][0]);
+            residual = residual > math::pi<float> ? residual - 2 * math::pi<float> : residual;
+            residual = residual < -math::pi<float> ? residual + 2 * math::pi<float> : residual;
+            _scalar(H, residual, m.variance);
+            break;
+        }
+        }
+    }
+
+    /**
+     * Fuses one scalar observation with Jacobian row `H` and injects the
+     * resulting error estimate into the nominal state.
+     */
+    constexpr bool _scalar(const std::array<float, N>& H, float residual, float variance)
+    {
+        std::array<float, N> PHt{};
+        float S = variance;
+        for (int i = 0; i < N; i++)
+        {
+            for (int j = 0; j < N; j++)
+                PHt[i] += _covariance[i][j] * H[j];
+            S += H[i] * PHt[i];
+        }
+
+        if (!(S > 0) || residual * residual > _params.gate * _params.gate * S)
+        {
+            _rejected++;
+            return false;
+        }
+
+        std::array<float, N> dx{};
+        for (int i = 0; i < N; i++)
+        {
+            float K = PHt[i] / S;
+            dx[i] = K * residual;
+            for (int j = 0; j < N; j++)
+                _covariance[i][j] -= K * PHt[j];
+        }
+
+        _delayed.attitude = (_delayed.attitude * quat{1, dx[ATTITUDE] / 2, dx[ATTITUDE + 1] / 2, dx[ATTITUDE + 2] / 2}).normalized();
+        for (int i = 0; i < 3; i++)
+        {
+            _delayed.velocity[i]   += dx[VELOCITY + i];
+            _delayed.position[i]   += dx[POSITION + i];
+            _delayed.gyro_bias[i]  += dx[GYRO_BIAS + i];
+            _delayed.accel_bias[i] += dx[ACCEL_BIAS + i];
+        }
+        return true;
+    }
+
+    static constexpr mat3 skew(const vec3& v)
+    {
+        return mat3{
+            vec3{0, -v[2], v[1]},
+            vec3{v[2], 0, -v[0]},
+            vec3{-v[1], v[0], 0}
+        };
+    }
+
+protected:
+
+    ekf_params _params;
+
+    state _delayed;
+    state _current;
+    covariance_type _covariance;
+    int64_t _time;
+
+    delta _accumulated;
+    std::array<delta, HISTORY> _history;
+    size_t _history_head;
+    size_t _history_size;
+
+    std::array<ekf_measurement, MEASUREMENTS> _measurements;
+    size_t _measurement_count;
+
+    uint32_t _rejected;
+    int64_t _aided;
+    bool _initialized;
+};
+
+static_assert([] {
+    // At rest with position fixes at the origin, the filter stays level and
+    // its position uncertainty shrinks.
+    ekf_params params;
+    params.delay = 0.02f;
+    ekf<8, 4> f(params);
+
+    vec3 gyro{}, accel{0, 0, -ekf<>::GRAVITY};
+    for (int i = 0; i <= 40; i++)
+    {
+        int64_t t = i * 5'000;
+        f.update(t, gyro, accel, 0.005f);
+        if (i % 4 == 0)
+            f.fuse(ekf_measurement{ekf_measurement::POSITION, t, vec3{}, 0.01f});
+    }
+
+    float variance = f.covariance()[ekf<>::POSITION][ekf<>::POSITION];
+    return variance < 0.05f && f.aided() > 0 && f.position().length() < 1e-3f && f.velocity().length() < 1e-3f
+        && math::abs(quaternion_to_euler(f.attitude())[0]) < 1e-4f;
+}());
+
+}
@@ -1,20 +0,0 @@
-#pragma once
-
-#include "driver/gpio.h"
-
-namespace lumina
-{
-
-class esc
-{
-public:
-
-    esc(int pin) {
-
-    }
-
-protected:
-
-};
-
-}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+
+#include <cstdint>
+
+#include "soc/soc_caps.h"
+#include "driver/mcpwm_prelude.h"
+
+#include "../check.hpp"
+#include "output.hpp"
+#include "pwm.hpp"
+
+namespace lumina
+{
+
+/**
+ * Analog ESC outputs (OneShot125, OneShot42, Multishot, PWM) on one MCPWM group.
+ *
+ * Every channel hangs off a single timer, two channels per operator, and
+ * compare values latch on the timer's zero event, so all pulses start on the
+ * same edge. Oneshot protocols run the timer for exactly one period per
+ * `write()`, right after the control loop produced the new outputs.
+ */
+template <size_t N>
+class pwm_group
+{
+    static_assert(N > 0 && N <= 2 * SOC_MCPWM_OPERATORS_PER_GROUP, "one MCPWM group drives at most 6 channels");
+
+    static constexpr size_t OPERATORS = (N + 1) / 2;
+
+public:
+
+    pwm_group(const std::array<int, N>& pins, pwm::protocol protocol, uint32_t rate_hz = pwm::PWM_RATE_MAX, int group = 0)
+    :   _timing(pwm::timing::make(protocol, rate_hz))
+    {
+        mcpwm_timer_config_t timer_config = {};
+        timer_config.group_id = group;
+        timer_config.clk_src = MCPWM_TIMER_CLK_SRC_DEFAULT;
+        timer_config.resolution_hz = _timing.resolution_hz;
+        timer_config.count_mode = MCPWM_TIMER_COUNT_MODE_UP;
+        timer_config.period_ticks = _timing.period_ticks;
+        ESP_CHECK(mcpwm_new_timer(&timer_config, &_timer));
+
+        for (size_t i = 0; i < OPERATORS; i++)
+        {
+            mcpwm_operator_config_t operator_config = {};
+            operator_config.group_id = group;
+            ESP_CHECK(mcpwm_new_operator(&operator_config, &_operators[i]));
+            ESP_CHECK(mcpwm_operator_connect_timer(_operators[i], _timer));
+        }
+
+        for (size_t i = 0; i < N; i++)
+        {
+            mcpwm_oper_handle_t oper = _operators[i / 2];
+
+            mcpwm_comparator_config_t comparator_config = {};
+            comparator_config.flags.update_cmp_on_tez = true;
+            ESP_CHECK(mcpwm_new_comparator(oper, &comparator_config, &_comparators[i]));
+            ESP_CHECK(mcpwm_comparator_set_compare_value(_comparators[i], _timing.min_ticks));
+
+            mcpwm_generator_config_t generator_config = {};
+            generator_config.gen_gpio_num = pins[i];
+            ESP_CHECK(mcpwm_new_generator(oper, &generator_config, &_generators[i]));
+
+            mcpwm_gen_timer_event_action_t on_empty = {};
+            on_empty.direction = MCPWM_TIMER_DIRECTION_UP;
+            on_empty.event = MCPWM_TIMER_EVENT_EMPTY;
+            on_empty.action = MCPWM_GEN_ACTION_HIGH;
+            ESP_CHECK(mcpwm_generator_set_action_on_timer_event(_generators[i], on_empty));
+
+            mcpwm_gen_compare_event_action_t on_compare = {};
+            on_compare.direction = MCPWM_TIMER_DIRECTION_UP;
+            on_compare.comparator = _comparators[i];
+            on_compare.action = MCPWM_GEN_ACTION_LOW;
+            ESP_CHECK(mcpwm_generator_set_action_on_compare_event(_generators[i], on_compare));
+        }
+
+        ESP_CHECK(mcpwm_timer_enable(_timer));
+
+        if (!_timing.oneshot)
+            ESP_CHECK(mcpwm_timer_start_stop(_timer, MCPWM_TIMER_START_NO_STOP));
+    }
+
+    pwm_group(const pwm_group&) = delete;
+    pwm_group& operator= (const pwm_group&) = delete;
+
+    ~pwm_group()
+    {
+        if (!_timing.oneshot)
+            ESP_CHECK(mcpwm_timer_start_stop(_timer, MCPWM_TIMER_STOP_EMPTY));
+        ESP_CHECK(mcpwm_timer_disable(_timer));
+
+        for (size_t i = 0; i < N; i++)
+        {
+            ESP_CHECK(mcpwm_del_generator(_generators[i]));
+            ESP_CHECK(mcpwm_del_comparator(_comparators[i]));
+        }
+        for (auto oper : _operators)
+            ESP_CHECK(mcpwm_del_operator(oper));
+
+        ESP_CHECK(mcpwm_del_timer(_timer));
+    }
+
+    static constexpr size_t size()
+    {
+        return N;
+    }
+
+    const pwm::timing& timing() const
+    {
+        return _timing;
+    }
+
+    /**
+     * Latches all throttles, normalized to [0, 1], for the next timer period.
+     * With a oneshot protocol this also fires that period.
+     */
+    void write(const std::array<float, N>& throttles)
+    {
+        for (size_t i = 0; i < N; i++)
+            mcpwm_comparator_set_compare_value(_comparators[i], _timing.pulse(throttles[i]));
+
+        if (_timing.oneshot)
+            mcpwm_timer_start_stop(_timer, MCPWM_TIMER_START_STOP_FULL);
+    }
+
+protected:
+
+    pwm::timing _timing;
+
+    mcpwm_timer_handle_t _timer;
+    std::array<mcpwm_oper_handle_t, OPERATORS> _operators;
+    std::array<mcpwm_cmpr_handle_t, N> _comparators;
+    std::array<mcpwm_gen_handle_t, N> _generators;
+};
+
+static_assert(motor_output<pwm_group<4>>);
+
+}
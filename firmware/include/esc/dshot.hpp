@@ -0,0 +1,381 @@
+#pragma once
+
+#include <array>
+#include <bit>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../placement.hpp"
+
+namespace lumina::dshot
+{
+
+/**
+ * DShot bit rates in kbit/s.
+ */
+enum class speed : uint32_t
+{
+    DSHOT150 = 150,
+    DSHOT300 = 300,
+    DSHOT600 = 600
+};
+
+/**
+ * Special commands sent in place of a throttle value (valid only with motors stopped).
+ */
+enum command : uint16_t
+{
+    MOTOR_STOP            = 0,
+    BEEP1                 = 1,
+    ESC_INFO              = 6,
+    SPIN_DIRECTION_1      = 7,
+    SPIN_DIRECTION_2      = 8,
+    MODE_3D_OFF           = 9,
+    SAVE_SETTINGS         = 12,
+    EXTENDED_TELEMETRY_ON = 13,
+    SPIN_DIRECTION_NORMAL = 20,
+    SPIN_DIRECTION_REVERSED = 21
+};
+
+static constexpr uint16_t THROTTLE_MIN = 48;
+static constexpr uint16_t THROTTLE_MAX = 2047;
+static constexpr int      FRAME_BITS   = 16;
+
+/**
+ * Maps a normalized throttle in [0, 1] onto the DShot throttle range.
+ * Zero maps to MOTOR_STOP rather than to the lowest spinning value.
+ */
+constexpr uint16_t LUMINA_HOT throttle(float value)
+{
+    if (!(value > 0)) return MOTOR_STOP;
+    if (value >= 1) return THROTTLE_MAX;
+    return static_cast<uint16_t>(THROTTLE_MIN + value * (THROTTLE_MAX - THROTTLE_MIN) + 0.5f);
+}
+
+/**
+ * Builds a 16-bit frame: 11-bit value, telemetry request bit and 4-bit checksum.
+ * Bidirectional (inverted) DShot transmits the complemented checksum.
+ */
+constexpr uint16_t LUMINA_HOT packet(uint16_t value, bool telemetry, bool inverted = false)
+{
+    uint16_t data = static_cast<uint16_t>(((value & 0x07FF) << 1) | (telemetry ? 1 : 0));
+    uint16_t crc  = (data ^ (data >> 4) ^ (data >> 8)) & 0x0F;
+    if (inverted)
+        crc = ~crc & 0x0F;
+    return static_cast<uint16_t>((data << 4) | crc);
+}
+
+/**
+ * Packs one RMT symbol word; bit layout matches `rmt_symbol_word_t`.
+ */
+constexpr uint32_t LUMINA_HOT symbol(uint16_t duration0, bool level0, uint16_t duration1, bool level1)
+{
+    return  (static_cast<uint32_t>(duration0 & 0x7FFF))       |
+            (static_cast<uint32_t>(level0)           << 15)   |
+            (static_cast<uint32_t>(duration1 & 0x7FFF) << 16) |
+            (static_cast<uint32_t>(level1)           << 31);
+}
+
+/**
+ * Bit timings in RMT ticks. A one is high for 3/4 of the bit period,
+ * a zero for 3/8, per the DShot specification.
+ */
+struct timing
+{
+    uint16_t one_high, one_low;
+    uint16_t zero_high, zero_low;
+    uint16_t pause;
+
+    static constexpr timing make(speed s, uint32_t resolution_hz)
+    {
+        uint32_t period = (resolution_hz + static_cast<uint32_t>(s) * 500) / (static_cast<uint32_t>(s) * 1000);
+        uint32_t one    = (period * 3 + 2) / 4;
+        uint32_t zero   = (period * 3 + 4) / 8;
+
+        // Idle line appended to every frame so back-to-back frames stay separable.
+        uint32_t pause  = resolution_hz / 500000;
+
+        return {
+            static_cast<uint16_t>(one),  static_cast<uint16_t>(period - one),
+            static_cast<uint16_t>(zero), static_cast<uint16_t>(period - zero),
+            static_cast<uint16_t>(pause)
+        };
+    }
+};
+
+/**
+ * Pre-encoded RMT symbol buffer for one DShot frame.
+ *
+ * `write()` only rewrites the symbols of bits that changed since the last
+ * frame, so steady throttle costs a compare and nothing else.
+ * `inverted` selects bidirectional DShot line levels (idle high).
+ */
+class frame
+{
+public:
+
+    static constexpr int SYMBOLS = FRAME_BITS + 1;
+
+public:
+
+    constexpr frame(timing t, bool inverted = false)
+    :   _timing(t),
+        _inverted(inverted),
+        _packet(0),
+        _symbols{}
+    {
+        for (int bit = 0; bit < FRAME_BITS; bit++)
+            _symbols[bit] = encode(false);
+        _symbols[FRAME_BITS] = symbol(_timing.pause, _inverted, _timing.pause, _inverted);
+    }
+
+    constexpr void LUMINA_HOT write(uint16_t packet)
+    {
+        uint16_t diff = packet ^ _packet;
+        _packet = packet;
+
+        while (diff)
+        {
+            int bit = std::countr_zero(diff);
+            _symbols[FRAME_BITS - 1 - bit] = encode((packet >> bit) & 1);
+            diff &= diff - 1;
+        }
+    }
+
+    constexpr uint16_t packet() const
+    {
+        return _packet;
+    }
+
+    constexpr const uint32_t* data() const
+    {
+        return _symbols.data();
+    }
+
+    static constexpr size_t size_bytes()
+    {
+        return SYMBOLS * sizeof(uint32_t);
+    }
+
+    constexpr const std::array<uint32_t, SYMBOLS>& symbols() const
+    {
+        return _symbols;
+    }
+
+protected:
+
+    constexpr uint32_t LUMINA_HOT encode(bool one) const
+    {
+        return one
+            ? symbol(_timing.one_high,  !_inverted, _timing.one_low,  _inverted)
+            : symbol(_timing.zero_high, !_inverted, _timing.zero_low, _inverted);
+    }
+
+    timing _timing;
+    bool _inverted;
+    uint16_t _packet;
+    std::array<uint32_t, SYMBOLS> _symbols;
+};
+
+
+/**
+ * Bidirectional DShot reply decoding.
+ *
+ * After every inverted frame the ESC answers on the same wire with 21 bits
+ * at 5/4 of the command bit rate. Level transitions encode ones (GCR/NRZI),
+ * the 20 transition bits are four 5-bit GCR groups carrying 16 bits, and
+ * those are 12 data bits plus a 4-bit checksum.
+ */
+namespace reply
+{
+
+static constexpr int      BITS     = 21;
+static constexpr uint32_t INVALID  = 0xFFFFFFFF;
+
+enum class type : uint8_t
+{
+    INVALID,
+    ERPM,
+    TEMPERATURE,
+    VOLTAGE,
+    CURRENT,
+    DEBUG1,
+    DEBUG2,
+    STRESS,
+    STATUS
+};
+
+struct value
+{
+    enum type type;
+    uint16_t  data;
+};
+
+/**
+ * Reply bit length in RMT ticks, as 24.8 fixed point.
+ */
+constexpr uint32_t bit_ticks(speed s, uint32_t resolution_hz)
+{
+    return static_cast<uint32_t>((static_cast<uint64_t>(resolution_hz) * 256 * 4) / (static_cast<uint64_t>(s) * 1000 * 5));
+}
+
+/**
+ * Rebuilds the 21 line levels (MSB first, idle high = 1) from captured RMT
+ * symbols. Idle time captured before the start bit is skipped and a capture
+ * that ends early is extended with idle level.
+ */
+constexpr uint32_t LUMINA_HOT levels(const uint32_t* symbols, size_t count, uint32_t bit_ticks)
+{
+    uint32_t bits = 0;
+    int n = 0;
+
+    // Both halves of each symbol in a plain loop: a lambda would be a
+    // separate function, outside IRAM.
+    for (size_t i = 0; i < count && n < BITS; i++)
+    {
+        for (int half = 0; half < 2; half++)
+        {
+            uint32_t word = symbols[i] >> (16 * half);
+            uint32_t duration = word & 0x7FFF, level = (word >> 15) & 1;
+            if (duration == 0 || (n == 0 && level))
+                continue;
+
+            int run = static_cast<int>((duration * 256 + bit_ticks / 2) / bit_ticks);
+            for (run = run ? run : 1; run > 0 && n < BITS; run--, n++)
+                bits = (bits << 1) | level;
+        }
+    }
+
+    for (; n < BITS; n++)
+        bits = (bits << 1) | 1;
+
+    return bits;
+}
+
+namespace detail
+{
+
+static constexpr uint8_t X = 0xFF;
+
+// Nibble of each 5-bit GCR code, X for codes outside the code. In DRAM,
+// since the RMT receive interrupt decodes every reply.
+LUMINA_HOT_DATA inline constexpr std::array<uint8_t, 32> GCR_TABLE = {
+    X, X, X, X, X, X, X, X, X, 9, 10, 11, X, 13, 14, 15,
+    X, X, 2, 3, X, 5, 6, 7, X, 0,  8,  1, X,  4, 12,  X
+};
+
+}
+
+/**
+ * Converts 21 line levels to the 16-bit payload, or INVALID on a bad GCR
+ * group or checksum.
+ */
+constexpr uint32_t LUMINA_HOT decode(uint32_t levels)
+{
+    uint32_t transitions = (levels ^ (levels >> 1)) & 0xFFFFF;
+
+    uint32_t payload = 0;
+    for (int group = 3; group >= 0; group--)
+    {
+        uint8_t nibble = detail::GCR_TABLE[(transitions >> (group * 5)) & 0x1F];
+        if (nibble == detail::X)
+            return INVALID;
+        payload = (payload << 4) | nibble;
+    }
+
+    uint32_t crc = payload ^ (payload >> 8);
+    crc ^= crc >> 4;
+    if ((crc & 0x0F) != 0x0F)
+        return INVALID;
+
+    return payload;
+}
+
+static_assert(static_cast<int>(type::STATUS) - static_cast<int>(type::TEMPERATURE) == 6,
+              "classify() maps EDT prefixes 0x2..0xE onto TEMPERATURE..STATUS in order");
+
+/**
+ * Classifies the 12-bit data of a decoded payload. With extended telemetry
+ * (EDT) enabled, a cleared mantissa MSB on a non-zero exponent marks a
+ * telemetry frame instead of an eRPM period. The EDT prefix is mapped
+ * arithmetically: a switch may compile to a jump table in flash.
+ */
+constexpr value LUMINA_HOT classify(uint32_t payload, bool edt)
+{
+    if (payload == INVALID)
+        return { type::INVALID, 0 };
+
+    uint16_t data = static_cast<uint16_t>(payload >> 4);
+
+    if (edt && (data & 0x100) == 0 && (data & 0xE00) != 0)
+        return { static_cast<type>(static_cast<int>(type::TEMPERATURE) + (data >> 9) - 1), static_cast<uint16_t>(data & 0xFF) };
+
+    return { type::ERPM, data };
+}
+
+/**
+ * Electrical RPM from a period-encoded eRPM value (3-bit shift, 9-bit period in us).
+ */
+constexpr uint32_t LUMINA_HOT erpm(uint16_t data)
+{
+    uint32_t period = static_cast<uint32_t>(data & 0x1FF) << (data >> 9);
+    if (period == 0 || data == 0x0FFF)
+        return 0;
+    return (60'000'000 + period / 2) / period;
+}
+
+/**
+ * Full pipeline from captured RMT symbols to a classified reply.
+ */
+constexpr value LUMINA_HOT parse(const uint32_t* symbols, size_t count, uint32_t bit_ticks, bool edt)
+{
+    return classify(decode(levels(symbols, count, bit_ticks)), edt);
+}
+
+}
+
+static_assert(packet(1046, false) == 0x82C6);
+static_assert(packet(0, false) == 0x0000);
+static_assert(packet(MOTOR_STOP, true, true) == 0x001E);
+static_assert(timing::make(speed::DSHOT600, 40'000'000).one_high == 50);
+static_assert(timing::make(speed::DSHOT600, 40'000'000).zero_high == 25);
+
+static_assert([] {
+    constexpr timing t = timing::make(speed::DSHOT600, 40'000'000);
+    frame incremental(t), fresh(t);
+    incremental.write(packet(1000, false));
+    incremental.write(packet(1046, false));
+    fresh.write(packet(1046, false));
+    return incremental.symbols() == fresh.symbols()
+        && fresh.symbols()[0] == symbol(t.one_high, true, t.one_low, false)
+        && fresh.symbols()[1] == symbol(t.zero_high, true, t.zero_low, false);
+}());
+
+static_assert([] {
+    // Encode payload 0x5A3 (eRPM period 0x1A3 << 2 us) with its checksum,
+    // GCR it, NRZI it onto line levels and check the decoder recovers it.
+    constexpr uint8_t gcr[16] = { 0x19, 0x1B, 0x12, 0x13, 0x1D, 0x15, 0x16, 0x17,
+                                  0x1A, 0x09, 0x0A, 0x0B, 0x1E, 0x0D, 0x0E, 0x0F };
+    uint32_t data = 0x5A3;
+    uint32_t crc = (~(data ^ (data >> 4) ^ (data >> 8))) & 0x0F;
+    uint32_t payload = (data << 4) | crc;
+
+    uint32_t transitions = 0;
+    for (int group = 3; group >= 0; group--)
+        transitions = (transitions << 5) | gcr[(payload >> (group * 4)) & 0x0F];
+
+    uint32_t level = 0, levels = 0;
+    for (int bit = 19; bit >= 0; bit--)
+    {
+        level ^= (transitions >> bit) & 1;
+        levels = (levels << 1) | level;
+    }
+
+    reply::value v = reply::classify(reply::decode(levels), true);
+    return v.type == reply::type::ERPM && v.data == data
+        && reply::erpm(v.data) == (60'000'000 + (0x1A3 << 2) / 2) / (0x1A3 << 2)
+        && reply::decode(levels ^ 0x10) == reply::INVALID;
+}());
+
+}
@@ -0,0 +1,321 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <utility>
+
+#include <cstdint>
+
+#include "esp_attr.h"
+#include "soc/soc_caps.h"
+#include "driver/gpio.h"
+#include "driver/rmt_tx.h"
+#include "driver/rmt_rx.h"
+
+#include "../check.hpp"
+#include "dshot.hpp"
+#include "output.hpp"
+
+namespace lumina
+{
+
+/**
+ * DShot ESC output on one RMT TX channel.
+ *
+ * Frames are kept pre-encoded in two symbol buffers: one is being clocked out
+ * by the peripheral while the other is updated, and only bits that changed
+ * since that buffer was last sent are re-encoded.
+ *
+ * In bidirectional mode the line is inverted and open-drain, and an RX
+ * channel on the same pin is armed at the end of every frame to capture
+ * the ESC's GCR reply, which is decoded to eRPM or extended telemetry in
+ * the receive interrupt.
+ */
+class esc
+{
+public:
+
+    static constexpr uint32_t RESOLUTION_HZ = 40'000'000;
+
+    struct telemetry
+    {
+        uint32_t erpm;
+        uint16_t voltage_mv;
+        uint8_t  temperature;
+        uint8_t  current;
+        uint32_t errors;
+    };
+
+public:
+
+    esc(int pin, dshot::speed speed = dshot::speed::DSHOT600, bool bidirectional = false)
+    :   _frames{ dshot::frame(dshot::timing::make(speed, RESOLUTION_HZ), bidirectional), dshot::frame(dshot::timing::make(speed, RESOLUTION_HZ), bidirectional) },
+        _back(0),
+        _bidirectional(bidirectional),
+        _edt(false),
+        _bit_ticks(dshot::reply::bit_ticks(speed, RESOLUTION_HZ)),
+        _rx_channel(nullptr),
+        _erpm(0), _voltage_mv(0), _temperature(0), _current(0), _errors(0)
+    {
+        if (_bidirectional)
+        {
+            // The RX channel has to exist before the TX channel loops the pin back.
+            rmt_rx_channel_config_t rx_config = {};
+            rx_config.gpio_num = static_cast<gpio_num_t>(pin);
+            rx_config.clk_src = RMT_CLK_SRC_DEFAULT;
+            rx_config.resolution_hz = RESOLUTION_HZ;
+            rx_config.mem_block_symbols = SOC_RMT_MEM_WORDS_PER_CHANNEL;
+            ESP_CHECK(rmt_new_rx_channel(&rx_config, &_rx_channel));
+
+            rmt_rx_event_callbacks_t rx_callbacks = {};
+            rx_callbacks.on_recv_done = &esc::_on_receive;
+            ESP_CHECK(rmt_rx_register_event_callbacks(_rx_channel, &rx_callbacks, this));
+
+            // Glitch filter well below a reply bit, idle threshold above the
+            // longest GCR run of three bits.
+            uint32_t bit_ns = 800'000 / static_cast<uint32_t>(speed);
+            _receive_config = {};
+            _receive_config.signal_range_min_ns = 300;
+            _receive_config.signal_range_max_ns = 4 * bit_ns;
+
+            ESP_CHECK(rmt_enable(_rx_channel));
+        }
+
+        // A frame is 17 symbols, so it always fits the channel's own memory
+        // block and is sent without DMA or refill interrupts.
+        rmt_tx_channel_config_t channel_config = {};
+        channel_config.gpio_num = static_cast<gpio_num_t>(pin);
+        channel_config.clk_src = RMT_CLK_SRC_DEFAULT;
+        channel_config.resolution_hz = RESOLUTION_HZ;
+        channel_config.mem_block_symbols = SOC_RMT_MEM_WORDS_PER_CHANNEL;
+        channel_config.trans_queue_depth = 2;
+        channel_config.flags.io_loop_back = _bidirectional;
+        channel_config.flags.io_od_mode = _bidirectional;
+        ESP_CHECK(rmt_new_tx_channel(&channel_config, &_channel));
+
+        if (_bidirectional)
+        {
+            rmt_tx_event_callbacks_t tx_callbacks = {};
+            tx_callbacks.on_trans_done = &esc::_on_transmitted;
+            ESP_CHECK(rmt_tx_register_event_callbacks(_channel, &tx_callbacks, this));
+        }
+
+        rmt_copy_encoder_config_t encoder_config = {};
+        ESP_CHECK(rmt_new_copy_encoder(&encoder_config, &_encoder));
+
+        ESP_CHECK(rmt_enable(_channel));
+    }
+
+    esc(const esc&) = delete;
+    esc& operator= (const esc&) = delete;
+
+    ~esc()
+    {
+        ESP_CHECK(rmt_disable(_channel));
+        ESP_CHECK(rmt_del_encoder(_encoder));
+        ESP_CHECK(rmt_del_channel(_channel));
+
+        if (_rx_channel)
+        {
+            ESP_CHECK(rmt_disable(_rx_channel));
+            ESP_CHECK(rmt_del_channel(_rx_channel));
+        }
+    }
+
+    /**
+     * Sets the throttle for the next frame, normalized to [0, 1].
+     */
+    void LUMINA_HOT throttle(float value)
+    {
+        command(dshot::throttle(value));
+    }
+
+    /**
+     * Sets a raw 11-bit DShot value (command or throttle) for the next frame.
+     */
+    void command(uint16_t value, bool telemetry = false)
+    {
+        _frames[_back].write(dshot::packet(value, telemetry, _bidirectional));
+    }
+
+    /**
+     * Queues the pending frame. On a channel that belongs to an `esc_group`
+     * the peripheral holds it until every channel of the group is queued.
+     */
+    void transmit()
+    {
+        rmt_transmit_config_t config = {};
+        config.loop_count = 0;
+        config.flags.eot_level = _bidirectional;
+
+        const dshot::frame& frame = _frames[_back];
+        ESP_CHECK(rmt_transmit(_channel, _encoder, frame.data(), frame.size_bytes(), &config));
+
+        _back ^= 1;
+    }
+
+    rmt_channel_handle_t channel() const
+    {
+        return _channel;
+    }
+
+    /**
+     * Decode EDT frames in replies. The ESC only sends them after it has
+     * received `dshot::EXTENDED_TELEMETRY_ON` with the telemetry bit set.
+     */
+    void extended_telemetry(bool enable)
+    {
+        _edt.store(enable, std::memory_order_relaxed);
+    }
+
+    /**
+     * Latest electrical RPM reported by the ESC, 0 when stopped or unknown.
+     * Divide by the number of pole pairs for mechanical RPM.
+     */
+    uint32_t erpm() const
+    {
+        return _erpm.load(std::memory_order_relaxed);
+    }
+
+    struct telemetry telemetry() const
+    {
+        return {
+            _erpm.load(std::memory_order_relaxed),
+            _voltage_mv.load(std::memory_order_relaxed),
+            _temperature.load(std::memory_order_relaxed),
+            _current.load(std::memory_order_relaxed),
+            _errors.load(std::memory_order_relaxed)
+        };
+    }
+
+protected:
+
+    static bool IRAM_ATTR _on_transmitted(rmt_channel_handle_t, const rmt_tx_done_event_data_t*, void* arg)
+    {
+        auto& esc = *static_cast<lumina::esc*>(arg);
+        rmt_receive(esc._rx_channel, esc._rx_symbols.data(), sizeof(esc._rx_symbols), &esc._receive_config);
+        return false;
+    }
+
+    static bool IRAM_ATTR _on_receive(rmt_channel_handle_t, const rmt_rx_done_event_data_t* event, void* arg)
+    {
+        auto& esc = *static_cast<lumina::esc*>(arg);
+
+        auto symbols = reinterpret_cast<const uint32_t*>(event->received_symbols);
+        dshot::reply::value reply = dshot::reply::parse(symbols, event->num_symbols, esc._bit_ticks,
+                                                        esc._edt.load(std::memory_order_relaxed));
+
+        // Compared in turn, eRPM first: GCC may put a switch's jump table in
+        // .rodata, which is flash.
+        using type = dshot::reply::type;
+        if (reply.type == type::ERPM)
+            esc._erpm.store(dshot::reply::erpm(reply.data), std::memory_order_relaxed);
+        else if (reply.type == type::TEMPERATURE)
+            esc._temperature.store(reply.data, std::memory_order_relaxed);
+        else if (reply.type == type::VOLTAGE)
+            esc._voltage_mv.store(reply.data * 250, std::memory_order_relaxed);
+        else if (reply.type == type::CURRENT)
+            esc._current.store(reply.data, std::memory_order_relaxed);
+        else if (reply.type == type::INVALID)
+            esc._errors.fetch_add(1, std::memory_order_relaxed);
+
+        return false;
+    }
+
+protected:
+
+    rmt_channel_handle_t _channel;
+    rmt_encoder_handle_t _encoder;
+
+    std::array<dshot::frame, 2> _frames;
+    int _back;
+
+    bool _bidirectional;
+    std::atomic<bool> _edt;         // set by tasks, read in the receive interrupt
+    uint32_t _bit_ticks;
+
+    rmt_channel_handle_t _rx_channel;
+    rmt_receive_config_t _receive_config;
+    std::array<rmt_symbol_word_t, SOC_RMT_MEM_WORDS_PER_CHANNEL> _rx_symbols;
+
+    std::atomic<uint32_t> _erpm;
+    std::atomic<uint16_t> _voltage_mv;
+    std::atomic<uint8_t>  _temperature;
+    std::atomic<uint8_t>  _current;
+    std::atomic<uint32_t> _errors;
+};
+
+
+/**
+ * A fixed set of ESCs whose frames leave the pins on the same clock edge.
+ */
+template <size_t N>
+class esc_group
+{
+public:
+
+    esc_group(const std::array<int, N>& pins, dshot::speed speed = dshot::speed::DSHOT600, bool bidirectional = false)
+    :   esc_group(pins, speed, bidirectional, std::make_index_sequence<N>{})
+    {}
+
+    esc_group(const esc_group&) = delete;
+    esc_group& operator= (const esc_group&) = delete;
+
+    ~esc_group()
+    {
+        ESP_CHECK(rmt_del_sync_manager(_sync));
+    }
+
+    esc& operator[] (size_t i)
+    {
+        return _escs[i];
+    }
+
+    static constexpr size_t size()
+    {
+        return N;
+    }
+
+    uint32_t erpm(size_t i) const
+    {
+        return _escs[i].erpm();
+    }
+
+    /**
+     * Encodes all throttles and sends them as one synchronized transaction.
+     */
+    void LUMINA_HOT write(const std::array<float, N>& throttles)
+    {
+        for (size_t i = 0; i < N; i++)
+            _escs[i].throttle(throttles[i]);
+        transmit();
+    }
+
+    void transmit()
+    {
+        for (auto& esc : _escs)
+            esc.transmit();
+    }
+
+protected:
+
+    template <size_t... I>
+    esc_group(const std::array<int, N>& pins, dshot::speed speed, bool bidirectional, std::index_sequence<I...>)
+    :   _escs{ esc(pins[I], speed, bidirectional)... }
+    {
+        rmt_channel_handle_t channels[N] = { _escs[I].channel()... };
+
+        rmt_sync_manager_config_t config = {};
+        config.tx_channel_array = channels;
+        config.array_size = N;
+        ESP_CHECK(rmt_new_sync_manager(&config, &_sync));
+    }
+
+    std::array<esc, N> _escs;
+    rmt_sync_manager_handle_t _sync;
+};
+
+static_assert(motor_output<esc_group<4>>);
+static_assert(rpm_source<esc_group<4>>);
+
+}
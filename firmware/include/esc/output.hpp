@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <concepts>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lumina
+{
+
+/**
+ * A fixed set of motor outputs updated together once per control loop with
+ * normalized throttles in [0, 1]. Implemented by `esc_group` (DShot) and
+ * `pwm_group` (analog protocols), so the mixer can drive either.
+ */
+template <typename T>
+concept motor_output = requires(T& output, const std::array<float, T::size()>& throttles)
+{
+    { T::size() } -> std::convertible_to<size_t>;
+    output.write(throttles);
+};
+
+/**
+ * Per-motor electrical RPM, e.g. from bidirectional DShot telemetry
+ * (`esc_group`) or from a simulator's motor model. 0 means stopped or
+ * unknown.
+ */
+template <typename T>
+concept rpm_source = requires(const T& source, size_t i)
+{
+    { T::size() } -> std::convertible_to<size_t>;
+    { source.erpm(i) } -> std::convertible_to<uint32_t>;
+};
+
+}
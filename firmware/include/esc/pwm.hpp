@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+
+namespace lumina::pwm
+{
+
+/**
+ * Analog ESC protocols. The oneshot family fires a single pulse per control
+ * loop; PWM free-runs at a fixed refresh rate.
+ */
+enum class protocol
+{
+    ONESHOT125,
+    ONESHOT42,
+    MULTISHOT,
+    PWM
+};
+
+static constexpr uint32_t PWM_RATE_MIN = 50;
+static constexpr uint32_t PWM_RATE_MAX = 490;
+
+/**
+ * Pulse timing of a protocol in timer ticks.
+ *
+ * The tick resolution is chosen per protocol so that the throttle range spans
+ * at least 800 ticks and the period still fits a 16-bit timer. All chosen
+ * resolutions divide the 160 MHz MCPWM source clock.
+ */
+struct timing
+{
+    uint32_t resolution_hz;
+    uint32_t min_ticks;
+    uint32_t max_ticks;
+    uint32_t period_ticks;
+    bool     oneshot;
+
+    /**
+     * @param rate_hz Refresh rate for `PWM`, clamped to 50–490 Hz. Ignored for oneshot protocols.
+     */
+    static constexpr timing make(protocol p, uint32_t rate_hz = PWM_RATE_MAX)
+    {
+        switch (p)
+        {
+            case protocol::ONESHOT125:
+                return from_us(8'000'000, 125, 250, true);
+
+            case protocol::ONESHOT42:
+                return from_us(20'000'000, 42, 84, true);
+
+            case protocol::MULTISHOT:
+                return from_us(80'000'000, 5, 25, true);
+
+            case protocol::PWM:
+            default:
+            {
+                if (rate_hz < PWM_RATE_MIN) rate_hz = PWM_RATE_MIN;
+                if (rate_hz > PWM_RATE_MAX) rate_hz = PWM_RATE_MAX;
+
+                timing t = from_us(1'000'000, 1000, 2000, false);
+                t.period_ticks = t.resolution_hz / rate_hz;
+                return t;
+            }
+        }
+    }
+
+    /**
+     * Pulse width in ticks for a normalized throttle in [0, 1].
+     */
+    constexpr uint32_t pulse(float throttle) const
+    {
+        if (!(throttle > 0)) return min_ticks;
+        if (throttle >= 1) return max_ticks;
+        return min_ticks + static_cast<uint32_t>(throttle * (max_ticks - min_ticks) + 0.5f);
+    }
+
+protected:
+
+    static constexpr timing from_us(uint32_t resolution_hz, uint32_t min_us, uint32_t max_us, bool oneshot)
+    {
+        uint32_t ticks_per_us = resolution_hz / 1'000'000;
+        uint32_t max_ticks = max_us * ticks_per_us;
+
+        // Oneshot pulses get a 5% guard after the longest pulse before the
+        // timer stops, so the falling edge is never cut off.
+        return { resolution_hz, min_us * ticks_per_us, max_ticks, max_ticks + max_ticks / 20, oneshot };
+    }
+};
+
+static_assert(timing::make(protocol::ONESHOT125).pulse(0) == 1000);
+static_assert(timing::make(protocol::ONESHOT125).pulse(1) == 2000);
+static_assert(timing::make(protocol::ONESHOT42).pulse(0.5f) == 1260);
+static_assert(timing::make(protocol::MULTISHOT).pulse(1) == 2000);
+static_assert(timing::make(protocol::PWM, 50).period_ticks == 20000);
+static_assert(timing::make(protocol::PWM, 1000).period_ticks == 2040);
+static_assert(timing::make(protocol::MULTISHOT).period_ticks < 65536);
+
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <array>
+
+#include <cstddef>
+
+#include "math.hpp"
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#include "dsps_fft2r.h"
+#define LUMINA_HAS_ESP_DSP_FFT 1
+#else
+#define LUMINA_HAS_ESP_DSP_FFT 0
+#endif
+
+namespace lumina
+{
+
+#if LUMINA_HAS_ESP_DSP_FFT
+namespace detail
+{
+
+// esp-dsp keeps one global twiddle table, sized for the largest transform.
+inline void esp_dsp_fft_init()
+{
+    static const bool ready = dsps_fft2r_init_fc32(nullptr, CONFIG_DSP_MAX_FFT_SIZE) == ESP_OK;
+    (void)ready;
+}
+
+}
+#endif
+
+
+/**
+ * Radix-2 FFT of N real samples.
+ *
+ * The samples are packed as N/2 complex values, transformed in place and
+ * split into the N/2 + 1 non-negative frequency bins, which halves the work
+ * of a complex transform. Bins are stored interleaved as {re, im}, except
+ * that the imaginary slot of bin 0 holds the real Nyquist bin.
+ *
+ * The transform runs in `STEPS` slices so a caller can spread it across
+ * loop iterations. On target the complex transform is esp-dsp's and takes a
+ * single slice; the portable one does one butterfly stage per slice. The
+ * esp-dsp transform needs `data` aligned to 16 bytes.
+ */
+template <size_t N>
+class real_fft
+{
+    static_assert(N >= 8 && (N & (N - 1)) == 0, "N must be a power of two");
+
+public:
+
+    static constexpr size_t BINS = N / 2 + 1;
+
+    static constexpr int LOG2 = [] {
+        int n = 0;
+        for (size_t m = N / 2; m > 1; m >>= 1)
+            n++;
+        return n;
+    }();
+
+#if LUMINA_HAS_ESP_DSP_FFT
+    static constexpr int STEPS = 2;
+#else
+    static constexpr int STEPS = LOG2 + 2;
+#endif
+
+public:
+
+    constexpr real_fft()
+    :   _twiddle{}
+    {
+        for (size_t k = 0; k < N / 2; k++)
+        {
+            float w = -2 * math::pi<float> * k / N;
+            _twiddle[2 * k] = math::cos(w);
+            _twiddle[2 * k + 1] = math::sin(w);
+        }
+
+#if LUMINA_HAS_ESP_DSP_FFT
+        if (!std::is_constant_evaluated())
+            detail::esp_dsp_fft_init();
+#endif
+    }
+
+    /**
+     * Runs slice `i` of the transform on `data`, N floats.
+     */
+    constexpr void step(float* data, int i) const
+    {
+        if (i == STEPS - 1)
+            return _split(data);
+
+#if LUMINA_HAS_ESP_DSP_FFT
+        if (!std::is_constant_evaluated())
+        {
+            dsps_fft2r_fc32(data, N / 2);
+            dsps_bit_rev_fc32(data, N / 2);
+            return;
+        }
+        for (int s = 0; s <= LOG2; s++)
+            _portable(data, s);
+#else
+        _portable(data, i);
+#endif
+    }
+
+    constexpr void transform(float* data) const
+    {
+        for (int i = 0; i < STEPS; i++)
+            step(data, i);
+    }
+
+    /**
+     * Squared magnitude of bin `k` of a transformed buffer.
+     */
+    static constexpr float power(const float* data, size_t k)
+    {
+        if (k == 0)
+            return data[0] * data[0];
+        if (k == N / 2)
+            return data[1] * data[1];
+        return data[2 * k] * data[2 * k] + data[2 * k + 1] * data[2 * k + 1];
+    }
+
+protected:
+
+    // Slice 0 is the bit reversal, slice s the butterflies of span 2^s.
+    constexpr void _portable(float* data, int s) const
+    {
+        constexpr size_t M = N / 2;
+
+        if (s == 0)
+        {
+            for (size_t i = 1, j = 0; i < M; i++)
+            {
+                size_t bit = M >> 1;
+                for (; j & bit; bit >>= 1)
+                    j ^= bit;
+                j ^= bit;
+
+                if (i < j)
+                {
+                    float re = data[2 * i], im = data[2 * i + 1];
+                    data[2 * i] = data[2 * j];
+                    data[2 * i + 1] = data[2 * j + 1];
+                    data[2 * j] = re;
+                    data[2 * j + 1] = im;
+                }
+            }
+            return;
+        }
+
+        size_t half = size_t(1) << (s - 1);
+        size_t stride = 2 * (M / (2 * half));
+        for (size_t start = 0; start < M; start += 2 * half)
+        {
+            for (size_t j = 0; j < half; j++)
+            {
+                float wr = _twiddle[2 * j * stride], wi = _twiddle[2 * j * stride + 1];
+                size_t a = 2 * (start + j), b = 2 * (start + j + half);
+
+                float tr = data[b] * wr - data[b + 1] * wi;
+                float ti = data[b] * wi + data[b + 1] * wr;
+                data[b] = data[a] - tr;
+                data[b + 1] = data[a + 1] - ti;
+                data[a] += tr;
+                data[a + 1] += ti;
+            }
+        }
+    }
+
+    // Separates the even/odd sample spectra of the packed transform and
+    // recombines them into the real spectrum, bins k and M - k at a time.
+    constexpr void _split(float* data) const
+    {
+        constexpr size_t M = N / 2;
+
+        float dc = data[0];
+        data[0] = dc + data[1];
+        data[1] = dc - data[1];
+
+        for (size_t k = 1; k <= M / 2; k++)
+        {
+            size_t a = 2 * k, b = 2 * (M - k);
+
+            float er = (data[a] + data[b]) / 2,         ei = (data[a + 1] - data[b + 1]) / 2;
+            float odd_r = (data[a + 1] + data[b + 1]) / 2, odd_i = (data[b] - data[a]) / 2;
+
+            float wr = _twiddle[2 * k], wi = _twiddle[2 * k + 1];
+            float tr = odd_r * wr - odd_i * wi, ti = odd_r * wi + odd_i * wr;
+
+            data[a] = er + tr;
+            data[a + 1] = ei + ti;
+            if (a != b)
+            {
+                // Bin M - k: conjugated halves and W^(M-k) = -conj(W^k).
+                data[b] = er - tr;
+                data[b + 1] = -ei + ti;
+            }
+        }
+    }
+
+protected:
+
+    std::array<float, N> _twiddle;
+};
+
+static_assert([] {
+    // Tone on bin 5 plus DC and Nyquist components: matches a direct DFT.
+    constexpr size_t N = 32;
+    float x[N] = {}, data[N] = {};
+    for (size_t i = 0; i < N; i++)
+        data[i] = x[i] = 0.5f + math::cos(2 * math::pi<float> * 5 * i / N + 0.3f) + (i % 2 ? -0.25f : 0.25f);
+
+    real_fft<N>{}.transform(data);
+
+    for (size_t k = 0; k <= N / 2; k++)
+    {
+        float re = 0, im = 0;
+        for (size_t i = 0; i < N; i++)
+        {
+            re += x[i] * math::cos(2 * math::pi<float> * k * i / N);
+            im -= x[i] * math::sin(2 * math::pi<float> * k * i / N);
+        }
+        if (math::abs(real_fft<N>::power(data, k) - (re * re + im * im)) > 1e-2f)
+            return false;
+    }
+    return true;
+}());
+
+}
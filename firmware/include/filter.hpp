@@ -0,0 +1,365 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include <cstddef>
+
+#include "math.hpp"
+#include "vec.hpp"
+#include "placement.hpp"
+
+#ifdef ESP_PLATFORM
+#include "dsps_biquad.h"
+#define LUMINA_HAS_ESP_DSP 1
+#else
+#define LUMINA_HAS_ESP_DSP 0
+#endif
+
+namespace lumina
+{
+
+/**
+ * Normalized biquad coefficients {b0, b1, b2, a1, a2} (a0 = 1), in the
+ * layout esp-dsp expects. Designs follow the RBJ audio EQ cookbook.
+ */
+struct biquad_coefficients : std::array<float, 5>
+{
+    static constexpr biquad_coefficients passthrough()
+    {
+        return {{1, 0, 0, 0, 0}};
+    }
+
+    static constexpr biquad_coefficients lowpass(float cutoff_hz, float sample_hz, float q = 0.70710678f)
+    {
+        auto [c, alpha] = _prewarp(cutoff_hz, sample_hz, q);
+        return _normalize((1 - c) / 2, 1 - c, (1 - c) / 2, 1 + alpha, -2 * c, 1 - alpha);
+    }
+
+    static constexpr biquad_coefficients notch(float center_hz, float sample_hz, float q)
+    {
+        auto [c, alpha] = _prewarp(center_hz, sample_hz, q);
+        return _normalize(1, -2 * c, 1, 1 + alpha, -2 * c, 1 - alpha);
+    }
+
+    /**
+     * Constant 0 dB peak gain band-pass.
+     */
+    static constexpr biquad_coefficients bandpass(float center_hz, float sample_hz, float q)
+    {
+        auto [c, alpha] = _prewarp(center_hz, sample_hz, q);
+        return _normalize(alpha, 0, -alpha, 1 + alpha, -2 * c, 1 - alpha);
+    }
+
+    /**
+     * Notch Q for a -3 dB band between `low_hz` and `center_hz`'s mirror image.
+     */
+    static constexpr float notch_q(float center_hz, float low_hz)
+    {
+        float high_hz = center_hz * center_hz / low_hz;
+        return center_hz / (high_hz - low_hz);
+    }
+
+    /**
+     * Magnitude of the frequency response at `hz`.
+     */
+    constexpr float gain(float hz, float sample_hz) const
+    {
+        const auto& k = *this;
+        float w = 2 * math::pi<float> * hz / sample_hz;
+        float c1 = math::cos(w), s1 = math::sin(w), c2 = math::cos(2 * w), s2 = math::sin(2 * w);
+
+        float nr = k[0] + k[1] * c1 + k[2] * c2, ni = -(k[1] * s1 + k[2] * s2);
+        float dr = 1 + k[3] * c1 + k[4] * c2,    di = -(k[3] * s1 + k[4] * s2);
+        return math::sqrt((nr * nr + ni * ni) / (dr * dr + di * di));
+    }
+
+protected:
+
+    struct prewarp { float c, alpha; };
+
+    static constexpr prewarp _prewarp(float hz, float sample_hz, float q)
+    {
+        float limit = 0.48f * sample_hz;
+        float w = 2 * math::pi<float> * (hz < limit ? hz : limit) / sample_hz;
+        return {math::cos(w), math::sin(w) / (2 * q)};
+    }
+
+    static constexpr biquad_coefficients _normalize(float b0, float b1, float b2, float a0, float a1, float a2)
+    {
+        return {{b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0}};
+    }
+};
+
+
+/**
+ * Direct form II biquad with hot-swappable coefficients.
+ *
+ * `retune()` may be called from another task: it fills a pending slot and
+ * raises a flag, and the filtering task adopts the new set at the start of
+ * its next sample or block, so a coefficient set is never observed half
+ * written. A retune is refused while the previous one is still pending.
+ *
+ * `process()` runs a block through esp-dsp's optimized biquad when the
+ * component is available; both paths share the same state layout.
+ */
+class biquad
+{
+public:
+
+    constexpr biquad(const biquad_coefficients& coefficients = biquad_coefficients::passthrough())
+    :   _active(coefficients),
+        _pending(coefficients),
+        _state{},
+        _dirty(false)
+    {}
+
+    biquad(const biquad& other)
+    :   biquad(other._active)
+    {}
+
+    biquad& operator= (const biquad& other)
+    {
+        _active = other._active;
+        _state = {};
+        return *this;
+    }
+
+    bool retune(const biquad_coefficients& coefficients)
+    {
+        if (_dirty.load(std::memory_order_acquire))
+            return false;
+        _pending = coefficients;
+        _dirty.store(true, std::memory_order_release);
+        return true;
+    }
+
+    void reset()
+    {
+        _state = {};
+    }
+
+    float LUMINA_HOT operator() (float x)
+    {
+        _swap();
+        return _step(x);
+    }
+
+    void LUMINA_HOT process(const float* in, float* out, size_t n)
+    {
+        _swap();
+#if LUMINA_HAS_ESP_DSP
+        dsps_biquad_f32(in, out, static_cast<int>(n), _active.data(), _state.data());
+#else
+        for (size_t i = 0; i < n; i++)
+            out[i] = _step(in[i]);
+#endif
+    }
+
+    const biquad_coefficients& coefficients() const
+    {
+        return _active;
+    }
+
+protected:
+
+    void _swap()
+    {
+        if (_dirty.load(std::memory_order_acquire))
+        {
+            _active = _pending;
+            _dirty.store(false, std::memory_order_release);
+        }
+    }
+
+    constexpr float LUMINA_HOT _step(float x)
+    {
+        const auto& k = _active;
+        float w = x - k[3] * _state[0] - k[4] * _state[1];
+        float y = k[0] * w + k[1] * _state[0] + k[2] * _state[1];
+        _state[1] = _state[0];
+        _state[0] = w;
+        return y;
+    }
+
+protected:
+
+    biquad_coefficients _active;
+    biquad_coefficients _pending;
+    std::array<float, 2> _state;
+    std::atomic<bool> _dirty;
+};
+
+
+/**
+ * First-order lowpass. The single coefficient is swapped atomically, so it
+ * can be retuned from any task.
+ */
+class pt1
+{
+public:
+
+    pt1(float cutoff_hz = 0, float sample_hz = 1)
+    :   _k(gain(cutoff_hz, sample_hz)),
+        _y(0)
+    {}
+
+    pt1(const pt1& other)
+    :   _k(other._k.load(std::memory_order_relaxed)),
+        _y(0)
+    {}
+
+    pt1& operator= (const pt1& other)
+    {
+        _k.store(other._k.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        _y = 0;
+        return *this;
+    }
+
+    static constexpr float gain(float cutoff_hz, float sample_hz)
+    {
+        if (cutoff_hz <= 0)
+            return 1;
+        float rc = 1 / (2 * math::pi<float> * cutoff_hz);
+        float dt = 1 / sample_hz;
+        return dt / (rc + dt);
+    }
+
+    void retune(float cutoff_hz, float sample_hz)
+    {
+        _k.store(gain(cutoff_hz, sample_hz), std::memory_order_relaxed);
+    }
+
+    void reset(float value = 0)
+    {
+        _y = value;
+    }
+
+    float LUMINA_HOT operator() (float x)
+    {
+        return _y += _k.load(std::memory_order_relaxed) * (x - _y);
+    }
+
+protected:
+
+    std::atomic<float> _k;
+    float _y;
+};
+
+
+/**
+ * `ORDER` cascaded PT1 stages whose cutoff is raised so the cascade is
+ * -3 dB at the requested frequency.
+ */
+template <int ORDER>
+class ptn
+{
+    static_assert(ORDER >= 1 && ORDER <= 3);
+
+public:
+
+    // 1 / sqrt(2^(1/n) - 1)
+    static constexpr float CORRECTION = ORDER == 1 ? 1.f : (ORDER == 2 ? 1.553773974f : 1.961459177f);
+
+    ptn(float cutoff_hz = 0, float sample_hz = 1)
+    {
+        retune(cutoff_hz, sample_hz);
+    }
+
+    void retune(float cutoff_hz, float sample_hz)
+    {
+        for (auto& stage : _stages)
+            stage.retune(cutoff_hz * CORRECTION, sample_hz);
+    }
+
+    void reset(float value = 0)
+    {
+        for (auto& stage : _stages)
+            stage.reset(value);
+    }
+
+    float LUMINA_HOT operator() (float x)
+    {
+        for (auto& stage : _stages)
+            x = stage(x);
+        return x;
+    }
+
+protected:
+
+    std::array<pt1, ORDER> _stages;
+};
+
+using pt2 = ptn<2>;
+using pt3 = ptn<3>;
+
+
+/**
+ * Independent copies of one filter type, one per axis.
+ *
+ * Samples go through as `vec`, or as per-axis blocks (one contiguous array
+ * per axis) where the filter has a block path.
+ */
+template <typename F, int N = 3>
+class filter_bank
+{
+public:
+
+    filter_bank() = default;
+
+    template <typename... Args>
+    filter_bank(const Args&... args)
+    {
+        for (auto& f : _filters)
+            f = F(args...);
+    }
+
+    /**
+     * Retunes every axis with the same arguments.
+     */
+    template <typename... Args>
+    void retune(const Args&... args)
+    {
+        for (auto& f : _filters)
+            f.retune(args...);
+    }
+
+    F& axis(int i)
+    {
+        return _filters[i];
+    }
+
+    void reset()
+    {
+        for (auto& f : _filters)
+            f.reset();
+    }
+
+    vec<N, float> LUMINA_HOT operator() (const vec<N, float>& x)
+    {
+        vec<N, float> y;
+        for (int i = 0; i < N; i++)
+            y[i] = _filters[i](x[i]);
+        return y;
+    }
+
+    void LUMINA_HOT process(const std::array<const float*, N>& in, const std::array<float*, N>& out, size_t n)
+    {
+        for (int i = 0; i < N; i++)
+            _filters[i].process(in[i], out[i], n);
+    }
+
+protected:
+
+    std::array<F, N> _filters;
+};
+
+static_assert(math::abs(biquad_coefficients::lowpass(100, 1000).gain(0, 1000) - 1) < 1e-4f);
+static_assert(math::abs(biquad_coefficients::lowpass(100, 1000).gain(100, 1000) - 0.70710678f) < 1e-3f);
+static_assert(biquad_coefficients::lowpass(100, 1000).gain(400, 1000) < 0.05f);
+static_assert(biquad_coefficients::notch(200, 2000, 3).gain(200, 2000) < 1e-3f);
+static_assert(math::abs(biquad_coefficients::notch(200, 2000, 3).gain(20, 2000) - 1) < 0.01f);
+static_assert(math::abs(biquad_coefficients::bandpass(200, 2000, 2).gain(200, 2000) - 1) < 1e-3f);
+static_assert(math::abs(biquad_coefficients::notch_q(200, 150) - 200.f / (200.f * 200 / 150 - 150)) < 1e-6f);
+
+}
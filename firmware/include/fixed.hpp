@@ -0,0 +1,334 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <compare>
+#include <limits>
+#include <type_traits>
+
+#include <cstdint>
+
+#include "vec.hpp"
+
+namespace lumina
+{
+
+/**
+ * Signed Q-format fixed-point number in the range [-1, 1).
+ *
+ * Q15 is stored in `int16_t` and Q31 in `int32_t`. All arithmetic is carried
+ * out in the next wider integer type and saturated back, so results never wrap.
+ * Multiplication rounds to nearest (ties towards +inf).
+ */
+template<int Q>
+class fixed
+{
+    static_assert(Q == 15 || Q == 31, "only Q15 and Q31 formats are supported");
+
+    template<int>
+    friend class fixed;
+
+public:
+
+    using raw_type  = std::conditional_t<Q == 15, int16_t, int32_t>;
+    using wide_type = std::conditional_t<Q == 15, int32_t, int64_t>;
+
+    static constexpr int      bits = Q;
+    static constexpr raw_type min_raw = std::numeric_limits<raw_type>::min();
+    static constexpr raw_type max_raw = std::numeric_limits<raw_type>::max();
+
+public:
+
+    constexpr fixed()
+    :   _raw(0)
+    {}
+
+    constexpr explicit fixed(float value)
+    :   _raw(saturate(round(static_cast<double>(value) * (int64_t(1) << Q))))
+    {}
+
+    /**
+     * Converts between Q formats, saturating or rounding as needed.
+     */
+    template<int R>
+    constexpr explicit fixed(fixed<R> other)
+    :   _raw(R < Q
+            ? static_cast<raw_type>(static_cast<wide_type>(other._raw) << (Q - R))
+            : saturate(rshift(other._raw, R - Q)))
+    {}
+
+    /**
+     * Wraps a raw integer, e.g. a signed 16-bit sensor sample, without scaling.
+     */
+    static constexpr fixed from_raw(raw_type raw)
+    {
+        fixed result;
+        result._raw = raw;
+        return result;
+    }
+
+    static constexpr fixed min() { return from_raw(min_raw); }
+    static constexpr fixed max() { return from_raw(max_raw); }
+
+    constexpr raw_type raw() const
+    {
+        return _raw;
+    }
+
+    constexpr explicit operator float() const
+    {
+        return static_cast<float>(_raw) / static_cast<float>(int64_t(1) << Q);
+    }
+
+    constexpr fixed operator+ (fixed f) const
+    {
+        return from_raw(saturate(static_cast<int64_t>(_raw) + f._raw));
+    }
+
+    constexpr fixed operator- (fixed f) const
+    {
+        return from_raw(saturate(static_cast<int64_t>(_raw) - f._raw));
+    }
+
+    constexpr fixed operator- () const
+    {
+        return from_raw(saturate(-static_cast<int64_t>(_raw)));
+    }
+
+    constexpr fixed operator* (fixed f) const
+    {
+        return from_raw(saturate(rshift(static_cast<int64_t>(_raw) * f._raw, Q)));
+    }
+
+    constexpr fixed &operator+= (fixed f) { return *this = *this + f; }
+    constexpr fixed &operator-= (fixed f) { return *this = *this - f; }
+    constexpr fixed &operator*= (fixed f) { return *this = *this * f; }
+
+    constexpr bool operator== (const fixed&) const = default;
+    constexpr auto operator<=> (const fixed&) const = default;
+
+    /**
+     * Clamps a wide intermediate to the representable range.
+     */
+    static constexpr raw_type saturate(int64_t value)
+    {
+        if (value > max_raw) return max_raw;
+        if (value < min_raw) return min_raw;
+        return static_cast<raw_type>(value);
+    }
+
+    /**
+     * Arithmetic right shift with round-to-nearest.
+     */
+    static constexpr int64_t rshift(int64_t value, int shift)
+    {
+        if (shift <= 0) return value;
+        return (value + (int64_t(1) << (shift - 1))) >> shift;
+    }
+
+protected:
+
+    static constexpr int64_t round(double value)
+    {
+        if (value >= static_cast<double>(std::numeric_limits<int64_t>::max())) return std::numeric_limits<int64_t>::max();
+        if (value <= static_cast<double>(std::numeric_limits<int64_t>::min())) return std::numeric_limits<int64_t>::min();
+        return static_cast<int64_t>(value >= 0 ? value + 0.5 : value - 0.5);
+    }
+
+    raw_type _raw;
+};
+
+using q15 = fixed<15>;
+using q31 = fixed<31>;
+
+
+/**
+ * Fixed-point vector for integer-only stages of the sensor pipeline.
+ *
+ * Products are accumulated in 64 bits and rounded once. Q15 keeps every
+ * product bit; Q31 drops `guard` low bits per product so the sum of `N`
+ * 62-bit products cannot overflow.
+ */
+template<int N, int Q>
+class vec<N, fixed<Q>> : public std::array<fixed<Q>, N>
+{
+public:
+
+    using value_type = fixed<Q>;
+    using raw_type   = typename value_type::raw_type;
+
+    static constexpr int guard = Q == 15 ? 0 : std::bit_width(static_cast<unsigned>(N));
+
+public:
+
+    constexpr value_type& x() requires(N >= 1) { return (*this)[0]; }
+    constexpr value_type& y() requires(N >= 2) { return (*this)[1]; }
+    constexpr value_type& z() requires(N >= 3) { return (*this)[2]; }
+
+    constexpr value_type x() const requires(N >= 1) { return (*this)[0]; }
+    constexpr value_type y() const requires(N >= 2) { return (*this)[1]; }
+    constexpr value_type z() const requires(N >= 3) { return (*this)[2]; }
+
+    static constexpr vec from_raw(const std::array<raw_type, N> &raw)
+    {
+        vec result;
+        for(int i = 0; i < N; i++)
+            result[i] = value_type::from_raw(raw[i]);
+        return result;
+    }
+
+    static constexpr vec from_float(const vec<N, float> &v)
+    {
+        vec result;
+        for(int i = 0; i < N; i++)
+            result[i] = value_type(v[i]);
+        return result;
+    }
+
+    constexpr vec<N, float> to_float() const
+    {
+        vec<N, float> result;
+        for(int i = 0; i < N; i++)
+            result[i] = static_cast<float>((*this)[i]);
+        return result;
+    }
+
+    constexpr value_type dot(const vec &v) const
+    {
+        int64_t sum = 0;
+        for(int i = 0; i < N; i++)
+            sum += (static_cast<int64_t>((*this)[i].raw()) * v[i].raw()) >> guard;
+        return value_type::from_raw(value_type::saturate(value_type::rshift(sum, Q - guard)));
+    }
+
+    constexpr vec cross(const vec &v) const requires(N == 3)
+    {
+        auto term = [](value_type a, value_type b, value_type c, value_type d) {
+            int64_t wide = ((static_cast<int64_t>(a.raw()) * b.raw()) >> guard) - ((static_cast<int64_t>(c.raw()) * d.raw()) >> guard);
+            return value_type::from_raw(value_type::saturate(value_type::rshift(wide, Q - guard)));
+        };
+
+        return {
+            term(y(), v.z(), z(), v.y()),
+            term(z(), v.x(), x(), v.z()),
+            term(x(), v.y(), y(), v.x())
+        };
+    }
+
+    /**
+     * Euclidean length via an integer square root of the full-width dot product.
+     * Saturates at `value_type::max()` for vectors longer than one.
+     */
+    constexpr value_type length() const
+    {
+        uint64_t sum = 0;
+        for(int i = 0; i < N; i++)
+            sum += static_cast<uint64_t>(static_cast<int64_t>((*this)[i].raw()) * (*this)[i].raw()) >> (2 * guard);
+        return value_type::from_raw(value_type::saturate(static_cast<int64_t>(isqrt(sum) << guard)));
+    }
+
+    constexpr vec operator+(const vec &v) const
+    {
+        vec result;
+        for(int i = 0; i < N; i++)
+            result[i] = (*this)[i] + v[i];
+        return result;
+    }
+
+    constexpr vec operator-(const vec &v) const
+    {
+        vec result;
+        for(int i = 0; i < N; i++)
+            result[i] = (*this)[i] - v[i];
+        return result;
+    }
+
+    constexpr vec operator-() const
+    {
+        vec result;
+        for(int i = 0; i < N; i++)
+            result[i] = -(*this)[i];
+        return result;
+    }
+
+    constexpr vec operator*(value_type s) const
+    {
+        vec result;
+        for(int i = 0; i < N; i++)
+            result[i] = (*this)[i] * s;
+        return result;
+    }
+
+    /**
+     * Arithmetic right shift of every component, rounding to nearest.
+     * Cheap power-of-two scaling for decimation and averaging.
+     */
+    constexpr vec operator>>(int shift) const
+    {
+        vec result;
+        for(int i = 0; i < N; i++)
+            result[i] = value_type::from_raw(static_cast<raw_type>(value_type::rshift((*this)[i].raw(), shift)));
+        return result;
+    }
+
+    constexpr vec &operator+=(const vec &v)
+    {
+        return *this = *this + v;
+    }
+
+    constexpr vec &operator-=(const vec &v)
+    {
+        return *this = *this - v;
+    }
+
+    constexpr vec &operator*=(value_type s)
+    {
+        return *this = *this * s;
+    }
+
+    constexpr vec &operator>>=(int shift)
+    {
+        return *this = *this >> shift;
+    }
+
+protected:
+
+    static constexpr uint64_t isqrt(uint64_t n)
+    {
+        uint64_t result = 0;
+        uint64_t bit = uint64_t(1) << 62;
+
+        while (bit > n)
+            bit >>= 2;
+
+        while (bit != 0)
+        {
+            if (n >= result + bit)
+            {
+                n -= result + bit;
+                result = (result >> 1) + bit;
+            }
+            else
+                result >>= 1;
+            bit >>= 2;
+        }
+
+        return result;
+    }
+
+};
+
+using vec2q15 = vec<2, q15>;
+using vec3q15 = vec<3, q15>;
+using vec3q31 = vec<3, q31>;
+
+static_assert(q15(0.5f).raw() == 0x4000);
+static_assert((q15::max() + q15::max()) == q15::max());
+static_assert((q15::min() - q15::max()) == q15::min());
+static_assert((-q15::min()) == q15::max());
+static_assert((q15::min() * q15::min()) == q15::max());
+static_assert((q15(0.5f) * q15(0.5f)).raw() == 0x2000);
+static_assert(q31(q15(0.5f)).raw() == 0x40000000);
+static_assert(q15(q31::from_raw(0x00008000)).raw() == 1);
+
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <bit>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lumina
+{
+
+/**
+ * Histogram with power-of-two buckets, for latencies and durations.
+ *
+ * Bucket 0 counts zeros and bucket i counts values in [2^(i-1), 2^i); the
+ * last bucket also takes everything larger. Recording is a count-leading-
+ * zeros and an increment. Single writer; other tasks may read it for
+ * reporting and at worst see a count that is one sample behind.
+ */
+template <size_t BUCKETS = 16>
+class histogram
+{
+public:
+
+    constexpr histogram()
+    :   _counts{},
+        _total(0),
+        _max(0)
+    {}
+
+    constexpr void record(uint32_t value)
+    {
+        size_t bucket = std::bit_width(value);
+        _counts[bucket < BUCKETS ? bucket : BUCKETS - 1]++;
+        _total++;
+        _max = value > _max ? value : _max;
+    }
+
+    constexpr void reset()
+    {
+        *this = histogram();
+    }
+
+    constexpr uint32_t count(size_t bucket) const
+    {
+        return _counts[bucket];
+    }
+
+    constexpr uint32_t total() const
+    {
+        return _total;
+    }
+
+    constexpr uint32_t max() const
+    {
+        return _max;
+    }
+
+    /**
+     * Upper bound of the bucket holding the `fraction` quantile, e.g. 0.99.
+     */
+    constexpr uint32_t percentile(float fraction) const
+    {
+        uint32_t target = static_cast<uint32_t>(fraction * _total);
+        uint32_t seen = 0;
+        for (size_t i = 0; i < BUCKETS - 1; i++)
+        {
+            seen += _counts[i];
+            if (seen > target)
+                return (uint32_t(1) << i) - 1;
+        }
+        return _max;
+    }
+
+    static constexpr size_t buckets()
+    {
+        return BUCKETS;
+    }
+
+protected:
+
+    std::array<uint32_t, BUCKETS> _counts;
+    uint32_t _total;
+    uint32_t _max;
+};
+
+static_assert([] {
+    histogram<8> h;
+    for (uint32_t v : {0u, 1u, 3u, 3u, 5u, 90u, 1000u})
+        h.record(v);
+    return h.count(0) == 1 && h.count(1) == 1 && h.count(2) == 2 && h.count(3) == 1 && h.count(7) == 2
+        && h.percentile(0.5f) == 3 && h.percentile(0.99f) == 1000 && h.max() == 1000;
+}());
+
+}
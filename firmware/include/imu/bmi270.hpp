@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_rom_sys.h"
+
+#include "../math.hpp"
+#include "fifo.hpp"
+#include "spi.hpp"
+
+namespace lumina::imu
+{
+
+// Configuration file distributed by Bosch with the BMI270 Sensor API. It is
+// not part of this tree; an application using the BMI270 links it in.
+extern "C" const uint8_t lumina_bmi270_config[];
+extern "C" const size_t lumina_bmi270_config_size;
+
+/**
+ * Bosch BMI270 at 1.6 kHz, +-2000 dps and +-16 g. The part runs nothing
+ * until its 8 KiB configuration file has been uploaded.
+ */
+struct bmi270
+{
+    using parser = fifo::bmi270;
+
+    static constexpr const char* NAME = "BMI270";
+
+    static constexpr int CONFIG_CLOCK_HZ = 10'000'000;
+    static constexpr int DATA_CLOCK_HZ = 10'000'000;
+    static constexpr size_t DUMMY = 1;
+
+    static constexpr float RATE_HZ = 1600;
+    static constexpr size_t WATERMARK = 2;
+    static constexpr size_t BURST = 16;
+
+    static constexpr float GYRO_RANGE = math::radians(2000.f);
+    static constexpr float ACCEL_RANGE = 16 * 9.80665f;
+
+    enum reg : uint8_t
+    {
+        CHIP_ID         = 0x00,
+        INTERNAL_STATUS = 0x21,
+        FIFO_LENGTH_0   = 0x24,
+        FIFO_DATA       = 0x26,
+        ACC_CONF        = 0x40,
+        ACC_RANGE       = 0x41,
+        GYR_CONF        = 0x42,
+        GYR_RANGE       = 0x43,
+        FIFO_WTM_0      = 0x46,
+        FIFO_WTM_1      = 0x47,
+        FIFO_CONFIG_0   = 0x48,
+        FIFO_CONFIG_1   = 0x49,
+        INT1_IO_CTRL    = 0x53,
+        INT_MAP_DATA    = 0x58,
+        INIT_CTRL       = 0x59,
+        INIT_ADDR_0     = 0x5B,
+        INIT_ADDR_1     = 0x5C,
+        INIT_DATA       = 0x5E,
+        PWR_CONF        = 0x7C,
+        PWR_CTRL        = 0x7D,
+        CMD             = 0x7E,
+    };
+
+    static constexpr uint8_t ID = 0x24;
+
+    static bool init(spi_device& spi)
+    {
+        spi.read(CHIP_ID);                              // a rising CS edge selects SPI
+        spi.write(CMD, 0xB6);                           // soft reset
+        esp_rom_delay_us(2000);
+        spi.read(CHIP_ID);
+
+        if (spi.read(CHIP_ID) != ID)
+            return false;
+
+        spi.write(PWR_CONF, 0x00);                      // no advanced power save during upload
+        esp_rom_delay_us(450);
+
+        spi.write(INIT_CTRL, 0x00);
+        size_t chunk = spi.capacity() & ~size_t(1);
+        for (size_t offset = 0; offset < lumina_bmi270_config_size; offset += chunk)
+        {
+            size_t size = lumina_bmi270_config_size - offset < chunk ? lumina_bmi270_config_size - offset : chunk;
+            spi.write(INIT_ADDR_0, (offset / 2) & 0x0F);
+            spi.write(INIT_ADDR_1, (offset / 2) >> 4);
+            spi.write(INIT_DATA, lumina_bmi270_config + offset, size);
+        }
+        spi.write(INIT_CTRL, 0x01);
+        esp_rom_delay_us(20'000);
+
+        if ((spi.read(INTERNAL_STATUS) & 0x0F) != 0x01)
+            return false;
+
+        spi.write(PWR_CTRL, 0x0E);                      // accel, gyro, temperature
+        spi.write(ACC_CONF, 0xAC);                      // 1600 Hz, normal bandwidth, performance mode
+        spi.write(ACC_RANGE, 0x03);                     // 16 g
+        spi.write(GYR_CONF, 0xEC);                      // 1600 Hz, normal bandwidth, performance mode
+        spi.write(GYR_RANGE, 0x00);                     // 2000 dps
+
+        spi.write(FIFO_WTM_0, (WATERMARK * parser::FRAME_BYTES) & 0xFF);
+        spi.write(FIFO_WTM_1, (WATERMARK * parser::FRAME_BYTES) >> 8);
+        spi.write(FIFO_CONFIG_0, 0x00);                 // stream, no sensortime frames
+        spi.write(FIFO_CONFIG_1, 0xD0);                 // gyro, accel, headers
+
+        spi.write(INT1_IO_CTRL, 0x0A);                  // INT1 output, push-pull, active high
+        spi.write(INT_MAP_DATA, 0x02);                  // FIFO watermark on INT1
+
+        spi.write(CMD, 0xB0);                           // flush FIFO
+        return true;
+    }
+
+    static size_t fifo_bytes(spi_device& spi)
+    {
+        const uint8_t* length = spi.read(FIFO_LENGTH_0, 2);
+        return (length[1] & 0x3F) << 8 | length[0];
+    }
+};
+
+}
@@ -0,0 +1,293 @@
+#pragma once
+
+#include <array>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../placement.hpp"
+
+namespace lumina::imu
+{
+
+/**
+ * One raw FIFO frame in sensor axes, full-scale mapped to int16.
+ */
+struct raw_sample
+{
+    std::array<int16_t, 3> gyro;
+    std::array<int16_t, 3> accel;
+};
+
+namespace detail
+{
+
+constexpr int16_t be16(const uint8_t* p)
+{
+    return static_cast<int16_t>(static_cast<uint16_t>(p[0] << 8 | p[1]));
+}
+
+constexpr int16_t le16(const uint8_t* p)
+{
+    return static_cast<int16_t>(static_cast<uint16_t>(p[1] << 8 | p[0]));
+}
+
+}
+
+/**
+ * FIFO parsers. Each takes the bytes of one burst read and calls `emit` with
+ * every complete accel+gyro frame, in FIFO order, returning the frame count.
+ * Partial and invalid frames are dropped; they never touch hardware.
+ */
+namespace fifo
+{
+
+/**
+ * ICM-42688-P, big-endian, 16-byte packet 3: header, accel, gyro,
+ * temperature and a 16-bit timestamp. Packets 1 and 2 (8 bytes, one sensor
+ * only) appear while a sensor starts up and are skipped.
+ */
+struct icm42688
+{
+    static constexpr size_t FRAME_BYTES = 16;
+
+    static constexpr uint8_t HEADER_EMPTY = 0x80;
+    static constexpr uint8_t HEADER_ACCEL = 0x40;
+    static constexpr uint8_t HEADER_GYRO  = 0x20;
+    static constexpr uint8_t HEADER_20BIT = 0x10;
+
+    static constexpr int16_t INVALID = -32768;
+
+    template <typename F>
+    static constexpr size_t LUMINA_HOT parse(const uint8_t* data, size_t size, F&& emit)
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < size;)
+        {
+            uint8_t header = data[i];
+            if (header & (HEADER_EMPTY | HEADER_20BIT))
+                break;
+
+            bool both = (header & (HEADER_ACCEL | HEADER_GYRO)) == (HEADER_ACCEL | HEADER_GYRO);
+            size_t length = both ? FRAME_BYTES : 8;
+            if (i + length > size)
+                break;
+
+            if (both)
+            {
+                const uint8_t* p = data + i + 1;
+                raw_sample s = {
+                    { detail::be16(p + 6), detail::be16(p + 8), detail::be16(p + 10) },
+                    { detail::be16(p + 0), detail::be16(p + 2), detail::be16(p + 4) }
+                };
+                if (s.gyro[0] != INVALID && s.accel[0] != INVALID)
+                {
+                    emit(s);
+                    count++;
+                }
+            }
+
+            i += length;
+        }
+        return count;
+    }
+};
+
+/**
+ * BMI270 in header mode, little-endian. Regular frames carry gyro before
+ * accel; skip, sensortime and config-change frames are stepped over.
+ * Accel and gyro run at the same rate, so gyro-only frames are dropped.
+ */
+struct bmi270
+{
+    static constexpr size_t FRAME_BYTES = 13;
+
+    static constexpr uint8_t HEADER_REGULAR = 0x80;
+    static constexpr uint8_t HEADER_ACCEL   = 0x04;
+    static constexpr uint8_t HEADER_GYRO    = 0x08;
+    static constexpr uint8_t HEADER_AUX     = 0x10;
+    static constexpr uint8_t HEADER_SKIP    = 0x40;
+    static constexpr uint8_t HEADER_TIME    = 0x44;
+    static constexpr uint8_t HEADER_CONFIG  = 0x48;
+    static constexpr uint8_t HEADER_EMPTY   = 0x80;
+
+    template <typename F>
+    static constexpr size_t LUMINA_HOT parse(const uint8_t* data, size_t size, F&& emit)
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < size;)
+        {
+            uint8_t header = data[i] & 0xFC;
+            size_t length;
+
+            if (header == HEADER_EMPTY)
+                break;
+            else if (header == HEADER_SKIP || header == HEADER_CONFIG)
+                length = 2;
+            else if (header == HEADER_TIME)
+                length = 4;
+            else if ((header & 0xE0) == HEADER_REGULAR)
+                length = 1 + (header & HEADER_AUX ? 8 : 0) + (header & HEADER_GYRO ? 6 : 0) + (header & HEADER_ACCEL ? 6 : 0);
+            else
+                break;
+
+            if (i + length > size)
+                break;
+
+            if ((header & 0xE0) == HEADER_REGULAR && (header & (HEADER_GYRO | HEADER_ACCEL)) == (HEADER_GYRO | HEADER_ACCEL))
+            {
+                const uint8_t* p = data + i + 1 + (header & HEADER_AUX ? 8 : 0);
+                raw_sample s = {
+                    { detail::le16(p + 0), detail::le16(p + 2), detail::le16(p + 4) },
+                    { detail::le16(p + 6), detail::le16(p + 8), detail::le16(p + 10) }
+                };
+                emit(s);
+                count++;
+            }
+
+            i += length;
+        }
+        return count;
+    }
+};
+
+/**
+ * MPU-6000 with accel and gyro enabled in FIFO_EN, big-endian. The FIFO has
+ * no headers, so frames are plain 12-byte records in register order.
+ */
+struct mpu6000
+{
+    static constexpr size_t FRAME_BYTES = 12;
+
+    template <typename F>
+    static constexpr size_t LUMINA_HOT parse(const uint8_t* data, size_t size, F&& emit)
+    {
+        size_t count = size / FRAME_BYTES;
+        for (size_t i = 0; i < count; i++)
+        {
+            const uint8_t* p = data + i * FRAME_BYTES;
+            raw_sample s = {
+                { detail::be16(p + 6), detail::be16(p + 8), detail::be16(p + 10) },
+                { detail::be16(p + 0), detail::be16(p + 2), detail::be16(p + 4) }
+            };
+            emit(s);
+        }
+        return count;
+    }
+};
+
+}
+
+
+/**
+ * Reconstructs per-sample timestamps from interrupt timestamps.
+ *
+ * The interrupt time, captured from the microsecond hardware timer, belongs
+ * to the newest sample of a burst; earlier samples are spaced by the sensor
+ * period. That period is tracked from interrupt intervals because the
+ * sensor's oscillator drifts from its nominal rate by up to a few percent.
+ */
+class clock
+{
+public:
+
+    /**
+     * @param rate_hz Nominal output data rate.
+     * @param tolerance Largest accepted relative deviation from the nominal period.
+     * @param gain Weight of a new period measurement.
+     */
+    constexpr clock(float rate_hz, float tolerance = 0.05f, float gain = 0.02f)
+    :   _nominal(1e6f / rate_hz),
+        _period(1e6f / rate_hz),
+        _tolerance(tolerance),
+        _gain(gain),
+        _last(-1),
+        _burst(0)
+    {}
+
+    /**
+     * Registers a burst of `count` samples whose newest one was taken at `time_us`.
+     */
+    constexpr void LUMINA_HOT update(int64_t time_us, size_t count)
+    {
+        if (count == 0)
+            return;
+
+        if (_last >= 0)
+        {
+            float measured = static_cast<float>(time_us - _last) / count;
+            float error = measured / _nominal - 1;
+
+            // Samples lost to a FIFO overflow or a late read make a single
+            // interval look too long; those are left out of the estimate.
+            if (error > -_tolerance && error < _tolerance)
+                _period += _gain * (measured - _period);
+        }
+
+        _last = time_us;
+        _burst = count;
+    }
+
+    /**
+     * Timestamp of sample `index` of the last burst, oldest first.
+     */
+    constexpr int64_t timestamp(size_t index) const
+    {
+        return _last - static_cast<int64_t>((_burst - 1 - index) * _period + 0.5f);
+    }
+
+    constexpr float period() const
+    {
+        return _period;
+    }
+
+    constexpr float rate() const
+    {
+        return 1e6f / _period;
+    }
+
+protected:
+
+    float _nominal;
+    float _period;
+    float _tolerance;
+    float _gain;
+
+    int64_t _last;
+    size_t _burst;
+};
+
+static_assert([] {
+    constexpr uint8_t burst[] = {
+        0x68, 0x00, 0x01, 0xFF, 0xFE, 0x10, 0x00, 0x00, 0x02, 0x00, 0x03, 0x80, 0x00, 0x00, 0x12, 0x34,
+        0x68, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x80, 0x00
+    };
+    raw_sample out{};
+    size_t n = fifo::icm42688::parse(burst, sizeof(burst), [&](const raw_sample& s) { out = s; });
+    return n == 1 && out.accel[0] == 1 && out.accel[1] == -2 && out.accel[2] == 4096
+        && out.gyro[0] == 2 && out.gyro[1] == 3 && out.gyro[2] == -32768;
+}());
+
+static_assert([] {
+    constexpr uint8_t burst[] = {
+        0x44, 0x10, 0x20, 0x30,
+        0x8C, 0x01, 0x00, 0xFF, 0xFF, 0x00, 0x80, 0x02, 0x00, 0x03, 0x00, 0x00, 0x10,
+        0x48, 0x00,
+        0x8C, 0x01
+    };
+    raw_sample out{};
+    size_t n = fifo::bmi270::parse(burst, sizeof(burst), [&](const raw_sample& s) { out = s; });
+    return n == 1 && out.gyro[0] == 1 && out.gyro[1] == -1 && out.gyro[2] == -32768
+        && out.accel[0] == 2 && out.accel[1] == 3 && out.accel[2] == 4096;
+}());
+
+static_assert([] {
+    clock c(1000);
+    c.update(10'000, 4);
+    c.update(14'040, 4);
+    return c.timestamp(3) == 14'040 && c.timestamp(0) == 14'040 - 3001
+        && c.period() > 1000 && c.period() < 1001;
+}());
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_rom_sys.h"
+
+#include "../math.hpp"
+#include "fifo.hpp"
+#include "spi.hpp"
+
+namespace lumina::imu
+{
+
+/**
+ * TDK ICM-42688-P at 8 kHz, +-2000 dps and +-16 g. The FIFO watermark
+ * interrupt fires every `WATERMARK` packets.
+ */
+struct icm42688
+{
+    using parser = fifo::icm42688;
+
+    static constexpr const char* NAME = "ICM-42688-P";
+
+    static constexpr int CONFIG_CLOCK_HZ = 1'000'000;
+    static constexpr int DATA_CLOCK_HZ = 24'000'000;
+    static constexpr size_t DUMMY = 0;
+
+    static constexpr float RATE_HZ = 8000;
+    static constexpr size_t WATERMARK = 8;
+    static constexpr size_t BURST = 4 * WATERMARK;
+
+    static constexpr float GYRO_RANGE = math::radians(32768 / 16.4f);
+    static constexpr float ACCEL_RANGE = 16 * 9.80665f;
+
+    enum reg : uint8_t
+    {
+        DEVICE_CONFIG     = 0x11,
+        INT_CONFIG        = 0x14,
+        FIFO_CONFIG       = 0x16,
+        FIFO_COUNTH       = 0x2E,
+        FIFO_DATA         = 0x30,
+        SIGNAL_PATH_RESET = 0x4B,
+        INTF_CONFIG0      = 0x4C,
+        PWR_MGMT0         = 0x4E,
+        GYRO_CONFIG0      = 0x4F,
+        ACCEL_CONFIG0     = 0x50,
+        FIFO_CONFIG1      = 0x5F,
+        FIFO_CONFIG2      = 0x60,
+        FIFO_CONFIG3      = 0x61,
+        INT_CONFIG1       = 0x64,
+        INT_SOURCE0       = 0x65,
+        WHO_AM_I          = 0x75,
+    };
+
+    static constexpr uint8_t ID = 0x47;
+
+    static bool init(spi_device& spi)
+    {
+        spi.write(DEVICE_CONFIG, 0x01);                 // soft reset
+        esp_rom_delay_us(1000);
+
+        if (spi.read(WHO_AM_I) != ID)
+            return false;
+
+        spi.write(INTF_CONFIG0, 0x70);                  // FIFO count in records, big-endian data
+        spi.write(PWR_MGMT0, 0x0F);                     // gyro and accel in low-noise mode
+        esp_rom_delay_us(300);
+
+        spi.write(GYRO_CONFIG0, 0x03);                  // 2000 dps, 8 kHz
+        spi.write(ACCEL_CONFIG0, 0x03);                 // 16 g, 8 kHz
+
+        spi.write(FIFO_CONFIG, 0x40);                   // stream to FIFO
+        spi.write(FIFO_CONFIG1, 0x27);                  // accel, gyro, temperature; watermark while above
+        spi.write(FIFO_CONFIG2, WATERMARK & 0xFF);
+        spi.write(FIFO_CONFIG3, WATERMARK >> 8);
+
+        spi.write(INT_CONFIG, 0x03);                    // INT1 push-pull, active high, pulsed
+        spi.write(INT_CONFIG1, 0x60);                   // 8 us pulses, as required above 4 kHz
+        spi.write(INT_SOURCE0, 0x04);                   // FIFO watermark on INT1
+
+        spi.write(SIGNAL_PATH_RESET, 0x02);             // flush FIFO
+        return true;
+    }
+
+    static size_t fifo_bytes(spi_device& spi)
+    {
+        const uint8_t* count = spi.read(FIFO_COUNTH, 2);
+        return (count[0] << 8 | count[1]) * parser::FRAME_BYTES;
+    }
+};
+
+}
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "../check.hpp"
+#include "../placement.hpp"
+#include "../fixed.hpp"
+#include "../ring.hpp"
+#include "../vec.hpp"
+#include "fifo.hpp"
+#include "spi.hpp"
+#include "icm42688.hpp"
+#include "bmi270.hpp"
+#include "mpu6000.hpp"
+
+namespace lumina::imu
+{
+
+/**
+ * One gyro/accel sample in sensor axes, as a fraction of the sensor's full
+ * scale, stamped in microseconds of `esp_timer_get_time()`.
+ */
+struct sample
+{
+    int64_t timestamp;
+    vec3q15 gyro;
+    vec3q15 accel;
+};
+
+
+/**
+ * FIFO-driven IMU on an SPI bus.
+ *
+ * The sensor's data-ready or watermark interrupt only records the hardware
+ * timer and wakes the driver task. The task reads the FIFO level, pulls the
+ * whole FIFO in one DMA burst, parses it in place and pushes the samples into
+ * a lock-free ring, which the control task drains with `read()`.
+ *
+ * `Sensor` describes one part: its parser, clocks, rates, full-scale ranges
+ * and `init()` / `fifo_bytes()` register sequences.
+ */
+template <typename Sensor, size_t QUEUE = 64>
+class driver
+{
+public:
+
+    static constexpr size_t BURST = Sensor::BURST;
+
+public:
+
+    /**
+     * @param bus SPI bus the sensor sits on.
+     * @param cs Chip-select pin.
+     * @param interrupt Pin wired to the sensor's INT1.
+     * @param core Core the driver task is pinned to.
+     * @param priority Driver task priority; it should preempt the control loop.
+     */
+    driver(const spi_bus& bus, int cs, int interrupt, int core = 1, UBaseType_t priority = configMAX_PRIORITIES - 1)
+    :   _spi(bus, cs, Sensor::CONFIG_CLOCK_HZ, BURST * Sensor::parser::FRAME_BYTES, Sensor::DUMMY),
+        _clock(Sensor::RATE_HZ),
+        _interrupt(static_cast<gpio_num_t>(interrupt)),
+        _task(nullptr),
+        _consumer(nullptr),
+        _interrupt_time(0),
+        _dropped(0)
+    {
+        if (!Sensor::init(_spi))
+        {
+            ESP_LOGE("IMU", "%s not responding on CS %d", Sensor::NAME, cs);
+            return;
+        }
+        _spi.clock(Sensor::DATA_CLOCK_HZ);
+
+        xTaskCreatePinnedToCore(&driver::_run, "imu", 4096, this, priority, &_task, core);
+
+        gpio_config_t io_config = {};
+        io_config.pin_bit_mask = 1ULL << interrupt;
+        io_config.mode = GPIO_MODE_INPUT;
+        io_config.intr_type = GPIO_INTR_POSEDGE;
+        ESP_CHECK(gpio_config(&io_config));
+
+        // The ISR service may already be installed by another driver.
+        if (esp_err_t status = gpio_install_isr_service(ESP_INTR_FLAG_IRAM); status != ESP_ERR_INVALID_STATE)
+        {
+            ESP_CHECK(status);
+        }
+        ESP_CHECK(gpio_isr_handler_add(_interrupt, &driver::_on_interrupt, this));
+
+        ESP_LOGI("IMU", "%s at %.0f Hz", Sensor::NAME, Sensor::RATE_HZ);
+    }
+
+    driver(const driver&) = delete;
+    driver& operator= (const driver&) = delete;
+
+    ~driver()
+    {
+        if (_task)
+        {
+            ESP_CHECK(gpio_isr_handler_remove(_interrupt));
+            vTaskDelete(_task);
+        }
+    }
+
+    /**
+     * Pops the oldest sample. Call from a single consumer task only.
+     */
+    bool read(sample& s)
+    {
+        return _samples.pop(s);
+    }
+
+    /**
+     * Wakes `task` through its notification count whenever new samples are queued.
+     */
+    void notify(TaskHandle_t task)
+    {
+        _consumer = task;
+    }
+
+    size_t available() const
+    {
+        return _samples.size();
+    }
+
+    /**
+     * Samples lost because the ring was full.
+     */
+    uint32_t dropped() const
+    {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Output data rate as measured against the hardware timer.
+     */
+    float rate() const
+    {
+        return _clock.rate();
+    }
+
+    static constexpr vec3 gyro(const sample& s)
+    {
+        return s.gyro.to_float() * Sensor::GYRO_RANGE;
+    }
+
+    static constexpr vec3 accel(const sample& s)
+    {
+        return s.accel.to_float() * Sensor::ACCEL_RANGE;
+    }
+
+protected:
+
+    static void IRAM_ATTR _on_interrupt(void* arg)
+    {
+        driver& self = *static_cast<driver*>(arg);
+        self._interrupt_time = esp_timer_get_time();
+
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(self._task, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+
+    static void LUMINA_HOT _run(void* arg)
+    {
+        driver& self = *static_cast<driver*>(arg);
+        std::array<raw_sample, BURST> raw;
+
+        for (;;)
+        {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            int64_t time = self._interrupt_time;
+
+            size_t bytes = Sensor::fifo_bytes(self._spi);
+            bytes = bytes > self._spi.capacity() ? self._spi.capacity() : bytes;
+            if (bytes == 0)
+                continue;
+
+            size_t count = 0;
+            Sensor::parser::parse(self._spi.read(Sensor::FIFO_DATA, bytes), bytes, [&](const raw_sample& s) {
+                raw[count++] = s;
+            });
+
+            self._clock.update(time, count);
+            for (size_t i = 0; i < count; i++)
+            {
+                sample s = { self._clock.timestamp(i), vec3q15::from_raw(raw[i].gyro), vec3q15::from_raw(raw[i].accel) };
+                if (!self._samples.push(s))
+                    self._dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            if (TaskHandle_t consumer = self._consumer; consumer && count)
+                xTaskNotifyGive(consumer);
+        }
+    }
+
+protected:
+
+    spi_device _spi;
+    clock _clock;
+    ring<sample, QUEUE> _samples;
+
+    gpio_num_t _interrupt;
+    TaskHandle_t _task;
+    TaskHandle_t volatile _consumer;
+
+    volatile int64_t _interrupt_time;
+    std::atomic<uint32_t> _dropped;
+};
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_rom_sys.h"
+
+#include "../math.hpp"
+#include "fifo.hpp"
+#include "spi.hpp"
+
+namespace lumina::imu
+{
+
+/**
+ * InvenSense MPU-6000 at 1 kHz, +-2000 dps and +-16 g. The part has no FIFO
+ * watermark interrupt, so data-ready fires for every sample; its accel does
+ * not sample faster than 1 kHz anyway. Configuration registers only accept
+ * SPI clocks up to 1 MHz.
+ */
+struct mpu6000
+{
+    using parser = fifo::mpu6000;
+
+    static constexpr const char* NAME = "MPU-6000";
+
+    static constexpr int CONFIG_CLOCK_HZ = 1'000'000;
+    static constexpr int DATA_CLOCK_HZ = 20'000'000;
+    static constexpr size_t DUMMY = 0;
+
+    static constexpr float RATE_HZ = 1000;
+    static constexpr size_t WATERMARK = 1;
+    static constexpr size_t BURST = 16;
+
+    static constexpr float GYRO_RANGE = math::radians(32768 / 16.4f);
+    static constexpr float ACCEL_RANGE = 16 * 9.80665f;
+
+    enum reg : uint8_t
+    {
+        SMPLRT_DIV        = 0x19,
+        CONFIG            = 0x1A,
+        GYRO_CONFIG       = 0x1B,
+        ACCEL_CONFIG      = 0x1C,
+        FIFO_EN           = 0x23,
+        INT_PIN_CFG       = 0x37,
+        INT_ENABLE        = 0x38,
+        SIGNAL_PATH_RESET = 0x68,
+        USER_CTRL         = 0x6A,
+        PWR_MGMT_1        = 0x6B,
+        FIFO_COUNTH       = 0x72,
+        FIFO_DATA         = 0x74,
+        WHO_AM_I          = 0x75,
+    };
+
+    static constexpr uint8_t ID = 0x68;
+
+    static bool init(spi_device& spi)
+    {
+        spi.write(PWR_MGMT_1, 0x80);                    // device reset
+        esp_rom_delay_us(100'000);
+        spi.write(SIGNAL_PATH_RESET, 0x07);
+        esp_rom_delay_us(100'000);
+
+        if (spi.read(WHO_AM_I) != ID)
+            return false;
+
+        spi.write(PWR_MGMT_1, 0x03);                    // PLL with gyro Z reference
+        spi.write(USER_CTRL, 0x10);                     // disable I2C
+
+        spi.write(CONFIG, 0x01);                        // 188 Hz DLPF, 1 kHz internal rate
+        spi.write(SMPLRT_DIV, 0x00);
+        spi.write(GYRO_CONFIG, 0x18);                   // 2000 dps
+        spi.write(ACCEL_CONFIG, 0x18);                  // 16 g
+
+        spi.write(INT_PIN_CFG, 0x10);                   // active high, 50 us pulse, clear on any read
+        spi.write(INT_ENABLE, 0x01);                    // data ready
+
+        spi.write(USER_CTRL, 0x14);                     // reset FIFO
+        spi.write(USER_CTRL, 0x50);                     // enable FIFO
+        spi.write(FIFO_EN, 0x78);                       // gyro XYZ and accel
+        return true;
+    }
+
+    static size_t fifo_bytes(spi_device& spi)
+    {
+        const uint8_t* count = spi.read(FIFO_COUNTH, 2);
+        size_t bytes = count[0] << 8 | count[1];
+        return bytes - bytes % parser::FRAME_BYTES;
+    }
+};
+
+}
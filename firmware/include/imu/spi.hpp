@@ -0,0 +1,180 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "esp_heap_caps.h"
+#include "driver/spi_master.h"
+
+#include "../check.hpp"
+#include "../placement.hpp"
+
+namespace lumina
+{
+
+/**
+ * SPI bus with DMA, shared by the devices added to it.
+ */
+class spi_bus
+{
+public:
+
+    spi_bus(spi_host_device_t host, int mosi, int miso, int sclk, size_t max_transfer = 4096)
+    :   _host(host)
+    {
+        spi_bus_config_t bus_config = {};
+        bus_config.mosi_io_num = mosi;
+        bus_config.miso_io_num = miso;
+        bus_config.sclk_io_num = sclk;
+        bus_config.quadwp_io_num = -1;
+        bus_config.quadhd_io_num = -1;
+        bus_config.max_transfer_sz = max_transfer;
+        ESP_CHECK(spi_bus_initialize(_host, &bus_config, SPI_DMA_CH_AUTO));
+    }
+
+    spi_bus(const spi_bus&) = delete;
+    spi_bus& operator= (const spi_bus&) = delete;
+
+    ~spi_bus()
+    {
+        ESP_CHECK(spi_bus_free(_host));
+    }
+
+    spi_host_device_t host() const
+    {
+        return _host;
+    }
+
+protected:
+
+    spi_host_device_t _host;
+};
+
+
+/**
+ * Register access to one sensor on an SPI bus.
+ *
+ * Transfers go through a pair of DMA-capable buffers owned by the device.
+ * A read returns a pointer into the receive buffer, so a FIFO burst is handed
+ * to the parser without a copy. `dummy` is the number of bytes the sensor
+ * clocks out between the address and the data (one on the BMI270).
+ */
+class spi_device
+{
+public:
+
+    spi_device(const spi_bus& bus, int cs, int clock_hz, size_t capacity, size_t dummy = 0)
+    :   _host(bus.host()),
+        _cs(cs),
+        _device(nullptr),
+        _capacity(capacity + 1 + dummy),
+        _dummy(dummy)
+    {
+        _tx = static_cast<uint8_t*>(heap_caps_calloc(1, _capacity, MALLOC_CAP_DMA));
+        _rx = static_cast<uint8_t*>(heap_caps_calloc(1, _capacity, MALLOC_CAP_DMA));
+        clock(clock_hz);
+    }
+
+    spi_device(const spi_device&) = delete;
+    spi_device& operator= (const spi_device&) = delete;
+
+    ~spi_device()
+    {
+        if (_device)
+            ESP_CHECK(spi_bus_remove_device(_device));
+        heap_caps_free(_tx);
+        heap_caps_free(_rx);
+    }
+
+    /**
+     * Re-attaches the device at another clock, e.g. slow for configuration
+     * registers and fast for data reads.
+     */
+    void clock(int clock_hz)
+    {
+        if (_device)
+            ESP_CHECK(spi_bus_remove_device(_device));
+
+        spi_device_interface_config_t device_config = {};
+        device_config.mode = 3;
+        device_config.clock_speed_hz = clock_hz;
+        device_config.spics_io_num = _cs;
+        device_config.queue_size = 1;
+        ESP_CHECK(spi_bus_add_device(_host, &device_config, &_device));
+    }
+
+    void write(uint8_t reg, uint8_t value)
+    {
+        _tx[0] = reg & 0x7F;
+        _tx[1] = value;
+        _transfer(2);
+    }
+
+    void write(uint8_t reg, const uint8_t* data, size_t size)
+    {
+        size = size + 1 > _capacity ? _capacity - 1 : size;
+        _tx[0] = reg & 0x7F;
+        std::memcpy(_tx + 1, data, size);
+        _transfer(size + 1);
+    }
+
+    uint8_t read(uint8_t reg)
+    {
+        return *read(reg, 1);
+    }
+
+    /**
+     * Burst-reads `size` bytes starting at `reg`. The returned pointer stays
+     * valid until the next transfer on this device.
+     */
+    const uint8_t* LUMINA_HOT read(uint8_t reg, size_t size)
+    {
+        size_t header = 1 + _dummy;
+        size = size + header > _capacity ? _capacity - header : size;
+
+        std::memset(_tx, 0, size + header);
+        _tx[0] = reg | 0x80;
+        _transfer(size + header);
+        return _rx + header;
+    }
+
+    size_t capacity() const
+    {
+        return _capacity - 1 - _dummy;
+    }
+
+protected:
+
+    void LUMINA_HOT _transfer(size_t bytes)
+    {
+        spi_transaction_t transaction = {};
+        transaction.length = bytes * 8;
+        transaction.tx_buffer = _tx;
+        transaction.rx_buffer = _rx;
+
+        // Short register accesses poll; long bursts block on the DMA
+        // interrupt so the core is free while the FIFO streams in.
+        if (bytes <= 32)
+        {
+            ESP_CHECK(spi_device_polling_transmit(_device, &transaction));
+        }
+        else
+        {
+            ESP_CHECK(spi_device_transmit(_device, &transaction));
+        }
+    }
+
+protected:
+
+    spi_host_device_t _host;
+    int _cs;
+    spi_device_handle_t _device;
+
+    size_t _capacity;
+    size_t _dummy;
+    uint8_t* _tx;
+    uint8_t* _rx;
+};
+
+}
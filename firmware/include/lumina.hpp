@@ -2,27 +2,25 @@
 
 #include "mavlink.hpp"
 #include "wlan/wlan.hpp"
-
-namespace lumina
-{
-
-// class drone
-// {
-// public:
-
-//     drone()
-//     :   _wlan(wlan::AP)
-//     {
-
-//     }
-
-//     void run()
-
-// protected:
-
-//     wlan<wlan::AP>  _wlan;
-//     mavlink         _mavlink;
-//     esc             _escs[4];
-// };
-
-}
+#include "esc/esc.hpp"
+#include "esc/analog.hpp"
+#include "imu/imu.hpp"
+#include "crsf/receiver.hpp"
+#include "adc.hpp"
+#include "attitude.hpp"
+#include "ekf.hpp"
+#include "pid.hpp"
+#include "filter.hpp"
+#include "notch.hpp"
+#include "mixer.hpp"
+#include "thrust.hpp"
+#include "timer.hpp"
+#include "placement.hpp"
+#include "periodic.hpp"
+#include "profile.hpp"
+#include "trace.hpp"
+#include "memory.hpp"
+#include "supervisor.hpp"
+#include "topic.hpp"
+#include "topics.hpp"
+#include "drone.hpp"
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+
+#include "vec.hpp"
+
+namespace lumina
+{
+
+template<int R, int C, typename T>
+class mat : public std::array<vec<C, T>, R>
+{
+public:
+
+    static constexpr mat identity() requires(R == C)
+    {
+        mat result{};
+        for(int i = 0; i < R; i++)
+            result[i][i] = 1;
+        return result;
+    }
+
+    constexpr vec<R, T> col(int c) const
+    {
+        vec<R, T> result{};
+        for(int i = 0; i < R; i++)
+            result[i] = (*this)[i][c];
+        return result;
+    }
+
+    constexpr mat<C, R, T> transposed() const
+    {
+        mat<C, R, T> result{};
+        for(int i = 0; i < R; i++)
+            for(int j = 0; j < C; j++)
+                result[j][i] = (*this)[i][j];
+        return result;
+    }
+
+    constexpr vec<R, T> operator*(const vec<C, T> &v) const
+    {
+        vec<R, T> result{};
+        for(int i = 0; i < R; i++)
+            result[i] = (*this)[i].dot(v);
+        return result;
+    }
+
+    template<int K>
+    constexpr mat<R, K, T> operator*(const mat<C, K, T> &m) const
+    {
+        mat<R, K, T> result{};
+        for(int i = 0; i < R; i++)
+            for(int k = 0; k < K; k++)
+                for(int j = 0; j < C; j++)
+                    result[i][k] += (*this)[i][j] * m[j][k];
+        return result;
+    }
+
+    constexpr mat operator+(const mat &m) const
+    {
+        mat result{};
+        for(int i = 0; i < R; i++)
+            result[i] = (*this)[i] + m[i];
+        return result;
+    }
+
+    constexpr mat operator-(const mat &m) const
+    {
+        mat result{};
+        for(int i = 0; i < R; i++)
+            result[i] = (*this)[i] - m[i];
+        return result;
+    }
+
+    constexpr mat operator*(T s) const
+    {
+        mat result{};
+        for(int i = 0; i < R; i++)
+            result[i] = (*this)[i] * s;
+        return result;
+    }
+
+};
+
+using mat3 = mat<3, 3, float>;
+using mat4 = mat<4, 4, float>;
+
+}
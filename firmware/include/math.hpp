@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cmath>
+#include <numbers>
+#include <type_traits>
+
+namespace lumina::math
+{
+
+/**
+ * Trigonometric subset usable in constant expressions.
+ *
+ * Each function evaluates a series in double precision when constant-evaluated
+ * and forwards to <cmath> at runtime, so compile-time tables cost nothing at
+ * boot and runtime calls keep the libm fast path.
+ */
+
+template<typename T>
+inline constexpr T pi = std::numbers::pi_v<T>;
+
+template<typename T>
+constexpr T abs(T x)
+{
+    return x < 0 ? -x : x;
+}
+
+template<typename T>
+constexpr T sqrt(T x)
+{
+    if (!std::is_constant_evaluated())
+        return std::sqrt(x);
+
+    if (x <= 0) return 0;
+
+    double r = x >= 1 ? static_cast<double>(x) : 1.0;
+    for (int i = 0; i < 64; i++)
+    {
+        double next = 0.5 * (r + x / r);
+        if (next == r) break;
+        r = next;
+    }
+    return static_cast<T>(r);
+}
+
+namespace detail
+{
+
+// sin(x) for |x| <= pi/4
+constexpr double sin_series(double x)
+{
+    double term = x, sum = x, x2 = x * x;
+    for (int n = 1; n < 12; n++)
+    {
+        term *= -x2 / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+// cos(x) for |x| <= pi/4
+constexpr double cos_series(double x)
+{
+    double term = 1, sum = 1, x2 = x * x;
+    for (int n = 1; n < 12; n++)
+    {
+        term *= -x2 / ((2 * n - 1) * (2 * n));
+        sum += term;
+    }
+    return sum;
+}
+
+// sin(x + k * pi/2) for |x| <= pi/4
+constexpr double sin_quadrant(double x, long k)
+{
+    switch (((k % 4) + 4) % 4)
+    {
+        case 0: return  sin_series(x);
+        case 1: return  cos_series(x);
+        case 2: return -sin_series(x);
+        default: return -cos_series(x);
+    }
+}
+
+constexpr long nearest(double x)
+{
+    return static_cast<long>(x >= 0 ? x + 0.5 : x - 0.5);
+}
+
+// atan(x) for |x| <= 1
+constexpr double atan_series(double x)
+{
+    // Halve the argument twice so the series converges quickly.
+    x = x / (1 + sqrt(1 + x * x));
+    x = x / (1 + sqrt(1 + x * x));
+
+    double term = x, sum = x, x2 = x * x;
+    for (int n = 1; n < 24; n++)
+    {
+        term *= -x2;
+        sum += term / (2 * n + 1);
+    }
+    return 4 * sum;
+}
+
+}
+
+template<typename T>
+constexpr T sin(T x)
+{
+    if (!std::is_constant_evaluated())
+        return std::sin(x);
+
+    long k = detail::nearest(x / (pi<double> / 2));
+    return static_cast<T>(detail::sin_quadrant(x - k * (pi<double> / 2), k));
+}
+
+template<typename T>
+constexpr T cos(T x)
+{
+    if (!std::is_constant_evaluated())
+        return std::cos(x);
+
+    long k = detail::nearest(x / (pi<double> / 2));
+    return static_cast<T>(detail::sin_quadrant(x - k * (pi<double> / 2), k + 1));
+}
+
+template<typename T>
+constexpr T atan(T x)
+{
+    if (!std::is_constant_evaluated())
+        return std::atan(x);
+
+    double d = x;
+    if (abs(d) <= 1)
+        return static_cast<T>(detail::atan_series(d));
+    return static_cast<T>((d > 0 ? pi<double> / 2 : -pi<double> / 2) - detail::atan_series(1 / d));
+}
+
+template<typename T>
+constexpr T atan2(T y, T x)
+{
+    if (!std::is_constant_evaluated())
+        return std::atan2(y, x);
+
+    if (x > 0) return atan(y / x);
+    if (x < 0) return y >= 0 ? atan(y / x) + pi<T> : atan(y / x) - pi<T>;
+    if (y > 0) return  pi<T> / 2;
+    if (y < 0) return -pi<T> / 2;
+    return 0;
+}
+
+template<typename T>
+constexpr T asin(T x)
+{
+    if (!std::is_constant_evaluated())
+        return std::asin(x);
+
+    if (x >=  1) return  pi<T> / 2;
+    if (x <= -1) return -pi<T> / 2;
+    return atan2(x, sqrt(1 - x * x));
+}
+
+template<typename T>
+constexpr T acos(T x)
+{
+    if (!std::is_constant_evaluated())
+        return std::acos(x);
+
+    return pi<T> / 2 - asin(x);
+}
+
+template<typename T>
+constexpr T radians(T degrees)
+{
+    return degrees * (pi<T> / 180);
+}
+
+template<typename T>
+constexpr T degrees(T radians)
+{
+    return radians * (180 / pi<T>);
+}
+
+static_assert(abs(sin(pi<double> / 6) - 0.5) < 1e-12);
+static_assert(abs(cos(pi<double> / 3) - 0.5) < 1e-12);
+static_assert(abs(sin(-7 * pi<double> / 2) - 1.0) < 1e-12);
+static_assert(abs(atan2(1.0, -1.0) - 3 * pi<double> / 4) < 1e-12);
+static_assert(abs(asin(0.5) - pi<double> / 6) < 1e-12);
+static_assert(abs(sqrt(2.0) * sqrt(2.0) - 2.0) < 1e-12);
+
+}
@@ -1,17 +1,336 @@
 #pragma once
 
-#include "mavlink/common/mavlink.h"
+#include <atomic>
+#include <iterator>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#else
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#endif
+
+#include "mavlink/lumina/mavlink.h"
+
+#include "seqlock.hpp"
+#include "histogram.hpp"
+#include "periodic.hpp"
+#include "profile.hpp"
+#include "trace.hpp"
 
 namespace lumina
 {
 
+/**
+ * True if message `id` is part of the generated dialect, i.e. has an entry
+ * in its CRC table. The parser drops any other message as corrupt, and one
+ * sent without an entry carries a checksum no ground station accepts, so
+ * code that handles a message checks it with a static_assert. Change the
+ * set with custom_mavlink_messages in platformio.ini.
+ */
+constexpr bool in_dialect(uint32_t id)
+{
+    constexpr mavlink_msg_entry_t entries[] = MAVLINK_MESSAGE_CRCS;
+    for (const auto& entry : entries)
+        if (entry.msgid == id)
+            return true;
+    return false;
+}
+
+// mavlink_get_msg_entry() bisects the table.
+static_assert([] {
+    constexpr mavlink_msg_entry_t entries[] = MAVLINK_MESSAGE_CRCS;
+    for (size_t i = 1; i < std::size(entries); i++)
+        if (entries[i - 1].msgid >= entries[i].msgid)
+            return false;
+    return true;
+}(), "MAVLINK_MESSAGE_CRCS is not sorted by message id");
+
+static_assert(in_dialect(MAVLINK_MSG_ID_MANUAL_CONTROL) && in_dialect(MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE),
+              "the fast path needs MANUAL_CONTROL and RC_CHANNELS_OVERRIDE in the dialect");
+
+
+/**
+ * Pilot stick input, normalized: roll, pitch and yaw in [-1, 1], throttle
+ * in [0, 1]. Positive pitch tilts the nose down (stick forward).
+ */
+struct manual_input
+{
+    float roll;
+    float pitch;
+    float yaw;
+    float throttle;
+    bool arm;
+    int64_t timestamp;              // esp_timer time the datagram was received, steady clock on the host
+};
+
+
+/**
+ * MAVLink over UDP to a ground station.
+ *
+ * A receive task blocks on the socket and parses every datagram as it
+ * arrives. MANUAL_CONTROL and RC_CHANNELS_OVERRIDE addressed to this system
+ * take a fast path: they are decoded right in the receive task and written
+ * into a seqlock slot that the control loop polls without blocking, with no
+ * queue or dispatcher in between. Everything else is only counted for now;
+ * messages outside the dialect fail the parser's checksum and are dropped.
+ *
+ * RC_CHANNELS_OVERRIDE is read in AETR order with the arm switch on channel
+ * 5; MANUAL_CONTROL arms while button 1 is held.
+ *
+ * On the host the receive task is a std::thread, so the fast path can be
+ * driven over UDP loopback.
+ */
 class mavlink
 {
 public:
 
+    static constexpr uint8_t SYSTEM_ID = 1;
+    static constexpr uint8_t COMPONENT_ID = MAV_COMP_ID_AUTOPILOT1;
+
+    static constexpr int64_t TIMEOUT_US = 500'000;
+
+#ifdef ESP_PLATFORM
+    static constexpr task_priority PRIORITY = configMAX_PRIORITIES - 4;
+#else
+    static constexpr task_priority PRIORITY = 0;
+#endif
+
+public:
+
+    /**
+     * @param remote_ip Destination of outgoing messages, network byte order.
+     * @param remote_port Ground station port.
+     * @param local_port Port the receive task listens on; replies come back here.
+     */
+    mavlink(uint32_t remote_ip, uint16_t remote_port = 14550, uint16_t local_port = 14555,
+            [[maybe_unused]] int core = 0, [[maybe_unused]] task_priority priority = PRIORITY)
+    :   _socket(socket(AF_INET, SOCK_DGRAM, 0)),
+        _remote{},
+        _read_sequence(0)
+    {
+        if (_socket < 0)
+        {
+#ifdef ESP_PLATFORM
+            ESP_LOGE("MAVLink", "Error creating socket");
+#else
+            std::fprintf(stderr, "MAVLink: error creating socket\n");
+#endif
+            return;
+        }
+
+        int broadcast = 1;
+        setsockopt(_socket, SOL_SOCKET, SO_BROADCAST, &broadcast, sizeof(broadcast));
+
+        sockaddr_in local = {};
+        local.sin_family = AF_INET;
+        local.sin_port = htons(local_port);
+        local.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (bind(_socket, reinterpret_cast<sockaddr*>(&local), sizeof(local)) < 0)
+        {
+#ifdef ESP_PLATFORM
+            ESP_LOGE("MAVLink", "Error binding port %u", local_port);
+#else
+            std::fprintf(stderr, "MAVLink: error binding port %u\n", local_port);
+#endif
+        }
+
+        _remote.sin_family = AF_INET;
+        _remote.sin_port = htons(remote_port);
+        _remote.sin_addr.s_addr = remote_ip;
+
+#ifdef ESP_PLATFORM
+        xTaskCreatePinnedToCore(&mavlink::_run, "mavlink", 4096, this, priority, &_task, core);
+#else
+        _running.store(true);
+        _thread = std::thread(&mavlink::_run, this);
+#endif
+    }
+
+    mavlink(const mavlink&) = delete;
+    mavlink& operator= (const mavlink&) = delete;
+
+    ~mavlink()
+    {
+#ifdef ESP_PLATFORM
+        if (_task)
+            vTaskDelete(_task);
+#else
+        // Shutting the socket down wakes the blocked recv().
+        if (_thread.joinable())
+        {
+            _running.store(false);
+            shutdown(_socket, SHUT_RDWR);
+            _thread.join();
+        }
+#endif
+        if (_socket >= 0)
+            close(_socket);
+    }
+
+    bool send(const mavlink_message_t& msg)
+    {
+        LUMINA_PROFILE_SCOPE("mav_tx");
+        LUMINA_TRACE_SCOPE("mav_tx");
+        uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+        uint16_t length = mavlink_msg_to_send_buffer(buffer, &msg);
+        return sendto(_socket, buffer, length, 0, reinterpret_cast<const sockaddr*>(&_remote), sizeof(_remote)) == length;
+    }
+
+    /**
+     * Copies the latest manual input and returns true if it is newer than
+     * at the previous call. Records its age for `latency()`. Call from a
+     * single consumer task only.
+     */
+    bool read(manual_input& in)
+    {
+        uint32_t sequence = _manual.read(in);
+        if (sequence == _read_sequence)
+            return false;
+
+        _read_sequence = sequence;
+        _latency.record(static_cast<uint32_t>(_now() - in.timestamp));
+        return true;
+    }
+
+    /**
+     * True if manual input arrived within `timeout_us`.
+     */
+    bool active(int64_t timeout_us = TIMEOUT_US) const
+    {
+        manual_input in;
+        return _manual.read(in) && _now() - in.timestamp <= timeout_us;
+    }
+
+    /**
+     * Microseconds from a datagram's arrival to the consumer's `read()`.
+     */
+    const histogram<>& latency() const
+    {
+        return _latency;
+    }
+
+    uint32_t received() const
+    {
+        return _received.load(std::memory_order_relaxed);
+    }
+
+protected:
+
+    static int64_t _now()
+    {
+#ifdef ESP_PLATFORM
+        return esp_timer_get_time();
+#else
+        using namespace std::chrono;
+        return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    static float _axis(int16_t value)
+    {
+        return value == INT16_MAX ? 0 : value / 1000.f;
+    }
+
+    static float _channel(uint16_t us)
+    {
+        if (us == 0 || us == UINT16_MAX)
+            return 0;
+        float x = (static_cast<int>(us) - 1500) / 500.f;
+        return x < -1 ? -1 : (x > 1 ? 1 : x);
+    }
+
+    void _fast_path(const mavlink_message_t& msg, int64_t arrival)
+    {
+        manual_input in = {};
+        in.timestamp = arrival;
+
+        if (msg.msgid == MAVLINK_MSG_ID_MANUAL_CONTROL)
+        {
+            if (mavlink_msg_manual_control_get_target(&msg) != SYSTEM_ID)
+                return;
+
+            in.pitch = _axis(mavlink_msg_manual_control_get_x(&msg));
+            in.roll = _axis(mavlink_msg_manual_control_get_y(&msg));
+            in.throttle = _axis(mavlink_msg_manual_control_get_z(&msg));
+            in.yaw = _axis(mavlink_msg_manual_control_get_r(&msg));
+            in.arm = mavlink_msg_manual_control_get_buttons(&msg) & 1;
+        }
+        else
+        {
+            if (mavlink_msg_rc_channels_override_get_target_system(&msg) != SYSTEM_ID)
+                return;
+
+            in.roll = _channel(mavlink_msg_rc_channels_override_get_chan1_raw(&msg));
+            in.pitch = _channel(mavlink_msg_rc_channels_override_get_chan2_raw(&msg));
+            in.throttle = (_channel(mavlink_msg_rc_channels_override_get_chan3_raw(&msg)) + 1) / 2;
+            in.yaw = _channel(mavlink_msg_rc_channels_override_get_chan4_raw(&msg));
+            in.arm = mavlink_msg_rc_channels_override_get_chan5_raw(&msg) > 1700;
+        }
+
+        in.throttle = in.throttle < 0 ? 0 : (in.throttle > 1 ? 1 : in.throttle);
+        _manual.write(in);
+    }
+
+    static void _run(void* arg)
+    {
+        mavlink& self = *static_cast<mavlink*>(arg);
+        uint8_t buffer[MAVLINK_MAX_PACKET_LEN * 2];
+
+        for (;;)
+        {
+            ssize_t size = recv(self._socket, buffer, sizeof(buffer), 0);
+            int64_t arrival = _now();
+#ifndef ESP_PLATFORM
+            if (!self._running.load())
+                return;
+#endif
+            if (size <= 0)
+                continue;
+
+            LUMINA_PROFILE_SCOPE("mav_rx");
+            LUMINA_TRACE_SCOPE("mav_rx");
+            mavlink_message_t msg;
+            mavlink_status_t status;
+            for (ssize_t i = 0; i < size; i++)
+            {
+                if (!mavlink_parse_char(MAVLINK_COMM_0, buffer[i], &msg, &status))
+                    continue;
+
+                self._received.fetch_add(1, std::memory_order_relaxed);
+                if (msg.msgid == MAVLINK_MSG_ID_MANUAL_CONTROL || msg.msgid == MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE)
+                    self._fast_path(msg, arrival);
+            }
+        }
+    }
+
 protected:
 
-    
+    int _socket;
+    sockaddr_in _remote;
+#ifdef ESP_PLATFORM
+    TaskHandle_t _task = nullptr;
+#else
+    std::thread _thread;
+    std::atomic<bool> _running;
+#endif
+
+    seqlock<manual_input> _manual;
+    std::atomic<uint32_t> _received;
+
+    uint32_t _read_sequence;
+    histogram<> _latency;
 };
 
 }
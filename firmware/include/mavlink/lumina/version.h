@@ -0,0 +1,14 @@
+/** @file
+ *  @brief MAVLink comm protocol pruned from common.xml
+ *  @see http://mavlink.org
+ */
+#pragma once
+ 
+#ifndef MAVLINK_VERSION_H
+#define MAVLINK_VERSION_H
+
+#define MAVLINK_BUILD_DATE "Wed Aug 07 2024"
+#define MAVLINK_WIRE_PROTOCOL_VERSION "2.0"
+#define MAVLINK_MAX_DIALECT_PAYLOAD_SIZE 233
+ 
+#endif // MAVLINK_VERSION_H
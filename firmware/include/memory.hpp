@@ -0,0 +1,416 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "placement.hpp"
+
+#ifdef ESP_PLATFORM
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#else
+#include <thread>
+#endif
+
+namespace lumina::memory
+{
+
+/**
+ * Byte counters of one pool or arena. Registers itself on construction so
+ * that telemetry can report every region's high-water mark.
+ */
+class usage
+{
+public:
+
+    static constexpr size_t MAX_REGIONS = 16;
+
+public:
+
+    usage(const char* name, size_t capacity)
+    :   _name(name),
+        _capacity(capacity),
+        _used(0),
+        _peak(0)
+    {
+        for (auto& slot : _registry)
+        {
+            usage* empty = nullptr;
+            if (slot.compare_exchange_strong(empty, this, std::memory_order_release, std::memory_order_relaxed))
+                break;
+        }
+    }
+
+    usage(const usage&) = delete;
+    usage& operator= (const usage&) = delete;
+
+    ~usage()
+    {
+        for (auto& slot : _registry)
+        {
+            usage* self = this;
+            if (slot.compare_exchange_strong(self, nullptr, std::memory_order_relaxed))
+                break;
+        }
+    }
+
+    void add(size_t bytes)
+    {
+        size_t used = _used.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        size_t peak = _peak.load(std::memory_order_relaxed);
+        while (used > peak && !_peak.compare_exchange_weak(peak, used, std::memory_order_relaxed))
+            ;
+    }
+
+    void remove(size_t bytes)
+    {
+        _used.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    const char* name() const
+    {
+        return _name;
+    }
+
+    size_t capacity() const
+    {
+        return _capacity;
+    }
+
+    size_t used() const
+    {
+        return _used.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Most bytes ever in use at once.
+     */
+    size_t peak() const
+    {
+        return _peak.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Calls `f(const usage&)` for every live region.
+     */
+    template <typename F>
+    static void for_each(F&& f)
+    {
+        for (const auto& slot : _registry)
+            if (const usage* u = slot.load(std::memory_order_acquire))
+                f(*u);
+    }
+
+protected:
+
+    const char* _name;
+    size_t _capacity;
+    std::atomic<size_t> _used;
+    std::atomic<size_t> _peak;
+
+    static inline std::array<std::atomic<usage*>, MAX_REGIONS> _registry{};
+};
+
+
+/**
+ * Fixed pool of `N` objects of type `T`, for packets and frames that change
+ * hands between tasks.
+ *
+ * Free slots form a lock-free stack of indices whose head carries a change
+ * counter against ABA, so `create()` and `destroy()` may be called from any
+ * task or ISR, on either core, in constant time. Nothing is allocated after
+ * construction; an exhausted pool returns nullptr.
+ */
+template <typename T, size_t N>
+class pool
+{
+    static constexpr uint32_t EMPTY = 0xFFFF;
+
+    static_assert(N > 0 && N < EMPTY, "pool indices are 16 bits");
+
+public:
+
+    struct deleter
+    {
+        pool* owner;
+
+        void operator() (T* object) const
+        {
+            owner->destroy(object);
+        }
+    };
+
+    using unique_ptr = std::unique_ptr<T, deleter>;
+
+public:
+
+    pool(const char* name)
+    :   _usage(name, N * sizeof(T)),
+        _head(0)
+    {
+        for (size_t i = 0; i < N; i++)
+            _next[i].store(i + 1 < N ? i + 1 : EMPTY, std::memory_order_relaxed);
+    }
+
+    pool(const pool&) = delete;
+    pool& operator= (const pool&) = delete;
+
+    template <typename... Args>
+    T* create(Args&&... args)
+    {
+        uint32_t head = _head.load(std::memory_order_acquire);
+        uint32_t index;
+        do
+        {
+            index = head & 0xFFFF;
+            if (index == EMPTY)
+                return nullptr;
+        }
+        while (!_head.compare_exchange_weak(head, _tag(head) | _next[index].load(std::memory_order_relaxed),
+                                            std::memory_order_acquire, std::memory_order_acquire));
+
+        _usage.add(sizeof(T));
+        return new (&_slots[index]) T(std::forward<Args>(args)...);
+    }
+
+    void destroy(T* object)
+    {
+        if (!object)
+            return;
+
+        object->~T();
+        _usage.remove(sizeof(T));
+
+        uint32_t index = static_cast<uint32_t>(reinterpret_cast<storage*>(object) - _slots.data());
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        do
+            _next[index].store(head & 0xFFFF, std::memory_order_relaxed);
+        while (!_head.compare_exchange_weak(head, _tag(head) | index, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    /**
+     * Like `create()`, but returns the object to the pool when the pointer dies.
+     */
+    template <typename... Args>
+    unique_ptr make(Args&&... args)
+    {
+        return unique_ptr(create(std::forward<Args>(args)...), deleter{this});
+    }
+
+    size_t available() const
+    {
+        return N - _usage.used() / sizeof(T);
+    }
+
+    static constexpr size_t capacity()
+    {
+        return N;
+    }
+
+    const memory::usage& usage() const
+    {
+        return _usage;
+    }
+
+protected:
+
+    // Next change counter in the upper half of the head.
+    static uint32_t _tag(uint32_t head)
+    {
+        return (head & 0xFFFF0000) + 0x10000;
+    }
+
+protected:
+
+    struct storage
+    {
+        alignas(T) std::byte bytes[sizeof(T)];
+    };
+
+    memory::usage _usage;
+    std::array<storage, N> _slots;
+    std::array<std::atomic<uint16_t>, N> _next;
+    std::atomic<uint32_t> _head;
+};
+
+
+/**
+ * Bytes needed to place one of each `Ts` in an arena, alignment included.
+ */
+template <typename... Ts>
+constexpr size_t footprint = ((sizeof(Ts) + alignof(Ts) - 1) + ... + 0);
+
+
+/**
+ * Bump allocator over a buffer of `BYTES`, for the long-lived state of one
+ * subsystem. Sized at compile time with `footprint`, it moves that state off
+ * task stacks and out of the heap, and its peak shows how much was needed.
+ *
+ * Objects are never destroyed individually, so only trivially destructible
+ * types may be placed. Not thread-safe: each arena belongs to one task.
+ */
+template <size_t BYTES>
+class arena
+{
+public:
+
+    arena(const char* name)
+    :   _usage(name, BYTES),
+        _offset(0)
+    {}
+
+    arena(const arena&) = delete;
+    arena& operator= (const arena&) = delete;
+
+    /**
+     * Returns `size` bytes aligned to `align`, or nullptr if the arena is full.
+     */
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t))
+    {
+        size_t start = (_offset + align - 1) & ~(align - 1);
+        if (start + size > BYTES)
+            return nullptr;
+
+        _usage.add(start + size - _offset);
+        _offset = start + size;
+        return _buffer + start;
+    }
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args)
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "arena objects are never destroyed");
+
+        void* p = allocate(sizeof(T), alignof(T));
+        return p ? new (p) T(std::forward<Args>(args)...) : nullptr;
+    }
+
+    /**
+     * Drops everything placed so far.
+     */
+    void reset()
+    {
+        _usage.remove(_offset);
+        _offset = 0;
+    }
+
+    static constexpr size_t capacity()
+    {
+        return BYTES;
+    }
+
+    const memory::usage& usage() const
+    {
+        return _usage;
+    }
+
+protected:
+
+    memory::usage _usage;
+    size_t _offset;
+    alignas(std::max_align_t) std::byte _buffer[BYTES];
+};
+
+
+/**
+ * No-heap-after-arming guard.
+ *
+ * Flight-critical tasks register with `protect()`. While `lock_heap(true)`
+ * is in effect, `check_allocation()` treats any heap allocation from one of
+ * them as a fault: on target it aborts with a backtrace that points at the
+ * caller, on the host it is counted for `heap_violations()`. The target
+ * calls it from the heap's allocation hook (CONFIG_HEAP_USE_HOOKS); on the
+ * host, code that wants the check calls it itself, as the replacement
+ * `operator new` of test/native/test_memory does.
+ *
+ * The hook runs inside the heap functions, which are in IRAM, so the check
+ * is too. Its only call into the OS, xTaskGetCurrentTaskHandle(), is IRAM
+ * resident as long as CONFIG_FREERTOS_PLACE_FUNCTIONS_INTO_FLASH is off.
+ */
+#ifdef ESP_PLATFORM
+using task_id = TaskHandle_t;
+
+inline task_id LUMINA_HOT current_task()
+{
+    return xTaskGetCurrentTaskHandle();
+}
+#else
+using task_id = std::thread::id;
+
+inline task_id current_task()
+{
+    return std::this_thread::get_id();
+}
+#endif
+
+namespace detail
+{
+
+inline constexpr size_t MAX_PROTECTED = 8;
+
+inline std::array<task_id, MAX_PROTECTED> protected_tasks{};
+inline std::atomic<size_t> protected_count{0};
+inline std::atomic<bool> heap_locked{false};
+inline std::atomic<uint32_t> violations{0};
+
+}
+
+/**
+ * Marks `task` as flight-critical. Call during startup, before locking.
+ */
+inline bool protect(task_id task = current_task())
+{
+    size_t i = detail::protected_count.load(std::memory_order_relaxed);
+    if (i >= detail::MAX_PROTECTED)
+        return false;
+
+    detail::protected_tasks[i] = task;
+    detail::protected_count.store(i + 1, std::memory_order_release);
+    return true;
+}
+
+inline void lock_heap(bool locked)
+{
+    detail::heap_locked.store(locked, std::memory_order_relaxed);
+}
+
+inline bool heap_locked()
+{
+    return detail::heap_locked.load(std::memory_order_relaxed);
+}
+
+inline uint32_t heap_violations()
+{
+    return detail::violations.load(std::memory_order_relaxed);
+}
+
+inline void LUMINA_HOT check_allocation()
+{
+    if (!detail::heap_locked.load(std::memory_order_relaxed))
+        return;
+
+    task_id task = current_task();
+    size_t count = detail::protected_count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (detail::protected_tasks[i] != task)
+            continue;
+
+        detail::violations.fetch_add(1, std::memory_order_relaxed);
+#ifdef ESP_PLATFORM
+        static const char LUMINA_HOT_DATA message[] = "heap allocation in a flight-critical task while armed";
+        esp_system_abort(message);
+#endif
+        return;
+    }
+}
+
+}
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <array>
+
+#include <cstddef>
+
+#include "math.hpp"
+#include "vec.hpp"
+#include "placement.hpp"
+
+namespace lumina
+{
+
+/**
+ * Per-motor mixing factors, packed as vec4{roll, pitch, yaw, thrust}.
+ */
+template <size_t N>
+using geometry = std::array<vec4, N>;
+
+/**
+ * Rotor position on the frame: arm angle in degrees clockwise from the nose
+ * (seen from above) and spin direction.
+ */
+struct arm
+{
+    enum spin { CW = -1, CCW = 1 };
+
+    float angle;
+    spin  direction;
+};
+
+/**
+ * Builds mixing factors for rotors on a flat frame. Body axes are NED:
+ * positive roll lowers the right side, positive pitch raises the nose and
+ * positive yaw turns the nose right, which CCW props produce by reaction.
+ * Roll and pitch factors are scaled so the largest one is exactly 1.
+ */
+template <size_t N>
+constexpr geometry<N> make_geometry(const std::array<arm, N>& arms)
+{
+    geometry<N> g{};
+    float scale = 0;
+
+    for (size_t i = 0; i < N; i++)
+    {
+        float a = math::radians(arms[i].angle);
+        g[i] = vec4{-math::sin(a), math::cos(a), static_cast<float>(arms[i].direction), 1};
+        scale = math::abs(g[i][0]) > scale ? math::abs(g[i][0]) : scale;
+        scale = math::abs(g[i][1]) > scale ? math::abs(g[i][1]) : scale;
+    }
+
+    for (auto& m : g)
+    {
+        m[0] = math::abs(m[0]) < 1e-6f ? 0 : m[0] / scale;
+        m[1] = math::abs(m[1]) < 1e-6f ? 0 : m[1] / scale;
+    }
+
+    return g;
+}
+
+namespace layout
+{
+
+// Rear right, front right, rear left, front left (Betaflight order).
+inline constexpr geometry<4> quad_x = make_geometry<4>({{
+    { 135, arm::CW }, { 45, arm::CCW }, { -135, arm::CCW }, { -45, arm::CW }
+}});
+
+// Rear, right, left, front.
+inline constexpr geometry<4> quad_plus = make_geometry<4>({{
+    { 180, arm::CW }, { 90, arm::CCW }, { -90, arm::CCW }, { 0, arm::CW }
+}});
+
+// Clockwise from front right.
+inline constexpr geometry<6> hex_x = make_geometry<6>({{
+    { 30, arm::CW }, { 90, arm::CCW }, { 150, arm::CW }, { -150, arm::CCW }, { -90, arm::CW }, { -30, arm::CCW }
+}});
+
+// Clockwise from front right.
+inline constexpr geometry<8> octo_x = make_geometry<8>({{
+    {   22.5f, arm::CW }, {   67.5f, arm::CCW }, {  112.5f, arm::CW }, {  157.5f, arm::CCW },
+    { -157.5f, arm::CW }, { -112.5f, arm::CCW }, { -67.5f,  arm::CW }, {  -22.5f, arm::CCW }
+}});
+
+static_assert(quad_x[0][0] == -1 && quad_x[0][1] == -1 && quad_x[0][2] == -1);
+static_assert(quad_x[3][0] ==  1 && quad_x[3][1] ==  1 && quad_x[3][2] == -1);
+static_assert(quad_plus[3][0] == 0 && quad_plus[3][1] == 1);
+
+}
+
+
+/**
+ * Maps roll/pitch/yaw/thrust demands to N normalized motor outputs.
+ *
+ * Every call runs the same straight-line passes over the motors:
+ *  1. roll/pitch are mixed and, if their spread exceeds the output range,
+ *     scaled down uniformly;
+ *  2. yaw gets whatever spread is left, so attitude wins over heading;
+ *  3. thrust is shifted into the range (airmode) or authority is reduced
+ *     near zero thrust (no airmode).
+ *
+ * Outputs are thrust fractions; `thrust_stage` turns them into motor commands.
+ */
+template <size_t N>
+class mixer
+{
+public:
+
+    constexpr mixer(const geometry<N>& geometry, bool airmode = true)
+    :   _geometry(geometry),
+        _airmode(airmode),
+        _saturated(false)
+    {}
+
+    static constexpr size_t size()
+    {
+        return N;
+    }
+
+    /**
+     * Replaces the mixing factors, e.g. with a custom layout loaded from parameters.
+     */
+    constexpr void set_geometry(const geometry<N>& geometry)
+    {
+        _geometry = geometry;
+    }
+
+    constexpr const geometry<N>& get_geometry() const
+    {
+        return _geometry;
+    }
+
+    constexpr void airmode(bool enable)
+    {
+        _airmode = enable;
+    }
+
+    /**
+     * True if the last `mix()` could not honour the full roll/pitch/yaw demand.
+     * Rate controllers use this to stop integrating.
+     */
+    constexpr bool saturated() const
+    {
+        return _saturated;
+    }
+
+    /**
+     * @param demand vec4{roll, pitch, yaw, thrust}, attitude axes in [-1, 1] and thrust in [0, 1].
+     *
+     * @return Per-motor thrust in [0, 1].
+     */
+    constexpr std::array<float, N> LUMINA_HOT mix(const vec4& demand)
+    {
+        std::array<float, N> rp{}, yaw{}, out{};
+
+        float rp_min = 0, rp_max = 0;
+        float yaw_min = 0, yaw_max = 0;
+        for (size_t i = 0; i < N; i++)
+        {
+            rp[i]  = demand[0] * _geometry[i][0] + demand[1] * _geometry[i][1];
+            yaw[i] = demand[2] * _geometry[i][2];
+            rp_min = rp[i] < rp_min ? rp[i] : rp_min;
+            rp_max = rp[i] > rp_max ? rp[i] : rp_max;
+            yaw_min = yaw[i] < yaw_min ? yaw[i] : yaw_min;
+            yaw_max = yaw[i] > yaw_max ? yaw[i] : yaw_max;
+        }
+
+        float rp_range = rp_max - rp_min;
+        float rp_scale = rp_range > 1 ? 1 / rp_range : 1;
+        rp_range *= rp_scale;
+
+        // Yaw may only use the spread roll/pitch left free. Bounding the
+        // combined spread by the sum of both keeps this a single pass.
+        float yaw_range = yaw_max - yaw_min;
+        float yaw_scale = yaw_range > 1 - rp_range ? (1 - rp_range) / yaw_range : 1;
+
+        _saturated = rp_scale < 1 || yaw_scale < 1;
+
+        float min = 0, max = 0;
+        for (size_t i = 0; i < N; i++)
+        {
+            out[i] = rp[i] * rp_scale + yaw[i] * yaw_scale;
+            min = out[i] < min ? out[i] : min;
+            max = out[i] > max ? out[i] : max;
+        }
+
+        float thrust = demand[3] < 0 ? 0 : (demand[3] > 1 ? 1 : demand[3]);
+        float authority = 1;
+
+        if (_airmode)
+        {
+            // Shift thrust so the whole spread fits into [0, 1].
+            thrust = thrust < -min ? -min : thrust;
+            thrust = thrust > 1 - max ? 1 - max : thrust;
+        }
+        else
+        {
+            // Keep thrust, give up attitude authority that would push a motor below zero.
+            thrust = thrust > 1 - max ? 1 - max : thrust;
+            if (thrust + min < 0)
+            {
+                authority = thrust / -min;
+                _saturated = true;
+            }
+        }
+
+        for (size_t i = 0; i < N; i++)
+        {
+            float t = thrust + out[i] * authority;
+            out[i] = t < 0 ? 0 : (t > 1 ? 1 : t);
+        }
+
+        return out;
+    }
+
+protected:
+
+    geometry<N> _geometry;
+    bool _airmode;
+    bool _saturated;
+};
+
+static_assert([] {
+    mixer<4> m(layout::quad_x);
+    auto hover = m.mix(vec4{0, 0, 0, 0.5f});
+    auto roll  = m.mix(vec4{1, 0, 1, 0.5f});
+    return hover[0] == 0.5f && hover[3] == 0.5f
+        && roll[0] == 0 && roll[3] == 1 && m.saturated();
+}());
+
+}
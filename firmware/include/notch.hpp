@@ -0,0 +1,473 @@
+#pragma once
+
+#include <array>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "math.hpp"
+#include "vec.hpp"
+#include "fft.hpp"
+#include "ring.hpp"
+#include "filter.hpp"
+#include "seqlock.hpp"
+#include "placement.hpp"
+#include "esc/output.hpp"
+
+namespace lumina
+{
+
+namespace detail
+{
+
+struct spectral_peak
+{
+    float bin = 0;          // interpolated, fractional
+    float power = 0;        // 0 if no peak was found
+};
+
+/**
+ * Strongest local maxima of a power spectrum between bins `first` and
+ * `last`, ordered by frequency. A peak must exceed `threshold` times the
+ * mean power of the range; its position is refined by fitting a parabola
+ * through the magnitudes around it.
+ */
+template <int PEAKS>
+constexpr std::array<spectral_peak, PEAKS> find_peaks(const float* power, size_t first, size_t last, float threshold)
+{
+    std::array<spectral_peak, PEAKS> peaks{};
+
+    float mean = 0;
+    for (size_t k = first; k <= last; k++)
+        mean += power[k];
+    mean /= (last - first + 1);
+
+    for (size_t k = first < 1 ? 1 : first; k <= last; k++)
+    {
+        if (power[k] <= power[k - 1] || power[k] < power[k + 1] || power[k] <= threshold * mean)
+            continue;
+
+        int slot = PEAKS;
+        while (slot > 0 && peaks[slot - 1].power < power[k])
+            slot--;
+        if (slot == PEAKS)
+            continue;
+
+        for (int i = PEAKS - 1; i > slot; i--)
+            peaks[i] = peaks[i - 1];
+
+        float l = math::sqrt(power[k - 1]), c = math::sqrt(power[k]), r = math::sqrt(power[k + 1]);
+        float curvature = l - 2 * c + r;
+        float offset = curvature < 0 ? (l - r) / (2 * curvature) : 0;
+        peaks[slot] = {k + offset, power[k]};
+    }
+
+    for (int i = 1; i < PEAKS; i++)
+        for (int j = i; j > 0 && peaks[j].power > 0 && (peaks[j - 1].power == 0 || peaks[j].bin < peaks[j - 1].bin); j--)
+        {
+            auto tmp = peaks[j];
+            peaks[j] = peaks[j - 1];
+            peaks[j - 1] = tmp;
+        }
+
+    return peaks;
+}
+
+}
+
+
+/**
+ * Notch bank that follows frame resonances found in the gyro spectrum.
+ *
+ * The work is split between two tasks. The filtering task calls
+ * `operator()` on every sample, which applies the notches and pushes
+ * decimated samples into a lock-free ring, and `update()` once per control
+ * iteration, which retunes the notches when new frequencies were published.
+ * A low-priority task calls `analyse()`: it drains the ring into a per-axis
+ * history, Hann-windows and transforms each axis, smooths the `PEAKS`
+ * strongest resonances between `min_hz` and `max_hz` and publishes them
+ * through a seqlock, so the filtering task never runs an FFT. Decimated
+ * samples that find the ring full are dropped.
+ *
+ * Notches start as pass-through and keep their last frequency when a
+ * resonance drops below the detection threshold.
+ */
+template <size_t SIZE = 128, int PEAKS = 3>
+class dynamic_notch
+{
+public:
+
+    using fft_type = real_fft<SIZE>;
+    using frequencies = std::array<std::array<float, PEAKS>, 3>;
+
+public:
+
+    /**
+     * @param sample_hz Rate of the samples passed to `operator()`.
+     * @param decimation Samples averaged per analysed sample.
+     * @param q Notch quality factor.
+     * @param smoothing Fraction of the frequency change applied per analysis.
+     * @param threshold Peak power over mean spectral power required for a detection.
+     */
+    dynamic_notch(float sample_hz, float min_hz = 80, float max_hz = 600, int decimation = 4,
+                  float q = 3.5f, float smoothing = 0.3f, float threshold = 2)
+    :   _sample_hz(sample_hz),
+        _min_hz(min_hz),
+        _max_hz(max_hz),
+        _q(q),
+        _smoothing(smoothing),
+        _threshold(threshold),
+        _decimation(decimation),
+        _accumulator{},
+        _count(0),
+        _tuned{},
+        _seen(0),
+        _write(0),
+        _history{},
+        _buffer{},
+        _frequency{}
+    {
+        float resolution = sample_hz / decimation / SIZE;
+        _first = static_cast<size_t>(min_hz / resolution);
+        _last = static_cast<size_t>(max_hz / resolution + 1);
+        _first = _first < 1 ? 1 : _first;
+        _last = _last > SIZE / 2 - 1 ? SIZE / 2 - 1 : _last;
+
+        for (size_t i = 0; i < SIZE; i++)
+            _window[i] = 0.5f - 0.5f * math::cos(2 * math::pi<float> * i / SIZE);
+    }
+
+    /**
+     * Filters one sample and feeds it to the analysis. Filtering task only.
+     */
+    vec3 LUMINA_HOT operator() (const vec3& x)
+    {
+        _accumulator += x;
+        if (++_count == _decimation)
+        {
+            _samples.push(_accumulator / _decimation);
+            _accumulator = vec3{};
+            _count = 0;
+        }
+
+        vec3 y = x;
+        for (auto& notch : _notches)
+            y = notch(y);
+        return y;
+    }
+
+    /**
+     * Retunes the notches whose published frequency changed. Filtering task only.
+     */
+    void LUMINA_HOT update()
+    {
+        if (_published.sequence() == _seen)
+            return;
+
+        frequencies f;
+        _seen = _published.read(f);
+        for (int a = 0; a < 3; a++)
+            for (int p = 0; p < PEAKS; p++)
+                if (f[a][p] != _tuned[a][p] && _notches[p].axis(a).retune(biquad_coefficients::notch(f[a][p], _sample_hz, _q)))
+                    _tuned[a][p] = f[a][p];
+    }
+
+    /**
+     * Runs the spectral analysis over the latest `SIZE` decimated samples of
+     * every axis and publishes the smoothed resonances. Analysis task only.
+     */
+    void analyse()
+    {
+        vec3 x;
+        while (_samples.pop(x))
+        {
+            for (int a = 0; a < 3; a++)
+                _history[a][_write] = x[a];
+            _write = (_write + 1) % SIZE;
+        }
+
+        for (int a = 0; a < 3; a++)
+        {
+            for (size_t i = 0; i < SIZE; i++)
+                _buffer[i] = _history[a][(_write + i) % SIZE] * _window[i];
+            _fft.transform(_buffer.data());
+            _detect(a);
+        }
+
+        _published.write(_frequency);
+    }
+
+    /**
+     * Center frequency notch `slot` on `axis` is tuned to, 0 while unused.
+     * Filtering task only.
+     */
+    float frequency(int axis, int slot) const
+    {
+        return _tuned[axis][slot];
+    }
+
+protected:
+
+    void _detect(int axis)
+    {
+        std::array<float, SIZE / 2 + 1> power;
+        for (size_t k = _first - 1; k <= _last + 1; k++)
+            power[k] = fft_type::power(_buffer.data(), k);
+
+        auto peaks = detail::find_peaks<PEAKS>(power.data(), _first, _last, _threshold);
+
+        float resolution = _sample_hz / _decimation / SIZE;
+        for (int p = 0; p < PEAKS; p++)
+        {
+            if (peaks[p].power == 0)
+                continue;
+
+            float& f = _frequency[axis][p];
+            float measured = peaks[p].bin * resolution;
+            f = f == 0 ? measured : f + _smoothing * (measured - f);
+            f = f < _min_hz ? _min_hz : (f > _max_hz ? _max_hz : f);
+        }
+    }
+
+protected:
+
+    float _sample_hz;
+    float _min_hz;
+    float _max_hz;
+    float _q;
+    float _smoothing;
+    float _threshold;
+    int _decimation;
+    size_t _first;
+    size_t _last;
+
+    // Filtering task.
+    vec3 _accumulator;
+    int _count;
+    std::array<filter_bank<biquad>, PEAKS> _notches;
+    frequencies _tuned;
+    uint32_t _seen;
+
+    // Shared.
+    ring<vec3, SIZE> _samples;
+    seqlock<frequencies> _published;
+
+    // Analysis task.
+    size_t _write;
+    std::array<std::array<float, SIZE>, 3> _history;
+    fft_type _fft;
+    std::array<float, SIZE> _window;
+    alignas(16) std::array<float, SIZE> _buffer;
+    frequencies _frequency;
+};
+
+static_assert([] {
+    // Two resonances, at 150 Hz and a weaker one at 330 Hz, over broadband
+    // noise, analysed at 2 kHz: both are found within half a bin (7.8 Hz)
+    // and reported in frequency order.
+    constexpr size_t N = 128;
+    constexpr float fs = 2000;
+    float data[N] = {};
+    uint32_t seed = 1;
+    for (size_t i = 0; i < N; i++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        float noise = (seed >> 8) * (1.f / (1 << 24)) - 0.5f;
+        float t = i / fs;
+        float hann = 0.5f - 0.5f * math::cos(2 * math::pi<float> * i / N);
+        data[i] = hann * (math::sin(2 * math::pi<float> * 150 * t) + 0.4f * math::sin(2 * math::pi<float> * 330 * t) + 0.2f * noise);
+    }
+
+    real_fft<N>{}.transform(data);
+    float power[N / 2 + 1] = {};
+    for (size_t k = 0; k <= N / 2; k++)
+        power[k] = real_fft<N>::power(data, k);
+
+    auto peaks = detail::find_peaks<3>(power, 5, 39, 2);
+    float resolution = fs / N;
+    return math::abs(peaks[0].bin * resolution - 150) < resolution / 2
+        && math::abs(peaks[1].bin * resolution - 330) < resolution / 2
+        && peaks[2].power == 0;
+}());
+
+
+
+/**
+ * Notches on every motor's rotation frequency and its harmonics.
+ *
+ * `update()` reads the motors' eRPM once per control iteration, lowpasses
+ * it and recomputes the coefficients of all MOTORS x HARMONICS notches,
+ * which the three gyro axes share. Notches are never tuned below `min_hz`:
+ * over the `fade_hz` above the floor a notch's output is cross-faded back
+ * to its input, so a slowing motor releases its notch gradually instead of
+ * dragging it into the control bandwidth. Harmonics fade out the same way
+ * approaching Nyquist.
+ *
+ * Coefficients are rewritten in place, so `update()` and `operator()` must
+ * run in the same task.
+ */
+template <size_t MOTORS = 4, int HARMONICS = 3>
+class rpm_filter
+{
+public:
+
+    static constexpr size_t NOTCHES = MOTORS * HARMONICS;
+
+public:
+
+    /**
+     * @param pole_pairs Motor magnet pole pairs, eRPM per mechanical RPM.
+     * @param min_hz Lowest notch frequency.
+     * @param fade_hz Width of the cross-fade above `min_hz` and below Nyquist.
+     * @param lpf_hz Cutoff of the lowpass on the motor frequencies.
+     */
+    constexpr rpm_filter(float sample_hz, int pole_pairs = 7, float min_hz = 100, float fade_hz = 50,
+                         float q = 5, float lpf_hz = 150)
+    :   _sample_hz(sample_hz),
+        _pole_pairs(pole_pairs),
+        _min_hz(min_hz),
+        _fade_hz(fade_hz),
+        _q(q),
+        _lpf_hz(lpf_hz),
+        _fundamental{},
+        _coefficients{},
+        _weight{},
+        _state{}
+    {}
+
+    /**
+     * @param dt Time since the previous update in seconds.
+     */
+    template <rpm_source S>
+    constexpr void LUMINA_HOT update(const S& source, float dt)
+    {
+        static_assert(S::size() >= MOTORS);
+
+        float k = dt > 0 ? pt1::gain(_lpf_hz, 1 / dt) : 1;
+        float limit = 0.48f * _sample_hz;
+
+        for (size_t m = 0; m < MOTORS; m++)
+        {
+            float hz = source.erpm(m) / (60.f * _pole_pairs);
+            _fundamental[m] += k * (hz - _fundamental[m]);
+
+            for (int h = 0; h < HARMONICS; h++)
+            {
+                size_t n = m * HARMONICS + h;
+                float f = _fundamental[m] * (h + 1);
+
+                float low = (f - _min_hz) / _fade_hz, high = (limit - f) / _fade_hz;
+                float weight = low < high ? low : high;
+                _weight[n] = weight < 0 ? 0 : (weight > 1 ? 1 : weight);
+
+                if (_weight[n] > 0)
+                    _coefficients[n] = biquad_coefficients::notch(f, _sample_hz, _q);
+            }
+        }
+    }
+
+    constexpr vec3 LUMINA_HOT operator() (const vec3& x)
+    {
+        vec3 y = x;
+        for (size_t n = 0; n < NOTCHES; n++)
+        {
+            if (_weight[n] == 0)
+                continue;
+
+            const auto& k = _coefficients[n];
+            for (int a = 0; a < 3; a++)
+            {
+                auto& s = _state[n][a];
+                float w = y[a] - k[3] * s[0] - k[4] * s[1];
+                float out = k[0] * w + k[1] * s[0] + k[2] * s[1];
+                s[1] = s[0];
+                s[0] = w;
+                y[a] += _weight[n] * (out - y[a]);
+            }
+        }
+        return y;
+    }
+
+    /**
+     * Filtered rotation frequency of `motor` in Hz.
+     */
+    constexpr float frequency(size_t motor) const
+    {
+        return _fundamental[motor];
+    }
+
+protected:
+
+    float _sample_hz;
+    int _pole_pairs;
+    float _min_hz;
+    float _fade_hz;
+    float _q;
+    float _lpf_hz;
+
+    std::array<float, MOTORS> _fundamental;
+    std::array<biquad_coefficients, NOTCHES> _coefficients;
+    std::array<float, NOTCHES> _weight;
+    std::array<std::array<std::array<float, 2>, 3>, NOTCHES> _state;
+};
+
+namespace detail
+{
+
+template <size_t N>
+struct constant_rpm
+{
+    std::array<uint32_t, N> values;
+
+    static constexpr size_t size() { return N; }
+    constexpr uint32_t erpm(size_t i) const { return values[i]; }
+};
+
+static_assert(rpm_source<constant_rpm<4>>);
+
+}
+
+static_assert([] {
+    // A motor at 12000 RPM (7 pole pairs) puts 200 Hz and 400 Hz into the
+    // gyro: after settling both are attenuated more than 20 dB.
+    rpm_filter<1, 2> filter(8000);
+    filter.update(detail::constant_rpm<1>{{84000}}, 0);
+
+    float in = 0, out = 0;
+    for (int i = 0; i < 1200; i++)
+    {
+        float t = i / 8000.f;
+        float x = math::sin(2 * math::pi<float> * 200 * t) + 0.5f * math::sin(2 * math::pi<float> * 400 * t);
+        float y = filter(vec3{x, 0, 0})[0];
+        if (i >= 600)
+        {
+            in += x * x;
+            out += y * y;
+        }
+    }
+    return out < in / 100 && math::abs(filter.frequency(0) - 200) < 0.01f;
+}());
+
+static_assert([] {
+    // Halfway into the fade above the floor the notch only removes half
+    // the tone; below the floor the signal passes untouched.
+    rpm_filter<1, 1> filter(8000, 7, 100, 50);
+    filter.update(detail::constant_rpm<1>{{125 * 60 * 7}}, 0);
+    float x = 0, y = 0;
+    for (int i = 0; i < 1200; i++)
+    {
+        float s = math::sin(2 * math::pi<float> * 125 * i / 8000.f);
+        float f = filter(vec3{s, 0, 0})[0];
+        if (i >= 600)
+        {
+            x += s * s;
+            y += f * f;
+        }
+    }
+
+    rpm_filter<1, 1> stopped(8000, 7, 100, 50);
+    stopped.update(detail::constant_rpm<1>{{60 * 60 * 7}}, 0);
+    return math::abs(y / x - 0.25f) < 0.02f && stopped(vec3{0.3f, 0, 0})[0] == 0.3f;
+}());
+
+}
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+#include <cstdint>
+
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "check.hpp"
+#else
+#include <chrono>
+#include <thread>
+#endif
+
+#include "profile.hpp"
+#include "trace.hpp"
+
+namespace lumina
+{
+
+#ifdef ESP_PLATFORM
+using task_priority = UBaseType_t;
+#else
+using task_priority = unsigned;
+#endif
+
+/**
+ * Scheduling parameters of a periodic task. Under rate-monotonic priority
+ * assignment, shorter periods get higher priorities.
+ */
+struct task_config
+{
+    const char* name;
+    uint32_t period_us;
+    task_priority priority = 1;
+    int core = -1;                  // -1 for no affinity
+    uint32_t deadline_us = 0;       // relative to the release, 0 for the period
+    uint32_t stack = 4096;
+};
+
+struct task_stats
+{
+    uint32_t releases;
+    uint32_t overruns;              // iterations that finished past their deadline
+    uint32_t skipped;               // releases that found the task still busy
+    uint32_t worst_us;              // longest release-to-completion time
+};
+
+
+/**
+ * Task that runs `body(tick)` once per period.
+ *
+ * Releases sit on an absolute timeline, `start + n * period`, so they never
+ * drift the way relative sleeps do. On target an esp_timer (1 us
+ * resolution, independent of the 100 Hz FreeRTOS tick) raises each release
+ * and wakes the task through its notification; the task is pinned and
+ * prioritized as configured. On the host the task is a std::thread that
+ * sleeps until the next absolute release.
+ *
+ * Each iteration's response time, from its nominal release to the end of
+ * `body`, is checked against the deadline; misses and releases that found
+ * the task still running are counted. Profiling builds also time `body` in
+ * a probe named after the task, and tracing builds record it as a span.
+ */
+template <typename F>
+class periodic_task
+{
+public:
+
+    periodic_task(const task_config& config, F body)
+    :   _config(config),
+        _body(std::move(body)),
+        _tick(0),
+        _releases(0),
+        _overruns(0),
+        _skipped(0),
+        _worst_us(0)
+    {
+        if (_config.deadline_us == 0)
+            _config.deadline_us = _config.period_us;
+
+#ifdef ESP_PLATFORM
+        BaseType_t core = _config.core < 0 ? tskNO_AFFINITY : _config.core;
+        xTaskCreatePinnedToCore(&periodic_task::_run, _config.name, _config.stack, this, _config.priority, &_task, core);
+
+        esp_timer_create_args_t timer_config = {};
+        timer_config.callback = &periodic_task::_on_timer;
+        timer_config.arg = this;
+        timer_config.dispatch_method = ESP_TIMER_TASK;
+        timer_config.name = _config.name;
+        ESP_CHECK(esp_timer_create(&timer_config, &_timer));
+
+        _start = esp_timer_get_time() + _config.period_us;
+        ESP_CHECK(esp_timer_start_periodic(_timer, _config.period_us));
+#else
+        _running.store(true);
+        _thread = std::thread([this] { _run(); });
+#endif
+    }
+
+    periodic_task(const periodic_task&) = delete;
+    periodic_task& operator= (const periodic_task&) = delete;
+
+    ~periodic_task()
+    {
+#ifdef ESP_PLATFORM
+        ESP_CHECK(esp_timer_stop(_timer));
+        ESP_CHECK(esp_timer_delete(_timer));
+        vTaskDelete(_task);
+#else
+        _running.store(false);
+        _thread.join();
+#endif
+    }
+
+    task_stats stats() const
+    {
+        return {
+            _releases.load(std::memory_order_relaxed),
+            _overruns.load(std::memory_order_relaxed),
+            _skipped.load(std::memory_order_relaxed),
+            _worst_us.load(std::memory_order_relaxed)
+        };
+    }
+
+    const task_config& config() const
+    {
+        return _config;
+    }
+
+protected:
+
+    // Runs the body for a release nominally due at `release`.
+    void _iteration(int64_t release)
+    {
+        {
+#if LUMINA_PROFILE
+            profile::scope timed(_probe);
+#endif
+#if LUMINA_TRACE
+            trace::span traced(_trace_name);
+#endif
+            _body(_tick);
+        }
+        _tick++;
+
+        int64_t response = _now() - release;
+        if (response > _config.deadline_us)
+            _overruns.fetch_add(1, std::memory_order_relaxed);
+        if (response > _worst_us.load(std::memory_order_relaxed))
+            _worst_us.store(static_cast<uint32_t>(response), std::memory_order_relaxed);
+    }
+
+#ifdef ESP_PLATFORM
+
+    static int64_t _now()
+    {
+        return esp_timer_get_time();
+    }
+
+    static void _on_timer(void* arg)
+    {
+        periodic_task& self = *static_cast<periodic_task*>(arg);
+        self._releases.fetch_add(1, std::memory_order_relaxed);
+        xTaskNotifyGive(self._task);
+    }
+
+    static void _run(void* arg)
+    {
+        periodic_task& self = *static_cast<periodic_task*>(arg);
+        uint32_t handled = 0;
+
+        for (;;)
+        {
+            uint32_t pending = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            if (pending > 1)
+                self._skipped.fetch_add(pending - 1, std::memory_order_relaxed);
+
+            // Run for the latest release only; a late task catches up rather
+            // than replaying the ones it missed.
+            handled += pending;
+            self._iteration(self._start + int64_t(handled - 1) * self._config.period_us);
+        }
+    }
+
+#else
+
+    static int64_t _now()
+    {
+        using namespace std::chrono;
+        return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    void _run()
+    {
+        using clock = std::chrono::steady_clock;
+        auto period = std::chrono::microseconds(_config.period_us);
+        auto release = clock::now() + period;
+        int64_t nominal = _now() + _config.period_us;
+
+        while (_running.load())
+        {
+            std::this_thread::sleep_until(release);
+            _releases.fetch_add(1, std::memory_order_relaxed);
+            _iteration(nominal);
+
+            release += period;
+            nominal += _config.period_us;
+            for (auto now = clock::now(); release <= now; release += period, nominal += _config.period_us)
+            {
+                _releases.fetch_add(1, std::memory_order_relaxed);
+                _skipped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+#endif
+
+protected:
+
+    task_config _config;
+    F _body;
+
+    uint32_t _tick;
+
+    std::atomic<uint32_t> _releases;
+    std::atomic<uint32_t> _overruns;
+    std::atomic<uint32_t> _skipped;
+    std::atomic<uint32_t> _worst_us;
+
+#if LUMINA_PROFILE
+    profile::probe _probe{_config.name};
+#endif
+#if LUMINA_TRACE
+    uint16_t _trace_name = trace::intern(_config.name);
+#endif
+
+#ifdef ESP_PLATFORM
+    TaskHandle_t _task;
+    esp_timer_handle_t _timer;
+    int64_t _start;
+#else
+    std::atomic<bool> _running;
+    std::thread _thread;
+#endif
+};
+
+}
@@ -0,0 +1,266 @@
+#pragma once
+
+#include <array>
+
+#include "math.hpp"
+#include "vec.hpp"
+#include "quat.hpp"
+#include "placement.hpp"
+
+namespace lumina
+{
+
+struct pid_gains
+{
+    float kp = 0;
+    float ki = 0;
+    float kd = 0;
+    float kf = 0;                       // on the setpoint derivative
+    float i_limit = 0.3f;               // bound of the integral term
+    float d_cutoff_hz = 100;            // first-order lowpass on the D term, 0 disables it
+};
+
+
+/**
+ * Single-axis PID controller.
+ *
+ * D acts on the measurement, so setpoint steps do not kick, and is lowpass
+ * filtered. Feed-forward acts on the setpoint derivative. The integral only
+ * grows while the actuators have headroom: when the caller reports saturation
+ * it is only allowed to shrink, and it is always clamped to `i_limit`.
+ */
+class pid
+{
+public:
+
+    constexpr pid(const pid_gains& gains = {})
+    :   _gains(gains),
+        _integral(0),
+        _derivative(0),
+        _last_setpoint(0),
+        _last_measurement(0),
+        _primed(false)
+    {}
+
+    constexpr void gains(const pid_gains& gains)
+    {
+        _gains = gains;
+    }
+
+    constexpr const pid_gains& gains() const
+    {
+        return _gains;
+    }
+
+    constexpr void reset()
+    {
+        _integral = 0;
+        _derivative = 0;
+        _primed = false;
+    }
+
+    /**
+     * @param attenuation Factor on P and D, from throttle PID attenuation.
+     * @param saturated True if the previous output could not be applied in full.
+     */
+    constexpr float LUMINA_HOT update(float setpoint, float measurement, float dt, bool saturated = false, float attenuation = 1)
+    {
+        float error = setpoint - measurement;
+        float p = _gains.kp * error * attenuation;
+
+        float d = 0, f = 0;
+        if (_primed && dt > 0)
+        {
+            float derivative = (_last_measurement - measurement) / dt;
+            if (_gains.d_cutoff_hz > 0)
+                _derivative += dt / (dt + 1 / (2 * math::pi<float> * _gains.d_cutoff_hz)) * (derivative - _derivative);
+            else
+                _derivative = derivative;
+
+            d = _gains.kd * _derivative * attenuation;
+            f = _gains.kf * (setpoint - _last_setpoint) / dt;
+        }
+
+        float integral = _integral + _gains.ki * error * dt;
+        if (!saturated || math::abs(integral) < math::abs(_integral))
+            _integral = integral < -_gains.i_limit ? -_gains.i_limit : (integral > _gains.i_limit ? _gains.i_limit : integral);
+
+        _last_setpoint = setpoint;
+        _last_measurement = measurement;
+        _primed = true;
+
+        return p + _integral + d + f;
+    }
+
+    constexpr float integral() const
+    {
+        return _integral;
+    }
+
+protected:
+
+    pid_gains _gains;
+
+    float _integral;
+    float _derivative;
+    float _last_setpoint;
+    float _last_measurement;
+    bool _primed;
+};
+
+
+/**
+ * Throttle PID attenuation: above `breakpoint` the P and D gains fall
+ * linearly, reaching 1 - `rate` at full throttle, since thrust (and with it
+ * loop gain) grows with motor speed.
+ */
+struct tpa
+{
+    float breakpoint = 0.5f;
+    float rate = 0;
+
+    constexpr float LUMINA_HOT operator() (float throttle) const
+    {
+        if (rate <= 0 || throttle <= breakpoint || breakpoint >= 1)
+            return 1;
+        return 1 - rate * ((throttle > 1 ? 1 : throttle) - breakpoint) / (1 - breakpoint);
+    }
+};
+
+
+/**
+ * Inner loop: body rates in rad/s to normalized roll/pitch/yaw demands for
+ * the mixer. TPA applies to roll and pitch only, yaw authority does not
+ * scale with thrust the same way.
+ */
+class rate_controller
+{
+public:
+
+    constexpr rate_controller(const std::array<pid_gains, 3>& gains, const tpa& attenuation = {}, float limit = 1)
+    :   _axes{pid(gains[0]), pid(gains[1]), pid(gains[2])},
+        _tpa(attenuation),
+        _limit(limit)
+    {}
+
+    constexpr pid& axis(int i)
+    {
+        return _axes[i];
+    }
+
+    constexpr void reset()
+    {
+        for (auto& axis : _axes)
+            axis.reset();
+    }
+
+    /**
+     * @param throttle Collective thrust in [0, 1], for TPA.
+     * @param saturated Mixer saturation of the previous cycle, see `mixer::saturated()`.
+     */
+    constexpr vec3 LUMINA_HOT update(const vec3& setpoint, const vec3& gyro, float dt, float throttle, bool saturated)
+    {
+        float attenuation = _tpa(throttle);
+
+        vec3 out{};
+        for (int i = 0; i < 3; i++)
+        {
+            float u = _axes[i].update(setpoint[i], gyro[i], dt, saturated, i < 2 ? attenuation : 1);
+            out[i] = u < -_limit ? -_limit : (u > _limit ? _limit : u);
+        }
+        return out;
+    }
+
+protected:
+
+    std::array<pid, 3> _axes;
+    tpa _tpa;
+    float _limit;
+};
+
+
+/**
+ * Outer loop: attitude error to body rate setpoints.
+ *
+ * The error is the shortest rotation from the estimate to the setpoint,
+ * taken as a rotation vector in body axes, so large errors and yaw wrap are
+ * handled without Euler angles. The optional integral is clamped per axis.
+ */
+class angle_controller
+{
+public:
+
+    /**
+     * @param kp Rate per radian of error, per axis.
+     * @param max_rate Rate setpoint limit in rad/s, per axis.
+     * @param ki Integral gain, per axis.
+     * @param i_limit Integral bound in rad/s.
+     */
+    constexpr angle_controller(const vec3& kp, const vec3& max_rate, const vec3& ki = {}, float i_limit = 0.5f)
+    :   _kp(kp),
+        _ki(ki),
+        _max_rate(max_rate),
+        _i_limit(i_limit),
+        _integral{}
+    {}
+
+    constexpr void reset()
+    {
+        _integral = vec3{};
+    }
+
+    /**
+     * @param feedforward Body rate added to the correction, e.g. from stick input.
+     */
+    constexpr vec3 LUMINA_HOT update(const quat& attitude, const quat& setpoint, float dt, const vec3& feedforward = {})
+    {
+        quat e = attitude.conjugate() * setpoint;
+        vec3 error = e.imag() * (e.w() < 0 ? -2.f : 2.f);
+
+        vec3 rate{};
+        for (int i = 0; i < 3; i++)
+        {
+            float integral = _integral[i] + _ki[i] * error[i] * dt;
+            _integral[i] = integral < -_i_limit ? -_i_limit : (integral > _i_limit ? _i_limit : integral);
+
+            float r = _kp[i] * error[i] + _integral[i] + feedforward[i];
+            rate[i] = r < -_max_rate[i] ? -_max_rate[i] : (r > _max_rate[i] ? _max_rate[i] : r);
+        }
+        return rate;
+    }
+
+protected:
+
+    vec3 _kp;
+    vec3 _ki;
+    vec3 _max_rate;
+    float _i_limit;
+    vec3 _integral;
+};
+
+static_assert(tpa{0.5f, 0.4f}(0.25f) == 1 && tpa{0.5f, 0.4f}(1) == 0.6f);
+
+static_assert([] {
+    // Rate step on a first-order plant (30 ms motor lag, 100 rad/s per unit
+    // demand) with a constant disturbance: settles within 2 % in 0.3 s,
+    // overshoots less than 5 % and the integral absorbs the disturbance.
+    rate_controller c({ pid_gains{0.03f, 0.5f, 0.0005f, 0, 0.3f, 100}, {}, {} });
+    float rate = 0, peak = 0, dt = 0.001f;
+    for (int i = 0; i < 300; i++)
+    {
+        float u = c.update(vec3{10, 0, 0}, vec3{rate, 0, 0}, dt, 0.5f, false)[0];
+        rate += (100 * (u - 0.1f) - rate) * dt / 0.03f;
+        peak = rate > peak ? rate : peak;
+    }
+    return math::abs(rate - 10) < 0.2f && peak < 10.5f && math::abs(c.axis(0).integral() - 0.2f) < 0.01f;
+}());
+
+static_assert([] {
+    // A 90 degree yaw error commands a yaw rate the short way round, clamped.
+    angle_controller c(vec3{6, 6, 4}, vec3{5, 5, 3});
+    quat target = quat::axis_angle(vec3{0, 0, 1}, -math::pi<float> / 2);
+    vec3 rate = c.update(quat::identity(), target, 0.001f);
+    return rate[0] == 0 && rate[1] == 0 && rate[2] == -3;
+}());
+
+}
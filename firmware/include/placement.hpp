@@ -0,0 +1,28 @@
+#pragma once
+
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+#endif
+
+/**
+ * Memory placement of the real-time path.
+ *
+ * Code and constants live in flash by default and run through the cache, so
+ * a cache miss stalls for microseconds, longer while a flash write such as
+ * an NVS commit holds the cache. LUMINA_HOT keeps a function in IRAM and
+ * LUMINA_HOT_DATA keeps a constant table in DRAM. Both go on the path from
+ * the sensor and receiver to the ESC write, and on anything an IRAM
+ * interrupt handler calls; IRAM is scarce, so nothing else gets them.
+ *
+ * The attributes work on inline, constexpr and template functions alike,
+ * each instance getting its own .iram1.N section. Code that cannot carry
+ * them is placed by src/placement.lf, and tools/placement.py reports hot
+ * symbols that still ended up in flash. On the host both expand to nothing.
+ */
+#ifdef ESP_PLATFORM
+#define LUMINA_HOT IRAM_ATTR
+#define LUMINA_HOT_DATA DRAM_ATTR
+#else
+#define LUMINA_HOT
+#define LUMINA_HOT_DATA
+#endif
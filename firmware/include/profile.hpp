@@ -0,0 +1,345 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef ESP_PLATFORM
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#else
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#endif
+
+#include "seqlock.hpp"
+#include "histogram.hpp"
+#include "placement.hpp"
+
+/**
+ * Timing instrumentation is compiled in with -DLUMINA_PROFILE=1. Without it
+ * LUMINA_PROFILE_SCOPE expands to nothing and periodic tasks keep no probe,
+ * so a disabled build carries no instrumentation code or data at all.
+ */
+#ifndef LUMINA_PROFILE
+#define LUMINA_PROFILE 0
+#endif
+
+namespace lumina::profile
+{
+
+#ifdef ESP_PLATFORM
+
+/**
+ * CPU cycle counter of the calling core. The two cores' counters are not
+ * synchronized, so only differences taken on one core are meaningful.
+ */
+inline uint32_t cycles()
+{
+    return esp_cpu_get_cycle_count();
+}
+
+inline uint32_t cycles_per_us()
+{
+    return esp_rom_get_cpu_ticks_per_us();
+}
+
+#else
+
+// Nanoseconds stand in for cycles on the host.
+inline uint32_t cycles()
+{
+    using namespace std::chrono;
+    return static_cast<uint32_t>(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+inline uint32_t cycles_per_us()
+{
+    return 1000;
+}
+
+#endif
+
+
+/**
+ * Summary of one probe, in microseconds.
+ */
+struct timing
+{
+    const char* name;
+    uint32_t count;
+    float min_us;
+    float mean_us;
+    float max_us;
+    float p99_us;                   // upper bound of the 99th percentile's log2 bucket
+    float jitter_us;                // spread between the shortest and longest interval between starts
+};
+
+
+/**
+ * Execution time statistics of one code site.
+ *
+ * Each `record()` takes the start and end cycle counts of one execution and
+ * updates min/mean/max, a log2 histogram of durations, and the spread of the
+ * intervals between consecutive starts, which is the activation jitter of a
+ * periodic site. The writer keeps its running totals privately and publishes
+ * a copy through a seqlock, so reporting from other tasks never blocks it.
+ *
+ * A probe belongs to one task; a site that runs on both cores, or a task that
+ * migrates mid-execution, produces bogus samples since cycle counters are per
+ * core. Probes register themselves for `for_each()` and `log()`.
+ */
+class probe
+{
+public:
+
+    static constexpr size_t MAX_PROBES = 32;
+
+public:
+
+    probe(const char* name)
+    :   _name(name),
+        _totals{},
+        _last_start(0)
+    {
+        for (auto& slot : _registry)
+        {
+            probe* empty = nullptr;
+            if (slot.compare_exchange_strong(empty, this, std::memory_order_release, std::memory_order_relaxed))
+                break;
+        }
+    }
+
+    probe(const probe&) = delete;
+    probe& operator= (const probe&) = delete;
+
+    ~probe()
+    {
+        for (auto& slot : _registry)
+        {
+            probe* self = this;
+            if (slot.compare_exchange_strong(self, nullptr, std::memory_order_relaxed))
+                break;
+        }
+    }
+
+    void LUMINA_HOT record(uint32_t start, uint32_t end)
+    {
+        uint32_t duration = end - start;
+        if (_totals.count == 0 || duration < _totals.min)
+            _totals.min = duration;
+        if (duration > _totals.max)
+            _totals.max = duration;
+        _totals.total += duration;
+        _totals.count++;
+
+        if (_totals.count > 1)
+        {
+            uint32_t interval = start - _last_start;
+            if (_totals.count == 2 || interval < _totals.min_interval)
+                _totals.min_interval = interval;
+            if (interval > _totals.max_interval)
+                _totals.max_interval = interval;
+        }
+        _last_start = start;
+
+        _distribution.record(duration);
+        _published.write(_totals);
+    }
+
+    timing read() const
+    {
+        totals t;
+        _published.read(t);
+
+        float scale = 1.f / cycles_per_us();
+        timing result = { _name, t.count, 0, 0, 0, 0, 0 };
+        if (t.count == 0)
+            return result;
+
+        result.min_us = t.min * scale;
+        result.mean_us = static_cast<float>(t.total) / t.count * scale;
+        result.max_us = t.max * scale;
+        uint32_t p99 = _distribution.percentile(0.99f);
+        result.p99_us = (p99 < t.max ? p99 : t.max) * scale;
+        result.jitter_us = (t.max_interval - t.min_interval) * scale;
+        return result;
+    }
+
+    const histogram<32>& distribution() const
+    {
+        return _distribution;
+    }
+
+    const char* name() const
+    {
+        return _name;
+    }
+
+    /**
+     * Calls `f(const probe&)` for every live probe.
+     */
+    template <typename F>
+    static void for_each(F&& f)
+    {
+        for (const auto& slot : _registry)
+            if (const probe* p = slot.load(std::memory_order_acquire))
+                f(*p);
+    }
+
+protected:
+
+    struct totals
+    {
+        uint32_t count;
+        uint32_t min;
+        uint32_t max;
+        uint32_t min_interval;
+        uint32_t max_interval;
+        uint64_t total;
+    };
+
+    const char* _name;
+    totals _totals;
+    uint32_t _last_start;
+
+    histogram<32> _distribution;
+    seqlock<totals> _published;
+
+    static inline std::array<std::atomic<probe*>, MAX_PROBES> _registry{};
+};
+
+
+/**
+ * Records the lifetime of a block into a probe.
+ */
+class scope
+{
+public:
+
+    scope(probe& p)
+    :   _probe(p),
+        _start(cycles())
+    {}
+
+    scope(const scope&) = delete;
+    scope& operator= (const scope&) = delete;
+
+    ~scope()
+    {
+        _probe.record(_start, cycles());
+    }
+
+protected:
+
+    probe& _probe;
+    uint32_t _start;
+};
+
+
+/**
+ * Busy fraction of each core between consecutive `sample()` calls.
+ *
+ * On target this is one minus the idle task's share of the FreeRTOS run-time
+ * counter, which needs CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS; without it
+ * every core reads as 0. On the host there is a single "core": the process's
+ * CPU time over wall time, which exceeds 1 when several threads run.
+ */
+class cpu_load
+{
+public:
+
+#ifdef ESP_PLATFORM
+    static constexpr size_t CORES = portNUM_PROCESSORS;
+#else
+    static constexpr size_t CORES = 1;
+#endif
+
+public:
+
+    cpu_load()
+    {
+        sample();
+    }
+
+    std::array<float, CORES> sample()
+    {
+        std::array<float, CORES> load{};
+
+#ifdef ESP_PLATFORM
+#if configGENERATE_RUN_TIME_STATS
+        uint32_t now = portGET_RUN_TIME_COUNTER_VALUE();
+        uint32_t elapsed = now - _time;
+        _time = now;
+
+        for (size_t core = 0; core < CORES; core++)
+        {
+            uint32_t idle = ulTaskGetRunTimeCounter(xTaskGetIdleTaskHandleForCore(core));
+            if (elapsed)
+                load[core] = 1 - static_cast<float>(idle - _idle[core]) / elapsed;
+            _idle[core] = idle;
+        }
+#endif
+#else
+        using namespace std::chrono;
+        int64_t now = duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+        std::clock_t busy = std::clock();
+        if (now > _time)
+            load[0] = static_cast<float>(busy - _busy) * 1e6f / CLOCKS_PER_SEC / (now - _time);
+        _time = now;
+        _busy = busy;
+#endif
+
+        return load;
+    }
+
+protected:
+
+#ifdef ESP_PLATFORM
+    uint32_t _time = 0;
+    std::array<uint32_t, CORES> _idle{};
+#else
+    int64_t _time = 0;
+    std::clock_t _busy = 0;
+#endif
+};
+
+
+/**
+ * Writes a table of every probe to the console.
+ */
+inline void log()
+{
+    probe::for_each([](const probe& p) {
+        timing t = p.read();
+#ifdef ESP_PLATFORM
+        ESP_LOGI("PROFILE", "%-12s n=%-8lu min %8.1f  mean %8.1f  max %8.1f  p99 %8.1f  jitter %8.1f us", t.name,
+            static_cast<unsigned long>(t.count), t.min_us, t.mean_us, t.max_us, t.p99_us, t.jitter_us);
+#else
+        std::printf("%-12s n=%-8lu min %8.1f  mean %8.1f  max %8.1f  p99 %8.1f  jitter %8.1f us\n", t.name,
+            static_cast<unsigned long>(t.count), t.min_us, t.mean_us, t.max_us, t.p99_us, t.jitter_us);
+#endif
+    });
+}
+
+}
+
+#if LUMINA_PROFILE
+#define LUMINA_PROFILE_CONCAT_(a, b) a##b
+#define LUMINA_PROFILE_CONCAT(a, b) LUMINA_PROFILE_CONCAT_(a, b)
+
+/**
+ * Times the rest of the enclosing block under `name`, a string literal.
+ */
+#define LUMINA_PROFILE_SCOPE(name)                                                          \
+    static lumina::profile::probe LUMINA_PROFILE_CONCAT(_profile_probe_, __LINE__)(name);   \
+    lumina::profile::scope LUMINA_PROFILE_CONCAT(_profile_scope_, __LINE__)(LUMINA_PROFILE_CONCAT(_profile_probe_, __LINE__))
+#else
+#define LUMINA_PROFILE_SCOPE(name) do {} while (0)
+#endif
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+
+#include "vec.hpp"
+
+namespace lumina
+{
+
+/**
+ * Hamilton quaternion stored as [w, x, y, z], null rotation being 1 0 0 0.
+ * Matches the component order MAVLink uses for attitude messages.
+ */
+template<typename T>
+class quaternion : public std::array<T, 4>
+{
+public:
+
+    static constexpr quaternion identity()
+    {
+        return {1, 0, 0, 0};
+    }
+
+    /**
+     * Rotation of `angle` radians about the unit `axis`.
+     */
+    static constexpr quaternion axis_angle(const vec<3, T> &axis, T angle)
+    {
+        T s = math::sin(angle / 2);
+        return {math::cos(angle / 2), axis[0] * s, axis[1] * s, axis[2] * s};
+    }
+
+    constexpr T& w() { return (*this)[0]; }
+    constexpr T& x() { return (*this)[1]; }
+    constexpr T& y() { return (*this)[2]; }
+    constexpr T& z() { return (*this)[3]; }
+
+    constexpr T w() const { return (*this)[0]; }
+    constexpr T x() const { return (*this)[1]; }
+    constexpr T y() const { return (*this)[2]; }
+    constexpr T z() const { return (*this)[3]; }
+
+    constexpr vec<3, T> imag() const
+    {
+        return {x(), y(), z()};
+    }
+
+    constexpr quaternion conjugate() const
+    {
+        return {w(), -x(), -y(), -z()};
+    }
+
+    constexpr T norm() const
+    {
+        return math::sqrt(w() * w() + x() * x() + y() * y() + z() * z());
+    }
+
+    constexpr quaternion normalized() const
+    {
+        T n = norm();
+        if(n == 0) return identity();
+        return *this * (1 / n);
+    }
+
+    /**
+     * Rotates `v` from the body frame into the reference frame.
+     */
+    constexpr vec<3, T> rotate(const vec<3, T> &v) const
+    {
+        vec<3, T> u = imag();
+        vec<3, T> t = u.cross(v) * 2;
+        return v + t * w() + u.cross(t);
+    }
+
+    constexpr quaternion operator*(const quaternion &q) const
+    {
+        return {
+            w() * q.w() - x() * q.x() - y() * q.y() - z() * q.z(),
+            w() * q.x() + x() * q.w() + y() * q.z() - z() * q.y(),
+            w() * q.y() - x() * q.z() + y() * q.w() + z() * q.x(),
+            w() * q.z() + x() * q.y() - y() * q.x() + z() * q.w()
+        };
+    }
+
+    constexpr quaternion operator+(const quaternion &q) const
+    {
+        return {w() + q.w(), x() + q.x(), y() + q.y(), z() + q.z()};
+    }
+
+    constexpr quaternion operator*(T s) const
+    {
+        return {w() * s, x() * s, y() * s, z() * s};
+    }
+
+    constexpr quaternion &operator*=(const quaternion &q)
+    {
+        return *this = *this * q;
+    }
+
+    constexpr quaternion &operator+=(const quaternion &q)
+    {
+        return *this = *this + q;
+    }
+
+};
+
+using quat = quaternion<float>;
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include <cstddef>
+
+#include "placement.hpp"
+
+namespace lumina
+{
+
+/**
+ * Lock-free single-producer single-consumer ring buffer.
+ *
+ * The producer only writes `_head` and the consumer only writes `_tail`, so
+ * one side may run in an ISR or on the other core without any locking.
+ * `N` must be a power of two; one slot is never used to tell full from empty.
+ */
+template <typename T, size_t N>
+class ring
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "ring size must be a power of two");
+
+public:
+
+    ring()
+    :   _head(0),
+        _tail(0)
+    {}
+
+    bool LUMINA_HOT push(const T& value)
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+        size_t next = (head + 1) & (N - 1);
+        if (next == _tail.load(std::memory_order_acquire))
+            return false;
+
+        _buffer[head] = value;
+        _head.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool LUMINA_HOT pop(T& value)
+    {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire))
+            return false;
+
+        value = _buffer[tail];
+        _tail.store((tail + 1) & (N - 1), std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const
+    {
+        return (_head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire)) & (N - 1);
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    static constexpr size_t capacity()
+    {
+        return N - 1;
+    }
+
+protected:
+
+    std::array<T, N> _buffer;
+
+    alignas(4) std::atomic<size_t> _head;
+    alignas(4) std::atomic<size_t> _tail;
+};
+
+}
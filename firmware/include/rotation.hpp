@@ -0,0 +1,181 @@
+#pragma once
+
+#include <array>
+
+#include "math.hpp"
+#include "vec.hpp"
+#include "mat.hpp"
+#include "quat.hpp"
+
+namespace lumina
+{
+
+/**
+ * Constexpr counterparts of the helpers in mavlink/mavlink_conversions.h.
+ *
+ * Euler angles are packed as vec{roll, pitch, yaw} in radians, quaternions are
+ * [w, x, y, z] and DCMs rotate body vectors into the reference frame, exactly
+ * as in the MAVLink C helpers.
+ */
+
+template<typename T>
+constexpr mat<3, 3, T> quaternion_to_dcm(const quaternion<T> &q)
+{
+    T a = q.w(), b = q.x(), c = q.y(), d = q.z();
+    T aa = a * a, bb = b * b, cc = c * c, dd = d * d;
+
+    using row = vec<3, T>;
+    return mat<3, 3, T>{
+        row{aa + bb - cc - dd, 2 * (b * c - a * d), 2 * (a * c + b * d)},
+        row{2 * (b * c + a * d), aa - bb + cc - dd, 2 * (c * d - a * b)},
+        row{2 * (b * d - a * c), 2 * (a * b + c * d), aa - bb - cc + dd}
+    };
+}
+
+template<typename T>
+constexpr vec<3, T> dcm_to_euler(const mat<3, 3, T> &dcm)
+{
+    T theta = math::asin(-dcm[2][0]);
+
+    if (math::abs(theta - math::pi<T> / 2) < T(1.0e-3))
+        return {0, theta, math::atan2(dcm[1][2] - dcm[0][1], dcm[0][2] + dcm[1][1])};
+
+    if (math::abs(theta + math::pi<T> / 2) < T(1.0e-3))
+        return {0, theta, math::atan2(dcm[1][2] - dcm[0][1], dcm[0][2] + dcm[1][1])};
+
+    return {math::atan2(dcm[2][1], dcm[2][2]), theta, math::atan2(dcm[1][0], dcm[0][0])};
+}
+
+template<typename T>
+constexpr vec<3, T> quaternion_to_euler(const quaternion<T> &q)
+{
+    return dcm_to_euler(quaternion_to_dcm(q));
+}
+
+template<typename T>
+constexpr quaternion<T> euler_to_quaternion(const vec<3, T> &euler)
+{
+    T cr = math::cos(euler[0] / 2), sr = math::sin(euler[0] / 2);
+    T cp = math::cos(euler[1] / 2), sp = math::sin(euler[1] / 2);
+    T cy = math::cos(euler[2] / 2), sy = math::sin(euler[2] / 2);
+
+    return {
+        cr * cp * cy + sr * sp * sy,
+        sr * cp * cy - cr * sp * sy,
+        cr * sp * cy + sr * cp * sy,
+        cr * cp * sy - sr * sp * cy
+    };
+}
+
+template<typename T>
+constexpr quaternion<T> dcm_to_quaternion(const mat<3, 3, T> &dcm)
+{
+    quaternion<T> q{};
+
+    T tr = dcm[0][0] + dcm[1][1] + dcm[2][2];
+    if (tr > 0)
+    {
+        T s = math::sqrt(tr + 1);
+        q[0] = s / 2;
+        s = T(0.5) / s;
+        q[1] = (dcm[2][1] - dcm[1][2]) * s;
+        q[2] = (dcm[0][2] - dcm[2][0]) * s;
+        q[3] = (dcm[1][0] - dcm[0][1]) * s;
+    }
+    else
+    {
+        int i = 0;
+        for (int n = 1; n < 3; n++)
+            if (dcm[n][n] > dcm[i][i])
+                i = n;
+
+        int j = (i + 1) % 3;
+        int k = (i + 2) % 3;
+
+        T s = math::sqrt(dcm[i][i] - dcm[j][j] - dcm[k][k] + 1);
+        q[i + 1] = s / 2;
+        s = T(0.5) / s;
+        q[j + 1] = (dcm[i][j] + dcm[j][i]) * s;
+        q[k + 1] = (dcm[k][i] + dcm[i][k]) * s;
+        q[0] = (dcm[k][j] - dcm[j][k]) * s;
+    }
+
+    return q;
+}
+
+template<typename T>
+constexpr mat<3, 3, T> euler_to_dcm(const vec<3, T> &euler)
+{
+    T cr = math::cos(euler[0]), sr = math::sin(euler[0]);
+    T cp = math::cos(euler[1]), sp = math::sin(euler[1]);
+    T cy = math::cos(euler[2]), sy = math::sin(euler[2]);
+
+    using row = vec<3, T>;
+    return mat<3, 3, T>{
+        row{cp * cy, -cr * sy + sr * sp * cy,  sr * sy + cr * sp * cy},
+        row{cp * sy,  cr * cy + sr * sp * sy, -sr * cy + cr * sp * sy},
+        row{-sp,      sr * cp,                 cr * cp}
+    };
+}
+
+
+/**
+ * Sensor mounting orientation relative to the airframe, named after the
+ * rotation that takes sensor axes to body axes.
+ */
+enum class orientation
+{
+    NONE,
+    YAW_45,
+    YAW_90,
+    YAW_135,
+    YAW_180,
+    YAW_225,
+    YAW_270,
+    YAW_315,
+    ROLL_180,
+    ROLL_180_YAW_90,
+    ROLL_180_YAW_270,
+    PITCH_180,
+    ROLL_90,
+    ROLL_270,
+    COUNT
+};
+
+/**
+ * Rotation matrices for every `orientation`, evaluated at compile time.
+ */
+inline constexpr std::array<mat3, static_cast<int>(orientation::COUNT)> orientations = [] {
+    constexpr float deg = math::pi<float> / 180;
+
+    return std::array<mat3, static_cast<int>(orientation::COUNT)>{
+        euler_to_dcm(vec3{0,         0,         0}),
+        euler_to_dcm(vec3{0,         0,         45 * deg}),
+        euler_to_dcm(vec3{0,         0,         90 * deg}),
+        euler_to_dcm(vec3{0,         0,        135 * deg}),
+        euler_to_dcm(vec3{0,         0,        180 * deg}),
+        euler_to_dcm(vec3{0,         0,        225 * deg}),
+        euler_to_dcm(vec3{0,         0,        270 * deg}),
+        euler_to_dcm(vec3{0,         0,        315 * deg}),
+        euler_to_dcm(vec3{180 * deg, 0,         0}),
+        euler_to_dcm(vec3{180 * deg, 0,         90 * deg}),
+        euler_to_dcm(vec3{180 * deg, 0,        270 * deg}),
+        euler_to_dcm(vec3{0,         180 * deg, 0}),
+        euler_to_dcm(vec3{90 * deg,  0,         0}),
+        euler_to_dcm(vec3{270 * deg, 0,         0}),
+    };
+}();
+
+constexpr const mat3 &rotation(orientation o)
+{
+    return orientations[static_cast<int>(o)];
+}
+
+static_assert(math::abs(rotation(orientation::YAW_90)[0][1] + 1) < 1e-6f);
+static_assert(math::abs(rotation(orientation::ROLL_180)[2][2] + 1) < 1e-6f);
+static_assert(math::abs((rotation(orientation::YAW_90) * vec3{1, 0, 0}).y() - 1) < 1e-6f);
+static_assert(math::abs(quaternion_to_euler(euler_to_quaternion(vec3{0.1f, -0.2f, 0.3f})).z() - 0.3f) < 1e-5f);
+static_assert(math::abs(dcm_to_quaternion(euler_to_dcm(vec3{0.1f, -0.2f, 0.3f})).w()
+                      - euler_to_quaternion(vec3{0.1f, -0.2f, 0.3f}).w()) < 1e-5f);
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <type_traits>
+
+#include <cstdint>
+
+#include "placement.hpp"
+
+namespace lumina
+{
+
+/**
+ * Single-writer sequence lock around a trivially copyable value.
+ *
+ * The writer bumps the sequence to odd, copies the value in and bumps it to
+ * even again; it never waits. Readers copy the value out and retry if the
+ * sequence was odd or changed meanwhile, so they never block the writer and
+ * never see a torn value. Meant for small, latest-value-wins slots such as
+ * setpoints, where a queue would only add latency.
+ */
+template <typename T>
+class seqlock
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+
+    constexpr seqlock()
+    :   _value{},
+        _sequence(0)
+    {}
+
+    void LUMINA_HOT write(const T& value)
+    {
+        uint32_t sequence = _sequence.load(std::memory_order_relaxed);
+        _sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        _value = value;
+
+        _sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    /**
+     * Copies the latest value into `value` and returns its sequence number,
+     * which grows by 2 per write; 0 means nothing was written yet.
+     */
+    uint32_t LUMINA_HOT read(T& value) const
+    {
+        for (;;)
+        {
+            uint32_t before = _sequence.load(std::memory_order_acquire);
+            if (before & 1)
+                continue;
+
+            value = const_cast<const T&>(_value);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (_sequence.load(std::memory_order_relaxed) == before)
+                return before;
+        }
+    }
+
+    uint32_t LUMINA_HOT sequence() const
+    {
+        return _sequence.load(std::memory_order_acquire);
+    }
+
+protected:
+
+    T _value;
+    std::atomic<uint32_t> _sequence;
+};
+
+}
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lumina
+{
+
+/**
+ * Steps of graceful degradation, in the order the supervisor takes them.
+ */
+enum class degradation : uint8_t
+{
+    NOMINAL,
+    REDUCED_TELEMETRY,              // telemetry streams at a fraction of their rate
+    NO_LOGGING,                     // diagnostics, logging and video paused as well
+    FAILSAFE                        // level, throttle ramped down to a disarm; latched
+};
+
+inline const char* to_string(degradation level)
+{
+    switch (level)
+    {
+        case degradation::NOMINAL:              return "nominal";
+        case degradation::REDUCED_TELEMETRY:    return "reduced telemetry";
+        case degradation::NO_LOGGING:           return "no logging";
+        case degradation::FAILSAFE:             return "failsafe";
+    }
+    return "?";
+}
+
+
+/**
+ * Latency budget of one real-time task.
+ *
+ * The task passes each iteration's response time, from the event that
+ * released it to its output, to `check()`. Misses and the worst response
+ * are kept in relaxed atomics so other tasks can read them at any time.
+ */
+class deadline
+{
+public:
+
+    deadline(const char* name, uint32_t budget_us)
+    :   _name(name),
+        _budget_us(budget_us),
+        _misses(0),
+        _worst_us(0)
+    {}
+
+    deadline(const deadline&) = delete;
+    deadline& operator= (const deadline&) = delete;
+
+    /**
+     * Returns true if `response_us` exceeded the budget.
+     */
+    bool check(int64_t response_us)
+    {
+        if (response_us > _worst_us.load(std::memory_order_relaxed))
+            _worst_us.store(static_cast<uint32_t>(response_us), std::memory_order_relaxed);
+
+        if (response_us <= _budget_us)
+            return false;
+
+        _misses.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    const char* name() const
+    {
+        return _name;
+    }
+
+    uint32_t budget_us() const
+    {
+        return _budget_us;
+    }
+
+    uint32_t misses() const
+    {
+        return _misses.load(std::memory_order_relaxed);
+    }
+
+    uint32_t worst_us() const
+    {
+        return _worst_us.load(std::memory_order_relaxed);
+    }
+
+protected:
+
+    const char* _name;
+    uint32_t _budget_us;
+    std::atomic<uint32_t> _misses;
+    std::atomic<uint32_t> _worst_us;
+};
+
+
+struct supervisor_config
+{
+    uint32_t window_us = 100'000;   // misses are counted per window
+    uint32_t degrade_misses = 3;    // misses within one window that step down a level
+    uint32_t recover_windows = 50;  // clean windows in a row that step back up a level
+};
+
+
+/**
+ * Sheds load before missed deadlines reach the vehicle.
+ *
+ * The supervisor sums the misses of the deadlines it watches over fixed
+ * windows. A window with `degrade_misses` or more moves one step down the
+ * `degradation` ladder, so a sustained overload walks from reduced telemetry
+ * to no logging to failsafe one window at a time, while a single hiccup
+ * costs nothing. `recover_windows` clean windows in a row move one step
+ * back up. FAILSAFE is the exception: it latches until `reset()`, as a
+ * vehicle that was caught out should not recover on its own.
+ *
+ * What each level sheds is up to the tasks that read it. On FAILSAFE the
+ * control task keeps running the rate loop, holds the vehicle level and
+ * ramps the throttle down to zero before it disarms, rather than cutting
+ * the motors in the air; it refuses to arm until the level is reset.
+ *
+ * `update()` belongs to one task, best the most critical one so that the
+ * supervisor keeps running however starved the others are. Any task may
+ * read `level()`.
+ */
+class supervisor
+{
+public:
+
+    static constexpr size_t MAX_DEADLINES = 8;
+
+public:
+
+    supervisor(const supervisor_config& config = {})
+    :   _config(config),
+        _deadlines{},
+        _seen{},
+        _count(0),
+        _window_start(0),
+        _window_misses(0),
+        _clean(0),
+        _level(degradation::NOMINAL),
+        _previous(degradation::NOMINAL)
+    {}
+
+    supervisor(const supervisor&) = delete;
+    supervisor& operator= (const supervisor&) = delete;
+
+    /**
+     * Adds `d` to the watched deadlines. Misses it had before are ignored.
+     */
+    bool watch(const deadline& d)
+    {
+        if (_count == MAX_DEADLINES)
+            return false;
+
+        _deadlines[_count] = &d;
+        _seen[_count] = d.misses();
+        _count++;
+        return true;
+    }
+
+    /**
+     * Closes the current window once `window_us` have passed since it
+     * opened and returns true if that changed the level.
+     */
+    bool update(int64_t now_us)
+    {
+        if (_window_start == 0)
+            _window_start = now_us;
+        if (now_us - _window_start < _config.window_us)
+            return false;
+        _window_start = now_us;
+
+        uint32_t misses = 0;
+        for (size_t i = 0; i < _count; i++)
+        {
+            uint32_t total = _deadlines[i]->misses();
+            misses += total - _seen[i];
+            _seen[i] = total;
+        }
+        _window_misses = misses;
+
+        degradation current = level();
+        if (misses >= _config.degrade_misses)
+        {
+            _clean = 0;
+            if (current == degradation::FAILSAFE)
+                return false;
+            return _set(static_cast<degradation>(static_cast<uint8_t>(current) + 1));
+        }
+
+        _clean = misses == 0 ? _clean + 1 : 0;
+        if (current == degradation::NOMINAL || current == degradation::FAILSAFE || _clean < _config.recover_windows)
+            return false;
+
+        _clean = 0;
+        return _set(static_cast<degradation>(static_cast<uint8_t>(current) - 1));
+    }
+
+    /**
+     * Returns to NOMINAL, e.g. to leave FAILSAFE when the pilot disarms.
+     * Returns true if that changed the level.
+     */
+    bool reset()
+    {
+        _clean = 0;
+        return _set(degradation::NOMINAL);
+    }
+
+    degradation level() const
+    {
+        return _level.load(std::memory_order_relaxed);
+    }
+
+    degradation previous() const
+    {
+        return _previous;
+    }
+
+    /**
+     * Misses counted in the last closed window.
+     */
+    uint32_t window_misses() const
+    {
+        return _window_misses;
+    }
+
+protected:
+
+    bool _set(degradation level)
+    {
+        degradation current = this->level();
+        if (level == current)
+            return false;
+
+        _previous = current;
+        _level.store(level, std::memory_order_relaxed);
+        return true;
+    }
+
+protected:
+
+    supervisor_config _config;
+
+    std::array<const deadline*, MAX_DEADLINES> _deadlines;
+    std::array<uint32_t, MAX_DEADLINES> _seen;
+    size_t _count;
+
+    int64_t _window_start;
+    uint32_t _window_misses;
+    uint32_t _clean;
+
+    std::atomic<degradation> _level;
+    degradation _previous;
+};
+
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <array>
+
+#include <cstddef>
+
+#include "math.hpp"
+#include "placement.hpp"
+
+namespace lumina
+{
+
+/**
+ * Inverse propeller thrust curve as a lookup table.
+ *
+ * Thrust is modelled as T(u) = (1 - k) u + k u^2 for a normalized command u,
+ * so k = 0 is linear and k = 1 purely quadratic. The table samples u(T) at
+ * evenly spaced thrust values; a lookup is one multiply, one truncation and
+ * one linear interpolation. `idle` lifts every non-zero command so motors
+ * keep spinning at the lowest thrust.
+ */
+class thrust_curve
+{
+public:
+
+    static constexpr size_t POINTS = 33;
+
+public:
+
+    constexpr thrust_curve(float k = 0, float idle = 0)
+    :   _table{},
+        _idle(idle)
+    {
+        k = k < 0 ? 0 : (k > 1 ? 1 : k);
+
+        for (size_t i = 0; i < POINTS; i++)
+        {
+            float t = static_cast<float>(i) / (POINTS - 1);
+            _table[i] = k > 0
+                ? (math::sqrt((1 - k) * (1 - k) + 4 * k * t) - (1 - k)) / (2 * k)
+                : t;
+        }
+    }
+
+    /**
+     * Motor command in [0, 1] for a normalized thrust in [0, 1].
+     */
+    constexpr float LUMINA_HOT operator() (float thrust) const
+    {
+        if (!(thrust > 0)) return 0;
+        if (thrust >= 1) return 1;
+
+        float x = thrust * (POINTS - 1);
+        size_t i = static_cast<size_t>(x);
+        float u = _table[i] + (x - i) * (_table[i + 1] - _table[i]);
+
+        return _idle + (1 - _idle) * u;
+    }
+
+protected:
+
+    std::array<float, POINTS> _table;
+    float _idle;
+};
+
+
+/**
+ * Motor-output stage between the mixer and the ESCs.
+ *
+ * Applies each motor's thrust curve and scales the result by reference over
+ * measured battery voltage, since motor speed follows duty times voltage.
+ * The voltage is low-pass filtered so current spikes do not modulate the
+ * outputs, and the boost is capped to avoid chasing a collapsing pack.
+ */
+template <size_t N>
+class thrust_stage
+{
+public:
+
+    /**
+     * @param curve Thrust curve shared by all motors until overridden per motor.
+     * @param reference_voltage Pack voltage at which no compensation is applied; 0 disables compensation.
+     * @param max_boost Upper bound of the voltage compensation factor.
+     * @param alpha Low-pass coefficient applied per `battery()` sample.
+     */
+    constexpr thrust_stage(const thrust_curve& curve = {}, float reference_voltage = 0, float max_boost = 1.3f, float alpha = 0.01f)
+    :   _reference(reference_voltage),
+        _max_boost(max_boost),
+        _alpha(alpha),
+        _voltage(reference_voltage),
+        _scale(1)
+    {
+        _curves.fill(curve);
+    }
+
+    static constexpr size_t size()
+    {
+        return N;
+    }
+
+    constexpr void curve(size_t motor, const thrust_curve& curve)
+    {
+        _curves[motor] = curve;
+    }
+
+    /**
+     * Feeds a battery voltage measurement in volts.
+     */
+    constexpr void battery(float volts)
+    {
+        if (_reference <= 0 || volts <= 0)
+            return;
+
+        _voltage += _alpha * (volts - _voltage);
+
+        float scale = _reference / _voltage;
+        _scale = scale < 1 ? 1 : (scale > _max_boost ? _max_boost : scale);
+    }
+
+    constexpr float compensation() const
+    {
+        return _scale;
+    }
+
+    constexpr std::array<float, N> LUMINA_HOT apply(const std::array<float, N>& thrust) const
+    {
+        std::array<float, N> out{};
+        for (size_t i = 0; i < N; i++)
+        {
+            float u = _curves[i](thrust[i]) * _scale;
+            out[i] = u > 1 ? 1 : u;
+        }
+        return out;
+    }
+
+protected:
+
+    std::array<thrust_curve, N> _curves;
+
+    float _reference;
+    float _max_boost;
+    float _alpha;
+    float _voltage;
+    float _scale;
+};
+
+static_assert(thrust_curve()(0.5f) == 0.5f);
+static_assert(math::abs(thrust_curve(1)(0.25f) - 0.5f) < 1e-6f);
+static_assert(math::abs(thrust_curve(0.5f)(0.3f) - (math::sqrt(0.25f + 0.6f) - 0.5f)) < 2e-3f);
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esp_attr.h"
+#include "driver/gptimer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "check.hpp"
+
+namespace lumina
+{
+
+/**
+ * Hardware-timed loop trigger.
+ *
+ * A general-purpose timer with auto-reload raises an alarm every period and
+ * the alarm interrupt gives the task's notification, so the loop is paced by
+ * the 1 MHz timer rather than the 100 Hz FreeRTOS tick. For sensors without
+ * a usable data-ready line; otherwise the IMU driver's notification is the
+ * better trigger since it carries no phase offset to the samples.
+ */
+class loop_timer
+{
+public:
+
+    static constexpr uint32_t RESOLUTION_HZ = 1'000'000;
+
+public:
+
+    loop_timer(uint32_t rate_hz, TaskHandle_t task)
+    :   _task(task),
+        _ticks(0)
+    {
+        gptimer_config_t timer_config = {};
+        timer_config.clk_src = GPTIMER_CLK_SRC_DEFAULT;
+        timer_config.direction = GPTIMER_COUNT_UP;
+        timer_config.resolution_hz = RESOLUTION_HZ;
+        ESP_CHECK(gptimer_new_timer(&timer_config, &_timer));
+
+        gptimer_event_callbacks_t callbacks = {};
+        callbacks.on_alarm = &loop_timer::_on_alarm;
+        ESP_CHECK(gptimer_register_event_callbacks(_timer, &callbacks, this));
+
+        gptimer_alarm_config_t alarm_config = {};
+        alarm_config.alarm_count = RESOLUTION_HZ / rate_hz;
+        alarm_config.reload_count = 0;
+        alarm_config.flags.auto_reload_on_alarm = true;
+        ESP_CHECK(gptimer_set_alarm_action(_timer, &alarm_config));
+
+        ESP_CHECK(gptimer_enable(_timer));
+        ESP_CHECK(gptimer_start(_timer));
+    }
+
+    loop_timer(const loop_timer&) = delete;
+    loop_timer& operator= (const loop_timer&) = delete;
+
+    ~loop_timer()
+    {
+        ESP_CHECK(gptimer_stop(_timer));
+        ESP_CHECK(gptimer_disable(_timer));
+        ESP_CHECK(gptimer_del_timer(_timer));
+    }
+
+    /**
+     * Alarms raised so far. If it runs ahead of the loop's own iteration
+     * count, the loop has missed periods.
+     */
+    uint32_t ticks() const
+    {
+        return _ticks;
+    }
+
+protected:
+
+    static bool IRAM_ATTR _on_alarm(gptimer_handle_t, const gptimer_alarm_event_data_t*, void* arg)
+    {
+        loop_timer& self = *static_cast<loop_timer*>(arg);
+        self._ticks = self._ticks + 1;
+
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(self._task, &woken);
+        return woken == pdTRUE;
+    }
+
+protected:
+
+    gptimer_handle_t _timer;
+    TaskHandle_t _task;
+    volatile uint32_t _ticks;
+};
+
+}
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <type_traits>
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#else
+#include <semaphore>
+#endif
+
+#include "ring.hpp"
+#include "seqlock.hpp"
+#include "placement.hpp"
+
+namespace lumina
+{
+
+#ifdef ESP_PLATFORM
+using task_handle = TaskHandle_t;
+
+inline void wake(task_handle task)
+{
+    xTaskNotifyGive(task);
+}
+#else
+using task_handle = std::counting_semaphore<>*;
+
+inline void wake(task_handle task)
+{
+    task->release();
+}
+#endif
+
+
+/**
+ * Typed publish/subscribe channel with a single publisher.
+ *
+ * The latest value sits in a seqlock, so any number of readers poll it
+ * without locks and the publisher never waits. Subscribers that must see
+ * every value, e.g. to consume a high-rate topic in batches, also get a
+ * private SPSC queue that `publish()` fills. Subscribers may ask to be
+ * woken through their task notification on every publish.
+ *
+ * Topics are meant to be defined once, at namespace scope (see
+ * topics.hpp); subscribers attach at startup and must outlive publishing.
+ */
+template <typename T>
+class topic
+{
+public:
+
+    using value_type = T;
+
+    static constexpr size_t MAX_SUBSCRIBERS = 8;
+
+    struct slot
+    {
+        void* queue;
+        bool (*push)(void*, const T&);
+        task_handle task;
+    };
+
+public:
+
+    constexpr topic(const char* name)
+    :   _name(name),
+        _slots{},
+        _claimed(0),
+        _count(0),
+        _dropped(0)
+    {}
+
+    topic(const topic&) = delete;
+    topic& operator= (const topic&) = delete;
+
+    void LUMINA_HOT publish(const T& value)
+    {
+        _value.write(value);
+
+        size_t count = _count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; i++)
+        {
+            const slot& s = _slots[i];
+            if (s.push && !s.push(s.queue, value))
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+            if (s.task)
+                wake(s.task);
+        }
+    }
+
+    /**
+     * Copies the latest value; returns its sequence number, 0 if never published.
+     */
+    uint32_t LUMINA_HOT read(T& value) const
+    {
+        return _value.read(value);
+    }
+
+    uint32_t LUMINA_HOT sequence() const
+    {
+        return _value.sequence();
+    }
+
+    const char* name() const
+    {
+        return _name;
+    }
+
+    /**
+     * Values lost because a subscriber's queue was full.
+     */
+    uint32_t dropped() const
+    {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Registers a subscriber. Returns false when all slots are taken.
+     */
+    bool attach(const slot& s)
+    {
+        size_t i = _claimed.fetch_add(1, std::memory_order_relaxed);
+        if (i >= MAX_SUBSCRIBERS)
+            return false;
+
+        _slots[i] = s;
+
+        // Publish slots in order, so the publisher never sees a gap.
+        size_t expected = i;
+        while (!_count.compare_exchange_weak(expected, i + 1, std::memory_order_release, std::memory_order_relaxed))
+            expected = i;
+        return true;
+    }
+
+protected:
+
+    const char* _name;
+    seqlock<T> _value;
+
+    std::array<slot, MAX_SUBSCRIBERS> _slots;
+    std::atomic<size_t> _claimed;
+    std::atomic<size_t> _count;
+    std::atomic<uint32_t> _dropped;
+};
+
+
+/**
+ * A reader of one topic.
+ *
+ * `update()` returns the latest value if it changed since the last call,
+ * skipping intermediate ones. With `QUEUE` > 0 (a power of two) every
+ * published value is also queued for `pop()`, until the queue is full.
+ */
+template <typename T, size_t QUEUE = 0>
+class subscriber
+{
+public:
+
+    subscriber(topic<T>& t, task_handle notify = nullptr)
+    :   _topic(t),
+        _seen(0)
+    {
+        typename topic<T>::slot s = {};
+        s.task = notify;
+        if constexpr (QUEUE > 0)
+        {
+            s.queue = &_queue;
+            s.push = [](void* queue, const T& value) {
+                return static_cast<ring<T, QUEUE>*>(queue)->push(value);
+            };
+        }
+        _attached = t.attach(s);
+    }
+
+    subscriber(const subscriber&) = delete;
+    subscriber& operator= (const subscriber&) = delete;
+
+    bool LUMINA_HOT update(T& value)
+    {
+        if (_topic.sequence() == _seen)
+            return false;
+        _seen = _topic.read(value);
+        return true;
+    }
+
+    bool pop(T& value) requires (QUEUE > 0)
+    {
+        return _queue.pop(value);
+    }
+
+    size_t available() const requires (QUEUE > 0)
+    {
+        return _queue.size();
+    }
+
+    bool attached() const
+    {
+        return _attached;
+    }
+
+protected:
+
+    topic<T>& _topic;
+    uint32_t _seen;
+    bool _attached;
+
+    struct no_queue {};
+    [[no_unique_address]] std::conditional_t<(QUEUE > 0), ring<T, QUEUE>, no_queue> _queue;
+};
+
+}
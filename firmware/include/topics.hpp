@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+
+#include <cstdint>
+
+#include "vec.hpp"
+#include "quat.hpp"
+#include "ekf.hpp"
+#include "topic.hpp"
+#include "supervisor.hpp"
+
+/**
+ * Message types and the topics that carry them. Every topic has exactly one
+ * publisher, named next to it.
+ */
+
+namespace lumina::msg
+{
+
+struct attitude
+{
+    int64_t timestamp;
+    quat attitude;                  // body to NED
+    vec3 rate;                      // filtered body rate, rad/s
+};
+
+struct odometry
+{
+    int64_t timestamp;
+    vec3 position;                  // NED, m
+    vec3 velocity;                  // NED, m/s
+    vec3 position_variance;         // m^2
+    vec3 velocity_variance;         // (m/s)^2
+    vec3 attitude_variance;         // body-frame attitude error, rad^2
+};
+
+struct actuators
+{
+    int64_t timestamp;
+    std::array<float, 4> outputs;   // normalized throttles sent to the ESCs
+    bool armed;
+};
+
+struct battery
+{
+    int64_t timestamp;
+    float voltage;                  // pack voltage, V
+};
+
+// Published on every change of the supervisor's degradation level.
+struct health
+{
+    int64_t timestamp;
+    degradation level;
+    degradation previous;
+    uint32_t misses;                // deadline misses in the window that caused the change
+};
+
+}
+
+namespace lumina::topics
+{
+
+inline topic<msg::attitude> attitude("attitude");           // control task
+inline topic<msg::odometry> odometry("odometry");           // navigation filter, once an aiding source runs it
+inline topic<msg::actuators> actuators("actuators");        // control task
+inline topic<msg::health> health("health");                 // control task
+inline topic<msg::battery> battery("battery");              // battery task
+
+}
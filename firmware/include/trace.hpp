@@ -0,0 +1,336 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+#include "esp_cpu.h"
+#include "esp_ipc.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#else
+#include <chrono>
+#endif
+
+#include "placement.hpp"
+#include "profile.hpp"
+
+/**
+ * Event tracing is compiled in with -DLUMINA_TRACE=1; without it the
+ * LUMINA_TRACE_* macros expand to nothing.
+ */
+#ifndef LUMINA_TRACE
+#define LUMINA_TRACE 0
+#endif
+
+namespace lumina::trace
+{
+
+enum class kind : uint8_t
+{
+    BEGIN = 'B',
+    END = 'E',
+    INSTANT = 'i'
+};
+
+struct event
+{
+    uint32_t cycles;                // cycle counter of the recording core
+    uint16_t name;                  // interned name
+    kind type;
+    uint8_t task;                   // index into the task names of the dump
+};
+
+static_assert(sizeof(event) == 8);
+
+static constexpr size_t EVENTS = 1024;          // per core, a power of two
+static constexpr size_t MAX_NAMES = 64;
+static constexpr size_t MAX_TASKS = 32;
+
+#ifdef ESP_PLATFORM
+static constexpr size_t CORES = portNUM_PROCESSORS;
+#else
+static constexpr size_t CORES = 1;
+#endif
+
+static_assert((EVENTS & (EVENTS - 1)) == 0);
+
+
+namespace detail
+{
+
+struct ring
+{
+    std::atomic<uint32_t> head;
+    std::array<event, EVENTS> events;
+};
+
+inline std::array<ring, CORES> rings{};
+inline std::atomic<bool> enabled{true};
+
+inline std::array<std::atomic<const char*>, MAX_NAMES> names{};
+inline std::array<std::atomic<const char*>, MAX_TASKS> tasks{};
+inline std::atomic<uint32_t> task_count{0};
+
+inline size_t core()
+{
+#ifdef ESP_PLATFORM
+    return esp_cpu_get_core_id();
+#else
+    return 0;
+#endif
+}
+
+inline const char* task_name()
+{
+#ifdef ESP_PLATFORM
+    return pcTaskGetName(nullptr);
+#else
+    return "main";
+#endif
+}
+
+// Index of the calling task, assigned on its first event.
+inline uint8_t task()
+{
+    thread_local uint8_t index = 0xFF;
+    if (index == 0xFF)
+    {
+        uint32_t i = task_count.fetch_add(1, std::memory_order_relaxed);
+        if (i < MAX_TASKS)
+            tasks[i].store(task_name(), std::memory_order_release);
+        index = i < MAX_TASKS ? i : MAX_TASKS - 1;
+    }
+    return index;
+}
+
+}
+
+
+/**
+ * Returns the ID of a name, a string with static storage. IDs are handed out
+ * in order of first use; the same pointer always maps to the same ID.
+ */
+inline uint16_t intern(const char* name)
+{
+    for (size_t i = 0; i < MAX_NAMES; i++)
+    {
+        const char* expected = nullptr;
+        if (detail::names[i].compare_exchange_strong(expected, name, std::memory_order_acq_rel) || expected == name)
+            return static_cast<uint16_t>(i);
+    }
+    return MAX_NAMES - 1;
+}
+
+/**
+ * Appends an event to the calling core's ring, overwriting the oldest.
+ *
+ * One relaxed fetch_add claims the slot, so tasks and interrupts on the same
+ * core can record concurrently and the cores never contend; the rest is the
+ * cycle counter read and an 8-byte store.
+ */
+inline void LUMINA_HOT record(uint16_t name, kind type)
+{
+    if (!detail::enabled.load(std::memory_order_relaxed))
+        return;
+
+    detail::ring& ring = detail::rings[detail::core()];
+    uint32_t index = ring.head.fetch_add(1, std::memory_order_relaxed);
+    ring.events[index & (EVENTS - 1)] = { profile::cycles(), name, type, detail::task() };
+}
+
+/**
+ * Stops recording, e.g. when a deadline was missed, so the rings keep the
+ * events that led up to it until they are dumped.
+ */
+inline void freeze()
+{
+    detail::enabled.store(false, std::memory_order_relaxed);
+}
+
+inline void resume()
+{
+    detail::enabled.store(true, std::memory_order_relaxed);
+}
+
+inline bool frozen()
+{
+    return !detail::enabled.load(std::memory_order_relaxed);
+}
+
+
+/**
+ * Records a begin event now and the matching end event at scope exit.
+ */
+class span
+{
+public:
+
+    span(uint16_t name)
+    :   _name(name)
+    {
+        record(_name, kind::BEGIN);
+    }
+
+    span(const span&) = delete;
+    span& operator= (const span&) = delete;
+
+    ~span()
+    {
+        record(_name, kind::END);
+    }
+
+protected:
+
+    uint16_t _name;
+};
+
+
+/**
+ * Pairs a core's cycle counter with esp_timer time, so the host can put all
+ * cores on one timeline.
+ */
+struct anchor
+{
+    uint32_t cycles;
+    int64_t time_us;
+};
+
+inline anchor now()
+{
+#ifdef ESP_PLATFORM
+    return { profile::cycles(), esp_timer_get_time() };
+#else
+    using namespace std::chrono;
+    return { profile::cycles(), duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count() };
+#endif
+}
+
+/**
+ * Serializes the rings, oldest event first, by calling `write(data, size)`
+ * with consecutive chunks. Call while frozen, or events being recorded may
+ * come out torn. Little-endian layout, as read by tools/trace2json.py:
+ *
+ *     "LTRC", u16 version, u8 cores, u8 reserved, u32 cycles per us
+ *     u16 names,  then per name:  u8 length, chars
+ *     u16 tasks,  then per task:  u8 length, chars
+ *     per core:   u32 anchor cycles, i64 anchor us, u32 count, count events
+ *
+ * Cycle timestamps wrap every 2^32 cycles (18 s at 240 MHz); events older
+ * than that relative to the anchor are placed one wrap too late.
+ */
+template <typename W>
+void dump(W&& write)
+{
+    auto put = [&](const auto& value) {
+        write(reinterpret_cast<const uint8_t*>(&value), sizeof(value));
+    };
+    auto put_string = [&](const char* s) {
+        uint8_t length = static_cast<uint8_t>(strnlen(s, UINT8_MAX));
+        put(length);
+        write(reinterpret_cast<const uint8_t*>(s), length);
+    };
+    // Takes a pointer so that both tables share one instance; per-size
+    // instances of a generic lambda drew false -Warray-bounds from GCC.
+    auto put_strings = [&](const std::atomic<const char*>* table, size_t count) {
+        put(static_cast<uint16_t>(count));
+        for (size_t i = 0; i < count; i++)
+        {
+            const char* s = table[i].load(std::memory_order_acquire);
+            put_string(s ? s : "?");
+        }
+    };
+
+    write(reinterpret_cast<const uint8_t*>("LTRC"), 4);
+    put(uint16_t(1));
+    put(uint8_t(CORES));
+    put(uint8_t(0));
+    put(profile::cycles_per_us());
+
+    size_t names = 0;
+    while (names < MAX_NAMES && detail::names[names].load(std::memory_order_acquire))
+        names++;
+    put_strings(detail::names.data(), names);
+
+    uint32_t tasks = detail::task_count.load(std::memory_order_acquire);
+    put_strings(detail::tasks.data(), tasks < MAX_TASKS ? tasks : MAX_TASKS);
+
+    for (size_t core = 0; core < CORES; core++)
+    {
+        // The cycle counters of the two cores differ, so read each on its own core.
+        anchor a;
+#ifdef ESP_PLATFORM
+        esp_ipc_call_blocking(core, [](void* arg) { *static_cast<anchor*>(arg) = now(); }, &a);
+#else
+        a = now();
+#endif
+        put(a.cycles);
+        put(a.time_us);
+
+        const detail::ring& ring = detail::rings[core];
+        uint32_t head = ring.head.load(std::memory_order_acquire);
+        uint32_t count = head < EVENTS ? head : EVENTS;
+        put(count);
+        for (uint32_t i = head - count; i != head; i++)
+            put(ring.events[i & (EVENTS - 1)]);
+    }
+}
+
+/**
+ * Dumps the rings to stdout as hex lines between "LTRC-BEGIN" and
+ * "LTRC-END", for tools/trace2json.py to pick out of a captured console log.
+ */
+inline void print()
+{
+    uint8_t line[32];
+    size_t used = 0;
+    auto flush = [&] {
+        for (size_t i = 0; i < used; i++)
+            std::printf("%02x", line[i]);
+        std::printf("\n");
+        used = 0;
+    };
+
+    std::printf("LTRC-BEGIN\n");
+    dump([&](const uint8_t* data, size_t size) {
+        for (size_t i = 0; i < size; i++)
+        {
+            line[used++] = data[i];
+            if (used == sizeof(line))
+                flush();
+        }
+    });
+    if (used)
+        flush();
+    std::printf("LTRC-END\n");
+    std::fflush(stdout);
+}
+
+}
+
+#if LUMINA_TRACE
+#define LUMINA_TRACE_CONCAT_(a, b) a##b
+#define LUMINA_TRACE_CONCAT(a, b) LUMINA_TRACE_CONCAT_(a, b)
+
+/**
+ * Traces the rest of the enclosing block as a span named `name`, a string literal.
+ */
+#define LUMINA_TRACE_SCOPE(name)                                                                        \
+    static const uint16_t LUMINA_TRACE_CONCAT(_trace_name_, __LINE__) = lumina::trace::intern(name);    \
+    lumina::trace::span LUMINA_TRACE_CONCAT(_trace_span_, __LINE__)(LUMINA_TRACE_CONCAT(_trace_name_, __LINE__))
+
+#define LUMINA_TRACE_INSTANT(name)                                                                      \
+    do {                                                                                                \
+        static const uint16_t _trace_name = lumina::trace::intern(name);                               \
+        lumina::trace::record(_trace_name, lumina::trace::kind::INSTANT);                               \
+    } while (0)
+#else
+#define LUMINA_TRACE_SCOPE(name) do {} while (0)
+#define LUMINA_TRACE_INSTANT(name) do {} while (0)
+#endif
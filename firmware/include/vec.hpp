@@ -1,7 +1,8 @@
 #pragma once
 
 #include <array>
-#include <cmath>
+
+#include "math.hpp"
 
 namespace lumina
 {
@@ -11,97 +12,105 @@ class vec : public:: std::array<T, N>
 {
 public:
 
-    T& x() requires(N >= 1) { return (*this)[0]; }
-    T& y() requires(N >= 2) { return (*this)[1]; }
-    T& z() requires(N >= 3) { return (*this)[2]; }
+    constexpr T& x() requires(N >= 1) { return (*this)[0]; }
+    constexpr T& y() requires(N >= 2) { return (*this)[1]; }
+    constexpr T& z() requires(N >= 3) { return (*this)[2]; }
 
-    T x() const requires(N >= 1) { return (*this)[0]; }
-    T y() const requires(N >= 2) { return (*this)[1]; }
-    T z() const requires(N >= 3) { return (*this)[2]; }
+    constexpr T x() const requires(N >= 1) { return (*this)[0]; }
+    constexpr T y() const requires(N >= 2) { return (*this)[1]; }
+    constexpr T z() const requires(N >= 3) { return (*this)[2]; }
 
-    vec normalized() const
+    constexpr vec normalized() const
     {
         T len = length();
         if(len == 0) return *this;
         return *this / len;
     }
 
-    T length() const
+    constexpr T length() const
     {
-        return std::sqrt(dot(*this));
+        return math::sqrt(dot(*this));
     }
 
-    T dot(const vec &v) const
+    constexpr T dot(const vec &v) const
     {
-        T sum = 0;
+        T sum{};
         for(int i = 0; i < N; i++)
             sum += (*this)[i] * v[i];
         return sum;
     }
     
-    vec cross(const vec &v) const requires(N == 3)
+    constexpr vec cross(const vec &v) const requires(N == 3)
     {
         return {y() * v.z() - z() * v.y(), z() * v.x() - x() * v.z(), x() * v.y() - y() * v.x()};
     }
 
-    static T angle(const vec &a, const vec &b)
+    static constexpr T angle(const vec &a, const vec &b)
     {
-        return std::acos(a.dot(b) / (a.length() * b.length()));
+        return math::acos(a.dot(b) / (a.length() * b.length()));
     }
 
-    static T distance(const vec &a, const vec &b)
+    static constexpr T distance(const vec &a, const vec &b)
     {
         return (a - b).length();
     }
 
-    vec operator+(const vec &v) const
+    constexpr vec operator+(const vec &v) const
     {
-        vec result;
+        vec result{};
         for(int i = 0; i < N; i++)
             result[i] = (*this)[i] + v[i];
         return result;
     }
 
-    vec operator-(const vec &v) const
+    constexpr vec operator-(const vec &v) const
     {
-        vec result;
+        vec result{};
         for(int i = 0; i < N; i++)
             result[i] = (*this)[i] - v[i];
         return result;
     }
 
-    vec operator*(T s) const
+    constexpr vec operator-() const
+    {
+        vec result{};
+        for(int i = 0; i < N; i++)
+            result[i] = -(*this)[i];
+        return result;
+    }
+
+    constexpr vec operator*(T s) const
     {
-        vec result;
+        vec result{};
         for(int i = 0; i < N; i++)
             result[i] = (*this)[i] * s;
         return result;
     }
 
-    vec operator/(T s) const
+    constexpr vec operator/(T s) const
     {
-        vec result;
+        vec result{};
         for(int i = 0; i < N; i++)
             result[i] = (*this)[i] / s;
         return result;
     }
 
-    vec &operator+=(const vec &v)
+    constexpr vec &operator+=(const vec &v)
     {
         return *this = *this + v;
     }
 
-    vec &operator-=(const vec &v)
+    constexpr vec &operator-=(const vec &v)
     {
         return *this = *this - v;
     }
 
-    vec &operator*=(T s)
+    constexpr vec &operator*=(T s)
     {
         return *this = *this * s;
     }
 
-    vec &operator/=(T s)
+    constexpr vec &operator/=(T s)
     {
         return *this = *this / s;
     }
@@ -1,11 +1,10 @@
 #pragma once
 
 #include <string_view>
-#include <string>
-#include <format>
 #include <array>
 
 #include <cstdint>
+#include <cstdio>
 
 namespace lumina
 {
@@ -159,9 +158,18 @@ public:
     }
 
 
-    operator std::string () const
+    /**
+     * Formats the IP address in dotted decimal notation.
+     *
+     * @return The null-terminated text, in a fixed buffer rather than on the heap.
+     *
+     * @throws None.
+     */
+    std::array<char, 16> str() const
     {
-        return std::format("{:d}.{:d}.{:d}.{:d}", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+        std::array<char, 16> text;
+        std::snprintf(text.data(), text.size(), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+        return text;
     }
 
 
@@ -1,11 +1,10 @@
 #pragma once
 
 #include <string_view>
-#include <string>
-#include <format>
 #include <array>
 
 #include <cstdint>
+#include <cstdio>
 
 namespace lumina
 {
@@ -64,9 +63,18 @@ public:
     {}
 
 
-    operator std::string () const
+    /**
+     * Formats the MAC address as colon-separated hex octets.
+     *
+     * @return The null-terminated text, in a fixed buffer rather than on the heap.
+     *
+     * @throws None.
+     */
+    std::array<char, 18> str() const
     {
-        return std::format("{:02x}:{:02x}:{:02x}:{:02x}:{:02x}:{:02x}", (*this)[0], (*this)[1], (*this)[2], (*this)[3], (*this)[4], (*this)[5]);
+        std::array<char, 18> text;
+        std::snprintf(text.data(), text.size(), "%02x:%02x:%02x:%02x:%02x:%02x", (*this)[0], (*this)[1], (*this)[2], (*this)[3], (*this)[4], (*this)[5]);
+        return text;
     }
 
 };
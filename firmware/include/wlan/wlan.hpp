@@ -2,7 +2,6 @@
 
 #include <string_view>
 #include <array>
-#include <format>
 
 #include <cstring>
 
@@ -18,8 +17,7 @@
 
 #include "ip.hpp"
 #include "mac.hpp"
-
-#define ESP_CHECK(x) if(auto err = x; err != ESP_OK) { ESP_LOGE("WLAN", "Error on " #x": %s", esp_err_to_name(err)); }
+#include "../check.hpp"
 
 namespace lumina
 {
@@ -253,8 +251,8 @@ protected:
                     wlan._ip = ipv4(ip_info.ip.addr);
                     wlan._mask = ipv4(ip_info.netmask.addr);
 
-                    ESP_LOGI("WLAN", "ap ip: %s", static_cast<std::string>(wlan._ip).c_str());
-                    ESP_LOGI("WLAN", "ap mask: %s", static_cast<std::string>(wlan._mask).c_str());
+                    ESP_LOGI("WLAN", "ap ip: %s", wlan._ip.str().data());
+                    ESP_LOGI("WLAN", "ap mask: %s", wlan._mask.str().data());
 
                     xEventGroupClearBits(wlan._event_group, DISABLED_BIT);
                     xEventGroupSetBits(wlan._event_group, ENABLED_BIT);
@@ -1,63 +1,702 @@
 
-#include <iostream>
 
 #include "lumina.hpp"
 
-#include "mavlink/common/mavlink.h"
-#include <sys/socket.h>
-#include <arpa/inet.h>
-#include <unistd.h>
+#include "mavlink/lumina/mavlink.h"
+#include "esp_heap_caps.h"
 
 #include <thread>
 #include <chrono>
+#include <atomic>
+#include <utility>
+#include <optional>
+#include <cstdio>
 
-extern "C"
-void app_main(void)
+namespace board
 {
-    std::this_thread::sleep_for(std::chrono::seconds(1));
 
-    lumina::wlan<lumina::AP> wlan("MAV", "12345678");
-    wlan.enable();
+// SPI2 wiring of the IMU.
+constexpr int IMU_MOSI = 11;
+constexpr int IMU_MISO = 13;
+constexpr int IMU_SCLK = 12;
+constexpr int IMU_CS   = 10;
+constexpr int IMU_INT  = 9;
+
+// DShot outputs in Betaflight motor order.
+constexpr std::array<int, 4> MOTORS = { 4, 5, 6, 7 };
+constexpr int MOTOR_POLE_PAIRS = 7;
+
+// CRSF receiver on UART1.
+constexpr uart_port_t RC_UART = UART_NUM_1;
+constexpr int RC_TX = 17;
+constexpr int RC_RX = 18;
+
+// 4S pack through a 10k/1k divider on ADC1.
+constexpr int BATTERY_SENSE = 1;
+constexpr float BATTERY_DIVIDER = 11;
+constexpr int BATTERY_CELLS = 4;
+
+}
+
+constexpr int TELEMETRY_HZ = 25;
+
+// The dynamic notch analysis transforms the last 64 ms of decimated gyro on
+// every axis at this rate, in a task of its own on core 0.
+constexpr int NOTCH_HZ = 100;
+
+// A oneshot ADC read takes tens of microseconds in flash-resident driver
+// code, so the battery is sampled by its own task on core 0 and the control
+// loop only reads the published voltage.
+constexpr int BATTERY_HZ = 100;
+
+// Telemetry only reports position and velocity while an aiding source keeps
+// the navigation filter from dead-reckoning on the accelerometer alone.
+constexpr int64_t AIDING_TIMEOUT_US = 1'000'000;
+
+// Thrust is compensated relative to a fully charged pack.
+constexpr float BATTERY_REFERENCE_VOLTAGE = 4.2f * board::BATTERY_CELLS;
+
+// Telemetry streams at a fifth of its rate while the supervisor sheds load.
+constexpr int REDUCED_TELEMETRY_DIVIDER = 5;
+static_assert(TELEMETRY_HZ % REDUCED_TELEMETRY_DIVIDER == 0);
+
+// A trace dump prints tens of kilobytes on core 0, so it waits until the
+// supervisor is back to nominal and runs at most this often.
+constexpr int64_t TRACE_DUMP_INTERVAL_US = 30'000'000;
+
+// Everything telemetry sends must be in the generated dialect.
+static_assert(lumina::in_dialect(MAVLINK_MSG_ID_HEARTBEAT) && lumina::in_dialect(MAVLINK_MSG_ID_STATUSTEXT) &&
+              lumina::in_dialect(MAVLINK_MSG_ID_ATTITUDE_QUATERNION) && lumina::in_dialect(MAVLINK_MSG_ID_LOCAL_POSITION_NED) &&
+              lumina::in_dialect(MAVLINK_MSG_ID_ODOMETRY) && lumina::in_dialect(MAVLINK_MSG_ID_RC_CHANNELS) &&
+              lumina::in_dialect(MAVLINK_MSG_ID_RADIO_STATUS) && lumina::in_dialect(MAVLINK_MSG_ID_NAMED_VALUE_INT) &&
+              lumina::in_dialect(MAVLINK_MSG_ID_NAMED_VALUE_FLOAT),
+              "telemetry sends a message that is not in the dialect");
+
+// One control step per IMU FIFO watermark, from the newest sample to the ESC write.
+constexpr int64_t CONTROL_DEADLINE_US = 1'000'000 * lumina::imu::icm42688::WATERMARK / lumina::imu::icm42688::RATE_HZ;
+
+// A supervisor failsafe levels the vehicle and takes the throttle down by
+// this fraction per second, then disarms once it reaches zero.
+constexpr float FAILSAFE_THROTTLE_RAMP = 0.1f;
+
+// Angle mode limits.
+constexpr float MAX_ANGLE = lumina::math::radians(30.f);
+constexpr float MAX_YAW_RATE = lumina::math::radians(200.f);
+constexpr size_t ARM_CHANNEL = 4;
+
+static float stick(uint16_t us)
+{
+    float x = (static_cast<int>(us) - 1500) / 500.f;
+    return x < -1 ? -1 : (x > 1 ? 1 : x);
+}
+
+// CRSF sticks in AETR order, arming on AUX1.
+static lumina::manual_input from_crsf(const lumina::crsf::input& in)
+{
+    const auto& ch = in.channels;
+    return { stick(ch[0]), stick(ch[1]), stick(ch[3]), (stick(ch[2]) + 1) / 2, ch[ARM_CHANNEL] > 1700, in.timestamp };
+}
+
+using imu_driver = lumina::imu::driver<lumina::imu::icm42688>;
+using fft_notch = lumina::dynamic_notch<>;
+
+struct control_context
+{
+    imu_driver& imu;
+    lumina::esc_group<4>& escs;
+    lumina::crsf::receiver& rc;
+    lumina::mavlink& gcs;
+    fft_notch& notch;
+    std::atomic<bool> armed;
+};
+
+// Runs the attitude filter on every gyro sample, then one angle/rate control
+// step per FIFO burst, i.e. at the IMU watermark
+// rate (1 kHz for the ICM-42688-P), and publishes estimates and outputs.
+static void LUMINA_HOT control_task(void* arg)
+{
+    auto& context = *static_cast<control_context*>(arg);
+    context.imu.notify(xTaskGetCurrentTaskHandle());
+    lumina::memory::protect();
+
+    // The large filter states live in a static arena rather than on the stack.
+    using rpm_notch = lumina::rpm_filter<4>;
+    static lumina::memory::arena<lumina::memory::footprint<rpm_notch>> memory("control");
+
+    lumina::mahony filter;
+    rpm_notch& rpm = *memory.make<rpm_notch>(lumina::imu::icm42688::RATE_HZ, board::MOTOR_POLE_PAIRS);
+    fft_notch& notch = context.notch;
+    lumina::filter_bank<lumina::biquad> gyro_filter(lumina::biquad_coefficients::lowpass(250, lumina::imu::icm42688::RATE_HZ));
+    lumina::imu::sample sample;
+    std::array<std::array<float, imu_driver::BURST>, 3> burst, filtered;
+    int64_t last = 0, last_control = 0;
 
-    auto ip = wlan.ip();
-    auto mask = wlan.mask();
-    auto broadcast_ip = (ip & mask) | ~mask;
+    lumina::angle_controller angles(lumina::vec3{6, 6, 4}, lumina::vec3{7, 7, 4});
+    lumina::rate_controller rates({
+        lumina::pid_gains{ 0.03f, 0.5f, 0.0005f, 0.0002f },
+        lumina::pid_gains{ 0.03f, 0.5f, 0.0005f, 0.0002f },
+        lumina::pid_gains{ 0.05f, 0.5f, 0,       0.0002f }
+    }, lumina::tpa{ 0.5f, 0.3f });
+    lumina::mixer<4> mixer(lumina::layout::quad_x);
+    lumina::thrust_stage<4> thrust(lumina::thrust_curve(0.3f, 0.05f), BATTERY_REFERENCE_VOLTAGE);
+    lumina::subscriber<lumina::msg::battery> battery_sub{lumina::topics::battery};
+    lumina::msg::battery pack{};
 
-    std::this_thread::sleep_for(std::chrono::seconds(2));
+    lumina::crsf::input sticks{};
+    lumina::manual_input manual{};
+    float heading = 0;
+    float throttle_limit = 1;
 
-    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
-    if (sockfd < 0)
-        std::cerr << "Error creating socket!" << std::endl;
+    // Late control steps make the supervisor shed the load on core 0.
+    lumina::deadline control_deadline("control", CONTROL_DEADLINE_US);
+    lumina::supervisor supervisor;
+    supervisor.watch(control_deadline);
 
-    sockaddr_in serverAddr = {};
-    serverAddr.sin_family = AF_INET;
-    serverAddr.sin_port = htons(14550);
-    serverAddr.sin_addr.s_addr = broadcast_ip;
-        
     while (true)
     {
-        mavlink_message_t msg;
-        uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        LUMINA_PROFILE_SCOPE("control");
+        LUMINA_TRACE_SCOPE("control");
+
+        // The notches follow the sample one by one, but the lowpass takes the
+        // burst as a block so that it runs through the vectorized esp-dsp
+        // biquad. Only the newest output feeds the control step.
+        lumina::vec3 rate{};
+        bool more = true;
+        while (more)
+        {
+            size_t n = 0;
+            while (n < imu_driver::BURST && (more = context.imu.read(sample)))
+            {
+                float dt = last ? (sample.timestamp - last) * 1e-6f : 0;
+                last = sample.timestamp;
+
+                lumina::vec3 gyro = notch(rpm(imu_driver::gyro(sample) - filter.bias()));
+                for (int axis = 0; axis < 3; axis++)
+                    burst[axis][n] = gyro[axis];
+                n++;
+
+                LUMINA_PROFILE_SCOPE("est");
+                filter.update(imu_driver::gyro(sample), imu_driver::accel(sample), dt);
+            }
+
+            if (n)
+            {
+                gyro_filter.process({ burst[0].data(), burst[1].data(), burst[2].data() },
+                                    { filtered[0].data(), filtered[1].data(), filtered[2].data() }, n);
+                rate = lumina::vec3{ filtered[0][n - 1], filtered[1][n - 1], filtered[2][n - 1] };
+            }
+        }
+
+        float dt = last_control ? (last - last_control) * 1e-6f : 0;
+        last_control = last;
+
+        rpm.update(context.escs, dt);
+        notch.update();
+        if (battery_sub.update(pack))
+            thrust.battery(pack.voltage);
+
+        // CRSF is the primary stick input, MAVLink manual control over Wi-Fi
+        // the fallback. Arming needs the switch, a live link and low
+        // throttle; losing every link or the switch disarms at once. A
+        // supervisor failsafe does not cut the motors in the air: the loop
+        // holds the vehicle level and ramps the throttle down, disarming
+        // once it reaches zero. It cannot be armed into.
+        context.rc.read(sticks);
+        context.gcs.read(manual);
+        bool crsf = !context.rc.failsafe();
+        bool link = crsf || context.gcs.active();
+        lumina::manual_input pilot = crsf ? from_crsf(sticks) : manual;
+        float throttle = link ? pilot.throttle : 0;
+        bool failsafe = supervisor.level() == lumina::degradation::FAILSAFE;
+        if (failsafe)
+        {
+            throttle_limit = std::max(0.f, std::min(throttle_limit, throttle) - FAILSAFE_THROTTLE_RAMP * dt);
+            throttle = std::min(throttle, throttle_limit);
+            pilot.roll = pilot.pitch = pilot.yaw = 0;
+        }
+        else
+            throttle_limit = 1;
+        bool landed = failsafe && throttle_limit == 0;
+        bool armed = link && pilot.arm && !landed &&
+                     (context.armed.load(std::memory_order_relaxed) || (!failsafe && throttle < 0.05f));
+        context.armed.store(armed, std::memory_order_relaxed);
+        lumina::memory::lock_heap(armed);
+
+        std::array<float, 4> outputs{};
+        if (armed)
+        {
+            heading += pilot.yaw * MAX_YAW_RATE * dt;
+            lumina::quat attitude_setpoint = lumina::euler_to_quaternion(lumina::vec3{
+                pilot.roll * MAX_ANGLE, -pilot.pitch * MAX_ANGLE, heading });
+
+            lumina::vec3 demand;
+            {
+                LUMINA_PROFILE_SCOPE("pid");
+                lumina::vec3 rate_setpoint = angles.update(filter.attitude(), attitude_setpoint, dt);
+                demand = rates.update(rate_setpoint, rate, dt, throttle, mixer.saturated());
+            }
+
+            LUMINA_PROFILE_SCOPE("mixer");
+            outputs = thrust.apply(mixer.mix(lumina::vec4{demand[0], demand[1], demand[2], throttle}));
+        }
+        else
+        {
+            heading = lumina::quaternion_to_euler(filter.attitude())[2];
+            angles.reset();
+            rates.reset();
+        }
+        context.escs.write(outputs);
+
+        int64_t now = esp_timer_get_time();
+        if (control_deadline.check(now - last))
+        {
+#if LUMINA_TRACE
+            // Keep the trace of what led up to a late output for telemetry to dump.
+            if (!lumina::trace::frozen())
+            {
+                LUMINA_TRACE_INSTANT("deadline");
+                lumina::trace::freeze();
+            }
+#endif
+        }
+
+        // A failsafe clears once the switch is off and the deadlines are met.
+        bool changed = supervisor.update(now);
+        if (failsafe && !pilot.arm && supervisor.window_misses() == 0)
+            changed |= supervisor.reset();
+        if (changed)
+            lumina::topics::health.publish({ now, supervisor.level(), supervisor.previous(), supervisor.window_misses() });
+
+        lumina::topics::actuators.publish({ last, outputs, armed });
+        lumina::topics::attitude.publish({ last, filter.attitude(), rate });
+    }
+}
+
+// With CONFIG_HEAP_USE_HOOKS every heap allocation passes through here,
+// from inside the IRAM-resident heap functions.
+extern "C"
+void LUMINA_HOT esp_heap_trace_alloc_hook(void*, size_t, uint32_t)
+{
+    lumina::memory::check_allocation();
+}
+
+// Wi-Fi access point for the ground station.
+struct link_component
+{
+    static constexpr const char* NAME = "link";
+
+    std::optional<lumina::wlan<lumina::AP>> wlan;
+
+    void init(auto&)
+    {
+        wlan.emplace("MAV", "12345678");
+        wlan->enable();
+    }
+};
+
+// MAVLink to the ground station, broadcast on the access point's subnet.
+struct gcs_component
+{
+    static constexpr const char* NAME = "mavlink";
+    using depends = lumina::depends<link_component>;
+
+    std::optional<lumina::mavlink> mavlink;
+
+    void init(auto& drone)
+    {
+        auto& wlan = *drone.template get<link_component>().wlan;
+        auto ip = wlan.ip();
+        auto mask = wlan.mask();
+        mavlink.emplace((ip & mask) | ~mask);
+    }
+};
+
+// Samples the pack voltage for the thrust stage; see BATTERY_HZ.
+struct battery_component
+{
+    static constexpr const char* NAME = "battery";
+
+    struct body
+    {
+        battery_component* self;
+
+        void operator() (uint32_t) const
+        {
+            float volts = self->battery->voltage();
+            if (volts > 0)
+                lumina::topics::battery.publish({ esp_timer_get_time(), volts });
+        }
+    };
+
+    std::optional<lumina::battery> battery;
+    std::optional<lumina::periodic_task<body>> task;
+
+    void init(auto&)
+    {
+        battery.emplace(board::BATTERY_SENSE, board::BATTERY_DIVIDER);
+    }
+
+    void start(auto&)
+    {
+        task.emplace(lumina::task_config{ .name = "battery", .period_us = 1'000'000 / BATTERY_HZ,
+                                          .priority = 4, .core = 0, .stack = 3072 }, body{ this });
+    }
+};
+
+// Finds the frame resonances the control task's dynamic notches follow, below
+// the battery and telemetry tasks; see NOTCH_HZ.
+struct notch_component
+{
+    static constexpr const char* NAME = "notch";
+
+    struct body
+    {
+        notch_component* self;
+
+        void operator() (uint32_t) const
+        {
+            self->notch->analyse();
+        }
+    };
+
+    std::optional<fft_notch> notch;
+    std::optional<lumina::periodic_task<body>> task;
+
+    void init(auto&)
+    {
+        notch.emplace(lumina::imu::icm42688::RATE_HZ);
+    }
+
+    void start(auto&)
+    {
+        task.emplace(lumina::task_config{ .name = "notch", .period_us = 1'000'000 / NOTCH_HZ,
+                                          .priority = 3, .core = 0, .stack = 3072 }, body{ this });
+    }
+};
+
+// The drivers allocate their interrupts on the initializing core, so the
+// sensor, ESC and receiver drivers come up on core 1 with the control task.
+struct imu_component
+{
+    static constexpr const char* NAME = "imu";
+    static constexpr int CORE = 1;
+
+    std::optional<lumina::spi_bus> spi;
+    std::optional<imu_driver> imu;
+
+    void init(auto&)
+    {
+        spi.emplace(SPI2_HOST, board::IMU_MOSI, board::IMU_MISO, board::IMU_SCLK);
+        imu.emplace(*spi, board::IMU_CS, board::IMU_INT);
+    }
+};
+
+// Bidirectional DShot for the eRPM telemetry that tunes the RPM filter.
+struct esc_component
+{
+    static constexpr const char* NAME = "escs";
+    static constexpr int CORE = 1;
+
+    std::optional<lumina::esc_group<4>> escs;
+
+    void init(auto&)
+    {
+        escs.emplace(board::MOTORS, lumina::dshot::speed::DSHOT600, true);
+    }
+};
+
+struct rc_component
+{
+    static constexpr const char* NAME = "crsf";
+    static constexpr int CORE = 1;
+
+    std::optional<lumina::crsf::receiver> receiver;
+
+    void init(auto&)
+    {
+        receiver.emplace(board::RC_UART, board::RC_TX, board::RC_RX);
+        lumina::memory::protect(receiver->task());
+    }
+};
+
+// Estimator, controller and mixer, which share one task so that a gyro
+// sample reaches the ESCs without a handoff; see control_task.
+struct control_component
+{
+    static constexpr const char* NAME = "control";
+    using depends = lumina::depends<imu_component, esc_component, rc_component, gcs_component, notch_component>;
+
+    std::optional<control_context> context;
+    TaskHandle_t task = nullptr;
+
+    void init(auto& drone)
+    {
+        context.emplace(*drone.template get<imu_component>().imu, *drone.template get<esc_component>().escs,
+                        *drone.template get<rc_component>().receiver, *drone.template get<gcs_component>().mavlink,
+                        *drone.template get<notch_component>().notch, false);
+    }
+
+    // Wi-Fi runs on core 0, so the whole sensor-to-motor path lives on core 1.
+    void start(auto&)
+    {
+        xTaskCreatePinnedToCore(&control_task, "control", 8192, &*context, configMAX_PRIORITIES - 2, &task, 1);
+    }
+};
+
+// Streams state to the ground station and the receiver.
+struct telemetry_component
+{
+    static constexpr const char* NAME = "telemetry";
+    using depends = lumina::depends<gcs_component, rc_component, control_component>;
+
+    struct body
+    {
+        telemetry_component* self;
+
+        void operator() (uint32_t tick) const
+        {
+            self->send(tick);
+        }
+    };
+
+    lumina::mavlink* mavlink = nullptr;
+    lumina::crsf::receiver* receiver = nullptr;
+    control_component* control = nullptr;
+
+    // Telemetry only needs the latest values, so it polls without queues.
+    lumina::subscriber<lumina::msg::attitude> attitude_sub{lumina::topics::attitude};
+    lumina::subscriber<lumina::msg::odometry> odometry_sub{lumina::topics::odometry};
+    lumina::subscriber<lumina::msg::actuators> actuators_sub{lumina::topics::actuators};
+    lumina::msg::attitude estimate = { 0, lumina::quat::identity(), {} };
+    lumina::msg::odometry odometry = {};
+    lumina::msg::actuators actuators = {};
+
+    // Every change of degradation level is queued, so none goes unreported.
+    lumina::subscriber<lumina::msg::health, 8> health_sub{lumina::topics::health};
+    lumina::msg::health health = {};
+#if LUMINA_PROFILE
+    lumina::profile::cpu_load load;
+    bool was_armed = false;
+#endif
+#if LUMINA_TRACE
+    int64_t trace_dumped = -TRACE_DUMP_INTERVAL_US;
+#endif
+
+    std::optional<lumina::periodic_task<body>> task;
+
+    // Telemetry shares core 0 with Wi-Fi, below the network stack's priorities.
+    void start(auto& drone)
+    {
+        mavlink = &*drone.template get<gcs_component>().mavlink;
+        receiver = &*drone.template get<rc_component>().receiver;
+        control = &drone.template get<control_component>();
+
+        task.emplace(lumina::task_config{ .name = "telemetry", .period_us = 1'000'000 / TELEMETRY_HZ,
+                                          .priority = 5, .core = 0, .stack = 6144 }, body{ this });
+    }
+
+    void send(uint32_t tick);
+};
+
+void telemetry_component::send(uint32_t tick)
+{
+    lumina::mavlink& gcs = *mavlink;
+    lumina::crsf::receiver& rc = *receiver;
+    control_context& context = *control->context;
+    mavlink_message_t msg;
+
+    attitude_sub.update(estimate);
+    odometry_sub.update(odometry);
+    actuators_sub.update(actuators);
+
+    while (health_sub.pop(health))
+    {
+        bool worse = health.level > health.previous;
+        char text[MAVLINK_MSG_STATUSTEXT_FIELD_TEXT_LEN + 1];
+        if (worse)
+            std::snprintf(text, sizeof(text), "RT: %s, %lu deadline misses",
+                lumina::to_string(health.level), static_cast<unsigned long>(health.misses));
+        else
+            std::snprintf(text, sizeof(text), "RT: back to %s", lumina::to_string(health.level));
+
+        uint8_t severity = health.level == lumina::degradation::FAILSAFE ? MAV_SEVERITY_CRITICAL
+                         : worse ? MAV_SEVERITY_WARNING : MAV_SEVERITY_NOTICE;
+        mavlink_msg_statustext_pack(1, 1, &msg, severity, text, 0, 0);
+        gcs.send(msg);
+    }
+    bool failsafe = health.level == lumina::degradation::FAILSAFE;
+    bool logging = health.level < lumina::degradation::NO_LOGGING;
+
+    if (tick % TELEMETRY_HZ == 0)
+    {
         mavlink_heartbeat_t heartbeat;
 
         heartbeat.type = MAV_TYPE_QUADROTOR;           // Set UAV type (e.g., quadrotor)
         heartbeat.autopilot = MAV_AUTOPILOT_GENERIC;  // Set autopilot type
-        heartbeat.base_mode = MAV_MODE_MANUAL_ARMED;   // Set mode (manual, armed, etc.)
+        heartbeat.base_mode = actuators.armed ? MAV_MODE_MANUAL_ARMED : MAV_MODE_MANUAL_DISARMED;
         heartbeat.custom_mode = 0;                     // Custom mode (typically set to 0)
-        heartbeat.system_status = MAV_STATE_ACTIVE;    // System status
+        heartbeat.system_status = failsafe ? MAV_STATE_CRITICAL : MAV_STATE_ACTIVE;  // System status
         heartbeat.mavlink_version = MAVLINK_VERSION;   // MAVLink version
 
         mavlink_msg_heartbeat_encode(1, 1, &msg, &heartbeat);
 
-        uint16_t messageLength = mavlink_msg_to_send_buffer(buffer, &msg);
+        if (!gcs.send(msg))
+            ESP_LOGD("TELEMETRY", "heartbeat not sent");
+    }
+
+    // The once-per-second messages fall on the ticks that still stream.
+    if (health.level >= lumina::degradation::REDUCED_TELEMETRY && tick % REDUCED_TELEMETRY_DIVIDER != 0)
+        return;
+
+    const lumina::quat& attitude = estimate.attitude;
+    const lumina::vec3& rate = estimate.rate;
+    const lumina::vec3& position = odometry.position;
+    const lumina::vec3& velocity = odometry.velocity;
+
+    int64_t time_us = esp_timer_get_time();
+    uint32_t time_boot_ms = time_us / 1000;
 
-        ssize_t sentBytes = sendto(sockfd, buffer, messageLength, 0, (struct sockaddr*)&serverAddr, sizeof(serverAddr));
-        if (sentBytes != messageLength) {
-            std::cerr << "Error sending heartbeat!" << std::endl;
-        } else {
-            std::cout << "Heartbeat sent!" << std::endl;
+    const float offset[4] = {};
+    mavlink_msg_attitude_quaternion_pack(1, 1, &msg, time_boot_ms,
+        attitude.w(), attitude.x(), attitude.y(), attitude.z(), rate[0], rate[1], rate[2], offset);
+    gcs.send(msg);
+
+    // Only an aided estimate is published; a stale one is not sent either.
+    if (odometry.timestamp && time_us - odometry.timestamp <= AIDING_TIMEOUT_US)
+    {
+        mavlink_msg_local_position_ned_pack(1, 1, &msg, time_boot_ms,
+            position[0], position[1], position[2], velocity[0], velocity[1], velocity[2]);
+        gcs.send(msg);
+
+        // Upper triangles of the 6x6 pose and twist covariances; only the
+        // diagonals are filled. Rates have no estimate of their own, so
+        // their variances are NaN, i.e. unknown.
+        constexpr int diagonal[6] = { 0, 6, 11, 15, 18, 20 };
+        float pose_covariance[21] = {}, velocity_covariance[21] = {};
+        for (int i = 0; i < 3; i++)
+        {
+            pose_covariance[diagonal[i]]         = odometry.position_variance[i];
+            pose_covariance[diagonal[i + 3]]     = odometry.attitude_variance[i];
+            velocity_covariance[diagonal[i]]     = odometry.velocity_variance[i];
+            velocity_covariance[diagonal[i + 3]] = NAN;
         }
 
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        mavlink_msg_odometry_pack(1, 1, &msg, time_us, MAV_FRAME_LOCAL_NED, MAV_FRAME_LOCAL_NED,
+            position[0], position[1], position[2], attitude.data(), velocity[0], velocity[1], velocity[2],
+            rate[0], rate[1], rate[2], pose_covariance, velocity_covariance, 0, MAV_ESTIMATOR_TYPE_AUTOPILOT, 0);
+        gcs.send(msg);
     }
+
+    // Receiver channels and link quality, scaled to the 0..254 range.
+    lumina::crsf::input sticks = rc.latest();
+    lumina::crsf::link_statistics link = rc.link();
+    uint8_t uplink = rc.failsafe() ? 0 : link.uplink_quality * 254 / 100;
+    uint8_t downlink = link.downlink_quality * 254 / 100;
+    const auto& ch = sticks.channels;
+    mavlink_msg_rc_channels_pack(1, 1, &msg, time_boot_ms, lumina::crsf::CHANNELS,
+        ch[0], ch[1], ch[2], ch[3], ch[4], ch[5], ch[6], ch[7],
+        ch[8], ch[9], ch[10], ch[11], ch[12], ch[13], ch[14], ch[15], UINT16_MAX, UINT16_MAX, uplink);
+    gcs.send(msg);
+
+    mavlink_msg_radio_status_pack(1, 1, &msg, uplink, downlink, 100, UINT8_MAX, UINT8_MAX, rc.errors(), 0);
+    gcs.send(msg);
+
+    lumina::vec3 euler = lumina::quaternion_to_euler(attitude);
+    rc.send(lumina::crsf::attitude(euler[0], euler[1], euler[2]));
+
+    if (tick % TELEMETRY_HZ == 0)
+    {
+        rc.send(lumina::crsf::flight_mode(failsafe ? "FAILSAFE"
+                                        : context.armed.load(std::memory_order_relaxed) ? "ANGLE" : "DISARMED"));
+    }
+
+    // Diagnostics count as logging and pause when the supervisor sheds load.
+    if (tick % TELEMETRY_HZ == 0 && logging)
+    {
+        mavlink_msg_named_value_int_pack(1, 1, &msg, time_boot_ms, "rc_lat_p99", rc.latency().percentile(0.99f));
+        gcs.send(msg);
+
+        mavlink_msg_named_value_int_pack(1, 1, &msg, time_boot_ms, "mc_lat_p99", gcs.latency().percentile(0.99f));
+        gcs.send(msg);
+
+        // High-water marks in bytes: every pool and arena, the heap's
+        // lowest free size and the control task's smallest stack margin.
+        lumina::memory::usage::for_each([&](const lumina::memory::usage& u) {
+            char name[MAVLINK_MSG_NAMED_VALUE_INT_FIELD_NAME_LEN + 1];
+            std::snprintf(name, sizeof(name), "%.7s.hw", u.name());
+            mavlink_msg_named_value_int_pack(1, 1, &msg, time_boot_ms, name, u.peak());
+            gcs.send(msg);
+        });
+
+        mavlink_msg_named_value_int_pack(1, 1, &msg, time_boot_ms, "heap_min", heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+        gcs.send(msg);
+
+        mavlink_msg_named_value_int_pack(1, 1, &msg, time_boot_ms, "stack_ctl", uxTaskGetStackHighWaterMark(control->task));
+        gcs.send(msg);
+
+#if LUMINA_PROFILE
+        // Mean, worst case and jitter of every probe in microseconds, as
+        // "<probe>.avg" etc. with the probe name cut to fit the 10 chars.
+        lumina::profile::probe::for_each([&](const lumina::profile::probe& p) {
+            lumina::profile::timing t = p.read();
+            const std::pair<const char*, float> values[] = { { "avg", t.mean_us }, { "max", t.max_us }, { "jit", t.jitter_us } };
+            for (const auto& [suffix, value] : values)
+            {
+                char name[MAVLINK_MSG_NAMED_VALUE_FLOAT_FIELD_NAME_LEN + 1];
+                std::snprintf(name, sizeof(name), "%.6s.%s", t.name, suffix);
+                mavlink_msg_named_value_float_pack(1, 1, &msg, time_boot_ms, name, value);
+                gcs.send(msg);
+            }
+        });
+
+        auto busy = load.sample();
+        for (size_t core = 0; core < busy.size(); core++)
+        {
+            char name[MAVLINK_MSG_NAMED_VALUE_FLOAT_FIELD_NAME_LEN + 1];
+            std::snprintf(name, sizeof(name), "load%u", static_cast<unsigned>(core));
+            mavlink_msg_named_value_float_pack(1, 1, &msg, time_boot_ms, name, busy[core]);
+            gcs.send(msg);
+        }
+#endif
+    }
+
+#if LUMINA_TRACE
+    // The frozen trace keeps what led up to the first miss until then.
+    if (lumina::trace::frozen() && health.level == lumina::degradation::NOMINAL &&
+        time_us - trace_dumped >= TRACE_DUMP_INTERVAL_US)
+    {
+        lumina::trace::print();
+        lumina::trace::resume();
+        trace_dumped = time_us;
+    }
+#endif
+
+#if LUMINA_PROFILE
+    // Dump the full table on the console after each flight.
+    if (was_armed && !actuators.armed && logging)
+        lumina::profile::log();
+    was_armed = actuators.armed;
+#endif
+}
+
+using drone = lumina::drone<link_component, gcs_component, imu_component, esc_component,
+                            rc_component, battery_component, notch_component, control_component, telemetry_component>;
+
+extern "C"
+void app_main(void)
+{
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+
+    static drone quad;
+    quad.init();
+    quad.start();
+
+    ESP_LOGI("DRONE", "ready to arm %lld us after init", static_cast<long long>(quad.ready_us()));
+    quad.timings([](const char* name, int64_t us) {
+        ESP_LOGI("DRONE", "  %-10s init %lld us", name, static_cast<long long>(us));
+    });
+
+    for (;;)
+        vTaskDelay(portMAX_DELAY);
 }
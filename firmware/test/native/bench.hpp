@@ -0,0 +1,57 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+
+#include <cstdio>
+
+#include <unity.h>
+
+/**
+ * Micro-benchmark helpers for the native tests.
+ *
+ * Host timings only rank alternatives against each other; the target's
+ * numbers come from the LUMINA_PROFILE probes. Each measurement is the best
+ * of a few runs so that a preempted run does not count.
+ */
+namespace bench
+{
+
+/**
+ * Keeps the compiler from dropping a computation whose result is unused.
+ */
+template <typename T>
+inline void keep(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * Mean nanoseconds per call of `f(i)` for i in [0, n).
+ */
+template <typename F>
+double ns_per_call(int n, F&& f, int runs = 5)
+{
+    double best = 1e30;
+    for (int r = 0; r < runs; r++)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < n; i++)
+            f(i);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / n;
+        best = std::min(best, ns);
+    }
+    return best;
+}
+
+/**
+ * Prints "<what>: <ns> ns" as a test message.
+ */
+inline void report(const char* what, double ns)
+{
+    char text[128];
+    std::snprintf(text, sizeof(text), "%s: %.2f ns", what, ns);
+    TEST_MESSAGE(text);
+}
+
+}
@@ -0,0 +1,262 @@
+#include <unity.h>
+
+#include <array>
+#include <cmath>
+#include <random>
+
+#include "bench.hpp"
+#include "attitude.hpp"
+
+using namespace lumina;
+
+static constexpr float G = 9.80665f;
+static constexpr float DT = 0.001f;
+
+/**
+ * Ground-truth flight: roll and pitch oscillate while the vehicle turns at
+ * a constant yaw rate. The IMU log is sampled from it at 1 kHz, with a
+ * constant gyro bias and white noise on both sensors.
+ */
+struct flight
+{
+    vec3 gyro_bias{};
+    float gyro_noise = 0.005f;              // rad/s
+    float accel_noise = 0.2f;               // m/s^2
+    float yaw_rate = 0.3f;                  // rad/s
+    std::mt19937 rng{7};
+
+    static vec3 euler(float t, float yaw_rate)
+    {
+        return vec3{0.3f * std::sin(2 * math::pi<float> * 0.3f * t),
+                    0.2f * std::sin(2 * math::pi<float> * 0.2f * t + 1),
+                    std::remainder(yaw_rate * t, 2 * math::pi<float>)};
+    }
+
+    quat truth(float t) const
+    {
+        return euler_to_quaternion(euler(t, yaw_rate));
+    }
+
+    /**
+     * Body rate from the Euler angle rates, at the middle of the step.
+     */
+    vec3 rate(float t) const
+    {
+        float tm = t + DT / 2;
+        vec3 e = euler(tm, yaw_rate);
+        float droll = 0.3f * 2 * math::pi<float> * 0.3f * std::cos(2 * math::pi<float> * 0.3f * tm);
+        float dpitch = 0.2f * 2 * math::pi<float> * 0.2f * std::cos(2 * math::pi<float> * 0.2f * tm + 1);
+        float dyaw = yaw_rate;
+        float sr = std::sin(e[0]), cr = std::cos(e[0]), sp = std::sin(e[1]), cp = std::cos(e[1]);
+        return vec3{droll - dyaw * sp, dpitch * cr + dyaw * sr * cp, -dpitch * sr + dyaw * cr * cp};
+    }
+
+    vec3 gyro(float t)
+    {
+        std::normal_distribution<float> n(0, gyro_noise);
+        return rate(t) + gyro_bias + vec3{n(rng), n(rng), n(rng)};
+    }
+
+    vec3 accel(float t)
+    {
+        std::normal_distribution<float> n(0, accel_noise);
+        return truth(t).conjugate().rotate(vec3{0, 0, -G}) + vec3{n(rng), n(rng), n(rng)};
+    }
+};
+
+/**
+ * Angle between the estimated and true gravity directions, in radians.
+ */
+static float tilt_error(const quat& estimate, const quat& truth)
+{
+    vec3 a = estimate.conjugate().rotate(vec3{0, 0, 1});
+    vec3 b = truth.conjugate().rotate(vec3{0, 0, 1});
+    float c = a.dot(b);
+    return std::acos(c > 1 ? 1 : c);
+}
+
+static float yaw_error(const quat& estimate, const quat& truth)
+{
+    return std::remainder(quaternion_to_euler(estimate)[2] - quaternion_to_euler(truth)[2], 2 * math::pi<float>);
+}
+
+struct result
+{
+    float worst_tilt;               // after the settling time
+    float final_tilt;
+    float final_yaw;
+};
+
+/**
+ * Replays `seconds` of the flight log into `filter`, starting from the
+ * truth, and reports the errors after `settle` seconds.
+ */
+template <typename F>
+static result replay(F& filter, flight& f, float seconds, float settle = 5)
+{
+    filter.reset(f.truth(0).conjugate().rotate(vec3{0, 0, -G}));
+    result r{0, 0, 0};
+    int steps = static_cast<int>(seconds / DT);
+    for (int i = 0; i < steps; i++)
+    {
+        float t = i * DT;
+        filter.update(f.gyro(t), f.accel(t + DT), DT);
+        if (t >= settle)
+            r.worst_tilt = std::max(r.worst_tilt, tilt_error(filter.attitude(), f.truth(t + DT)));
+    }
+    float end = steps * DT;
+    r.final_tilt = tilt_error(filter.attitude(), f.truth(end));
+    r.final_yaw = yaw_error(filter.attitude(), f.truth(end));
+    return r;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_tracks_the_flight_without_bias()
+{
+    flight f;
+    mahony m;
+    result rm = replay(m, f, 30);
+    TEST_ASSERT_LESS_THAN(math::radians(1.f), rm.worst_tilt);
+    TEST_ASSERT_LESS_THAN(math::radians(1.f), std::fabs(rm.final_yaw));
+
+    flight g;
+    madgwick w;
+    result rw = replay(w, g, 30);
+    TEST_ASSERT_LESS_THAN(math::radians(1.5f), rw.worst_tilt);
+    TEST_ASSERT_LESS_THAN(math::radians(2.f), std::fabs(rw.final_yaw));
+}
+
+void test_mahony_rejects_gyro_bias()
+{
+    // 1 deg/s of roll and pitch bias: the integral learns it and the tilt
+    // error falls back to the noise level.
+    flight f;
+    f.gyro_bias = vec3{math::radians(1.f), math::radians(-1.f), 0};
+    mahony m;
+    result r = replay(m, f, 60, 30);
+    TEST_ASSERT_LESS_THAN(math::radians(0.5f), r.worst_tilt);
+    TEST_ASSERT_FLOAT_WITHIN(math::radians(0.1f), f.gyro_bias[0], m.bias()[0]);
+    TEST_ASSERT_FLOAT_WITHIN(math::radians(0.1f), f.gyro_bias[1], m.bias()[1]);
+
+    // Madgwick has no bias state: the same bias leaves a standing tilt error
+    // of about bias / beta, which a larger beta trades against noise.
+    flight g;
+    g.gyro_bias = f.gyro_bias;
+    madgwick w(0.1f);
+    result rw = replay(w, g, 60, 30);
+    TEST_ASSERT_LESS_THAN(math::radians(1.f) * std::sqrt(2.f) / 0.1f * 1.2f, rw.worst_tilt);
+}
+
+/**
+ * Seconds until `filter`, started level, stays within 1 degree of a
+ * vehicle hovering tilted 30 degrees in roll and -10 in pitch.
+ */
+template <typename F>
+static float settling_time(F& filter, float& final_error)
+{
+    quat truth = euler_to_quaternion(vec3{math::radians(30.f), math::radians(-10.f), 0});
+    vec3 accel = truth.conjugate().rotate(vec3{0, 0, -G});
+    filter.reset(vec3{0, 0, -G});
+
+    float settled = 0;
+    for (int i = 0; i < 20'000; i++)
+    {
+        filter.update(vec3{}, accel, DT);
+        final_error = tilt_error(filter.attitude(), truth);
+        if (final_error >= math::radians(1.f))
+            settled = (i + 1) * DT;
+    }
+    return settled;
+}
+
+void test_converges_from_a_tilted_start()
+{
+    float error;
+    // Mahony's bias integral takes up part of the initial error and only
+    // bleeds it off at the ki bandwidth, which sets its settling time.
+    mahony m;
+    float t = settling_time(m, error);
+    TEST_ASSERT_LESS_THAN(15.f, t);
+    TEST_ASSERT_LESS_THAN(math::radians(1.f), error);
+
+    madgwick w(0.2f);
+    t = settling_time(w, error);
+    TEST_ASSERT_LESS_THAN(2.f, t);
+    TEST_ASSERT_LESS_THAN(math::radians(0.1f), error);
+}
+
+void test_yaw_drift_is_bounded_by_the_yaw_bias()
+{
+    // Gravity does not observe yaw, so a yaw-rate bias integrates into
+    // heading. The accel correction must not add to it while the vehicle
+    // rolls and pitches.
+    flight f;
+    float bias = math::radians(0.2f);
+    f.gyro_bias = vec3{0, 0, bias};
+    mahony m;
+    result r = replay(m, f, 60);
+    float expected = bias * 60;
+    TEST_ASSERT_FLOAT_WITHIN(0.2f * expected, expected, r.final_yaw);
+    TEST_ASSERT_LESS_THAN(math::radians(1.f), r.worst_tilt);
+}
+
+void test_hard_acceleration_is_rejected()
+{
+    // Two seconds of lateral acceleration. Within the 20 % rejection band
+    // (0.5 g sideways) the estimate leans into it; beyond it (0.8 g) the
+    // accel is ignored and the estimate stays level.
+    quat level = quat::identity();
+    mahony m;
+    m.reset(vec3{0, 0, -G});
+    for (int i = 0; i < 2000; i++)
+        m.update(vec3{}, vec3{0.5f * G, 0, -G}, DT);
+    vec3 shaken{0.8f * G, 0, -G};
+    TEST_ASSERT_TRUE(shaken.length() > 1.2f * G);
+    mahony n;
+    n.reset(vec3{0, 0, -G});
+    for (int i = 0; i < 2000; i++)
+        n.update(vec3{}, shaken, DT);
+    TEST_ASSERT_LESS_THAN(1e-6f, tilt_error(n.attitude(), level));
+    TEST_ASSERT_GREATER_THAN(math::radians(5.f), tilt_error(m.attitude(), level));
+}
+
+// Both filters run on every gyro sample, up to 8 kHz.
+void test_update_cost()
+{
+    flight f;
+    std::array<vec3, 256> gyro, accel;
+    for (size_t i = 0; i < gyro.size(); i++)
+    {
+        gyro[i] = f.gyro(i * DT);
+        accel[i] = f.accel(i * DT);
+    }
+
+    mahony m;
+    madgwick w;
+    m.reset(accel[0]);
+    w.reset(accel[0]);
+    double mahony_ns = bench::ns_per_call(1'000'000, [&](int i) {
+        m.update(gyro[i & 255], accel[i & 255], DT);
+        bench::keep(m.attitude());
+    });
+    double madgwick_ns = bench::ns_per_call(1'000'000, [&](int i) {
+        w.update(gyro[i & 255], accel[i & 255], DT);
+        bench::keep(w.attitude());
+    });
+    bench::report("mahony update", mahony_ns);
+    bench::report("madgwick update", madgwick_ns);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_tracks_the_flight_without_bias);
+    RUN_TEST(test_mahony_rejects_gyro_bias);
+    RUN_TEST(test_converges_from_a_tilted_start);
+    RUN_TEST(test_yaw_drift_is_bounded_by_the_yaw_bias);
+    RUN_TEST(test_hard_acceleration_is_rejected);
+    RUN_TEST(test_update_cost);
+    return UNITY_END();
+}
@@ -0,0 +1,114 @@
+#include <unity.h>
+
+#include <array>
+#include <cmath>
+
+#include "bench.hpp"
+#include "math.hpp"
+#include "mixer.hpp"
+#include "rotation.hpp"
+#include "vec.hpp"
+
+using namespace lumina;
+
+// Geometry in constant expressions.
+static_assert(vec3{1, 2, 3}.dot(vec3{4, 5, 6}) == 32);
+static_assert(vec3{1, 0, 0}.cross(vec3{0, 1, 0}) == vec3{0, 0, 1});
+static_assert(math::abs(vec3{3, 4, 0}.length() - 5) < 1e-6f);
+static_assert(math::abs(math::sin(math::pi<float> / 6) - 0.5f) < 1e-6f);
+static_assert(math::abs(math::cos(math::pi<float> / 3) - 0.5f) < 1e-6f);
+static_assert(math::abs(math::atan2(1.f, -1.f) - 3 * math::pi<float> / 4) < 1e-6f);
+static_assert(math::abs(math::asin(1.f) - math::pi<float> / 2) < 1e-6f);
+static_assert(math::abs(math::sqrt(2.f) - 1.41421356f) < 1e-6f);
+
+// Samples of the compile-time trig over several turns, both signs.
+static constexpr int SAMPLES = 97;
+static constexpr float at(int i)
+{
+    return -10 + 20.f * i / (SAMPLES - 1);
+}
+
+static constexpr auto table(float (*f)(float))
+{
+    std::array<float, SAMPLES> values{};
+    for (int i = 0; i < SAMPLES; i++)
+        values[i] = f(at(i));
+    return values;
+}
+
+static constexpr auto SIN = table([](float x) { return math::sin(x); });
+static constexpr auto COS = table([](float x) { return math::cos(x); });
+static constexpr auto ATAN = table([](float x) { return math::atan(x); });
+
+void setUp() {}
+void tearDown() {}
+
+void test_compile_time_trig_matches_libm()
+{
+    for (int i = 0; i < SAMPLES; i++)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(2e-7f, std::sin(at(i)), SIN[i]);
+        TEST_ASSERT_FLOAT_WITHIN(2e-7f, std::cos(at(i)), COS[i]);
+        TEST_ASSERT_FLOAT_WITHIN(2e-7f, std::atan(at(i)), ATAN[i]);
+    }
+}
+
+void test_compile_time_tables_match_runtime()
+{
+    // The same functions called at run time go through libm.
+    volatile float deg = math::pi<float> / 180;
+    mat3 yaw_90 = euler_to_dcm(vec3{0, 0, 90 * deg});
+    mat3 roll_180 = euler_to_dcm(vec3{180 * deg, 0, 0});
+    for (int r = 0; r < 3; r++)
+        for (int c = 0; c < 3; c++)
+        {
+            TEST_ASSERT_FLOAT_WITHIN(1e-6f, yaw_90[r][c], rotation(orientation::YAW_90)[r][c]);
+            TEST_ASSERT_FLOAT_WITHIN(1e-6f, roll_180[r][c], rotation(orientation::ROLL_180)[r][c]);
+        }
+
+    volatile float angle = 45;
+    float a = math::radians(static_cast<float>(angle));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, -std::sin(a) / std::sin(math::radians(45.f)), layout::quad_x[1][0]);
+}
+
+// What the constexpr tables save at boot: building the orientation table
+// and the mixer layouts at run time. As constexpr data they cost nothing.
+void test_startup_cost_of_runtime_tables()
+{
+    volatile float scale = 1;
+    double orientations_ns = bench::ns_per_call(10'000, [&](int) {
+        float deg = scale * math::pi<float> / 180;
+        std::array<mat3, 4> t = {
+            euler_to_dcm(vec3{0, 0, 45 * deg}), euler_to_dcm(vec3{0, 0, 90 * deg}),
+            euler_to_dcm(vec3{180 * deg, 0, 90 * deg}), euler_to_dcm(vec3{90 * deg, 0, 0}),
+        };
+        bench::keep(t);
+    });
+
+    double layouts_ns = bench::ns_per_call(10'000, [&](int) {
+        float s = scale;
+        bench::keep(make_geometry<4>({{ { 135 * s, arm::CW }, { 45 * s, arm::CCW }, { -135 * s, arm::CCW }, { -45 * s, arm::CW } }}));
+        bench::keep(make_geometry<8>({{
+            {   22.5f * s, arm::CW }, {   67.5f * s, arm::CCW }, {  112.5f * s, arm::CW }, {  157.5f * s, arm::CCW },
+            { -157.5f * s, arm::CW }, { -112.5f * s, arm::CCW }, { -67.5f * s,  arm::CW }, {  -22.5f * s, arm::CCW }
+        }}));
+    });
+
+    double lookup_ns = bench::ns_per_call(1'000'000, [&](int i) {
+        bench::keep(rotation(static_cast<orientation>(i % static_cast<int>(orientation::COUNT))));
+    });
+
+    bench::report("4 orientation matrices built at run time", orientations_ns);
+    bench::report("quad and octo layouts built at run time", layouts_ns);
+    bench::report("constexpr orientation lookup", lookup_ns);
+    TEST_ASSERT_LESS_THAN(orientations_ns, lookup_ns);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_compile_time_trig_matches_libm);
+    RUN_TEST(test_compile_time_tables_match_runtime);
+    RUN_TEST(test_startup_cost_of_runtime_tables);
+    return UNITY_END();
+}
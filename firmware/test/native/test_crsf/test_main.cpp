@@ -0,0 +1,289 @@
+#include <unity.h>
+
+#include <random>
+#include <vector>
+
+#include "bench.hpp"
+#include "crsf/crsf.hpp"
+#include "histogram.hpp"
+
+using namespace lumina;
+using namespace lumina::crsf;
+
+void setUp() {}
+void tearDown() {}
+
+/**
+ * RC channel frames as a receiver sends them, each with its own values.
+ */
+struct stream
+{
+    std::vector<uint8_t> bytes;
+    std::vector<channels> sent;
+    std::mt19937 rng{5};
+
+    void add_rc()
+    {
+        std::uniform_int_distribution<int> value(172, 1811);
+        channels c;
+        for (auto& v : c)
+            v = static_cast<uint16_t>(value(rng));
+        auto payload = pack(c);
+        frame f(type::RC_CHANNELS, payload.data(), payload.size(), ADDRESS_FLIGHT_CONTROLLER);
+        bytes.insert(bytes.end(), f.bytes.begin(), f.bytes.begin() + f.size);
+        sent.push_back(c);
+    }
+
+    void add(std::initializer_list<uint8_t> raw)
+    {
+        bytes.insert(bytes.end(), raw);
+    }
+};
+
+/**
+ * Parser with the channels of every RC frame it accepted.
+ */
+struct decoder
+{
+    parser p;
+    std::vector<channels> received;
+
+    void feed(const uint8_t* data, size_t size)
+    {
+        p.feed(data, size, [&](type t, const uint8_t* payload, size_t length) {
+            if (t == type::RC_CHANNELS && length == CHANNELS_SIZE)
+                received.push_back(unpack(payload));
+        });
+    }
+
+    void feed(const std::vector<uint8_t>& bytes)
+    {
+        feed(bytes.data(), bytes.size());
+    }
+};
+
+static void test_crc8_matches_bitwise_reference()
+{
+    std::mt19937 rng(1);
+    for (int n = 0; n < 200; n++)
+    {
+        std::vector<uint8_t> data(n % 64);
+        for (auto& b : data)
+            b = static_cast<uint8_t>(rng());
+
+        uint8_t crc = 0;
+        for (uint8_t b : data)
+        {
+            crc ^= b;
+            for (int bit = 0; bit < 8; bit++)
+                crc = crc & 0x80 ? static_cast<uint8_t>(crc << 1 ^ 0xD5) : static_cast<uint8_t>(crc << 1);
+        }
+        TEST_ASSERT_EQUAL_UINT8(crc, crc8(data.data(), data.size()));
+    }
+}
+
+static void test_byte_at_a_time()
+{
+    // The UART may hand over a frame in any split, down to single bytes.
+    stream s;
+    for (int i = 0; i < 50; i++)
+        s.add_rc();
+
+    decoder d;
+    for (uint8_t b : s.bytes)
+        d.feed(&b, 1);
+
+    TEST_ASSERT_EQUAL_size_t(s.sent.size(), d.received.size());
+    TEST_ASSERT_TRUE(d.received == s.sent);
+    TEST_ASSERT_EQUAL_UINT32(50, d.p.frames());
+    TEST_ASSERT_EQUAL_UINT32(0, d.p.errors());
+}
+
+static void test_random_splits()
+{
+    stream s;
+    for (int i = 0; i < 200; i++)
+        s.add_rc();
+
+    decoder d;
+    std::mt19937 rng(9);
+    for (size_t i = 0; i < s.bytes.size();)
+    {
+        size_t n = std::min<size_t>(1 + rng() % 90, s.bytes.size() - i);
+        d.feed(s.bytes.data() + i, n);
+        i += n;
+    }
+    TEST_ASSERT_TRUE(d.received == s.sent);
+    TEST_ASSERT_EQUAL_UINT32(0, d.p.errors());
+}
+
+static void test_bad_length_byte()
+{
+    // A length byte that cannot fit a frame, or is too short to hold a type
+    // and CRC, is an error and the next frame still decodes. A second
+    // address byte in the length slot starts the frame over.
+    stream s;
+    s.add({ ADDRESS_FLIGHT_CONTROLLER, 0x50 });
+    s.add_rc();
+    s.add({ ADDRESS_FLIGHT_CONTROLLER, 0x01 });
+    s.add_rc();
+    s.add({ ADDRESS_FLIGHT_CONTROLLER, static_cast<uint8_t>(MAX_FRAME - 1) });
+    s.add_rc();
+    s.add({ ADDRESS_FLIGHT_CONTROLLER });
+    s.add_rc();
+
+    decoder d;
+    d.feed(s.bytes);
+    TEST_ASSERT_TRUE(d.received == s.sent);
+    TEST_ASSERT_EQUAL_UINT32(4, d.p.errors());
+
+    // The largest length the buffer holds is accepted.
+    uint8_t payload[MAX_PAYLOAD] = {};
+    frame longest(type::FLIGHT_MODE, payload, sizeof(payload), ADDRESS_FLIGHT_CONTROLLER);
+    TEST_ASSERT_EQUAL_size_t(MAX_FRAME, longest.size);
+    size_t seen = 0;
+    parser p;
+    p.feed(longest.bytes.data(), longest.size, [&](type, const uint8_t*, size_t length) { seen = length; });
+    TEST_ASSERT_EQUAL_size_t(MAX_PAYLOAD, seen);
+    TEST_ASSERT_EQUAL_UINT32(0, p.errors());
+}
+
+static void test_resync_after_crc_error()
+{
+    // A flipped payload bit costs exactly that frame.
+    stream s;
+    for (int i = 0; i < 10; i++)
+        s.add_rc();
+    size_t frame_size = s.bytes.size() / 10;
+    s.bytes[3 * frame_size + 8] ^= 0x10;
+
+    decoder d;
+    d.feed(s.bytes);
+    TEST_ASSERT_EQUAL_UINT32(1, d.p.errors());
+    TEST_ASSERT_EQUAL_size_t(9, d.received.size());
+    TEST_ASSERT_TRUE(d.received[3] == s.sent[4]);
+
+    // A corrupted length swallows the start of the next frame. The parser
+    // searches the dropped bytes again, so only the damaged frame is lost
+    // even when its payload holds address bytes that start false frames.
+    std::mt19937 rng(4);
+    for (int trial = 0; trial < 100; trial++)
+    {
+        stream t;
+        t.rng.seed(trial);
+        for (int i = 0; i < 20; i++)
+            t.add_rc();
+        size_t victim = 2 + rng() % 5;
+        t.bytes[victim * frame_size + 1] = static_cast<uint8_t>(30 + rng() % 32);
+
+        decoder e;
+        e.feed(t.bytes);
+        t.sent.erase(t.sent.begin() + victim);
+        TEST_ASSERT_TRUE(e.received == t.sent);
+        TEST_ASSERT_EQUAL_UINT32(1, e.p.errors());
+    }
+}
+
+static void test_channel_scaling()
+{
+    // The full ELRS range maps onto 988..2012 us, monotonically, with 992
+    // on center; packing round-trips any 11-bit value.
+    TEST_ASSERT_EQUAL_UINT16(988, to_us(172));
+    TEST_ASSERT_EQUAL_UINT16(1500, to_us(992));
+    TEST_ASSERT_EQUAL_UINT16(2012, to_us(1811));
+    for (uint16_t v = 173; v <= 1811; v++)
+    {
+        TEST_ASSERT_TRUE(to_us(v) >= to_us(v - 1));
+        TEST_ASSERT_TRUE(to_us(v) - to_us(v - 1) <= 1);
+    }
+
+    std::mt19937 rng(2);
+    for (int n = 0; n < 100; n++)
+    {
+        channels c;
+        for (auto& v : c)
+            v = static_cast<uint16_t>(rng() & 0x7FF);
+        TEST_ASSERT_TRUE(unpack(pack(c).data()) == c);
+    }
+}
+
+static void test_histogram_percentiles()
+{
+    // Empty: every quantile and the maximum read 0.
+    histogram<> empty;
+    TEST_ASSERT_EQUAL_UINT32(0, empty.percentile(0.5f));
+    TEST_ASSERT_EQUAL_UINT32(0, empty.percentile(0.99f));
+    TEST_ASSERT_EQUAL_UINT32(0, empty.max());
+
+    // Bucket edges: 2^k - 1 and 2^k land in neighbouring buckets.
+    histogram<> h;
+    for (uint32_t k = 1; k < 15; k++)
+    {
+        h.reset();
+        h.record((1u << k) - 1);
+        h.record(1u << k);
+        TEST_ASSERT_EQUAL_UINT32(1, h.count(k));
+        TEST_ASSERT_EQUAL_UINT32(1, h.count(k + 1));
+    }
+
+    // 90 fast samples and 10 slow: the median is the fast bucket's bound,
+    // the tail the slow one's, and quantiles never decrease.
+    h.reset();
+    for (int i = 0; i < 90; i++)
+        h.record(100);
+    for (int i = 0; i < 10; i++)
+        h.record(3000);
+    TEST_ASSERT_EQUAL_UINT32(127, h.percentile(0.5f));
+    TEST_ASSERT_EQUAL_UINT32(127, h.percentile(0.89f));
+    TEST_ASSERT_EQUAL_UINT32(4095, h.percentile(0.95f));
+    uint32_t previous = 0;
+    for (float q = 0; q <= 1; q += 0.01f)
+    {
+        TEST_ASSERT_TRUE(h.percentile(q) >= previous);
+        previous = h.percentile(q);
+    }
+
+    // Values past the last bucket saturate into it; quantiles that land
+    // there report the largest value seen rather than a bucket bound.
+    histogram<8> saturated;
+    saturated.record(10);
+    for (int i = 0; i < 9; i++)
+        saturated.record(1'000'000 + i);
+    TEST_ASSERT_EQUAL_UINT32(9, saturated.count(7));
+    TEST_ASSERT_EQUAL_UINT32(15, saturated.percentile(0.05f));
+    TEST_ASSERT_EQUAL_UINT32(1'000'008, saturated.percentile(0.5f));
+    TEST_ASSERT_EQUAL_UINT32(1'000'008, saturated.percentile(1));
+    TEST_ASSERT_EQUAL_UINT32(10, saturated.total());
+}
+
+// The receiver task parses every frame at up to 500 Hz; the bytes come in
+// one idle-line chunk per frame.
+static void test_parse_benchmark()
+{
+    stream s;
+    for (int i = 0; i < 64; i++)
+        s.add_rc();
+    size_t frame_size = s.bytes.size() / 64;
+
+    parser p;
+    uint32_t sum = 0;
+    auto on_frame = [&](type, const uint8_t* payload, size_t) { sum += unpack(payload)[0]; };
+    bench::report("crsf parse + unpack per frame", bench::ns_per_call(200'000, [&](int i) {
+        p.feed(s.bytes.data() + (i & 63) * frame_size, frame_size, on_frame);
+    }));
+    bench::keep(sum);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_crc8_matches_bitwise_reference);
+    RUN_TEST(test_byte_at_a_time);
+    RUN_TEST(test_random_splits);
+    RUN_TEST(test_bad_length_byte);
+    RUN_TEST(test_resync_after_crc_error);
+    RUN_TEST(test_channel_scaling);
+    RUN_TEST(test_histogram_percentiles);
+    RUN_TEST(test_parse_benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,120 @@
+#include <unity.h>
+
+#include <chrono>
+#include <iterator>
+
+#include <cstdio>
+
+#include "mavlink/lumina/mavlink.h"
+
+// The messages custom_mavlink_messages in platformio.ini generates.
+static constexpr uint32_t MESSAGES[] = {
+    MAVLINK_MSG_ID_HEARTBEAT, MAVLINK_MSG_ID_STATUSTEXT, MAVLINK_MSG_ID_ATTITUDE_QUATERNION,
+    MAVLINK_MSG_ID_LOCAL_POSITION_NED, MAVLINK_MSG_ID_ODOMETRY, MAVLINK_MSG_ID_RC_CHANNELS,
+    MAVLINK_MSG_ID_RADIO_STATUS, MAVLINK_MSG_ID_NAMED_VALUE_INT, MAVLINK_MSG_ID_NAMED_VALUE_FLOAT,
+    MAVLINK_MSG_ID_MANUAL_CONTROL, MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE,
+};
+
+static constexpr mavlink_msg_entry_t ENTRIES[] = MAVLINK_MESSAGE_CRCS;
+
+static constexpr uint32_t GPS_RAW_INT = 24;     // in common, not in the dialect
+static constexpr uint8_t GPS_RAW_INT_CRC = 24;
+
+static double ns_per(int n, std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / n;
+}
+
+// Feeds a serialized message through a fresh parser; returns the status.
+static uint8_t parse(const mavlink_message_t& msg, mavlink_message_t& out)
+{
+    uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+    uint16_t length = mavlink_msg_to_send_buffer(buffer, &msg);
+
+    mavlink_status_t status = {};
+    uint8_t result = MAVLINK_FRAMING_INCOMPLETE;
+    for (uint16_t i = 0; i < length; i++)
+        result = mavlink_frame_char_buffer(&out, &status, buffer[i], &out, &status);
+    return result;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_table_holds_exactly_the_listed_messages()
+{
+    TEST_ASSERT_EQUAL_size_t(std::size(MESSAGES), std::size(ENTRIES));
+    for (size_t i = 1; i < std::size(ENTRIES); i++)
+        TEST_ASSERT_LESS_THAN(ENTRIES[i].msgid, ENTRIES[i - 1].msgid);
+    for (uint32_t id : MESSAGES)
+        TEST_ASSERT_NOT_NULL(mavlink_get_msg_entry(id));
+    TEST_ASSERT_NULL(mavlink_get_msg_entry(GPS_RAW_INT));
+
+    char text[80];
+    std::snprintf(text, sizeof(text), "%zu entries, %zu bytes", std::size(ENTRIES), sizeof(ENTRIES));
+    TEST_MESSAGE(text);
+}
+
+void test_lookup_cost()
+{
+    constexpr int ROUNDS = 200'000;
+    volatile uint32_t sink = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; r++)
+        for (uint32_t id : MESSAGES)
+            sink = sink + mavlink_get_msg_entry(id)->crc_extra;
+    double ns = ns_per(ROUNDS * int(std::size(MESSAGES)), begin);
+
+    char text[80];
+    std::snprintf(text, sizeof(text), "mavlink_get_msg_entry %.1f ns", ns);
+    TEST_MESSAGE(text);
+}
+
+void test_round_trip_and_parse_cost()
+{
+    mavlink_message_t msg, out;
+    mavlink_msg_heartbeat_pack(1, 1, &msg, MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_GENERIC, MAV_MODE_MANUAL_ARMED, 0, MAV_STATE_ACTIVE);
+    TEST_ASSERT_EQUAL_UINT8(MAVLINK_FRAMING_OK, parse(msg, out));
+    TEST_ASSERT_EQUAL_UINT32(MAVLINK_MSG_ID_HEARTBEAT, out.msgid);
+    TEST_ASSERT_EQUAL_UINT8(MAV_TYPE_QUADROTOR, mavlink_msg_heartbeat_get_type(&out));
+
+    const float q[4] = { 1, 0, 0, 0 }, covariance[21] = {};
+    mavlink_msg_odometry_pack(1, 1, &msg, 0, MAV_FRAME_LOCAL_NED, MAV_FRAME_LOCAL_NED, 1, 2, 3, q, 0, 0, 0, 0, 0, 0,
+                              covariance, covariance, 0, MAV_ESTIMATOR_TYPE_AUTOPILOT, 0);
+
+    uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+    uint16_t length = mavlink_msg_to_send_buffer(buffer, &msg);
+    constexpr int ROUNDS = 20'000;
+    mavlink_status_t status = {};
+    int received = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; r++)
+        for (uint16_t i = 0; i < length; i++)
+            received += mavlink_frame_char_buffer(&out, &status, buffer[i], &out, &status) == MAVLINK_FRAMING_OK;
+    double ns = ns_per(ROUNDS * length, begin);
+    TEST_ASSERT_EQUAL_INT(ROUNDS, received);
+
+    char text[80];
+    std::snprintf(text, sizeof(text), "parsing %.1f ns per byte, %u byte ODOMETRY", ns, unsigned(length));
+    TEST_MESSAGE(text);
+}
+
+// A message outside the dialect has no CRC extra here, so it fails its
+// checksum and is dropped.
+void test_message_outside_the_dialect_is_dropped()
+{
+    mavlink_message_t msg = {}, out;
+    msg.msgid = GPS_RAW_INT;
+    mavlink_finalize_message(&msg, 1, 1, 30, 30, GPS_RAW_INT_CRC);
+    TEST_ASSERT_NOT_EQUAL(MAVLINK_FRAMING_OK, parse(msg, out));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_table_holds_exactly_the_listed_messages);
+    RUN_TEST(test_lookup_cost);
+    RUN_TEST(test_round_trip_and_parse_cost);
+    RUN_TEST(test_message_outside_the_dialect_is_dropped);
+    return UNITY_END();
+}
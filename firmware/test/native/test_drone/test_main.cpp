@@ -0,0 +1,169 @@
+#include <unity.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <cstdio>
+
+#include "drone.hpp"
+
+using namespace std::chrono;
+
+// Order in which lifecycle hooks ran, e.g. "i:link i:imu s:link".
+static std::string journal;
+static std::atomic<int> initializing{0};
+static std::atomic<int> overlap{0};
+static std::thread::id main_thread;
+
+static void log(const char* hook, const char* name)
+{
+    static std::atomic_flag lock = ATOMIC_FLAG_INIT;
+    while (lock.test_and_set()) {}
+    journal += std::string(hook) + ":" + name + " ";
+    lock.clear();
+}
+
+// Stands in for slow bring-up such as Wi-Fi association or a sensor reset.
+template <int MS>
+static void bring_up(const char* name)
+{
+    int active = initializing.fetch_add(1) + 1;
+    int seen = overlap.load();
+    while (active > seen && !overlap.compare_exchange_weak(seen, active)) {}
+    std::this_thread::sleep_for(milliseconds(MS));
+    initializing.fetch_sub(1);
+    log("i", name);
+}
+
+struct link_component
+{
+    static constexpr const char* NAME = "link";
+    void init(auto&) { bring_up<60>(NAME); }
+    void start(auto&) { log("s", NAME); }
+    void stop(auto&) { log("x", NAME); }
+};
+
+struct imu_component
+{
+    static constexpr const char* NAME = "imu";
+    static constexpr int CORE = 1;
+    std::thread::id thread;
+    void init(auto&) { thread = std::this_thread::get_id(); bring_up<40>(NAME); }
+    void start(auto&) { log("s", NAME); }
+};
+
+struct esc_component
+{
+    static constexpr const char* NAME = "escs";
+    static constexpr int CORE = 1;
+    void init(auto&) { bring_up<20>(NAME); }
+};
+
+struct control_component
+{
+    static constexpr const char* NAME = "control";
+    using depends = lumina::depends<imu_component, esc_component>;
+    bool ready = false;
+    void init(auto& drone)
+    {
+        // Dependencies are initialized by now.
+        ready = journal.find("i:imu") != std::string::npos && journal.find("i:escs") != std::string::npos;
+        bring_up<10>(NAME);
+        (void)drone.template get<imu_component>();
+    }
+    void start(auto&) { log("s", NAME); }
+    void stop(auto&) { log("x", NAME); }
+};
+
+using quad = lumina::drone<link_component, imu_component, esc_component, control_component>;
+
+// One component after another, and the slowest of level 0 plus level 1.
+static constexpr int64_t SERIAL_US = (60 + 40 + 20 + 10) * 1000;
+static constexpr int64_t CRITICAL_US = (60 + 10) * 1000;
+
+void setUp()
+{
+    journal.clear();
+    overlap.store(0);
+    main_thread = std::this_thread::get_id();
+}
+
+void tearDown() {}
+
+void test_levels_follow_dependencies()
+{
+    static_assert(quad::LEVELS == 2);
+    static_assert(lumina::detail::init_level<control_component>() == 1);
+    static_assert(lumina::detail::init_level<link_component>() == 0);
+    static_assert(lumina::detail::init_core<imu_component>() == 1);
+    static_assert(lumina::detail::init_core<link_component>() == -1);
+}
+
+void test_init_overlaps_independent_components()
+{
+    quad drone;
+    drone.init();
+    drone.start();
+
+    TEST_ASSERT_TRUE(drone.get<control_component>().ready);
+    TEST_ASSERT_GREATER_OR_EQUAL(3, overlap.load());
+
+    // Level 0 takes as long as its slowest component, level 1 follows.
+    char text[96];
+    std::snprintf(text, sizeof(text), "ready after %lld us, %lld us if serial",
+                  static_cast<long long>(drone.ready_us()), static_cast<long long>(SERIAL_US));
+    TEST_MESSAGE(text);
+    TEST_ASSERT_GREATER_OR_EQUAL(CRITICAL_US, drone.ready_us());
+    TEST_ASSERT_LESS_THAN(SERIAL_US, drone.ready_us());
+
+    drone.timings([](const char* name, int64_t us) {
+        char line[64];
+        std::snprintf(line, sizeof(line), "  %-8s init %lld us", name, static_cast<long long>(us));
+        TEST_MESSAGE(line);
+    });
+}
+
+void test_pinned_init_runs_on_a_worker()
+{
+    quad drone;
+    drone.init();
+    TEST_ASSERT_TRUE(drone.get<imu_component>().thread != main_thread);
+}
+
+void test_start_in_order_stop_in_reverse()
+{
+    quad drone;
+    drone.init();
+    journal.clear();
+    drone.start();
+    drone.stop();
+    TEST_ASSERT_EQUAL_STRING("s:link s:imu s:control x:control x:link ", journal.c_str());
+}
+
+void test_timings_cover_every_component()
+{
+    quad drone;
+    drone.init();
+    const char* names[] = { "link", "imu", "escs", "control" };
+    const int64_t floor_us[] = { 60'000, 40'000, 20'000, 10'000 };
+    size_t i = 0;
+    drone.timings([&](const char* name, int64_t us) {
+        TEST_ASSERT_EQUAL_STRING(names[i], name);
+        TEST_ASSERT_GREATER_OR_EQUAL(floor_us[i], us);
+        i++;
+    });
+    TEST_ASSERT_EQUAL_size_t(4, i);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_levels_follow_dependencies);
+    RUN_TEST(test_init_overlaps_independent_components);
+    RUN_TEST(test_pinned_init_runs_on_a_worker);
+    RUN_TEST(test_start_in_order_stop_in_reverse);
+    RUN_TEST(test_timings_cover_every_component);
+    return UNITY_END();
+}
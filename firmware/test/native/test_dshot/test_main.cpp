@@ -0,0 +1,141 @@
+#include <unity.h>
+
+#include <array>
+
+#include "bench.hpp"
+#include "esc/dshot.hpp"
+
+using namespace lumina;
+
+static constexpr dshot::timing TIMING = dshot::timing::make(dshot::speed::DSHOT600, 40'000'000);
+
+/**
+ * Frame built bit by bit as the specification describes it: value,
+ * telemetry bit, then the XOR of the three nibbles, complemented for
+ * bidirectional DShot.
+ */
+static uint16_t reference_packet(uint16_t value, bool telemetry, bool inverted)
+{
+    uint16_t data = static_cast<uint16_t>((value << 1) | telemetry);
+    uint16_t crc = 0;
+    for (int nibble = 0; nibble < 3; nibble++)
+        crc ^= (data >> (nibble * 4)) & 0xF;
+    if (inverted)
+        crc ^= 0xF;
+    return static_cast<uint16_t>((data << 4) | crc);
+}
+
+static std::array<uint32_t, dshot::frame::SYMBOLS> reference_symbols(uint16_t packet, bool inverted)
+{
+    std::array<uint32_t, dshot::frame::SYMBOLS> symbols{};
+    for (int bit = 0; bit < dshot::FRAME_BITS; bit++)
+    {
+        bool one = (packet >> (dshot::FRAME_BITS - 1 - bit)) & 1;
+        symbols[bit] = one
+            ? dshot::symbol(TIMING.one_high, !inverted, TIMING.one_low, inverted)
+            : dshot::symbol(TIMING.zero_high, !inverted, TIMING.zero_low, inverted);
+    }
+    symbols[dshot::FRAME_BITS] = dshot::symbol(TIMING.pause, inverted, TIMING.pause, inverted);
+    return symbols;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_packets_match_reference()
+{
+    for (uint16_t value = 0; value <= dshot::THROTTLE_MAX; value++)
+        for (int flags = 0; flags < 4; flags++)
+        {
+            bool telemetry = flags & 1, inverted = flags & 2;
+            TEST_ASSERT_EQUAL_UINT16(reference_packet(value, telemetry, inverted), dshot::packet(value, telemetry, inverted));
+        }
+}
+
+void test_throttle_range()
+{
+    TEST_ASSERT_EQUAL_UINT16(dshot::MOTOR_STOP, dshot::throttle(0));
+    TEST_ASSERT_EQUAL_UINT16(dshot::MOTOR_STOP, dshot::throttle(-0.1f));
+    TEST_ASSERT_EQUAL_UINT16(dshot::THROTTLE_MIN, dshot::throttle(1e-6f));
+    TEST_ASSERT_EQUAL_UINT16(1048, dshot::throttle(0.5f));
+    TEST_ASSERT_EQUAL_UINT16(dshot::THROTTLE_MAX, dshot::throttle(1));
+    TEST_ASSERT_EQUAL_UINT16(dshot::THROTTLE_MAX, dshot::throttle(2));
+}
+
+void test_timing_at_each_speed()
+{
+    // 40 MHz RMT: 1.67 us bit at DSHOT600, 3.33 us at DSHOT300, 6.67 us at DSHOT150.
+    constexpr dshot::speed speeds[] = { dshot::speed::DSHOT150, dshot::speed::DSHOT300, dshot::speed::DSHOT600 };
+    constexpr uint16_t periods[] = { 267, 133, 67 };
+    for (int i = 0; i < 3; i++)
+    {
+        dshot::timing t = dshot::timing::make(speeds[i], 40'000'000);
+        TEST_ASSERT_EQUAL_UINT16(periods[i], t.one_high + t.one_low);
+        TEST_ASSERT_EQUAL_UINT16(periods[i], t.zero_high + t.zero_low);
+        TEST_ASSERT_TRUE(t.one_high > t.zero_high);
+        TEST_ASSERT_EQUAL_UINT16(80, t.pause);
+    }
+}
+
+void test_incremental_frame_matches_reference()
+{
+    for (bool inverted : { false, true })
+    {
+        dshot::frame frame(TIMING, inverted);
+        for (uint16_t value = 0; value <= dshot::THROTTLE_MAX; value += 7)
+        {
+            uint16_t packet = dshot::packet(value, value & 1, inverted);
+            frame.write(packet);
+            TEST_ASSERT_EQUAL_UINT16(packet, frame.packet());
+            TEST_ASSERT_TRUE(frame.symbols() == reference_symbols(packet, inverted));
+        }
+    }
+}
+
+// One motor's share of every control loop: throttle to packet to RMT
+// symbols. A slowly moving throttle flips a few low bits per frame, which is
+// what the incremental write is built for; rebuilding all 17 symbols is the
+// baseline.
+void test_encoding_cost()
+{
+    constexpr int N = 1'000'000;
+    std::array<float, 1024> throttle;
+    for (size_t i = 0; i < throttle.size(); i++)
+        throttle[i] = 0.3f + 0.05f * ((i * 37) % 64) / 64.f;
+
+    dshot::frame frame(TIMING, true);
+    double incremental = bench::ns_per_call(N, [&](int i) {
+        frame.write(dshot::packet(dshot::throttle(throttle[i & 1023]), false, true));
+        bench::keep(frame.data());
+    });
+
+    std::array<uint32_t, dshot::frame::SYMBOLS> symbols{};
+    double full = bench::ns_per_call(N, [&](int i) {
+        uint16_t packet = dshot::packet(dshot::throttle(throttle[i & 1023]), false, true);
+        for (int bit = 0; bit < dshot::FRAME_BITS; bit++)
+            symbols[bit] = (packet >> (dshot::FRAME_BITS - 1 - bit)) & 1
+                ? dshot::symbol(TIMING.one_high, false, TIMING.one_low, true)
+                : dshot::symbol(TIMING.zero_high, false, TIMING.zero_low, true);
+        bench::keep(symbols);
+    });
+
+    double steady = bench::ns_per_call(N, [&](int) {
+        frame.write(dshot::packet(dshot::throttle(0.4f), false, true));
+        bench::keep(frame.data());
+    });
+
+    bench::report("frame, incremental write", incremental);
+    bench::report("frame, all symbols rebuilt", full);
+    bench::report("frame, steady throttle", steady);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_packets_match_reference);
+    RUN_TEST(test_throttle_range);
+    RUN_TEST(test_timing_at_each_speed);
+    RUN_TEST(test_incremental_frame_matches_reference);
+    RUN_TEST(test_encoding_cost);
+    return UNITY_END();
+}
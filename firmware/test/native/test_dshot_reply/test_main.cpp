@@ -0,0 +1,206 @@
+#include <unity.h>
+
+#include <array>
+#include <vector>
+
+#include "bench.hpp"
+#include "esc/dshot.hpp"
+
+using namespace lumina;
+using namespace lumina::dshot;
+
+static constexpr uint32_t RESOLUTION_HZ = 40'000'000;
+static constexpr uint32_t BIT_TICKS = reply::bit_ticks(speed::DSHOT600, RESOLUTION_HZ);
+
+/**
+ * One captured reply as the RMT receiver delivers it.
+ */
+struct capture
+{
+    std::array<uint32_t, 16> symbols;
+    size_t count;
+};
+
+/**
+ * Payload of a 12-bit reply value: the value and its complemented checksum.
+ */
+static uint32_t payload(uint16_t data)
+{
+    return (static_cast<uint32_t>(data) << 4) | (~(data ^ (data >> 4) ^ (data >> 8)) & 0x0F);
+}
+
+/**
+ * Line levels of a payload: start bit, then the GCR groups in NRZI.
+ */
+static uint32_t line(uint32_t payload)
+{
+    constexpr uint8_t gcr[16] = { 0x19, 0x1B, 0x12, 0x13, 0x1D, 0x15, 0x16, 0x17,
+                                  0x1A, 0x09, 0x0A, 0x0B, 0x1E, 0x0D, 0x0E, 0x0F };
+    uint32_t transitions = 0;
+    for (int group = 3; group >= 0; group--)
+        transitions = (transitions << 5) | gcr[(payload >> (group * 4)) & 0x0F];
+
+    uint32_t level = 0, levels = 0;
+    for (int bit = 19; bit >= 0; bit--)
+    {
+        level ^= (transitions >> bit) & 1;
+        levels = (levels << 1) | level;
+    }
+    return levels;
+}
+
+/**
+ * Records the line as RMT symbols: some idle before the start bit, every
+ * edge moved by up to `jitter` ticks, and nothing after the last edge,
+ * where the receiver's idle timeout ends the capture.
+ */
+static capture record(uint32_t levels, uint32_t seed, int jitter)
+{
+    std::vector<std::pair<uint32_t, bool>> runs;
+    uint32_t idle = 40 + seed % 200;
+    runs.push_back({ idle, true });
+
+    double bit = BIT_TICKS / 256.0;
+    double start = idle;
+    auto edge = [&](int index) {
+        seed = seed * 1103515245 + 12345;
+        int offset = jitter ? static_cast<int>((seed >> 16) % (2 * jitter + 1)) - jitter : 0;
+        return start + (20 - index) * bit + offset;
+    };
+
+    double from = start;
+    for (int index = 19; index >= -1; index--)
+    {
+        bool level = (levels >> (index + 1)) & 1;
+        bool next = index >= 0 ? (levels >> index) & 1 : true;
+        if (level == next) continue;
+        double to = edge(index);
+        runs.push_back({ static_cast<uint32_t>(to - from + 0.5), level });
+        from = to;
+    }
+
+    capture c{};
+    for (size_t i = 0; i < runs.size(); i += 2)
+    {
+        uint32_t d1 = i + 1 < runs.size() ? runs[i + 1].first : 0;
+        bool l1 = i + 1 < runs.size() ? runs[i + 1].second : true;
+        c.symbols[c.count++] = symbol(runs[i].first, runs[i].second, d1, l1);
+    }
+    return c;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_every_value_decodes_through_jitter()
+{
+    for (uint32_t data = 0; data < 0x1000; data++)
+    {
+        capture c = record(line(payload(data)), data, 10);
+        TEST_ASSERT_EQUAL_UINT32(payload(data), reply::decode(reply::levels(c.symbols.data(), c.count, BIT_TICKS)));
+    }
+}
+
+void test_corruption_is_rejected()
+{
+    // A flipped level moves two transitions, which nearly always breaks a
+    // GCR group or the checksum. The rest decode to a different value.
+    int rejected = 0, total = 0;
+    for (uint32_t data = 0; data < 0x1000; data += 3)
+    {
+        uint32_t levels = line(payload(data));
+        for (int bit = 0; bit < 20; bit++)
+        {
+            uint32_t decoded = reply::decode(levels ^ (1u << bit));
+            TEST_ASSERT_NOT_EQUAL(payload(data), decoded);
+            total++;
+            rejected += decoded == reply::INVALID;
+        }
+    }
+    TEST_ASSERT_GREATER_THAN(total * 99 / 100, rejected);
+}
+
+void test_erpm_and_extended_telemetry()
+{
+    // 0x5A3: period 0x1A3 << 2 us.
+    reply::value v = reply::classify(payload(0x5A3), true);
+    TEST_ASSERT_TRUE(v.type == reply::type::ERPM);
+    TEST_ASSERT_EQUAL_UINT32(35800, reply::erpm(v.data));
+    TEST_ASSERT_EQUAL_UINT32(0, reply::erpm(0x0FFF));
+    TEST_ASSERT_EQUAL_UINT32(0, reply::erpm(0));
+
+    v = reply::classify(payload(0x22D), true);
+    TEST_ASSERT_TRUE(v.type == reply::type::TEMPERATURE);
+    TEST_ASSERT_EQUAL_UINT16(0x2D, v.data);
+    TEST_ASSERT_TRUE(reply::classify(payload(0x4A0), true).type == reply::type::VOLTAGE);
+    TEST_ASSERT_TRUE(reply::classify(payload(0x612), true).type == reply::type::CURRENT);
+    TEST_ASSERT_TRUE(reply::classify(payload(0xE01), true).type == reply::type::STATUS);
+
+    // Without EDT the same frames are eRPM periods.
+    TEST_ASSERT_TRUE(reply::classify(payload(0x22D), false).type == reply::type::ERPM);
+    TEST_ASSERT_TRUE(reply::classify(reply::INVALID, true).type == reply::type::INVALID);
+
+    // Every 12-bit value classifies as the EDT specification's prefix table says.
+    constexpr reply::type PREFIX[8] = {
+        reply::type::ERPM, reply::type::TEMPERATURE, reply::type::VOLTAGE, reply::type::CURRENT,
+        reply::type::DEBUG1, reply::type::DEBUG2, reply::type::STRESS, reply::type::STATUS
+    };
+    for (uint32_t data = 0; data < 0x1000; data++)
+    {
+        bool edt = (data & 0x100) == 0 && (data & 0xE00) != 0;
+        reply::value v = reply::classify(payload(data), true);
+        TEST_ASSERT_TRUE(v.type == (edt ? PREFIX[data >> 9] : reply::type::ERPM));
+        TEST_ASSERT_EQUAL_UINT16(edt ? data & 0xFF : data, v.data);
+    }
+}
+
+void test_short_capture_is_padded_with_idle()
+{
+    // Every valid reply ends high, so its last run merges with the idle line
+    // and the receiver never delivers it. The decoder fills it in.
+    for (uint32_t data : { 0x000u, 0x5A3u, 0xFFFu })
+    {
+        capture c = record(line(payload(data)), data, 0);
+        uint32_t last = c.symbols[c.count - 1];
+        bool level = (last >> 16) & 0x7FFF ? last >> 31 : (last >> 15) & 1;
+        TEST_ASSERT_FALSE(level);
+        TEST_ASSERT_EQUAL_UINT32(payload(data), reply::decode(reply::levels(c.symbols.data(), c.count, BIT_TICKS)));
+    }
+}
+
+// Decoding happens in the RMT receive callback for every motor after every
+// frame: four replies per loop at up to 8 kHz.
+void test_decode_throughput()
+{
+    constexpr int RECORDINGS = 512;
+    std::vector<capture> recordings;
+    for (int i = 0; i < RECORDINGS; i++)
+        recordings.push_back(record(line(payload((i * 2654435761u) & 0xFFF)), i, 10));
+
+    double parse_ns = bench::ns_per_call(1'000'000, [&](int i) {
+        const capture& c = recordings[i % RECORDINGS];
+        bench::keep(reply::parse(c.symbols.data(), c.count, BIT_TICKS, true));
+    });
+
+    std::vector<uint32_t> levels;
+    for (const capture& c : recordings)
+        levels.push_back(reply::levels(c.symbols.data(), c.count, BIT_TICKS));
+    double decode_ns = bench::ns_per_call(1'000'000, [&](int i) {
+        bench::keep(reply::erpm(reply::classify(reply::decode(levels[i % RECORDINGS]), false).data));
+    });
+
+    bench::report("reply, symbols to classified value", parse_ns);
+    bench::report("reply, GCR decode and eRPM only", decode_ns);
+    TEST_ASSERT_LESS_THAN(parse_ns, decode_ns);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_every_value_decodes_through_jitter);
+    RUN_TEST(test_corruption_is_rejected);
+    RUN_TEST(test_erpm_and_extended_telemetry);
+    RUN_TEST(test_short_capture_is_padded_with_idle);
+    RUN_TEST(test_decode_throughput);
+    return UNITY_END();
+}
@@ -0,0 +1,229 @@
+#include <unity.h>
+
+#include <cmath>
+#include <random>
+
+#include "bench.hpp"
+#include "ekf.hpp"
+
+using namespace lumina;
+
+using nav_filter = ekf<>;
+
+static constexpr float G = nav_filter::GRAVITY;
+static constexpr float DT = 0.001f;
+static constexpr int64_t DT_US = 1'000;
+
+void setUp() {}
+void tearDown() {}
+
+/**
+ * Level IMU log of a vehicle moving at a constant NED velocity: the gyro
+ * reads only noise and the accelerometer only gravity. Position fixes of the
+ * true track are taken every `fix_every` samples.
+ */
+struct cruise
+{
+    vec3 velocity{};
+    vec3 origin{};
+    float gyro_noise = 0.005f;              // rad/s
+    float accel_noise = 0.1f;               // m/s^2
+    float fix_noise = 0.05f;                // m
+    std::mt19937 rng{11};
+
+    vec3 position(int64_t t) const
+    {
+        return origin + velocity * (t * 1e-6f);
+    }
+
+    vec3 gyro()
+    {
+        std::normal_distribution<float> n(0, gyro_noise);
+        return vec3{n(rng), n(rng), n(rng)};
+    }
+
+    vec3 accel()
+    {
+        std::normal_distribution<float> n(0, accel_noise);
+        return vec3{n(rng), n(rng), -G + n(rng)};
+    }
+
+    ekf_measurement fix(int64_t t)
+    {
+        std::normal_distribution<float> n(0, fix_noise);
+        return { ekf_measurement::POSITION, t, position(t) + vec3{n(rng), n(rng), n(rng)}, fix_noise * fix_noise };
+    }
+
+    /**
+     * Feeds `seconds` of the log from sample `start` on, fusing a fix every
+     * `fix_every` samples (never if 0). Returns the next sample index.
+     */
+    template <typename Filter>
+    int replay(Filter& f, float seconds, int fix_every, int start = 0)
+    {
+        int end = start + static_cast<int>(seconds / DT);
+        for (int i = start; i < end; i++)
+        {
+            int64_t t = i * DT_US;
+            f.update(t, gyro(), accel(), i ? DT : 0);
+            if (fix_every && i % fix_every == 0)
+                f.fuse(fix(t));
+        }
+        return end;
+    }
+};
+
+static float max_component(const vec3& v)
+{
+    return std::max({ std::fabs(v[0]), std::fabs(v[1]), std::fabs(v[2]) });
+}
+
+static void test_stationary_converges()
+{
+    // 10 Hz fixes at the origin pull the initial 0.5 m of position and
+    // velocity uncertainty down and hold the vehicle still and level.
+    cruise log;
+    nav_filter f;
+    vec3 initial = f.variance(nav_filter::POSITION);
+    log.replay(f, 20, 100);
+
+    TEST_ASSERT_TRUE(f.aided() > 0);
+    TEST_ASSERT_EQUAL_UINT32(0, f.rejected());
+    TEST_ASSERT_LESS_THAN(0.1f, max_component(f.position()));
+    TEST_ASSERT_LESS_THAN(0.1f, max_component(f.velocity()));
+    TEST_ASSERT_LESS_THAN(initial[0] / 10, max_component(f.variance(nav_filter::POSITION)));
+    TEST_ASSERT_LESS_THAN(initial[0] / 10, max_component(f.variance(nav_filter::VELOCITY)));
+
+    vec3 euler = quaternion_to_euler(f.attitude());
+    TEST_ASSERT_LESS_THAN(math::radians(1.f), std::fabs(euler[0]));
+    TEST_ASSERT_LESS_THAN(math::radians(1.f), std::fabs(euler[1]));
+}
+
+static void test_constant_velocity_converges()
+{
+    // The filter starts at rest; position fixes alone have to reveal the
+    // velocity, since the accelerometer sees none of it.
+    cruise log;
+    log.velocity = vec3{1.f, -0.5f, 0.2f};
+    nav_filter f;
+    int end = log.replay(f, 20, 100);
+
+    vec3 error = f.velocity() - log.velocity;
+    TEST_ASSERT_LESS_THAN(0.05f, max_component(error));
+    TEST_ASSERT_LESS_THAN(0.1f, max_component(f.position() - log.position((end - 1) * DT_US)));
+}
+
+static void test_covariance_grows_without_aiding()
+{
+    // Without fixes position and velocity only integrate the accelerometer,
+    // so their variance grows every prediction and nothing claims aiding.
+    cruise log;
+    nav_filter f;
+    int i = log.replay(f, 0.5f, 0);
+    float previous = f.variance(nav_filter::POSITION)[0];
+    for (int k = 0; k < 10; k++)
+    {
+        i = log.replay(f, 1, 0, i);
+        float variance = f.variance(nav_filter::POSITION)[0];
+        TEST_ASSERT_GREATER_THAN(previous, variance);
+        previous = variance;
+    }
+    TEST_ASSERT_EQUAL_INT64(0, f.aided());
+
+    // Once fixes resume, one second brings it back down.
+    log.replay(f, 1, 100, i);
+    TEST_ASSERT_LESS_THAN(previous / 10, f.variance(nav_filter::POSITION)[0]);
+    TEST_ASSERT_TRUE(f.aided() > 0);
+}
+
+static void test_delayed_fusion()
+{
+    // A fix that arrives late but inside the filter delay lands at the time
+    // it was taken: the filter ends up exactly where it would have had the
+    // fix arrived on time.
+    cruise log;
+    log.velocity = vec3{0.5f, 0, 0};
+    nav_filter on_time, late;
+
+    constexpr int LATENCY = 60;             // samples, under the 100 ms delay
+    ekf_measurement pending{};
+    for (int i = 0; i < 5'000; i++)
+    {
+        int64_t t = i * DT_US;
+        vec3 gyro = log.gyro(), accel = log.accel();
+        on_time.update(t, gyro, accel, i ? DT : 0);
+        late.update(t, gyro, accel, i ? DT : 0);
+
+        if (i % 100 == 0)
+        {
+            pending = log.fix(t);
+            TEST_ASSERT_TRUE(on_time.fuse(pending));
+        }
+        if (i % 100 == LATENCY)
+            TEST_ASSERT_TRUE(late.fuse(pending));
+    }
+
+    for (int k = 0; k < 3; k++)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(1e-6f, on_time.position()[k], late.position()[k]);
+        TEST_ASSERT_FLOAT_WITHIN(1e-6f, on_time.velocity()[k], late.velocity()[k]);
+    }
+    TEST_ASSERT_EQUAL_INT64(on_time.aided(), late.aided());
+
+    // A fix older than the delayed filter is refused rather than fused out
+    // of order.
+    TEST_ASSERT_FALSE(late.fuse(log.fix(4'999 * DT_US - 200'000)));
+}
+
+static void test_outlier_gated()
+{
+    // A fix 20 m off is many standard deviations out and must not move
+    // the estimate.
+    cruise log;
+    nav_filter f;
+    int i = log.replay(f, 5, 100);
+    vec3 before = f.position();
+
+    int64_t t = i * DT_US;
+    f.fuse({ ekf_measurement::POSITION, t, vec3{20, 0, 0}, 0.0025f });
+    log.replay(f, 0.2f, 0, i);
+
+    TEST_ASSERT_EQUAL_UINT32(1, f.rejected());
+    TEST_ASSERT_LESS_THAN(0.05f, max_component(f.position() - before));
+}
+
+// The control task feeds every IMU sample; most calls only accumulate, one
+// in `period / dt` also predicts the covariance and re-integrates the
+// buffered deltas, so the mean is what the sample rate has to afford.
+static void test_update_benchmark()
+{
+    cruise log;
+    nav_filter f;
+    log.replay(f, 1, 100);
+
+    std::array<vec3, 64> gyro, accel;
+    for (size_t i = 0; i < gyro.size(); i++)
+    {
+        gyro[i] = log.gyro();
+        accel[i] = log.accel();
+    }
+
+    int64_t t = 1'000'000;
+    double ns = bench::ns_per_call(20'000, [&](int i) {
+        f.update(t += DT_US, gyro[i % 64], accel[i % 64], DT);
+    });
+    bench::keep(f.position());
+    bench::report("ekf update (mean per 1 kHz sample)", ns);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_stationary_converges);
+    RUN_TEST(test_constant_velocity_converges);
+    RUN_TEST(test_covariance_grows_without_aiding);
+    RUN_TEST(test_delayed_fusion);
+    RUN_TEST(test_outlier_gated);
+    RUN_TEST(test_update_benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,273 @@
+#include <unity.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "bench.hpp"
+#include "ring.hpp"
+#include "imu/fifo.hpp"
+
+using namespace lumina;
+using namespace lumina::imu;
+
+static raw_sample expected(int i)
+{
+    int16_t v = static_cast<int16_t>(i % 8000);
+    return { { static_cast<int16_t>(2 * v), static_cast<int16_t>(-3 * v), static_cast<int16_t>(v - 4000) },
+             { v, static_cast<int16_t>(-v), static_cast<int16_t>(4096 + v) } };
+}
+
+static void be16(std::vector<uint8_t>& out, int16_t v)
+{
+    out.push_back(static_cast<uint8_t>(static_cast<uint16_t>(v) >> 8));
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+static void le16(std::vector<uint8_t>& out, int16_t v)
+{
+    out.push_back(static_cast<uint8_t>(v));
+    out.push_back(static_cast<uint8_t>(static_cast<uint16_t>(v) >> 8));
+}
+
+/**
+ * ICM-42688-P packet 3 as the sensor writes it: header with the ODR
+ * timestamp flag, accel, gyro, temperature and the 16-bit FIFO timestamp,
+ * which wraps every 65536 ticks.
+ */
+static void icm_packet(std::vector<uint8_t>& out, const raw_sample& s, uint16_t timestamp)
+{
+    out.push_back(0x68);
+    for (int16_t v : s.accel) be16(out, v);
+    for (int16_t v : s.gyro) be16(out, v);
+    out.push_back(25);
+    out.push_back(static_cast<uint8_t>(timestamp >> 8));
+    out.push_back(static_cast<uint8_t>(timestamp));
+}
+
+template <typename Parser>
+static std::vector<raw_sample> parse(const std::vector<uint8_t>& burst)
+{
+    std::vector<raw_sample> out;
+    size_t n = Parser::parse(burst.data(), burst.size(), [&](const raw_sample& s) { out.push_back(s); });
+    TEST_ASSERT_EQUAL_size_t(out.size(), n);
+    return out;
+}
+
+static bool same(const raw_sample& a, const raw_sample& b)
+{
+    return a.gyro == b.gyro && a.accel == b.accel;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_icm42688_replay_across_timestamp_wrap()
+{
+    // 4000 packets at 8 kHz with the 16-bit FIFO timestamp (1 us ticks in
+    // 125 us steps) wrapping several times, read in bursts of 1 to 32
+    // packets as the watermark interrupt and late reads would split them.
+    std::vector<raw_sample> replayed;
+    int next = 0;
+    uint16_t timestamp = 0xF000;
+    for (int burst = 0; next < 4000; burst++)
+    {
+        int packets = 1 + (burst * 7) % 32;
+        std::vector<uint8_t> bytes;
+        for (int i = 0; i < packets; i++, next++, timestamp += 125)
+            icm_packet(bytes, expected(next), timestamp);
+        for (const raw_sample& s : parse<fifo::icm42688>(bytes))
+            replayed.push_back(s);
+    }
+
+    TEST_ASSERT_EQUAL_size_t(next, replayed.size());
+    for (size_t i = 0; i < replayed.size(); i++)
+        TEST_ASSERT_TRUE(same(expected(i), replayed[i]));
+}
+
+void test_icm42688_drops_partial_and_invalid_packets()
+{
+    std::vector<uint8_t> bytes;
+    icm_packet(bytes, expected(1), 0);
+
+    // Invalid marker in the accel: the sensor had no new sample.
+    raw_sample invalid = expected(2);
+    invalid.accel[0] = fifo::icm42688::INVALID;
+    icm_packet(bytes, invalid, 125);
+
+    // Gyro-only packet 2 while the accel starts up.
+    bytes.insert(bytes.end(), { 0x28, 0, 1, 0, 2, 0, 3, 25 });
+
+    icm_packet(bytes, expected(3), 250);
+
+    // A packet cut off by the end of the burst.
+    std::vector<uint8_t> cut = bytes;
+    icm_packet(cut, expected(4), 375);
+    cut.resize(cut.size() - 5);
+
+    auto out = parse<fifo::icm42688>(cut);
+    TEST_ASSERT_EQUAL_size_t(2, out.size());
+    TEST_ASSERT_TRUE(same(expected(1), out[0]));
+    TEST_ASSERT_TRUE(same(expected(3), out[1]));
+
+    // An empty FIFO header or a 20-bit packet ends the burst.
+    std::vector<uint8_t> empty = bytes;
+    empty.insert(empty.end(), 16, 0x80);
+    icm_packet(empty, expected(5), 500);
+    TEST_ASSERT_EQUAL_size_t(2, parse<fifo::icm42688>(empty).size());
+
+    std::vector<uint8_t> wide = bytes;
+    wide.push_back(0x78);
+    wide.insert(wide.end(), 19, 0);
+    TEST_ASSERT_EQUAL_size_t(2, parse<fifo::icm42688>(wide).size());
+}
+
+void test_bmi270_frames()
+{
+    auto regular = [](std::vector<uint8_t>& out, const raw_sample& s) {
+        out.push_back(0x8C);
+        for (int16_t v : s.gyro) le16(out, v);
+        for (int16_t v : s.accel) le16(out, v);
+    };
+
+    std::vector<uint8_t> bytes = { 0x44, 0x10, 0x20, 0x30 };     // sensortime
+    regular(bytes, expected(1));
+    bytes.insert(bytes.end(), { 0x40, 0x02 });                  // skip: two frames lost
+    bytes.insert(bytes.end(), { 0x48, 0x00 });                  // config change
+    bytes.push_back(0x88);                                      // gyro only
+    for (int16_t v : expected(9).gyro) le16(bytes, v);
+    bytes.push_back(0x9C);                                      // aux, gyro, accel
+    bytes.insert(bytes.end(), 8, 0xAA);
+    for (int16_t v : expected(2).gyro) le16(bytes, v);
+    for (int16_t v : expected(2).accel) le16(bytes, v);
+    regular(bytes, expected(3));
+
+    auto out = parse<fifo::bmi270>(bytes);
+    TEST_ASSERT_EQUAL_size_t(3, out.size());
+    TEST_ASSERT_TRUE(same(expected(1), out[0]));
+    TEST_ASSERT_TRUE(same(expected(2), out[1]));
+    TEST_ASSERT_TRUE(same(expected(3), out[2]));
+
+    // Partial trailing frame and the 0x80 empty marker.
+    std::vector<uint8_t> cut(bytes.begin(), bytes.end() - 3);
+    TEST_ASSERT_EQUAL_size_t(2, parse<fifo::bmi270>(cut).size());
+    cut = bytes;
+    cut.insert(cut.end(), { 0x80, 0x00 });
+    regular(cut, expected(4));
+    TEST_ASSERT_EQUAL_size_t(3, parse<fifo::bmi270>(cut).size());
+}
+
+void test_mpu6000_drops_trailing_bytes()
+{
+    std::vector<uint8_t> bytes;
+    for (int i = 0; i < 5; i++)
+    {
+        for (int16_t v : expected(i).accel) be16(bytes, v);
+        for (int16_t v : expected(i).gyro) be16(bytes, v);
+    }
+    bytes.resize(bytes.size() - 7);
+    auto out = parse<fifo::mpu6000>(bytes);
+    TEST_ASSERT_EQUAL_size_t(4, out.size());
+    for (size_t i = 0; i < out.size(); i++)
+        TEST_ASSERT_TRUE(same(expected(i), out[i]));
+}
+
+void test_clock_tracks_a_drifting_sensor()
+{
+    // The oscillator runs 2 % fast. Interrupt times start past 2^32 us
+    // (71 minutes of uptime) so a 32-bit truncation would show.
+    constexpr double PERIOD = 125 / 1.02;
+    imu::clock c(8000);
+    int64_t start = (int64_t(1) << 32) + 12345;
+    int64_t previous = 0;
+    int sample = 0;
+
+    for (int burst = 0; burst < 2000; burst++)
+    {
+        size_t count = burst % 10 == 9 ? 9 : 8;         // a late read now and then
+        sample += count;
+        int64_t time = start + static_cast<int64_t>(sample * PERIOD);
+        c.update(time, count);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            int64_t t = c.timestamp(i);
+            if (burst > 0)
+                TEST_ASSERT_TRUE(t > previous);
+            previous = t;
+        }
+        TEST_ASSERT_EQUAL_INT64(time, c.timestamp(count - 1));
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, PERIOD, c.period());
+    TEST_ASSERT_FLOAT_WITHIN(1, 8000 * 1.02f, c.rate());
+
+    // An overflow that loses samples makes one interval too long; it must
+    // not pull the period estimate.
+    float period = c.period();
+    sample += 64;
+    c.update(start + static_cast<int64_t>(sample * PERIOD), 8);
+    TEST_ASSERT_EQUAL_FLOAT(period, c.period());
+}
+
+void test_sample_ring_wraps()
+{
+    // The driver queues parsed samples in a 64-slot ring for the control
+    // task; over many bursts its indices wrap and a full ring drops.
+    struct queued { int64_t timestamp; raw_sample s; };
+    ring<queued, 64> samples;
+    int pushed = 0, popped = 0, dropped = 0;
+    for (int burst = 0; burst < 1000; burst++)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            if (samples.push({ pushed, expected(pushed) }))
+                pushed++;
+            else
+                dropped++;
+        }
+
+        // The consumer stalls for ten bursts every two hundred.
+        if (burst % 200 >= 190)
+            continue;
+        queued q;
+        while (samples.pop(q))
+        {
+            TEST_ASSERT_EQUAL_INT64(popped, q.timestamp);
+            TEST_ASSERT_TRUE(same(expected(popped), q.s));
+            popped++;
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(pushed, popped + static_cast<int>(samples.size()));
+    // Each stall overflows by 80 - 63 samples, and the burst that ends it
+    // pushes 8 more into the full ring before the consumer drains it.
+    TEST_ASSERT_EQUAL_INT(5 * (10 * 8 - 63) + 4 * 8, dropped);
+}
+
+// One watermark burst of 8 packets, parsed in the IMU driver task.
+void test_parse_cost()
+{
+    std::vector<uint8_t> bytes;
+    for (int i = 0; i < 8; i++)
+        icm_packet(bytes, expected(i), i * 125);
+
+    std::array<raw_sample, 8> raw;
+    double ns = bench::ns_per_call(1'000'000, [&](int) {
+        size_t count = 0;
+        fifo::icm42688::parse(bytes.data(), bytes.size(), [&](const raw_sample& s) { raw[count++] = s; });
+        bench::keep(raw);
+    });
+    bench::report("ICM-42688-P burst of 8 packets", ns);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_icm42688_replay_across_timestamp_wrap);
+    RUN_TEST(test_icm42688_drops_partial_and_invalid_packets);
+    RUN_TEST(test_bmi270_frames);
+    RUN_TEST(test_mpu6000_drops_trailing_bytes);
+    RUN_TEST(test_clock_tracks_a_drifting_sensor);
+    RUN_TEST(test_sample_ring_wraps);
+    RUN_TEST(test_parse_cost);
+    return UNITY_END();
+}
@@ -0,0 +1,222 @@
+#include <unity.h>
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "filter.hpp"
+
+using namespace lumina;
+
+static constexpr float RATE_HZ = 4000;
+
+/**
+ * Steady-state amplitude of `filter` driven by a unit sine at `hz`, from
+ * the RMS over one second, which holds a whole number of periods.
+ */
+template <typename F>
+static float measure(F& filter, float hz)
+{
+    double power = 0;
+    int n = static_cast<int>(RATE_HZ);
+    for (int i = 0; i < 2 * n; i++)
+    {
+        float y = filter(std::sin(2 * math::pi<float> * hz * i / RATE_HZ));
+        if (i >= n)
+            power += y * y;
+    }
+    return static_cast<float>(std::sqrt(2 * power / n));
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_biquad_response_matches_design()
+{
+    const biquad_coefficients designs[] = {
+        biquad_coefficients::lowpass(150, RATE_HZ),
+        biquad_coefficients::notch(300, RATE_HZ, biquad_coefficients::notch_q(300, 240)),
+        biquad_coefficients::bandpass(500, RATE_HZ, 2),
+    };
+    for (const auto& k : designs)
+        for (float hz : { 20.f, 100.f, 150.f, 240.f, 300.f, 375.f, 500.f, 1000.f, 1800.f })
+        {
+            biquad f(k);
+            TEST_ASSERT_FLOAT_WITHIN(0.01f, k.gain(hz, RATE_HZ), measure(f, hz));
+        }
+}
+
+void test_notch_q_gives_the_requested_band()
+{
+    // The band edges are placed in analog frequency; the bilinear transform
+    // shifts them slightly at 4 kHz.
+    auto k = biquad_coefficients::notch(300, RATE_HZ, biquad_coefficients::notch_q(300, 240));
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 0.70710678f, k.gain(240, RATE_HZ));
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 0.70710678f, k.gain(375, RATE_HZ));
+    TEST_ASSERT_LESS_THAN(1e-3f, k.gain(300, RATE_HZ));
+}
+
+/**
+ * Gain of `ORDER` discrete PT1 stages with coefficient `k` at `hz`.
+ */
+static float ptn_gain(int order, float k, float hz)
+{
+    float w = 2 * math::pi<float> * hz / RATE_HZ;
+    float re = 1 - (1 - k) * std::cos(w), im = (1 - k) * std::sin(w);
+    return std::pow(k / std::sqrt(re * re + im * im), static_cast<float>(order));
+}
+
+void test_ptn_response()
+{
+    // The PT1 gain dt / (RC + dt) is a backward Euler discretization: at
+    // 100 Hz of 4 kHz each stage is a little below its analog response, so
+    // the cascade's -3 dB point lands a few percent under the cutoff.
+    for (float hz : { 20.f, 100.f, 800.f })
+    {
+        pt1 a(100, RATE_HZ);
+        pt2 b(100, RATE_HZ);
+        pt3 c(100, RATE_HZ);
+        float ga = measure(a, hz), gb = measure(b, hz), gc = measure(c, hz);
+        TEST_ASSERT_FLOAT_WITHIN(0.005f, ptn_gain(1, pt1::gain(100, RATE_HZ), hz), ga);
+        TEST_ASSERT_FLOAT_WITHIN(0.005f, ptn_gain(2, pt1::gain(100 * pt2::CORRECTION, RATE_HZ), hz), gb);
+        TEST_ASSERT_FLOAT_WITHIN(0.005f, ptn_gain(3, pt1::gain(100 * pt3::CORRECTION, RATE_HZ), hz), gc);
+
+        if (hz == 100)
+            for (float g : { ga, gb, gc })
+                TEST_ASSERT_FLOAT_WITHIN(0.08f, 0.70710678f, g);
+
+        // Higher orders roll off faster above the cutoff.
+        if (hz == 800)
+            TEST_ASSERT_TRUE(gc < gb && gb < ga);
+    }
+}
+
+void test_retune_is_adopted_on_the_next_sample()
+{
+    biquad f;
+    TEST_ASSERT_EQUAL_FLOAT(1, f(1));
+    auto k = biquad_coefficients::lowpass(100, RATE_HZ);
+    TEST_ASSERT_TRUE(f.retune(k));
+    TEST_ASSERT_FALSE(f.retune(biquad_coefficients::passthrough()));
+    f.reset();
+    TEST_ASSERT_EQUAL_FLOAT(k[0], f(1));
+    TEST_ASSERT_TRUE(f.coefficients() == k);
+    TEST_ASSERT_TRUE(f.retune(biquad_coefficients::passthrough()));
+}
+
+void test_retune_from_another_thread_never_tears()
+{
+    // The filter adopts the pending set while the tuner may be writing the
+    // next one; a torn copy would match neither design.
+    auto slow = biquad_coefficients::lowpass(50, RATE_HZ);
+    auto fast = biquad_coefficients::lowpass(900, RATE_HZ);
+    biquad f(slow);
+
+    std::atomic<bool> done{false};
+    std::thread tuner([&] {
+        for (int i = 0; !done.load(); i++)
+        {
+            f.retune(i & 1 ? slow : fast);
+            std::this_thread::yield();
+        }
+    });
+
+    int swaps = 0;
+    const biquad_coefficients* last = &slow;
+    for (int i = 0; i < 200'000; i++)
+    {
+        bench::keep(f(std::sin(0.01f * i)));
+        const auto& k = f.coefficients();
+        TEST_ASSERT_TRUE(k == slow || k == fast);
+        const biquad_coefficients* now = k == slow ? &slow : &fast;
+        swaps += now != last;
+        last = now;
+        if ((i & 63) == 0)
+            std::this_thread::yield();
+    }
+    done = true;
+    tuner.join();
+    TEST_ASSERT_GREATER_THAN(10, swaps);
+}
+
+void test_bank_block_path_matches_samples()
+{
+    constexpr size_t N = 256;
+    std::array<std::vector<float>, 3> in, out;
+    for (int a = 0; a < 3; a++)
+    {
+        in[a].resize(N);
+        out[a].resize(N);
+        for (size_t i = 0; i < N; i++)
+            in[a][i] = std::sin(0.1f * (a + 1) * i);
+    }
+
+    auto k = biquad_coefficients::lowpass(200, RATE_HZ);
+    filter_bank<biquad> blocks(k), samples(k);
+    blocks.process({in[0].data(), in[1].data(), in[2].data()}, {out[0].data(), out[1].data(), out[2].data()}, N);
+
+    for (size_t i = 0; i < N; i++)
+    {
+        vec3 y = samples(vec3{in[0][i], in[1][i], in[2][i]});
+        for (int a = 0; a < 3; a++)
+            TEST_ASSERT_FLOAT_WITHIN(1e-6f, y[a], out[a][i]);
+    }
+}
+
+// Gyro and D-term filtering runs per axis per sample at up to 4 kHz.
+void test_per_sample_cost()
+{
+    constexpr int N = 1'000'000;
+    std::array<float, 256> x;
+    std::array<vec3, 256> v;
+    for (size_t i = 0; i < x.size(); i++)
+    {
+        x[i] = std::sin(0.37f * i);
+        v[i] = vec3{x[i], std::cos(0.11f * i), std::sin(0.05f * i)};
+    }
+
+    biquad b(biquad_coefficients::lowpass(150, RATE_HZ));
+    pt1 p1(100, RATE_HZ);
+    pt2 p2(100, RATE_HZ);
+    pt3 p3(100, RATE_HZ);
+    filter_bank<biquad> bank(biquad_coefficients::lowpass(150, RATE_HZ));
+
+    std::array<float, 256> out;
+    double block = bench::ns_per_call(N / 256, [&](int) {
+        b.process(x.data(), out.data(), x.size());
+        bench::keep(out);
+    }) / 256;
+
+    // The control task hands the lowpass one FIFO burst per step.
+    constexpr size_t BURST = 8;
+    std::array<std::array<float, BURST>, 3> burst_out;
+    double burst = bench::ns_per_call(N / BURST, [&](int i) {
+        const float* in = x.data() + (i * BURST & 255);
+        bank.process({ in, in, in }, { burst_out[0].data(), burst_out[1].data(), burst_out[2].data() }, BURST);
+        bench::keep(burst_out);
+    }) / BURST;
+
+    bench::report("biquad per sample", bench::ns_per_call(N, [&](int i) { bench::keep(b(x[i & 255])); }));
+    bench::report("biquad per sample, 256-sample block", block);
+    bench::report("pt1 per sample", bench::ns_per_call(N, [&](int i) { bench::keep(p1(x[i & 255])); }));
+    bench::report("pt2 per sample", bench::ns_per_call(N, [&](int i) { bench::keep(p2(x[i & 255])); }));
+    bench::report("pt3 per sample", bench::ns_per_call(N, [&](int i) { bench::keep(p3(x[i & 255])); }));
+    bench::report("biquad bank per vec3", bench::ns_per_call(N, [&](int i) { bench::keep(bank(v[i & 255])); }));
+    bench::report("biquad bank per vec3, 8-sample burst", burst);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_biquad_response_matches_design);
+    RUN_TEST(test_notch_q_gives_the_requested_band);
+    RUN_TEST(test_ptn_response);
+    RUN_TEST(test_retune_is_adopted_on_the_next_sample);
+    RUN_TEST(test_retune_from_another_thread_never_tears);
+    RUN_TEST(test_bank_block_path_matches_samples);
+    RUN_TEST(test_per_sample_cost);
+    return UNITY_END();
+}
@@ -0,0 +1,123 @@
+#include <unity.h>
+
+#include <array>
+
+#include "bench.hpp"
+#include "fixed.hpp"
+
+using namespace lumina;
+
+void setUp() {}
+void tearDown() {}
+
+void test_conversion_rounds_and_saturates()
+{
+    TEST_ASSERT_EQUAL_INT16(16384, q15(0.5f).raw());
+    TEST_ASSERT_EQUAL_INT16(q15::max_raw, q15(1.0f).raw());
+    TEST_ASSERT_EQUAL_INT16(q15::min_raw, q15(-1.0f).raw());
+    TEST_ASSERT_EQUAL_INT16(q15::min_raw, q15(-3.0f).raw());
+    TEST_ASSERT_EQUAL_INT16(1, q15(1.4f / 32768).raw());
+    TEST_ASSERT_EQUAL_INT16(2, q15(1.6f / 32768).raw());
+    TEST_ASSERT_EQUAL_INT16(-2, q15(-1.6f / 32768).raw());
+
+    // Q31 to Q15 rounds, Q15 to Q31 is exact.
+    TEST_ASSERT_EQUAL_INT16(1, q15(q31::from_raw(1 << 15)).raw());
+    TEST_ASSERT_EQUAL_INT16(0, q15(q31::from_raw((1 << 15) - 1)).raw());
+    TEST_ASSERT_EQUAL_INT32(int32_t(-5) << 16, q31(q15::from_raw(-5)).raw());
+}
+
+void test_arithmetic_saturates_instead_of_wrapping()
+{
+    TEST_ASSERT_TRUE(q15::max() == q15(0.75f) + q15(0.75f));
+    TEST_ASSERT_TRUE(q15::min() == q15(-0.75f) - q15(0.75f));
+    TEST_ASSERT_TRUE(q15::max() == -q15::min());
+    TEST_ASSERT_TRUE(q31::max() == -q31::min());
+
+    // -1 * -1 is the only product that leaves the range.
+    TEST_ASSERT_TRUE(q15::max() == q15::min() * q15::min());
+    TEST_ASSERT_TRUE(q31::max() == q31::min() * q31::min());
+}
+
+void test_multiply_rounds_to_nearest()
+{
+    // 3/2^15 * 0.5 = 1.5 LSB rounds up, -1.5 LSB rounds towards +inf.
+    TEST_ASSERT_EQUAL_INT16(2, (q15::from_raw(3) * q15(0.5f)).raw());
+    TEST_ASSERT_EQUAL_INT16(-1, (q15::from_raw(-3) * q15(0.5f)).raw());
+    TEST_ASSERT_EQUAL_INT16(0, (q15::from_raw(1) * q15::from_raw(1)).raw());
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.25f * 0.6f, static_cast<float>(q15(0.25f) * q15(0.6f)));
+}
+
+void test_vector_operations()
+{
+    vec<3, q15> a = vec<3, q15>::from_float({0.5f, -0.25f, 0.125f});
+    vec<3, q15> b = vec<3, q15>::from_float({0.5f, 0.5f, 0.5f});
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.1875f, static_cast<float>(a.dot(b)));
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.5728f, static_cast<float>(a.length()));
+
+    vec<3, float> c = a.cross(b).to_float();
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, -0.1875f, c[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, -0.1875f, c[1]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.375f, c[2]);
+
+    // The dot product of full-scale Q31 vectors keeps guard bits and saturates.
+    vec<3, q31> full{ q31::max(), q31::max(), q31::max() };
+    TEST_ASSERT_TRUE(q31::max() == full.dot(full));
+    TEST_ASSERT_TRUE(q31::max() == full.length());
+
+    vec<3, q15> d = vec<3, q15>::from_raw({ 5, -5, 6 }) >> 1;
+    TEST_ASSERT_EQUAL_INT16(3, d[0].raw());
+    TEST_ASSERT_EQUAL_INT16(-2, d[1].raw());
+    TEST_ASSERT_EQUAL_INT16(3, d[2].raw());
+}
+
+// The ISR-side front end: raw int16 samples, bias removal, a gain and a
+// 2:1 decimation, in Q15 against the same in float.
+void test_front_end_fixed_vs_float()
+{
+    constexpr int SAMPLES = 4096;
+    static std::array<std::array<int16_t, 3>, SAMPLES> raw;
+    for (int i = 0; i < SAMPLES; i++)
+        for (int j = 0; j < 3; j++)
+            raw[i][j] = static_cast<int16_t>((i * 7919 + j * 104729) % 65536 - 32768);
+
+    const vec<3, q15> bias = vec<3, q15>::from_raw({ 12, -40, 7 });
+    const q15 gain(0.9f);
+    double fixed_ns = bench::ns_per_call(SAMPLES / 2, [&](int i) {
+        vec<3, q15> a = vec<3, q15>::from_raw(raw[2 * i]) - bias;
+        vec<3, q15> b = vec<3, q15>::from_raw(raw[2 * i + 1]) - bias;
+        bench::keep(((a >> 1) + (b >> 1)) * gain);
+    });
+
+    const vec<3, float> fbias{ 12 / 32768.f, -40 / 32768.f, 7 / 32768.f };
+    const float fgain = 0.9f;
+    double float_ns = bench::ns_per_call(SAMPLES / 2, [&](int i) {
+        vec<3, float> a, b;
+        for (int j = 0; j < 3; j++)
+        {
+            a[j] = raw[2 * i][j] / 32768.f;
+            b[j] = raw[2 * i + 1][j] / 32768.f;
+        }
+        bench::keep(((a - fbias) + (b - fbias)) * (0.5f * fgain));
+    });
+
+    bench::report("front end per sample pair, Q15", fixed_ns);
+    bench::report("front end per sample pair, float", float_ns);
+
+    // Both paths agree to a few LSB away from saturation.
+    vec<3, q15> a = vec<3, q15>::from_raw({ 1000, -2000, 3000 }) - bias;
+    vec<3, q15> b = vec<3, q15>::from_raw({ 1100, -2100, 3100 }) - bias;
+    vec<3, float> f = (((a >> 1) + (b >> 1)) * gain).to_float();
+    TEST_ASSERT_FLOAT_WITHIN(3 / 32768.f, (1050 - 12) * 0.9f / 32768, f[0]);
+    TEST_ASSERT_FLOAT_WITHIN(3 / 32768.f, (-2050 + 40) * 0.9f / 32768, f[1]);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_conversion_rounds_and_saturates);
+    RUN_TEST(test_arithmetic_saturates_instead_of_wrapping);
+    RUN_TEST(test_multiply_rounds_to_nearest);
+    RUN_TEST(test_vector_operations);
+    RUN_TEST(test_front_end_fixed_vs_float);
+    return UNITY_END();
+}
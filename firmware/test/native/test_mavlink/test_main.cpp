@@ -0,0 +1,262 @@
+#include <unity.h>
+
+#include <chrono>
+#include <thread>
+
+#include "bench.hpp"
+#include "mavlink.hpp"
+
+using namespace lumina;
+
+// Loopback ports of the flight controller and the ground station.
+static constexpr uint16_t LOCAL_PORT = 24555;
+static constexpr uint16_t REMOTE_PORT = 24550;
+
+static constexpr uint8_t GCS_SYSTEM = 255;
+static constexpr uint8_t GCS_COMPONENT = MAV_COMP_ID_MISSIONPLANNER;
+
+void setUp() {}
+void tearDown() {}
+
+/**
+ * Ground station end of the link: a UDP socket on REMOTE_PORT that sends to
+ * the flight controller's LOCAL_PORT. It packs on its own MAVLink channel so
+ * that it shares no parser state with the receive thread.
+ */
+struct ground_station
+{
+    int socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in target{};
+
+    ground_station()
+    {
+        int reuse = 1;
+        setsockopt(socket_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in local{};
+        local.sin_family = AF_INET;
+        local.sin_port = htons(REMOTE_PORT);
+        local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(socket_fd, reinterpret_cast<sockaddr*>(&local), sizeof(local));
+
+        timeval timeout{1, 0};
+        setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        target.sin_family = AF_INET;
+        target.sin_port = htons(LOCAL_PORT);
+        target.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    }
+
+    ~ground_station()
+    {
+        close(socket_fd);
+    }
+
+    void send(const mavlink_message_t& msg)
+    {
+        uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+        uint16_t length = mavlink_msg_to_send_buffer(buffer, &msg);
+        sendto(socket_fd, buffer, length, 0, reinterpret_cast<const sockaddr*>(&target), sizeof(target));
+    }
+
+    void manual_control(uint8_t target_system, int16_t x, int16_t y, int16_t z, int16_t r, uint16_t buttons)
+    {
+        mavlink_manual_control_t m{};
+        m.target = target_system;
+        m.x = x;
+        m.y = y;
+        m.z = z;
+        m.r = r;
+        m.buttons = buttons;
+        mavlink_message_t msg;
+        mavlink_msg_manual_control_encode_chan(GCS_SYSTEM, GCS_COMPONENT, MAVLINK_COMM_1, &msg, &m);
+        send(msg);
+    }
+
+    void rc_override(uint8_t target_system, uint16_t ch1, uint16_t ch2, uint16_t ch3, uint16_t ch4, uint16_t ch5)
+    {
+        mavlink_rc_channels_override_t m{};
+        m.target_system = target_system;
+        m.target_component = 0;
+        m.chan1_raw = ch1;
+        m.chan2_raw = ch2;
+        m.chan3_raw = ch3;
+        m.chan4_raw = ch4;
+        m.chan5_raw = ch5;
+        mavlink_message_t msg;
+        mavlink_msg_rc_channels_override_encode_chan(GCS_SYSTEM, GCS_COMPONENT, MAVLINK_COMM_1, &msg, &m);
+        send(msg);
+    }
+};
+
+/**
+ * Polls `read()` the way the control loop does until new input arrives or
+ * a second has passed.
+ */
+static bool wait_for_input(mavlink& fc, manual_input& in)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        if (fc.read(in))
+            return true;
+        std::this_thread::yield();
+    }
+    return false;
+}
+
+/**
+ * Waits until the receive thread has parsed `count` messages in total.
+ */
+static bool wait_for_received(mavlink& fc, uint32_t count)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (fc.received() < count)
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+            return false;
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+static void test_manual_control()
+{
+    // Stick axes in thousandths, INT16_MAX for an unused axis, button 1 arms.
+    ground_station gcs;
+    mavlink fc(htonl(INADDR_LOOPBACK), REMOTE_PORT, LOCAL_PORT);
+    manual_input in{};
+    TEST_ASSERT_FALSE(fc.active());
+
+    gcs.manual_control(mavlink::SYSTEM_ID, 500, -250, 800, 100, 1);
+    TEST_ASSERT_TRUE(wait_for_input(fc, in));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.5f, in.pitch);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, -0.25f, in.roll);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.8f, in.throttle);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.1f, in.yaw);
+    TEST_ASSERT_TRUE(in.arm);
+    TEST_ASSERT_TRUE(fc.active());
+    TEST_ASSERT_FALSE(fc.read(in));
+
+    gcs.manual_control(mavlink::SYSTEM_ID, 0, 0, 1200, INT16_MAX, 0);
+    TEST_ASSERT_TRUE(wait_for_input(fc, in));
+    TEST_ASSERT_EQUAL_FLOAT(0, in.yaw);
+    TEST_ASSERT_EQUAL_FLOAT(1, in.throttle);
+    TEST_ASSERT_FALSE(in.arm);
+}
+
+static void test_rc_channels_override()
+{
+    // AETR in servo microseconds, arm on channel 5 above 1700 us; 0 and
+    // UINT16_MAX mean "no change" and read as center.
+    ground_station gcs;
+    mavlink fc(htonl(INADDR_LOOPBACK), REMOTE_PORT, LOCAL_PORT);
+    manual_input in{};
+
+    gcs.rc_override(mavlink::SYSTEM_ID, 2000, 1250, 1000, UINT16_MAX, 1800);
+    TEST_ASSERT_TRUE(wait_for_input(fc, in));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1, in.roll);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, -0.5f, in.pitch);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0, in.throttle);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0, in.yaw);
+    TEST_ASSERT_TRUE(in.arm);
+
+    gcs.rc_override(mavlink::SYSTEM_ID, 900, 1500, 2100, 1750, 1500);
+    TEST_ASSERT_TRUE(wait_for_input(fc, in));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, -1, in.roll);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1, in.throttle);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.5f, in.yaw);
+    TEST_ASSERT_FALSE(in.arm);
+}
+
+static void test_other_system_is_ignored()
+{
+    // Input for another vehicle on the same network is parsed and counted
+    // but never reaches the setpoint slot.
+    ground_station gcs;
+    mavlink fc(htonl(INADDR_LOOPBACK), REMOTE_PORT, LOCAL_PORT);
+    manual_input in{};
+
+    gcs.manual_control(mavlink::SYSTEM_ID + 1, 500, 500, 500, 500, 1);
+    gcs.rc_override(mavlink::SYSTEM_ID + 1, 2000, 2000, 2000, 2000, 2000);
+    TEST_ASSERT_TRUE(wait_for_received(fc, 2));
+    TEST_ASSERT_FALSE(fc.read(in));
+    TEST_ASSERT_FALSE(fc.active());
+
+    gcs.manual_control(mavlink::SYSTEM_ID, 0, 0, 300, 0, 0);
+    TEST_ASSERT_TRUE(wait_for_input(fc, in));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.3f, in.throttle);
+}
+
+static void test_latency_is_recorded()
+{
+    // Every read() that returns new input records the time since its
+    // datagram arrived.
+    ground_station gcs;
+    mavlink fc(htonl(INADDR_LOOPBACK), REMOTE_PORT, LOCAL_PORT);
+    manual_input in{};
+
+    for (int i = 0; i < 20; i++)
+    {
+        gcs.manual_control(mavlink::SYSTEM_ID, 0, 0, static_cast<int16_t>(50 * i), 0, 0);
+        TEST_ASSERT_TRUE(wait_for_input(fc, in));
+    }
+    TEST_ASSERT_EQUAL_UINT32(20, fc.latency().total());
+    TEST_ASSERT_LESS_THAN(1'000'000u, fc.latency().max());
+    TEST_ASSERT_TRUE(fc.latency().percentile(0.5f) <= fc.latency().percentile(0.99f));
+}
+
+static void test_send_reaches_ground_station()
+{
+    ground_station gcs;
+    mavlink fc(htonl(INADDR_LOOPBACK), REMOTE_PORT, LOCAL_PORT);
+
+    mavlink_message_t msg;
+    mavlink_msg_heartbeat_pack(mavlink::SYSTEM_ID, mavlink::COMPONENT_ID, &msg, MAV_TYPE_QUADROTOR,
+                               MAV_AUTOPILOT_GENERIC, 0, 0, MAV_STATE_STANDBY);
+    TEST_ASSERT_TRUE(fc.send(msg));
+
+    uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+    ssize_t size = recv(gcs.socket_fd, buffer, sizeof(buffer), 0);
+    TEST_ASSERT_GREATER_THAN(0, static_cast<int>(size));
+
+    mavlink_message_t received;
+    mavlink_status_t status;
+    bool parsed = false;
+    for (ssize_t i = 0; i < size; i++)
+        parsed |= mavlink_parse_char(MAVLINK_COMM_2, buffer[i], &received, &status) != 0;
+    TEST_ASSERT_TRUE(parsed);
+    TEST_ASSERT_EQUAL_UINT32(MAVLINK_MSG_ID_HEARTBEAT, received.msgid);
+}
+
+// Stick input is only as fresh as the path from the socket to the control
+// loop; this times a loopback datagram until read() returns it.
+static void test_round_trip_benchmark()
+{
+    ground_station gcs;
+    mavlink fc(htonl(INADDR_LOOPBACK), REMOTE_PORT, LOCAL_PORT);
+    manual_input in{};
+
+    constexpr int N = 200;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; i++)
+    {
+        gcs.manual_control(mavlink::SYSTEM_ID, 0, 0, static_cast<int16_t>(i), 0, 0);
+        wait_for_input(fc, in);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / N;
+    bench::report("manual control sendto to read()", ns);
+    bench::report("manual control arrival to read(), p50 bucket bound", fc.latency().percentile(0.5f) * 1e3);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_manual_control);
+    RUN_TEST(test_rc_channels_override);
+    RUN_TEST(test_other_system_is_ignored);
+    RUN_TEST(test_latency_is_recorded);
+    RUN_TEST(test_send_reaches_ground_station);
+    RUN_TEST(test_round_trip_benchmark);
+    return UNITY_END();
+}
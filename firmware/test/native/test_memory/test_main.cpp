@@ -0,0 +1,232 @@
+#include <unity.h>
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstdlib>
+
+#include "memory.hpp"
+
+using namespace lumina;
+
+// Replacement operator new that runs the no-heap-after-arming check, as the
+// heap's allocation hook does on target.
+void* operator new(size_t size)
+{
+    memory::check_allocation();
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+struct packet
+{
+    uint32_t id;
+    uint8_t payload[60];
+
+    explicit packet(uint32_t id)
+    :   id(id),
+        payload{}
+    {}
+};
+
+// Kept out of reach of the optimizer, which may drop a new/delete pair.
+static int* volatile allocation;
+
+static void allocate(int value)
+{
+    allocation = new int(value);
+    delete allocation;
+}
+
+void setUp()
+{
+    memory::lock_heap(false);
+}
+
+void tearDown()
+{
+    memory::lock_heap(false);
+}
+
+void test_pool_exhausts_and_reuses()
+{
+    static memory::pool<packet, 4> packets("packets");
+    std::vector<packet*> taken;
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        packet* p = packets.create(i);
+        TEST_ASSERT_NOT_NULL(p);
+        TEST_ASSERT_EQUAL_UINT32(i, p->id);
+        taken.push_back(p);
+    }
+    TEST_ASSERT_NULL(packets.create(99u));
+    TEST_ASSERT_EQUAL_size_t(0, packets.available());
+    TEST_ASSERT_EQUAL_size_t(4 * sizeof(packet), packets.usage().peak());
+
+    packets.destroy(taken[2]);
+    TEST_ASSERT_EQUAL_size_t(1, packets.available());
+    packet* again = packets.create(7u);
+    TEST_ASSERT_TRUE(again == taken[2]);
+    taken[2] = again;
+
+    for (packet* p : taken)
+        packets.destroy(p);
+    TEST_ASSERT_EQUAL_size_t(4, packets.available());
+    TEST_ASSERT_EQUAL_size_t(0, packets.usage().used());
+}
+
+void test_pool_unique_ptr_returns_slot()
+{
+    static memory::pool<packet, 2> packets("owned");
+    {
+        auto a = packets.make(1u);
+        auto b = packets.make(2u);
+        TEST_ASSERT_NOT_NULL(a.get());
+        TEST_ASSERT_NOT_NULL(b.get());
+        TEST_ASSERT_NULL(packets.make(3u).get());
+    }
+    TEST_ASSERT_EQUAL_size_t(2, packets.available());
+}
+
+// Threads take and return slots; a slot handed out twice would have its id
+// overwritten by the second owner.
+void test_pool_concurrent_create_destroy()
+{
+    static memory::pool<packet, 64> packets("shared");
+    std::atomic<uint32_t> stolen{0};
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < 4; t++)
+        threads.emplace_back([&, t] {
+            packet* held[8] = {};
+            uint32_t ids[8] = {};
+            for (uint32_t round = 0; round < 20'000; round++)
+            {
+                uint32_t k = round % 8;
+                if (held[k])
+                {
+                    if (held[k]->id != ids[k])
+                        stolen.fetch_add(1);
+                    packets.destroy(held[k]);
+                    held[k] = nullptr;
+                }
+                else
+                {
+                    ids[k] = t << 24 | round;
+                    held[k] = packets.create(ids[k]);
+                }
+                if (round % 64 == 0)
+                    std::this_thread::yield();
+            }
+            for (packet* p : held)
+                packets.destroy(p);
+        });
+    for (auto& t : threads)
+        t.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, stolen.load());
+    TEST_ASSERT_EQUAL_size_t(64, packets.available());
+}
+
+void test_arena_aligns_and_fills()
+{
+    memory::arena<64> arena("arena");
+    uint8_t* byte = arena.make<uint8_t>(uint8_t(1));
+    double* value = arena.make<double>(2.0);
+    TEST_ASSERT_NOT_NULL(byte);
+    TEST_ASSERT_NOT_NULL(value);
+    TEST_ASSERT_EQUAL_size_t(0, reinterpret_cast<uintptr_t>(value) % alignof(double));
+    TEST_ASSERT_EQUAL_size_t(16, arena.usage().used());
+
+    TEST_ASSERT_NULL(arena.allocate(64));
+    TEST_ASSERT_NOT_NULL(arena.allocate(48, 1));
+    TEST_ASSERT_NULL(arena.allocate(1, 1));
+
+    arena.reset();
+    TEST_ASSERT_EQUAL_size_t(0, arena.usage().used());
+    TEST_ASSERT_EQUAL_size_t(64, arena.usage().peak());
+}
+
+void test_footprint_covers_alignment()
+{
+    struct alignas(16) wide { float v[4]; };
+    memory::arena<memory::footprint<uint8_t, wide, double>> arena("exact");
+    TEST_ASSERT_NOT_NULL(arena.make<uint8_t>(uint8_t(0)));
+    TEST_ASSERT_NOT_NULL(arena.make<wide>());
+    TEST_ASSERT_NOT_NULL(arena.make<double>(0.0));
+}
+
+void test_regions_are_registered()
+{
+    memory::arena<32> arena("registered");
+    bool found = false;
+    memory::usage::for_each([&](const memory::usage& u) {
+        if (std::string(u.name()) == "registered")
+            found = u.capacity() == 32;
+    });
+    TEST_ASSERT_TRUE(found);
+}
+
+void test_guard_counts_allocations_of_protected_tasks()
+{
+    TEST_ASSERT_TRUE(memory::protect());
+    uint32_t before = memory::heap_violations();
+
+    // Starting a thread allocates, so the unprotected one starts unlocked.
+    std::atomic<bool> go{false};
+    std::thread other([&] {
+        while (!go.load())
+            std::this_thread::yield();
+        allocate(4);
+    });
+
+    // Unlocked, allocating is fine.
+    allocate(1);
+    TEST_ASSERT_EQUAL_UINT32(before, memory::heap_violations());
+
+    memory::lock_heap(true);
+    TEST_ASSERT_TRUE(memory::heap_locked());
+    allocate(2);
+    TEST_ASSERT_EQUAL_UINT32(before + 1, memory::heap_violations());
+
+    // Pools and arenas do not touch the heap.
+    static memory::pool<packet, 2> packets("armed");
+    packets.destroy(packets.create(1u));
+    memory::arena<16> arena("armed");
+    arena.make<int>(3);
+    TEST_ASSERT_EQUAL_UINT32(before + 1, memory::heap_violations());
+
+    // An unprotected task may still allocate.
+    go.store(true);
+    other.join();
+    TEST_ASSERT_EQUAL_UINT32(before + 1, memory::heap_violations());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_pool_exhausts_and_reuses);
+    RUN_TEST(test_pool_unique_ptr_returns_slot);
+    RUN_TEST(test_pool_concurrent_create_destroy);
+    RUN_TEST(test_arena_aligns_and_fills);
+    RUN_TEST(test_footprint_covers_alignment);
+    RUN_TEST(test_regions_are_registered);
+    RUN_TEST(test_guard_counts_allocations_of_protected_tasks);
+    return UNITY_END();
+}
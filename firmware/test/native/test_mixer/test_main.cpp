@@ -0,0 +1,190 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <array>
+#include <random>
+
+#include <cstdio>
+
+#include "bench.hpp"
+#include "mixer.hpp"
+
+using namespace lumina;
+
+template <size_t N>
+static void check_balanced(const geometry<N>& g)
+{
+    // Pure thrust and pure yaw produce no roll or pitch moment.
+    vec4 sum{};
+    for (const vec4& m : g)
+        sum = sum + m;
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0, sum[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0, sum[1]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0, sum[2]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, N, sum[3]);
+}
+
+template <size_t N>
+static std::array<float, N> spread(const geometry<N>& g, const vec4& demand)
+{
+    std::array<float, N> out{};
+    for (size_t i = 0; i < N; i++)
+        out[i] = demand[0] * g[i][0] + demand[1] * g[i][1] + demand[2] * g[i][2];
+    return out;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_layouts_are_balanced()
+{
+    check_balanced(layout::quad_x);
+    check_balanced(layout::quad_plus);
+    check_balanced(layout::hex_x);
+    check_balanced(layout::octo_x);
+}
+
+void test_unsaturated_demand_is_exact()
+{
+    mixer<6> m(layout::hex_x);
+    vec4 demand{0.2f, -0.1f, 0.15f, 0.5f};
+    auto out = m.mix(demand);
+    auto expected = spread(layout::hex_x, demand);
+    for (size_t i = 0; i < 6; i++)
+        TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.5f + expected[i], out[i]);
+    TEST_ASSERT_FALSE(m.saturated());
+}
+
+void test_airmode_keeps_authority_at_zero_thrust()
+{
+    mixer<4> m(layout::quad_x);
+    vec4 demand{0.3f, 0, 0, 0};
+    auto out = m.mix(demand);
+    auto expected = spread(layout::quad_x, demand);
+    for (size_t i = 0; i < 4; i++)
+        TEST_ASSERT_FLOAT_WITHIN(1e-6f, expected[i] - expected[0], out[i] - out[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0, std::min(std::min(out[0], out[1]), std::min(out[2], out[3])));
+    TEST_ASSERT_FALSE(m.saturated());
+
+    // Full thrust is pulled down just enough to fit the spread.
+    out = m.mix(vec4{0.3f, 0, 0, 1});
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1, std::max(std::max(out[0], out[1]), std::max(out[2], out[3])));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.4f, std::min(std::min(out[0], out[1]), std::min(out[2], out[3])));
+}
+
+void test_without_airmode_thrust_wins_near_zero()
+{
+    mixer<4> m(layout::quad_x, false);
+    auto out = m.mix(vec4{0.3f, 0, 0, 0.1f});
+    for (float o : out)
+        TEST_ASSERT_TRUE(o >= 0);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.4f, out[0] + out[1] + out[2] + out[3]);
+    TEST_ASSERT_TRUE(m.saturated());
+
+    out = m.mix(vec4{0.3f, 0, 0, 0});
+    for (float o : out)
+        TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0, o);
+}
+
+void test_roll_and_pitch_take_priority_over_yaw()
+{
+    mixer<4> m(layout::quad_x);
+
+    // Roll uses the whole range: yaw gets none of it.
+    auto out = m.mix(vec4{0.5f, 0, 1, 0.5f});
+    auto roll = spread(layout::quad_x, vec4{0.5f, 0, 0, 0});
+    for (size_t i = 0; i < 4; i++)
+        TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.5f + roll[i], out[i]);
+    TEST_ASSERT_TRUE(m.saturated());
+
+    // Half the range left: yaw is scaled into it.
+    out = m.mix(vec4{0.25f, 0, 1, 0.5f});
+    float lo = 1, hi = 0;
+    for (float o : out)
+    {
+        lo = std::min(lo, o);
+        hi = std::max(hi, o);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1, hi - lo);
+    TEST_ASSERT_TRUE(m.saturated());
+
+    // Roll beyond the range is scaled down, keeping the roll/pitch ratio.
+    out = m.mix(vec4{2, 1, 0, 0.5f});
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1, out[3] - out[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1 / 3.f, out[2] - out[1]);
+}
+
+void test_outputs_stay_in_range()
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> axis(-2, 2), thrust(-0.5f, 1.5f);
+    mixer<8> air(layout::octo_x), plain(layout::octo_x, false);
+    for (int i = 0; i < 10'000; i++)
+    {
+        vec4 demand{axis(rng), axis(rng), axis(rng), thrust(rng)};
+        for (auto* m : { &air, &plain })
+            for (float o : m->mix(demand))
+                TEST_ASSERT_TRUE(o >= 0 && o <= 1);
+    }
+}
+
+void test_custom_geometry()
+{
+    // A wide quad, arms 30 degrees off the lateral axis: roll is the
+    // strong axis, pitch gets tan(30) of it.
+    constexpr geometry<4> wide = make_geometry<4>({{
+        { 120, arm::CW }, { 60, arm::CCW }, { -120, arm::CCW }, { -60, arm::CW }
+    }});
+    mixer<4> m(layout::quad_x);
+    m.set_geometry(wide);
+    TEST_ASSERT_TRUE(m.get_geometry() == wide);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, -1, wide[0][0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, -0.57735f, wide[0][1]);
+    check_balanced(wide);
+}
+
+template <size_t N>
+static void bench_layout(const char* name, const geometry<N>& g)
+{
+    std::array<vec4, 256> calm, hard;
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> small(-0.1f, 0.1f), large(-2, 2), thrust(0, 1);
+    for (size_t i = 0; i < calm.size(); i++)
+    {
+        calm[i] = vec4{small(rng), small(rng), small(rng), 0.5f};
+        hard[i] = vec4{large(rng), large(rng), large(rng), thrust(rng)};
+    }
+
+    mixer<N> m(g);
+    double calm_ns = bench::ns_per_call(1'000'000, [&](int i) { bench::keep(m.mix(calm[i & 255])); });
+    double hard_ns = bench::ns_per_call(1'000'000, [&](int i) { bench::keep(m.mix(hard[i & 255])); });
+
+    char what[64];
+    std::snprintf(what, sizeof(what), "%s mix, unsaturated", name);
+    bench::report(what, calm_ns);
+    std::snprintf(what, sizeof(what), "%s mix, saturated", name);
+    bench::report(what, hard_ns);
+}
+
+// The mixer runs once per control loop. Its passes are branch-free over the
+// motors, so saturated demands should cost about the same as calm ones.
+void test_mix_cost()
+{
+    bench_layout("quad", layout::quad_x);
+    bench_layout("hex", layout::hex_x);
+    bench_layout("octo", layout::octo_x);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_layouts_are_balanced);
+    RUN_TEST(test_unsaturated_demand_is_exact);
+    RUN_TEST(test_airmode_keeps_authority_at_zero_thrust);
+    RUN_TEST(test_without_airmode_thrust_wins_near_zero);
+    RUN_TEST(test_roll_and_pitch_take_priority_over_yaw);
+    RUN_TEST(test_outputs_stay_in_range);
+    RUN_TEST(test_custom_geometry);
+    RUN_TEST(test_mix_cost);
+    return UNITY_END();
+}
@@ -0,0 +1,244 @@
+#include <unity.h>
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <random>
+#include <thread>
+
+#include "bench.hpp"
+#include "notch.hpp"
+
+using namespace lumina;
+
+static constexpr float RATE_HZ = 8000;
+static constexpr float MIN_HZ = 80;
+static constexpr float MAX_HZ = 600;
+
+// Samples per analysis at the 100 Hz the analysis task runs at.
+static constexpr int PERIOD = 80;
+
+// Spectral resolution of the default 128-point analysis decimated by 4.
+static constexpr float RESOLUTION = RATE_HZ / 4 / 128;
+
+using notch_type = dynamic_notch<>;
+
+void setUp() {}
+void tearDown() {}
+
+/**
+ * Gyro with tones on the roll axis over white noise on every axis.
+ */
+struct vibration
+{
+    std::mt19937 rng{3};
+    std::normal_distribution<float> noise{0, 0.05f};
+    float phase[2] = {};
+
+    vec3 operator() (float hz0, float a0, float hz1 = 0, float a1 = 0)
+    {
+        phase[0] = std::remainder(phase[0] + 2 * math::pi<float> * hz0 / RATE_HZ, 2 * math::pi<float>);
+        phase[1] = std::remainder(phase[1] + 2 * math::pi<float> * hz1 / RATE_HZ, 2 * math::pi<float>);
+        float x = a0 * std::sin(phase[0]) + a1 * std::sin(phase[1]);
+        return vec3{x + noise(rng), noise(rng), noise(rng)};
+    }
+};
+
+/**
+ * Both tasks' halves in one thread: the analysis and retune every PERIOD samples.
+ */
+static vec3 filter(notch_type& notch, const vec3& x, int i)
+{
+    vec3 y = notch(x);
+    if (i % PERIOD == PERIOD - 1)
+    {
+        notch.analyse();
+        notch.update();
+    }
+    return y;
+}
+
+/**
+ * Distance from `hz` to the nearest notch on `axis`.
+ */
+static float nearest(const notch_type& notch, int axis, float hz)
+{
+    float best = 1e9f;
+    for (int p = 0; p < 3; p++)
+        best = std::min(best, std::fabs(notch.frequency(axis, p) - hz));
+    return best;
+}
+
+static void assert_in_band(const notch_type& notch)
+{
+    for (int a = 0; a < 3; a++)
+        for (int p = 0; p < 3; p++)
+        {
+            float f = notch.frequency(a, p);
+            TEST_ASSERT_TRUE(f == 0 || (f >= MIN_HZ && f <= MAX_HZ));
+        }
+}
+
+static void test_follows_a_sweeping_tone()
+{
+    // A resonance that climbs from 120 to 550 Hz over four seconds, as a
+    // motor spooling up would drag it: a notch follows within a bin and
+    // none ever leaves the band.
+    notch_type notch(RATE_HZ, MIN_HZ, MAX_HZ);
+    vibration gyro;
+
+    constexpr int N = 4 * RATE_HZ;
+    float worst = 0;
+    for (int i = 0; i < N; i++)
+    {
+        float hz = 120 + (550 - 120) * i / N;
+        filter(notch, gyro(hz, 1), i);
+        if (i % PERIOD == PERIOD - 1)
+        {
+            assert_in_band(notch);
+            if (i > RATE_HZ / 2)
+                worst = std::max(worst, nearest(notch, 0, hz));
+        }
+    }
+    TEST_ASSERT_LESS_THAN(RESOLUTION, worst);
+}
+
+static void test_tone_beyond_the_band_is_clamped()
+{
+    // A tone sweeping past the top of the band takes its notch up to the
+    // edge but not beyond it.
+    notch_type notch(RATE_HZ, MIN_HZ, MAX_HZ);
+    vibration gyro;
+
+    constexpr int N = 2 * RATE_HZ;
+    float highest = 0;
+    for (int i = 0; i < N; i++)
+    {
+        filter(notch, gyro(500 + 300.f * i / N, 1), i);
+        if (i % PERIOD == PERIOD - 1)
+        {
+            assert_in_band(notch);
+            for (int p = 0; p < 3; p++)
+                highest = std::max(highest, notch.frequency(0, p));
+        }
+    }
+    TEST_ASSERT_FLOAT_WITHIN(RESOLUTION, MAX_HZ, highest);
+}
+
+static void test_finds_two_peaks()
+{
+    // Two resonances on the roll axis get a notch each, in frequency order,
+    // and together lose more than 20 dB.
+    notch_type notch(RATE_HZ, MIN_HZ, MAX_HZ);
+    vibration gyro;
+
+    constexpr int N = 2 * RATE_HZ;
+    double in = 0, out = 0;
+    for (int i = 0; i < N; i++)
+    {
+        vec3 x = gyro(150, 1, 330, 0.5f);
+        vec3 y = filter(notch, x, i);
+        if (i >= N / 2)
+        {
+            in += x[0] * x[0];
+            out += y[0] * y[0];
+        }
+    }
+
+    TEST_ASSERT_FLOAT_WITHIN(RESOLUTION / 2, 150, notch.frequency(0, 0));
+    TEST_ASSERT_FLOAT_WITHIN(RESOLUTION / 2, 330, notch.frequency(0, 1));
+    TEST_ASSERT_LESS_THAN(in / 100, out);
+    assert_in_band(notch);
+}
+
+static void test_nothing_retunes_until_published()
+{
+    // The filtering side only adopts what the analysis has published.
+    notch_type notch(RATE_HZ, MIN_HZ, MAX_HZ);
+    vibration gyro;
+
+    for (int i = 0; i < RATE_HZ; i++)
+        notch(gyro(200, 1));
+    notch.update();
+    TEST_ASSERT_EQUAL_FLOAT(0, notch.frequency(0, 0));
+
+    notch.analyse();
+    TEST_ASSERT_EQUAL_FLOAT(0, notch.frequency(0, 0));
+    notch.update();
+    TEST_ASSERT_FLOAT_WITHIN(RESOLUTION / 2, 200, notch.frequency(0, 0));
+}
+
+static void test_analysis_on_another_thread()
+{
+    // The layout on target: the filtering thread feeds samples and retunes,
+    // a second thread analyses whenever it gets to run.
+    notch_type notch(RATE_HZ, MIN_HZ, MAX_HZ);
+    vibration gyro;
+    std::atomic<bool> done{false};
+    std::atomic<int> passes{0};
+
+    std::thread analysis([&] {
+        while (!done.load())
+        {
+            notch.analyse();
+            passes++;
+            std::this_thread::yield();
+        }
+    });
+
+    for (int i = 0; i < 2 * RATE_HZ; i++)
+    {
+        notch(gyro(240, 1));
+        if (i % 8 == 7)
+        {
+            notch.update();
+            std::this_thread::yield();
+        }
+    }
+    done = true;
+    analysis.join();
+    notch.update();
+
+    TEST_ASSERT_GREATER_THAN(10, passes.load());
+    TEST_ASSERT_LESS_THAN(RESOLUTION, nearest(notch, 0, 240));
+    assert_in_band(notch);
+}
+
+// operator() runs per gyro sample at 8 kHz and update() once per control
+// step on the control task; analyse() is the whole load of the task that
+// took the FFT off the control loop.
+static void test_benchmark()
+{
+    notch_type notch(RATE_HZ, MIN_HZ, MAX_HZ);
+    vibration gyro;
+    std::array<vec3, 256> x;
+    for (auto& v : x)
+        v = gyro(150, 1, 330, 0.5f);
+    for (int i = 0; i < 4 * PERIOD; i++)
+        filter(notch, x[i & 255], i);
+
+    bench::report("dynamic notch per sample", bench::ns_per_call(1'000'000, [&](int i) {
+        bench::keep(notch(x[i & 255]));
+    }));
+    double analysis = bench::ns_per_call(2'000, [&](int) {
+        notch.analyse();
+    });
+    double retune = bench::ns_per_call(2'000, [&](int) {
+        notch.analyse();
+        notch.update();
+    }) - analysis;
+    bench::report("dynamic notch analysis", analysis);
+    bench::report("dynamic notch update after an analysis", retune);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_follows_a_sweeping_tone);
+    RUN_TEST(test_tone_beyond_the_band_is_clamped);
+    RUN_TEST(test_finds_two_peaks);
+    RUN_TEST(test_nothing_retunes_until_published);
+    RUN_TEST(test_analysis_on_another_thread);
+    RUN_TEST(test_benchmark);
+    return UNITY_END();
+}
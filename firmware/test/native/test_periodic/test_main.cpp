@@ -0,0 +1,134 @@
+#include <unity.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <cstdio>
+
+#include "periodic.hpp"
+
+using namespace std::chrono;
+
+static constexpr uint32_t PERIOD_US = 2000;
+static constexpr int RELEASES = 100;
+
+static int64_t now_us()
+{
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Records when each tick ran and optionally stalls on one of them.
+struct recorder
+{
+    std::array<int64_t, RELEASES> times{};
+    std::atomic<int> count{0};
+    uint32_t work_us = 0;
+    int stall_tick = -1;
+    uint32_t stall_us = 0;
+
+    void operator() (uint32_t tick)
+    {
+        int i = count.load();
+        if (i < RELEASES)
+        {
+            times[i] = now_us();
+            count.store(i + 1);
+        }
+        std::this_thread::sleep_for(microseconds(static_cast<int>(tick) == stall_tick ? stall_us : work_us));
+    }
+};
+
+struct body
+{
+    recorder* r;
+
+    void operator() (uint32_t tick) const
+    {
+        (*r)(tick);
+    }
+};
+
+static void wait_for(const recorder& r, int count)
+{
+    while (r.count.load() < count)
+        std::this_thread::sleep_for(milliseconds(1));
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_deadline_defaults_to_period()
+{
+    recorder r;
+    lumina::periodic_task<body> task({ .name = "test", .period_us = PERIOD_US }, body{ &r });
+    TEST_ASSERT_EQUAL_UINT32(PERIOD_US, task.config().deadline_us);
+}
+
+// With 300 us of work per tick a relative sleep would fall 30 ms behind
+// over 100 periods; absolute releases stay within scheduling jitter.
+void test_releases_do_not_drift()
+{
+    recorder r;
+    r.work_us = 300;
+    {
+        lumina::periodic_task<body> task({ .name = "drift", .period_us = PERIOD_US }, body{ &r });
+        wait_for(r, RELEASES);
+    }
+
+    int64_t first = r.times[0];
+    int64_t error = r.times[RELEASES - 1] - first - int64_t(RELEASES - 1) * PERIOD_US;
+    char text[64];
+    std::snprintf(text, sizeof(text), "drift after %d releases: %lld us", RELEASES, static_cast<long long>(error));
+    TEST_MESSAGE(text);
+    TEST_ASSERT_LESS_THAN(int64_t(PERIOD_US), error < 0 ? -error : error);
+}
+
+void test_overrun_is_counted_and_skipped()
+{
+    recorder r;
+    r.stall_tick = 5;
+    r.stall_us = 3 * PERIOD_US;
+    lumina::periodic_task<body> task({ .name = "overrun", .period_us = PERIOD_US }, body{ &r });
+    wait_for(r, 20);
+
+    lumina::task_stats stats = task.stats();
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(1, stats.overruns);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(2, stats.skipped);
+    TEST_ASSERT_GREATER_THAN(int64_t(3 * PERIOD_US), int64_t(stats.worst_us));
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(20 + stats.skipped, stats.releases);
+}
+
+void test_tick_counts_iterations()
+{
+    struct counter
+    {
+        std::atomic<uint32_t>* last;
+        std::atomic<uint32_t>* calls;
+
+        void operator() (uint32_t tick) const
+        {
+            last->store(tick);
+            calls->fetch_add(1);
+        }
+    };
+
+    std::atomic<uint32_t> last{0}, calls{0};
+    {
+        lumina::periodic_task<counter> task({ .name = "ticks", .period_us = PERIOD_US }, counter{ &last, &calls });
+        while (calls.load() < 10)
+            std::this_thread::sleep_for(milliseconds(1));
+    }
+    TEST_ASSERT_EQUAL_UINT32(calls.load() - 1, last.load());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_deadline_defaults_to_period);
+    RUN_TEST(test_releases_do_not_drift);
+    RUN_TEST(test_overrun_is_counted_and_skipped);
+    RUN_TEST(test_tick_counts_iterations);
+    return UNITY_END();
+}
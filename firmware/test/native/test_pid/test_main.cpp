@@ -0,0 +1,186 @@
+#include <unity.h>
+
+#include <array>
+#include <cmath>
+
+#include "bench.hpp"
+#include "pid.hpp"
+
+using namespace lumina;
+
+static constexpr float DT = 1.f / 4000;
+
+/**
+ * One body axis: motors follow the demand with a 30 ms lag, full demand
+ * gives 100 rad/s, and `disturbance` is an offset such as a CG error.
+ */
+struct plant
+{
+    float rate = 0;
+    float angle = 0;
+    float disturbance = 0;
+
+    void step(float u, float dt)
+    {
+        rate += (100 * (u - disturbance) - rate) * dt / 0.03f;
+        angle += rate * dt;
+    }
+};
+
+struct response
+{
+    float final;
+    float peak;
+    float settled;                      // last time outside the 2 % band, in s
+};
+
+template <typename F>
+static response run(float target, float seconds, F&& step)
+{
+    response r{0, 0, 0};
+    int steps = static_cast<int>(seconds / DT);
+    for (int i = 0; i < steps; i++)
+    {
+        float y = step();
+        r.peak = std::max(r.peak, y);
+        if (std::fabs(y - target) > 0.02f * std::fabs(target))
+            r.settled = (i + 1) * DT;
+        r.final = y;
+    }
+    return r;
+}
+
+static const std::array<pid_gains, 3> RATE_GAINS = {
+    pid_gains{0.03f, 0.5f, 0.0005f, 0, 0.3f, 100},
+    pid_gains{0.03f, 0.5f, 0.0005f, 0, 0.3f, 100},
+    pid_gains{0.05f, 0.5f, 0, 0, 0.3f, 0},
+};
+
+void setUp() {}
+void tearDown() {}
+
+void test_rate_step_response()
+{
+    rate_controller c(RATE_GAINS);
+    plant p;
+    p.disturbance = 0.1f;
+    response r = run(10, 1, [&] {
+        p.step(c.update(vec3{10, 0, 0}, vec3{p.rate, 0, 0}, DT, 0.5f, false)[0], DT);
+        return p.rate;
+    });
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 10, r.final);
+    TEST_ASSERT_LESS_THAN(10.5f, r.peak);
+    TEST_ASSERT_LESS_THAN(0.3f, r.settled);
+    // The integral carries the 0.1 demand that holds 10 rad/s plus the disturbance.
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, 0.2f, c.axis(0).integral());
+}
+
+void test_angle_step_response()
+{
+    // 20 degree roll step through the cascade.
+    rate_controller rate(RATE_GAINS);
+    angle_controller angle(vec3{6, 6, 4}, vec3{10, 10, 5});
+    plant p;
+    float target = math::radians(20.f);
+    quat setpoint = quat::axis_angle(vec3{1, 0, 0}, target);
+
+    response r = run(target, 2, [&] {
+        vec3 rate_setpoint = angle.update(quat::axis_angle(vec3{1, 0, 0}, p.angle), setpoint, DT);
+        p.step(rate.update(rate_setpoint, vec3{p.rate, 0, 0}, DT, 0.5f, false)[0], DT);
+        return p.angle;
+    });
+    TEST_ASSERT_FLOAT_WITHIN(0.002f, target, r.final);
+    TEST_ASSERT_LESS_THAN(target * 1.05f, r.peak);
+    TEST_ASSERT_LESS_THAN(1.f, r.settled);
+}
+
+void test_derivative_on_measurement_does_not_kick()
+{
+    pid c(pid_gains{0, 0, 0.01f, 0, 0.3f, 0});
+    c.update(0, 0, DT);
+    TEST_ASSERT_EQUAL_FLOAT(0, c.update(100, 0, DT));
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, -0.01f * 1 / DT, c.update(100, 1, DT));
+}
+
+void test_feedforward_acts_on_setpoint_change()
+{
+    pid c(pid_gains{0, 0, 0, 0.002f, 0.3f, 0});
+    c.update(0, 0, DT);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.002f * 1 / DT, c.update(1, 0, DT));
+    TEST_ASSERT_EQUAL_FLOAT(0, c.update(1, 0, DT));
+}
+
+void test_integral_does_not_wind_up_while_saturated()
+{
+    pid c(pid_gains{0, 1, 0, 0, 0.3f, 0});
+    for (int i = 0; i < 100; i++)
+        c.update(1, 0, DT, false);
+    float before = c.integral();
+
+    // Saturated: a growing error does not grow the integral, a reversed one shrinks it.
+    for (int i = 0; i < 100; i++)
+        c.update(1, 0, DT, true);
+    TEST_ASSERT_EQUAL_FLOAT(before, c.integral());
+    c.update(-1, 0, DT, true);
+    TEST_ASSERT_LESS_THAN(before, c.integral());
+
+    // Unsaturated, it is bounded by i_limit.
+    for (int i = 0; i < 10'000; i++)
+        c.update(1, 0, DT, false);
+    TEST_ASSERT_EQUAL_FLOAT(0.3f, c.integral());
+}
+
+void test_tpa_attenuates_roll_and_pitch_only()
+{
+    std::array<pid_gains, 3> p{ pid_gains{1}, pid_gains{1}, pid_gains{1} };
+    for (auto& g : p)
+        g.i_limit = 0;
+    rate_controller c(p, tpa{0.5f, 0.4f});
+    vec3 full = c.update(vec3{0.5f, 0.5f, 0.5f}, vec3{}, DT, 1, false);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.3f, full[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.3f, full[1]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.5f, full[2]);
+    vec3 low = c.update(vec3{0.5f, 0.5f, 0.5f}, vec3{}, DT, 0.4f, false);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.5f, low[0]);
+}
+
+// Both controllers run every loop at up to 4 kHz, a 250 us budget shared
+// with the filters, the mixer and the ESC output.
+void test_update_cost()
+{
+    std::array<vec3, 256> gyro;
+    std::array<quat, 256> attitude;
+    for (size_t i = 0; i < gyro.size(); i++)
+    {
+        gyro[i] = vec3{std::sin(i * 0.1f), std::cos(i * 0.07f), std::sin(i * 0.03f)};
+        attitude[i] = quat::axis_angle(vec3{0.6f, 0.8f, 0}, std::sin(i * 0.05f));
+    }
+
+    rate_controller rate(RATE_GAINS, tpa{0.5f, 0.3f});
+    angle_controller angle(vec3{6, 6, 4}, vec3{10, 10, 5}, vec3{0.5f, 0.5f, 0});
+    quat level = quat::identity();
+
+    double rate_ns = bench::ns_per_call(1'000'000, [&](int i) {
+        bench::keep(rate.update(vec3{1, 0, 0}, gyro[i & 255], DT, 0.6f, false));
+    });
+    double cascade_ns = bench::ns_per_call(1'000'000, [&](int i) {
+        vec3 setpoint = angle.update(attitude[i & 255], level, DT);
+        bench::keep(rate.update(setpoint, gyro[i & 255], DT, 0.6f, false));
+    });
+
+    bench::report("rate controller update", rate_ns);
+    bench::report("angle and rate cascade update", cascade_ns);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_rate_step_response);
+    RUN_TEST(test_angle_step_response);
+    RUN_TEST(test_derivative_on_measurement_does_not_kick);
+    RUN_TEST(test_feedforward_acts_on_setpoint_change);
+    RUN_TEST(test_integral_does_not_wind_up_while_saturated);
+    RUN_TEST(test_tpa_attenuates_roll_and_pitch_only);
+    RUN_TEST(test_update_cost);
+    return UNITY_END();
+}
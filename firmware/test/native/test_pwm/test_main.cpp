@@ -0,0 +1,109 @@
+#include <unity.h>
+
+#include <cmath>
+
+#include "bench.hpp"
+#include "esc/pwm.hpp"
+
+using namespace lumina;
+
+static constexpr pwm::protocol PROTOCOLS[] = {
+    pwm::protocol::ONESHOT125, pwm::protocol::ONESHOT42, pwm::protocol::MULTISHOT, pwm::protocol::PWM
+};
+
+// Pulse range of each protocol in microseconds.
+static constexpr float MIN_US[] = { 125, 42, 5, 1000 };
+static constexpr float MAX_US[] = { 250, 84, 25, 2000 };
+
+void setUp() {}
+void tearDown() {}
+
+void test_pulse_widths_match_the_protocols()
+{
+    for (int p = 0; p < 4; p++)
+    {
+        pwm::timing t = pwm::timing::make(PROTOCOLS[p]);
+        float us_per_tick = 1e6f / t.resolution_hz;
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f, MIN_US[p], t.pulse(0) * us_per_tick);
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f, MAX_US[p], t.pulse(1) * us_per_tick);
+        TEST_ASSERT_FLOAT_WITHIN(us_per_tick, (MIN_US[p] + MAX_US[p]) / 2, t.pulse(0.5f) * us_per_tick);
+    }
+}
+
+void test_resolution_and_period_fit_the_timer()
+{
+    for (pwm::protocol p : PROTOCOLS)
+    {
+        pwm::timing t = pwm::timing::make(p);
+        TEST_ASSERT_EQUAL_UINT32(0, 160'000'000 % t.resolution_hz);
+        TEST_ASSERT_TRUE(t.max_ticks - t.min_ticks >= 800);
+        TEST_ASSERT_TRUE(t.period_ticks < 65536);
+        TEST_ASSERT_TRUE(t.period_ticks > t.max_ticks);
+        TEST_ASSERT_EQUAL(p != pwm::protocol::PWM, t.oneshot);
+    }
+
+    // Oneshot timers stop 5 % after the longest pulse.
+    pwm::timing oneshot = pwm::timing::make(pwm::protocol::ONESHOT125);
+    TEST_ASSERT_EQUAL_UINT32(oneshot.max_ticks + oneshot.max_ticks / 20, oneshot.period_ticks);
+}
+
+void test_pwm_rate_is_clamped()
+{
+    TEST_ASSERT_EQUAL_UINT32(20000, pwm::timing::make(pwm::protocol::PWM, 10).period_ticks);
+    TEST_ASSERT_EQUAL_UINT32(20000, pwm::timing::make(pwm::protocol::PWM, 50).period_ticks);
+    TEST_ASSERT_EQUAL_UINT32(2500, pwm::timing::make(pwm::protocol::PWM, 400).period_ticks);
+    TEST_ASSERT_EQUAL_UINT32(1'000'000 / 490, pwm::timing::make(pwm::protocol::PWM, 2000).period_ticks);
+
+    // Oneshot protocols ignore the rate.
+    TEST_ASSERT_EQUAL_UINT32(pwm::timing::make(pwm::protocol::ONESHOT42).period_ticks,
+                             pwm::timing::make(pwm::protocol::ONESHOT42, 50).period_ticks);
+}
+
+void test_throttle_is_clamped_and_monotonic()
+{
+    for (pwm::protocol p : PROTOCOLS)
+    {
+        pwm::timing t = pwm::timing::make(p);
+
+        // Disarmed outputs are written as zero throttle, a NaN must not spin a motor.
+        TEST_ASSERT_EQUAL_UINT32(t.min_ticks, t.pulse(0));
+        TEST_ASSERT_EQUAL_UINT32(t.min_ticks, t.pulse(-0.5f));
+        TEST_ASSERT_EQUAL_UINT32(t.min_ticks, t.pulse(NAN));
+        TEST_ASSERT_EQUAL_UINT32(t.max_ticks, t.pulse(1.5f));
+        TEST_ASSERT_EQUAL_UINT32(t.max_ticks, t.pulse(INFINITY));
+
+        uint32_t previous = t.pulse(0);
+        for (int i = 1; i <= 10'000; i++)
+        {
+            uint32_t ticks = t.pulse(i / 10'000.f);
+            TEST_ASSERT_TRUE(ticks >= previous && ticks - previous <= 1);
+            previous = ticks;
+        }
+    }
+}
+
+// Throttle to compare value for four motors, once per control loop.
+void test_pulse_cost()
+{
+    pwm::timing t = pwm::timing::make(pwm::protocol::ONESHOT125);
+    float throttle[256];
+    for (int i = 0; i < 256; i++)
+        throttle[i] = i / 255.f;
+
+    double ns = bench::ns_per_call(1'000'000, [&](int i) {
+        for (int m = 0; m < 4; m++)
+            bench::keep(t.pulse(throttle[(i + m * 64) & 255]));
+    });
+    bench::report("4 pulse widths", ns);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_pulse_widths_match_the_protocols);
+    RUN_TEST(test_resolution_and_period_fit_the_timer);
+    RUN_TEST(test_pwm_rate_is_clamped);
+    RUN_TEST(test_throttle_is_clamped_and_monotonic);
+    RUN_TEST(test_pulse_cost);
+    return UNITY_END();
+}
@@ -0,0 +1,147 @@
+#include <unity.h>
+
+#include <array>
+#include <cmath>
+
+#include "bench.hpp"
+#include "notch.hpp"
+
+using namespace lumina;
+
+static constexpr float RATE_HZ = 4000;
+static constexpr int POLE_PAIRS = 7;
+
+/**
+ * Host stand-in for the ESCs: four motors whose speed follows a commanded
+ * RPM, reported as eRPM like bidirectional DShot does.
+ */
+struct motor_simulator
+{
+    std::array<float, 4> rpm{};
+
+    static constexpr size_t size() { return 4; }
+
+    uint32_t erpm(size_t i) const
+    {
+        return static_cast<uint32_t>(rpm[i] * POLE_PAIRS);
+    }
+
+    /**
+     * Motor vibration on one gyro axis: each motor's fundamental and a
+     * weaker second harmonic, with per-motor phase offsets.
+     */
+    float vibration(float t) const
+    {
+        float x = 0;
+        for (size_t m = 0; m < 4; m++)
+        {
+            float hz = rpm[m] / 60;
+            x += std::sin(2 * math::pi<float> * hz * t + m) + 0.5f * std::sin(4 * math::pi<float> * hz * t + 2 * m);
+        }
+        return x;
+    }
+};
+
+static_assert(rpm_source<motor_simulator>);
+
+void setUp() {}
+void tearDown() {}
+
+void test_tracks_and_removes_motor_noise()
+{
+    motor_simulator motors;
+    motors.rpm = {12000, 12600, 13200, 13800};
+    rpm_filter<4, 3> filter(RATE_HZ, POLE_PAIRS);
+
+    // A slow 2 Hz control motion must pass, the motor noise must not.
+    double signal = 0, noise_in = 0, error = 0;
+    for (int i = 0; i < 8000; i++)
+    {
+        float t = i / RATE_HZ;
+        filter.update(motors, 1 / RATE_HZ);
+        float motion = 0.5f * std::sin(2 * math::pi<float> * 2 * t);
+        float noise = motors.vibration(t);
+        float y = filter(vec3{motion + noise, 0, motion})[0];
+        if (i >= 4000)
+        {
+            signal += motion * motion;
+            noise_in += noise * noise;
+            error += (y - motion) * (y - motion);
+        }
+    }
+
+    for (size_t m = 0; m < 4; m++)
+        TEST_ASSERT_FLOAT_WITHIN(0.1f, motors.rpm[m] / 60, filter.frequency(m));
+    TEST_ASSERT_LESS_THAN(noise_in / 100, error);
+}
+
+void test_follows_a_throttle_sweep()
+{
+    // Motors ramp from 9000 to 24000 RPM in a second; the lowpass on the
+    // frequencies lags the ramp by about 1 / (2 pi 150 Hz).
+    motor_simulator motors;
+    rpm_filter<4, 3> filter(RATE_HZ, POLE_PAIRS);
+    for (int i = 0; i < 4000; i++)
+    {
+        float rpm = 9000 + 15000 * i / 4000.f;
+        motors.rpm = {rpm, rpm, rpm, rpm};
+        filter.update(motors, 1 / RATE_HZ);
+    }
+    float slope = 15000 / 60.f;
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 400 - slope / (2 * math::pi<float> * 150), filter.frequency(0));
+}
+
+void test_stopped_motors_release_their_notches()
+{
+    motor_simulator motors;
+    rpm_filter<4, 3> filter(RATE_HZ, POLE_PAIRS);
+    filter.update(motors, 0);
+    vec3 x{0.3f, -0.2f, 0.1f};
+    vec3 y = filter(x);
+    for (int a = 0; a < 3; a++)
+        TEST_ASSERT_EQUAL_FLOAT(x[a], y[a]);
+}
+
+// The notches are retuned every control iteration from the latest eRPM:
+// 12 notch designs, each a sin and a cos, on top of filtering three axes.
+void test_retune_cost()
+{
+    constexpr int N = 200'000;
+    std::array<motor_simulator, 64> samples;
+    for (size_t i = 0; i < samples.size(); i++)
+        for (size_t m = 0; m < 4; m++)
+            samples[i].rpm[m] = 12000 + 3000 * std::sin(0.1f * i + m);
+
+    std::array<vec3, 64> gyro;
+    for (size_t i = 0; i < gyro.size(); i++)
+        gyro[i] = vec3{samples[i].vibration(i / RATE_HZ), 0.1f, -0.1f};
+
+    rpm_filter<4, 3> filter(RATE_HZ, POLE_PAIRS);
+    double update_ns = bench::ns_per_call(N, [&](int i) {
+        filter.update(samples[i & 63], 1 / RATE_HZ);
+        bench::keep(filter.frequency(0));
+    });
+    double filter_ns = bench::ns_per_call(N, [&](int i) { bench::keep(filter(gyro[i & 63])); });
+
+    motor_simulator stopped;
+    rpm_filter<4, 3> idle(RATE_HZ, POLE_PAIRS);
+    double idle_ns = bench::ns_per_call(N, [&](int) {
+        idle.update(stopped, 1 / RATE_HZ);
+        bench::keep(idle.frequency(0));
+    });
+
+    bench::report("rpm filter retune, 12 notches", update_ns);
+    bench::report("rpm filter retune, motors stopped", idle_ns);
+    bench::report("rpm filter per vec3 sample, 12 notches", filter_ns);
+    TEST_ASSERT_LESS_THAN(update_ns, idle_ns);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_tracks_and_removes_motor_noise);
+    RUN_TEST(test_follows_a_throttle_sweep);
+    RUN_TEST(test_stopped_motors_release_their_notches);
+    RUN_TEST(test_retune_cost);
+    return UNITY_END();
+}
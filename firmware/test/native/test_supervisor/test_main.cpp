@@ -0,0 +1,148 @@
+#include <unity.h>
+
+#include "supervisor.hpp"
+
+using lumina::degradation;
+
+static constexpr uint32_t BUDGET_US = 1000;
+static constexpr lumina::supervisor_config CONFIG = { .window_us = 100'000, .degrade_misses = 3, .recover_windows = 5 };
+
+struct fixture
+{
+    lumina::deadline control{"control", BUDGET_US};
+    lumina::supervisor supervisor{CONFIG};
+    int64_t now = 1;
+
+    fixture()
+    {
+        supervisor.watch(control);
+        supervisor.update(now);
+    }
+
+    // Misses `misses` deadlines, met ones in between, then closes the window.
+    bool window(uint32_t misses)
+    {
+        for (uint32_t i = 0; i < 10; i++)
+            control.check(i < misses ? BUDGET_US + 1 : BUDGET_US);
+        now += CONFIG.window_us;
+        return supervisor.update(now);
+    }
+};
+
+void setUp() {}
+void tearDown() {}
+
+void test_deadline_counts_misses()
+{
+    lumina::deadline d("test", BUDGET_US);
+    TEST_ASSERT_FALSE(d.check(BUDGET_US));
+    TEST_ASSERT_TRUE(d.check(BUDGET_US + 1));
+    TEST_ASSERT_EQUAL_UINT32(1, d.misses());
+    TEST_ASSERT_EQUAL_UINT32(BUDGET_US + 1, d.worst_us());
+}
+
+void test_hiccup_costs_nothing()
+{
+    fixture f;
+    TEST_ASSERT_FALSE(f.window(CONFIG.degrade_misses - 1));
+    TEST_ASSERT_EQUAL(degradation::NOMINAL, f.supervisor.level());
+}
+
+void test_window_only_closes_after_its_length()
+{
+    fixture f;
+    for (uint32_t i = 0; i < CONFIG.degrade_misses; i++)
+        f.control.check(BUDGET_US + 1);
+    TEST_ASSERT_FALSE(f.supervisor.update(f.now + CONFIG.window_us - 1));
+    TEST_ASSERT_EQUAL(degradation::NOMINAL, f.supervisor.level());
+    TEST_ASSERT_TRUE(f.supervisor.update(f.now + CONFIG.window_us));
+    TEST_ASSERT_EQUAL(degradation::REDUCED_TELEMETRY, f.supervisor.level());
+}
+
+void test_overload_walks_the_ladder()
+{
+    fixture f;
+    const degradation ladder[] = { degradation::REDUCED_TELEMETRY, degradation::NO_LOGGING, degradation::FAILSAFE };
+    degradation previous = degradation::NOMINAL;
+    for (degradation level : ladder)
+    {
+        TEST_ASSERT_TRUE(f.window(CONFIG.degrade_misses));
+        TEST_ASSERT_EQUAL(level, f.supervisor.level());
+        TEST_ASSERT_EQUAL(previous, f.supervisor.previous());
+        TEST_ASSERT_EQUAL_UINT32(CONFIG.degrade_misses, f.supervisor.window_misses());
+        previous = level;
+    }
+
+    // Further overload has nowhere to go.
+    TEST_ASSERT_FALSE(f.window(10));
+    TEST_ASSERT_EQUAL(degradation::FAILSAFE, f.supervisor.level());
+}
+
+void test_recovery_steps_up_one_level()
+{
+    fixture f;
+    f.window(CONFIG.degrade_misses);
+    f.window(CONFIG.degrade_misses);
+    TEST_ASSERT_EQUAL(degradation::NO_LOGGING, f.supervisor.level());
+
+    for (uint32_t i = 0; i < CONFIG.recover_windows - 1; i++)
+        TEST_ASSERT_FALSE(f.window(0));
+    TEST_ASSERT_TRUE(f.window(0));
+    TEST_ASSERT_EQUAL(degradation::REDUCED_TELEMETRY, f.supervisor.level());
+
+    // A window with a miss restarts the clean count.
+    for (uint32_t i = 0; i < CONFIG.recover_windows - 1; i++)
+        f.window(0);
+    f.window(1);
+    for (uint32_t i = 0; i < CONFIG.recover_windows - 1; i++)
+        TEST_ASSERT_FALSE(f.window(0));
+    TEST_ASSERT_TRUE(f.window(0));
+    TEST_ASSERT_EQUAL(degradation::NOMINAL, f.supervisor.level());
+}
+
+void test_failsafe_latches_until_reset()
+{
+    fixture f;
+    for (int i = 0; i < 3; i++)
+        f.window(CONFIG.degrade_misses);
+    TEST_ASSERT_EQUAL(degradation::FAILSAFE, f.supervisor.level());
+
+    for (uint32_t i = 0; i < 4 * CONFIG.recover_windows; i++)
+        TEST_ASSERT_FALSE(f.window(0));
+    TEST_ASSERT_EQUAL(degradation::FAILSAFE, f.supervisor.level());
+
+    TEST_ASSERT_TRUE(f.supervisor.reset());
+    TEST_ASSERT_EQUAL(degradation::NOMINAL, f.supervisor.level());
+    TEST_ASSERT_EQUAL(degradation::FAILSAFE, f.supervisor.previous());
+    TEST_ASSERT_FALSE(f.supervisor.reset());
+
+    // After the reset the ladder starts over.
+    TEST_ASSERT_TRUE(f.window(CONFIG.degrade_misses));
+    TEST_ASSERT_EQUAL(degradation::REDUCED_TELEMETRY, f.supervisor.level());
+}
+
+void test_misses_before_watch_are_ignored()
+{
+    lumina::deadline d("late", BUDGET_US);
+    for (int i = 0; i < 10; i++)
+        d.check(BUDGET_US + 1);
+
+    lumina::supervisor s(CONFIG);
+    s.watch(d);
+    s.update(1);
+    TEST_ASSERT_FALSE(s.update(1 + CONFIG.window_us));
+    TEST_ASSERT_EQUAL(degradation::NOMINAL, s.level());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_deadline_counts_misses);
+    RUN_TEST(test_hiccup_costs_nothing);
+    RUN_TEST(test_window_only_closes_after_its_length);
+    RUN_TEST(test_overload_walks_the_ladder);
+    RUN_TEST(test_recovery_steps_up_one_level);
+    RUN_TEST(test_failsafe_latches_until_reset);
+    RUN_TEST(test_misses_before_watch_are_ignored);
+    return UNITY_END();
+}
@@ -0,0 +1,141 @@
+#include <unity.h>
+
+#include <array>
+#include <cmath>
+
+#include "bench.hpp"
+#include "thrust.hpp"
+
+using namespace lumina;
+
+/**
+ * Exact inverse of T(u) = (1 - k) u + k u^2.
+ */
+static float exact(float k, float thrust)
+{
+    return k > 0 ? (std::sqrt((1 - k) * (1 - k) + 4 * k * thrust) - (1 - k)) / (2 * k) : thrust;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_lookup_accuracy()
+{
+    // The inverse is steepest at zero thrust for k = 1 (a square root), so
+    // the first segment carries the largest interpolation error: a chord of
+    // sqrt over [0, 1/32] is off by up to 1/(4 sqrt(32)) = 0.044.
+    for (float k : { 0.f, 0.2f, 0.5f, 0.8f, 1.f })
+    {
+        thrust_curve curve(k);
+        float worst = 0, worst_above_tenth = 0;
+        for (int i = 0; i <= 10'000; i++)
+        {
+            float t = i / 10'000.f;
+            float error = std::fabs(curve(t) - exact(k, t));
+            worst = std::max(worst, error);
+            if (t >= 0.1f)
+                worst_above_tenth = std::max(worst_above_tenth, error);
+        }
+        TEST_ASSERT_LESS_THAN(k < 1 ? 0.01f : 0.045f, worst);
+        TEST_ASSERT_LESS_THAN(1e-3f, worst_above_tenth);
+    }
+}
+
+void test_curve_is_monotonic_and_bounded()
+{
+    thrust_curve curve(0.7f, 0.05f);
+    TEST_ASSERT_EQUAL_FLOAT(0, curve(0));
+    TEST_ASSERT_EQUAL_FLOAT(0, curve(-1));
+    TEST_ASSERT_EQUAL_FLOAT(1, curve(1));
+    TEST_ASSERT_EQUAL_FLOAT(1, curve(2));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.05f, curve(1e-9f));
+
+    float previous = curve(1e-6f);
+    for (int i = 1; i <= 1000; i++)
+    {
+        float u = curve(i / 1000.f);
+        TEST_ASSERT_TRUE(u >= previous);
+        previous = u;
+    }
+}
+
+void test_battery_compensation()
+{
+    thrust_stage<4> stage(thrust_curve(), 16.8f, 1.3f, 0.5f);
+    std::array<float, 4> half{0.5f, 0.5f, 0.5f, 0.5f};
+
+    // A full pack gets no change, a fuller one is not attenuated.
+    stage.battery(17.2f);
+    TEST_ASSERT_EQUAL_FLOAT(1, stage.compensation());
+
+    // Sag converges to reference over measured.
+    for (int i = 0; i < 50; i++)
+        stage.battery(14.0f);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 16.8f / 14.0f, stage.compensation());
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.5f * 16.8f / 14.0f, stage.apply(half)[2]);
+
+    // The boost is capped and outputs stay in range.
+    for (int i = 0; i < 50; i++)
+        stage.battery(10.0f);
+    TEST_ASSERT_EQUAL_FLOAT(1.3f, stage.compensation());
+    TEST_ASSERT_EQUAL_FLOAT(1, stage.apply({0.9f, 0.9f, 0.9f, 0.9f})[0]);
+
+    // A single spike moves the filtered voltage only by alpha.
+    thrust_stage<4> slow(thrust_curve(), 16.8f);
+    slow.battery(12.0f);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 16.8f / (16.8f - 0.01f * 4.8f), slow.compensation());
+
+    // No reference voltage: no compensation.
+    thrust_stage<4> off;
+    off.battery(12.0f);
+    TEST_ASSERT_EQUAL_FLOAT(1, off.compensation());
+}
+
+void test_per_motor_curves()
+{
+    thrust_stage<4> stage(thrust_curve(0.5f));
+    stage.curve(3, thrust_curve());
+    auto out = stage.apply({0.3f, 0.3f, 0.3f, 0.3f});
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, exact(0.5f, 0.3f), out[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.3f, out[3]);
+}
+
+// The table is built once per parameter change; the lookup runs for every
+// motor in every loop, where the closed form would need a square root and
+// a division per motor.
+void test_build_and_lookup_cost()
+{
+    volatile float k = 0.4f;
+    double build_ns = bench::ns_per_call(10'000, [&](int) { bench::keep(thrust_curve(k, 0.05f)); });
+
+    thrust_curve curve(0.4f, 0.05f);
+    std::array<float, 256> thrust;
+    for (size_t i = 0; i < thrust.size(); i++)
+        thrust[i] = i / 255.f;
+
+    double lookup_ns = bench::ns_per_call(1'000'000, [&](int i) { bench::keep(curve(thrust[i & 255])); });
+    double closed_ns = bench::ns_per_call(1'000'000, [&](int i) { bench::keep(0.05f + 0.95f * exact(k, thrust[i & 255])); });
+
+    thrust_stage<4> stage(curve, 16.8f);
+    stage.battery(15.5f);
+    std::array<std::array<float, 4>, 64> mixed;
+    for (size_t i = 0; i < mixed.size(); i++)
+        mixed[i] = {thrust[i], thrust[i + 64], thrust[i + 128], thrust[i + 192]};
+    double stage_ns = bench::ns_per_call(1'000'000, [&](int i) { bench::keep(stage.apply(mixed[i & 63])); });
+
+    bench::report("thrust table build", build_ns);
+    bench::report("thrust table lookup", lookup_ns);
+    bench::report("thrust closed form", closed_ns);
+    bench::report("quad thrust stage per loop", stage_ns);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_lookup_accuracy);
+    RUN_TEST(test_curve_is_monotonic_and_bounded);
+    RUN_TEST(test_battery_compensation);
+    RUN_TEST(test_per_motor_curves);
+    RUN_TEST(test_build_and_lookup_cost);
+    return UNITY_END();
+}
@@ -0,0 +1,218 @@
+#include <unity.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <semaphore>
+#include <thread>
+#include <vector>
+
+#include <cstdio>
+
+#include "topic.hpp"
+#include "topics.hpp"
+
+static constexpr uint32_t PUBLISHES = 200'000;
+
+// Every word carries the same counter, so a torn copy shows up as a mismatch.
+struct sample
+{
+    std::array<uint32_t, 32> words;
+
+    static sample of(uint32_t n)
+    {
+        sample s;
+        s.words.fill(n);
+        return s;
+    }
+
+    bool consistent() const
+    {
+        for (uint32_t w : words)
+            if (w != words[0])
+                return false;
+        return true;
+    }
+};
+
+void setUp() {}
+void tearDown() {}
+
+void test_polling_readers_never_see_torn_values()
+{
+    static lumina::topic<sample> t("stress");
+    std::atomic<bool> done{false};
+    std::atomic<uint32_t> torn{0}, backwards{0}, updates{0};
+    std::atomic<int> ready{0};
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; r++)
+        readers.emplace_back([&] {
+            lumina::subscriber<sample> sub(t);
+            ready.fetch_add(1);
+            sample s{};
+            uint32_t last = 0;
+            while (!done.load(std::memory_order_relaxed))
+            {
+                if (!sub.update(s))
+                    continue;
+                updates.fetch_add(1, std::memory_order_relaxed);
+                if (!s.consistent())
+                    torn.fetch_add(1, std::memory_order_relaxed);
+                else if (s.words[0] < last)
+                    backwards.fetch_add(1, std::memory_order_relaxed);
+                last = s.words[0];
+            }
+        });
+
+    while (ready.load() < 3)
+        std::this_thread::yield();
+    for (uint32_t n = 1; n <= PUBLISHES; n++)
+        t.publish(sample::of(n));
+    done.store(true);
+    for (auto& r : readers)
+        r.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, torn.load());
+    TEST_ASSERT_EQUAL_UINT32(0, backwards.load());
+    TEST_ASSERT_GREATER_THAN(0, int(updates.load()));
+
+    sample latest{};
+    TEST_ASSERT_NOT_EQUAL(0, t.read(latest));
+    TEST_ASSERT_EQUAL_UINT32(PUBLISHES, latest.words[0]);
+}
+
+void test_queue_delivers_every_value_or_counts_it()
+{
+    static lumina::topic<uint32_t> t("queued");
+    auto sub = std::make_unique<lumina::subscriber<uint32_t, 64>>(t);
+    TEST_ASSERT_TRUE(sub->attached());
+
+    std::atomic<bool> started{false}, done{false};
+    uint32_t received = 0, out_of_order = 0;
+    std::thread consumer([&] {
+        started.store(true);
+        uint32_t value, last = 0;
+        for (;;)
+        {
+            bool finished = done.load(std::memory_order_acquire);
+            while (sub->pop(value))
+            {
+                if (value <= last)
+                    out_of_order++;
+                last = value;
+                received++;
+            }
+            if (finished)
+                return;
+        }
+    });
+
+    while (!started.load())
+        std::this_thread::yield();
+    // Yield now and then so the consumer also runs on a single core.
+    for (uint32_t n = 1; n <= PUBLISHES; n++)
+    {
+        t.publish(n);
+        if (n % 32 == 0)
+            std::this_thread::yield();
+    }
+    done.store(true, std::memory_order_release);
+    consumer.join();
+
+    char text[80];
+    std::snprintf(text, sizeof(text), "%u received, %u dropped", unsigned(received), unsigned(t.dropped()));
+    TEST_MESSAGE(text);
+    TEST_ASSERT_EQUAL_UINT32(0, out_of_order);
+    TEST_ASSERT_EQUAL_UINT32(PUBLISHES, received + t.dropped());
+}
+
+void test_full_queue_drops_newest()
+{
+    static lumina::topic<uint32_t> t("full");
+    lumina::subscriber<uint32_t, 4> sub(t);
+    for (uint32_t n = 1; n <= 10; n++)
+        t.publish(n);
+
+    uint32_t value = 0, received = 0;
+    while (sub.pop(value))
+        TEST_ASSERT_EQUAL_UINT32(++received, value);
+    TEST_ASSERT_EQUAL_UINT32(10 - received, t.dropped());
+
+    // The latest value is there for polling all the same.
+    TEST_ASSERT_TRUE(sub.update(value));
+    TEST_ASSERT_EQUAL_UINT32(10, value);
+    TEST_ASSERT_FALSE(sub.update(value));
+}
+
+void test_publish_wakes_subscribers()
+{
+    static lumina::topic<uint32_t> t("wake");
+    std::counting_semaphore<> wakeup(0);
+    lumina::subscriber<uint32_t, 16> sub(t, &wakeup);
+
+    std::thread consumer([&] {
+        uint32_t value = 0;
+        while (value < 10)
+        {
+            wakeup.acquire();
+            while (sub.pop(value)) {}
+        }
+    });
+
+    for (uint32_t n = 1; n <= 10; n++)
+    {
+        t.publish(n);
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    consumer.join();
+    TEST_ASSERT_EQUAL_UINT32(0, t.dropped());
+}
+
+void test_attach_is_limited()
+{
+    static lumina::topic<uint32_t> t("many");
+    std::vector<std::unique_ptr<lumina::subscriber<uint32_t>>> subs;
+    for (size_t i = 0; i < lumina::topic<uint32_t>::MAX_SUBSCRIBERS; i++)
+    {
+        subs.push_back(std::make_unique<lumina::subscriber<uint32_t>>(t));
+        TEST_ASSERT_TRUE(subs.back()->attached());
+    }
+    lumina::subscriber<uint32_t> extra(t);
+    TEST_ASSERT_FALSE(extra.attached());
+}
+
+// The control loop publishes odometry on every step; keep it cheap.
+void test_odometry_publish_cost()
+{
+    static lumina::topic<lumina::msg::odometry> t("odometry");
+    lumina::subscriber<lumina::msg::odometry> sub(t);
+    lumina::msg::odometry odometry{};
+
+    constexpr int N = 1'000'000;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; i++)
+    {
+        odometry.timestamp = i;
+        t.publish(odometry);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / N;
+
+    char text[80];
+    std::snprintf(text, sizeof(text), "msg::odometry is %zu bytes, publish %.1f ns", sizeof(lumina::msg::odometry), ns);
+    TEST_MESSAGE(text);
+    TEST_ASSERT_LESS_OR_EQUAL(128, int(sizeof(lumina::msg::odometry)));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_polling_readers_never_see_torn_values);
+    RUN_TEST(test_queue_delivers_every_value_or_counts_it);
+    RUN_TEST(test_full_queue_drops_newest);
+    RUN_TEST(test_publish_wakes_subscribers);
+    RUN_TEST(test_attach_is_limited);
+    RUN_TEST(test_odometry_publish_cost);
+    return UNITY_END();
+}
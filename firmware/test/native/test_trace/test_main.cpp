@@ -0,0 +1,156 @@
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include <cstring>
+
+#define LUMINA_TRACE 1
+#include "trace.hpp"
+
+using namespace lumina;
+
+// Reads a dump back in the layout documented at trace::dump().
+struct reader
+{
+    const std::vector<uint8_t>& data;
+    size_t offset = 0;
+
+    template <typename T>
+    T take()
+    {
+        T value;
+        std::memcpy(&value, data.data() + offset, sizeof(T));
+        offset += sizeof(T);
+        return value;
+    }
+
+    std::vector<std::string> strings()
+    {
+        std::vector<std::string> result(take<uint16_t>());
+        for (std::string& s : result)
+        {
+            uint8_t length = take<uint8_t>();
+            s.assign(reinterpret_cast<const char*>(data.data() + offset), length);
+            offset += length;
+        }
+        return result;
+    }
+};
+
+static std::vector<uint8_t> dump()
+{
+    std::vector<uint8_t> data;
+    trace::dump([&](const uint8_t* p, size_t n) { data.insert(data.end(), p, p + n); });
+    return data;
+}
+
+static std::vector<trace::event> events(reader& r)
+{
+    r.take<uint32_t>();
+    r.take<int64_t>();
+    std::vector<trace::event> result(r.take<uint32_t>());
+    for (trace::event& e : result)
+        e = r.take<trace::event>();
+    return result;
+}
+
+static void skip_header(reader& r)
+{
+    r.offset = 12;
+    r.strings();
+    r.strings();
+}
+
+void setUp()
+{
+    trace::resume();
+}
+
+void tearDown() {}
+
+void test_dump_round_trip()
+{
+    uint16_t outer = trace::intern("outer");
+    uint16_t inner = trace::intern("inner");
+    TEST_ASSERT_EQUAL_UINT16(outer, trace::intern("outer"));
+    {
+        LUMINA_TRACE_SCOPE("outer");
+        LUMINA_TRACE_INSTANT("mark");
+        LUMINA_TRACE_SCOPE("inner");
+    }
+    trace::freeze();
+
+    std::vector<uint8_t> data = dump();
+    reader r{data};
+    TEST_ASSERT_EQUAL_MEMORY("LTRC\x01\x00", data.data(), 6);
+    r.offset = 6;
+    TEST_ASSERT_EQUAL_UINT8(trace::CORES, r.take<uint8_t>());
+    r.take<uint8_t>();
+    TEST_ASSERT_EQUAL_UINT32(profile::cycles_per_us(), r.take<uint32_t>());
+
+    std::vector<std::string> names = r.strings();
+    TEST_ASSERT_EQUAL_STRING("outer", names.at(outer).c_str());
+    TEST_ASSERT_EQUAL_STRING("inner", names.at(inner).c_str());
+    std::vector<std::string> tasks = r.strings();
+    TEST_ASSERT_EQUAL_STRING("main", tasks.at(0).c_str());
+
+    std::vector<trace::event> recorded = events(r);
+    TEST_ASSERT_EQUAL_size_t(data.size(), r.offset);
+
+    const char* expected[] = { "outer", "mark", "inner", "inner", "outer" };
+    const trace::kind kinds[] = { trace::kind::BEGIN, trace::kind::INSTANT, trace::kind::BEGIN,
+                                  trace::kind::END, trace::kind::END };
+    TEST_ASSERT_EQUAL_size_t(5, recorded.size());
+    for (size_t i = 0; i < recorded.size(); i++)
+    {
+        TEST_ASSERT_EQUAL_STRING(expected[i], names.at(recorded[i].name).c_str());
+        TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(kinds[i]), static_cast<uint8_t>(recorded[i].type));
+        TEST_ASSERT_EQUAL_UINT8(0, recorded[i].task);
+        if (i > 0)
+            TEST_ASSERT_TRUE(recorded[i].cycles - recorded[i - 1].cycles < 0x80000000u);
+    }
+}
+
+void test_frozen_trace_records_nothing()
+{
+    trace::freeze();
+    TEST_ASSERT_TRUE(trace::frozen());
+    std::vector<uint8_t> before = dump();
+    reader r{before};
+    skip_header(r);
+    size_t count = events(r).size();
+
+    LUMINA_TRACE_INSTANT("ignored");
+    std::vector<uint8_t> after = dump();
+    reader s{after};
+    skip_header(s);
+    TEST_ASSERT_EQUAL_size_t(count, events(s).size());
+}
+
+void test_ring_keeps_the_newest_events()
+{
+    uint16_t name = trace::intern("fill");
+    for (uint32_t i = 0; i < 2 * trace::EVENTS; i++)
+        trace::record(name, trace::kind::INSTANT);
+    uint16_t last = trace::intern("last");
+    trace::record(last, trace::kind::INSTANT);
+    trace::freeze();
+
+    std::vector<uint8_t> data = dump();
+    reader r{data};
+    skip_header(r);
+    std::vector<trace::event> recorded = events(r);
+    TEST_ASSERT_EQUAL_size_t(trace::EVENTS, recorded.size());
+    TEST_ASSERT_EQUAL_UINT16(name, recorded.front().name);
+    TEST_ASSERT_EQUAL_UINT16(last, recorded.back().name);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_dump_round_trip);
+    RUN_TEST(test_frozen_trace_records_nothing);
+    RUN_TEST(test_ring_keeps_the_newest_events);
+    return UNITY_END();
+}
@@ -0,0 +1,107 @@
+"""Checks tools/mavlink_dialect.py and measures the pruned dialect against
+its source.
+
+    python3 -m unittest discover -s test/tools
+"""
+
+import configparser
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import unittest
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..')
+TOOLS = os.path.join(ROOT, 'tools')
+sys.path.insert(0, TOOLS)
+
+import mavlink_dialect  # noqa: E402
+
+
+def configured_messages():
+    config = configparser.ConfigParser(inline_comment_prefixes=(';',))
+    config.read(os.path.join(ROOT, 'platformio.ini'))
+    return config['env:seeed_xiao_esp32s3']['custom_mavlink_messages'].split()
+
+
+class mavlink_dialect_test(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls.messages = set(configured_messages())
+        cls.source = mavlink_dialect.dialect(mavlink_dialect.MAVLINK, 'common')
+        cls.ids = cls.source.ids()
+        cls.entries = cls.source.entries()
+        cls.files = mavlink_dialect.render('lumina', cls.source, cls.messages, cls.ids, cls.entries)
+
+    def test_committed_dialect_is_up_to_date(self):
+        for name, text in self.files.items():
+            with open(os.path.join(mavlink_dialect.MAVLINK, 'lumina', name)) as f:
+                self.assertEqual(f.read(), text, f'include/mavlink/lumina/{name} is stale')
+
+    def test_tables_hold_only_the_listed_messages(self):
+        header = self.files['lumina.h']
+        table = mavlink_dialect.CRCS.search(header).group(1)
+        ids = [int(e[0]) for e in mavlink_dialect.ENTRY.findall(table)]
+        self.assertEqual(ids, sorted(self.ids[m] for m in self.messages))
+
+        names = mavlink_dialect.NAMES.search(header).group(1)
+        self.assertEqual({n for n, _ in mavlink_dialect.NAME.findall(names)}, self.messages)
+        for m in self.messages:
+            self.assertIn(f'mavlink_msg_{m.lower()}.h', header)
+        # Headers come from whichever dialect of the chain defines them.
+        self.assertEqual(header.count('/mavlink_msg_'), len(self.messages))
+        self.assertIn('#include "../minimal/mavlink_msg_heartbeat.h"', header)
+
+        # Enums of the whole chain are kept, so MAV_* constants still work.
+        self.assertIn('MAV_TYPE_QUADROTOR', header)
+        self.assertIn('MAV_AUTOPILOT_GENERIC', header)
+
+    def test_payload_size_follows_the_largest_message(self):
+        by_id = {e[0]: e for e in self.entries}
+        largest = max(by_id[self.ids[m]][3] for m in self.messages)
+        self.assertIn(f'MAVLINK_MAX_DIALECT_PAYLOAD_SIZE {largest}', self.files['version.h'])
+
+    def test_measurements(self):
+        full, pruned = len(self.entries), len(self.messages)
+        size = mavlink_dialect.ENTRY_SIZE
+        print(f'\n  CRC table   {pruned * size:>6} bytes instead of {full * size}'
+              f'\n  bisection   {mavlink_dialect.steps(pruned):>6} steps instead of {mavlink_dialect.steps(full)}')
+        self.assertLess(pruned, full)
+        self.assertEqual(mavlink_dialect.steps(1), 0)
+        self.assertEqual(mavlink_dialect.steps(11), 4)
+        self.assertEqual(mavlink_dialect.steps(223), 8)
+
+    def test_hash_is_stable_and_signed(self):
+        a = mavlink_dialect.xml_hash('HEARTBEAT:0:50')
+        self.assertEqual(a, mavlink_dialect.xml_hash('HEARTBEAT:0:50'))
+        self.assertNotEqual(a, mavlink_dialect.xml_hash('HEARTBEAT:0:51'))
+        self.assertTrue(-(1 << 63) <= a < 1 << 63)
+
+    def run_tool(self, *args):
+        return subprocess.run([sys.executable, os.path.join(TOOLS, 'mavlink_dialect.py'), *args],
+                              capture_output=True, text=True)
+
+    def test_unknown_message_is_rejected(self):
+        result = self.run_tool('HEARTBEAT', 'NOT_A_MESSAGE', '--mavlink', mavlink_dialect.MAVLINK, '--name', 'unused')
+        self.assertNotEqual(result.returncode, 0)
+        self.assertIn('NOT_A_MESSAGE', result.stderr)
+        self.assertFalse(os.path.exists(os.path.join(mavlink_dialect.MAVLINK, 'unused')))
+
+    def test_rewrites_only_changed_files(self):
+        # The generator writes next to its source dialect, so work on a copy.
+        with tempfile.TemporaryDirectory() as root:
+            for d in ('common', 'standard', 'minimal'):
+                shutil.copytree(os.path.join(mavlink_dialect.MAVLINK, d), os.path.join(root, d))
+
+            first = self.run_tool('HEARTBEAT', 'STATUSTEXT', '--mavlink', root, '--quiet')
+            self.assertEqual(first.returncode, 0, first.stderr)
+            self.assertIn('wrote', first.stdout)
+
+            second = self.run_tool('HEARTBEAT', 'STATUSTEXT', '--mavlink', root, '--quiet')
+            self.assertIn('up to date', second.stdout)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,150 @@
+"""Checks tools/placement.py against a linker map excerpt in the layout GNU ld
+writes for ESP-IDF builds.
+
+    python3 -m unittest discover -s test/tools
+"""
+
+import os
+import subprocess
+import sys
+import tempfile
+import unittest
+
+TOOLS = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'tools')
+sys.path.insert(0, TOOLS)
+
+import placement  # noqa: E402
+
+# Long input section names wrap their address and size onto the next line.
+MAP = '''\
+Archive member included to satisfy reference by file (symbol)
+
+esp-idf/main/libmain.a(main.cpp.obj)
+                              (app_main)
+
+Linker script and memory map
+
+.iram0.vectors  0x40374000      0x403
+ *(.exception_vectors.text)
+ .exception_vectors.text
+                0x40374000      0x403 esp-idf/xtensa/libxtensa.a(xtensa_vectors.S.obj)
+                0x40374000                _WindowOverflow4
+
+.iram0.text     0x40374404     0x1200
+ *(.iram1 .iram1.*)
+ .iram1.5       0x40374404       0x60 esp-idf/main/libmain.a(main.cpp.obj)
+                0x40374404                _ZN6lumina5dshot6encodeEtb
+ .iram1.6       0x40374464       0x20 esp-idf/main/libmain.a(main.cpp.obj)
+                0x40374464                esp_heap_trace_alloc_hook
+ .iram1.7       0x40374484       0x10 esp-idf/main/libmain.a(main.cpp.obj)
+                0x40374484                _ZN6lumina6memory16check_allocationEv
+
+.dram0.data     0x3fc88000      0x200
+ .dram1.2       0x3fc88000      0x100 esp-idf/main/libmain.a(main.cpp.obj)
+                0x3fc88000                _ZN6lumina4crsf6detail10CRC8_TABLEE
+ .data          0x3fc88100      0x100 esp-idf/main/libmain.a(main.cpp.obj)
+
+.flash.text     0x42000020     0x4000
+ .text._ZN6lumina3pid6updateEfff
+                0x42000020       0x80 esp-idf/main/libmain.a(main.cpp.obj)
+                0x42000020                _ZN6lumina3pid6updateEfff
+ .literal._ZN6lumina3pid6updateEfff
+                0x420000a0       0x10 esp-idf/main/libmain.a(main.cpp.obj)
+ .text.app_main
+                0x420000b0       0x30 esp-idf/main/libmain.a(main.cpp.obj)
+                0x420000b0                app_main
+ .text          0x420000e0       0x50 /toolchain/lib/libm.a(lib_a-sf_sin.o)
+                0x420000e0                sinf
+ .text.empty    0x42000130        0x0 esp-idf/main/libmain.a(main.cpp.obj)
+
+.flash.rodata   0x3c010020      0x400
+ .rodata.str1.1
+                0x3c010020       0x40 esp-idf/main/libmain.a(main.cpp.obj)
+
+.debug_info     0x00000000    0x10000
+ .debug_info    0x00000000      0x100 esp-idf/main/libmain.a(main.cpp.obj)
+'''
+
+
+def cxxfilt():
+    return placement.find_cxxfilt(None)
+
+
+class placement_test(unittest.TestCase):
+
+    def setUp(self):
+        self.sections = placement.parse(MAP.splitlines(True))
+
+    def test_parse_sections(self):
+        found = {(s.memory, s.name): s for s in self.sections}
+        self.assertEqual(found['IRAM', '.iram1.5'].size, 0x60)
+        self.assertEqual(found['IRAM', '.iram1.5'].symbols, ['_ZN6lumina5dshot6encodeEtb'])
+        self.assertEqual(found['DRAM', '.dram1.2'].size, 0x100)
+
+        # Wrapped lines carry the size and source on the next line.
+        wrapped = found['flash', '.text._ZN6lumina3pid6updateEfff']
+        self.assertEqual(wrapped.size, 0x80)
+        self.assertEqual(wrapped.source, 'esp-idf/main/libmain.a(main.cpp.obj)')
+        self.assertEqual(wrapped.kind(), 'code')
+        self.assertEqual(found['flash', '.rodata.str1.1'].kind(), 'data')
+
+        # Empty sections and sections outside MEMORY are left out.
+        self.assertNotIn(('flash', '.text.empty'), found)
+        self.assertFalse(any(s.name.startswith('.debug') for s in self.sections))
+        self.assertFalse(any(s.name.startswith('*') for s in self.sections))
+
+    def test_classify(self):
+        patterns = [placement.re.compile(p) for p in placement.HOT]
+        hot = placement.classify(self.sections, patterns, cxxfilt())
+        where = {}
+        for name, s in hot:
+            where.setdefault(s.memory, set()).add(s.name)
+
+        self.assertIn('.iram1.6', where['IRAM'])
+        self.assertIn('.iram1.7', where['IRAM'])
+        self.assertIn('.dram1.2', where['DRAM'])
+        self.assertIn('.text', where['flash'])          # sinf from libm
+        self.assertNotIn('.text.app_main', where['flash'])
+        if cxxfilt():
+            self.assertIn('.iram1.5', where['IRAM'])
+            self.assertIn('.text._ZN6lumina3pid6updateEfff', where['flash'])
+            self.assertIn('.literal._ZN6lumina3pid6updateEfff', where['flash'])
+
+    def run_tool(self, *args):
+        with tempfile.NamedTemporaryFile('w', suffix='.map', delete=False) as f:
+            f.write(MAP)
+        try:
+            return subprocess.run([sys.executable, os.path.join(TOOLS, 'placement.py'), f.name, *args],
+                                  capture_output=True, text=True)
+        finally:
+            os.unlink(f.name)
+
+    def test_check_budget(self):
+        # sinf alone is 0x50 bytes, pid::update 0x90 more once demangled.
+        left = 0x50 + (0x90 if cxxfilt() else 0)
+        result = self.run_tool('--check')
+        self.assertEqual(result.returncode, 1, result.stdout)
+        self.assertIn('Hot symbols in flash:', result.stdout)
+        self.assertIn(f'{left} bytes of hot symbols in flash', result.stderr)
+
+        self.assertEqual(self.run_tool('--check', '--budget', str(left)).returncode, 0)
+
+    def test_extra_pattern(self):
+        result = self.run_tool('--hot', r'^app_main$')
+        self.assertEqual(result.returncode, 0)
+        self.assertIn('app_main', result.stdout)
+
+    def test_map_without_sections(self):
+        with tempfile.NamedTemporaryFile('w', suffix='.map', delete=False) as f:
+            f.write('Linker script and memory map\n\n.debug_info 0x0 0x10\n')
+        try:
+            result = subprocess.run([sys.executable, os.path.join(TOOLS, 'placement.py'), f.name],
+                                    capture_output=True, text=True)
+        finally:
+            os.unlink(f.name)
+        self.assertNotEqual(result.returncode, 0)
+        self.assertIn('no sections', result.stderr)
+
+
+if __name__ == '__main__':
+    unittest.main()
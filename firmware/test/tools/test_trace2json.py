@@ -0,0 +1,108 @@
+"""Round trip of a trace dump, in the layout lumina::trace::dump() writes,
+through tools/trace2json.py.
+
+    python3 -m unittest discover -s test/tools
+"""
+
+import os
+import struct
+import sys
+import unittest
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'tools'))
+
+import trace2json  # noqa: E402
+
+CYCLES_PER_US = 240
+
+
+def strings(values):
+    data = struct.pack('<H', len(values))
+    for v in values:
+        data += struct.pack('<B', len(v)) + v.encode()
+    return data
+
+
+def dump(names, tasks, cores):
+    """`cores` is a list of (anchor cycles, anchor us, [(cycles, name, phase, task)])."""
+    data = b'LTRC' + struct.pack('<HBBI', 1, len(cores), 0, CYCLES_PER_US)
+    data += strings(names) + strings(tasks)
+    for anchor_cycles, anchor_us, events in cores:
+        data += struct.pack('<IqI', anchor_cycles, anchor_us, len(events))
+        for cycles, name, phase, task in events:
+            data += trace2json.EVENT.pack(cycles, name, phase.encode(), task)
+    return data
+
+
+def console(data, noise=b'I (1234) boot: ready\n'):
+    lines = [data[i:i + 32].hex() for i in range(0, len(data), 32)]
+    return noise + b'LTRC-BEGIN\n' + '\n'.join(lines).encode() + b'\nLTRC-END\n' + noise
+
+
+NAMES = ['control', 'deadline', 'telemetry']
+TASKS = ['ctrl', 'tlm']
+# Core 0 runs a control span with an instant in it, core 1 a telemetry span
+# whose cycle counter wraps in between. Both anchors are at 1 s.
+CORES = [
+    (10_000, 1_000_000, [(10_000 - 2400, 0, 'B', 0), (10_000 - 1200, 1, 'i', 0), (10_000 - 240, 0, 'E', 0)]),
+    (50, 1_000_000, [((50 - 480) & 0xFFFFFFFF, 2, 'B', 1), (0xFFFFFFFF - 100, 2, 'E', 1)]),
+]
+
+
+class trace2json_test(unittest.TestCase):
+
+    def test_binary_round_trip(self):
+        data = dump(NAMES, TASKS, CORES)
+        self.assertIs(trace2json.extract(data), data)
+
+        names, tasks, events = trace2json.parse(data)
+        self.assertEqual(names, NAMES)
+        self.assertEqual(tasks, TASKS)
+        self.assertEqual(len(events), 5)
+
+        core, time_us, name, phase, task = events[0]
+        self.assertEqual((core, name, phase, task), (0, 0, 'B', 0))
+        self.assertAlmostEqual(time_us, 1_000_000 - 10)
+
+        # Cycle counts from before the counter wrapped still come out earlier.
+        wrapped = [e for e in events if e[0] == 1]
+        self.assertAlmostEqual(wrapped[0][1], 1_000_000 - 2)
+        self.assertAlmostEqual(wrapped[1][1], 1_000_000 - 151 / CYCLES_PER_US)
+
+    def test_console_log_round_trip(self):
+        data = dump(NAMES, TASKS, CORES)
+        older = dump(NAMES[:1], TASKS[:1], [(0, 0, [])])
+        log = console(older) + console(data)
+        self.assertEqual(trace2json.extract(log), data)
+
+    def test_log_starting_with_the_begin_marker(self):
+        data = dump(NAMES, TASKS, CORES)
+        self.assertEqual(trace2json.extract(console(data, noise=b'')), data)
+
+    def test_truncated_log(self):
+        log = console(dump(NAMES, TASKS, CORES))
+        with self.assertRaises(SystemExit):
+            trace2json.extract(log[:log.index(b'LTRC-END')])
+
+    def test_convert(self):
+        names, tasks, events = trace2json.parse(dump(NAMES, TASKS, CORES))
+        # An end whose begin was overwritten by the ring is dropped.
+        events.append((0, events[0][1] - 1, 0, 'E', 0))
+        trace = trace2json.convert(names, tasks, events)['traceEvents']
+
+        metadata = [e for e in trace if e['ph'] == 'M']
+        self.assertIn({'name': 'thread_name', 'ph': 'M', 'pid': 1, 'tid': 1, 'args': {'name': 'tlm'}}, metadata)
+
+        timeline = [e for e in trace if e['ph'] != 'M']
+        self.assertEqual([(e['name'], e['ph']) for e in timeline], [
+            ('control', 'B'), ('deadline', 'i'), ('telemetry', 'B'), ('control', 'E'), ('telemetry', 'E'),
+        ])
+        # Times count from the earliest event, dropped ones included.
+        self.assertEqual(timeline[0]['ts'], 1)
+        self.assertEqual(timeline[1]['s'], 't')
+        self.assertEqual(timeline[3]['ts'], 10)
+        self.assertEqual(timeline[4]['ts'], round(11 - 151 / CYCLES_PER_US, 3))
+
+
+if __name__ == '__main__':
+    unittest.main()
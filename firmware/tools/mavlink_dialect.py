@@ -0,0 +1,246 @@
+#!/usr/bin/env python3
+"""Generates a MAVLink dialect that holds only the messages the firmware uses.
+
+The full common dialect defines 223 messages. Every translation unit that
+includes it parses all of their headers, and the parser's CRC table,
+which mavlink_get_msg_entry() bisects for every message sent or received,
+carries an entry for each of them. The pruned dialect keeps the enums of
+the source dialect and its bases, so MAV_* constants work as before, but
+includes only the listed messages and has only their CRC, info and name
+table entries. A message missing from the list does not compile.
+
+    tools/mavlink_dialect.py HEARTBEAT STATUSTEXT ...
+
+Files are only rewritten when their content changes, so running this before
+every build costs no recompilation. The report compares table sizes and
+bisection steps with the source dialect.
+"""
+
+import argparse
+import hashlib
+import math
+import os
+import re
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+MAVLINK = os.path.join(HERE, '..', 'include', 'mavlink')
+
+# sizeof(mavlink_msg_entry_t): uint32_t msgid and six uint8_t, padded.
+ENTRY_SIZE = 12
+
+CRCS = re.compile(r'^#define MAVLINK_MESSAGE_CRCS \{(.*)\}$', re.M)
+ENTRY = re.compile(r'\{(\d+), (\d+), (\d+), (\d+), (\d+), (\d+), (\d+)\}')
+NAMES = re.compile(r'^# define MAVLINK_MESSAGE_NAMES \{(.*)\}$', re.M)
+NAME = re.compile(r'\{ "(\w+)", (\d+) \}')
+BASE = re.compile(r'^#include "\.\./(\w+)/\1\.h"$', re.M)
+VERSION = re.compile(r'^#define MAVLINK_VERSION (\d+)$', re.M)
+ENUMS = re.compile(r'// ENUM DEFINITIONS\n(.*?)\n// MAVLINK VERSION', re.S)
+
+
+class dialect:
+
+    def __init__(self, root, name):
+        self.name = name
+        self.directory = os.path.join(root, name)
+        with open(os.path.join(self.directory, name + '.h')) as f:
+            self.text = f.read()
+
+        base = BASE.search(self.text)
+        self.base = dialect(root, base.group(1)) if base else None
+
+    def chain(self):
+        """This dialect followed by its bases."""
+        d = self
+        while d:
+            yield d
+            d = d.base
+
+    def entries(self):
+        match = CRCS.search(self.text)
+        return [tuple(int(v) for v in e) for e in ENTRY.findall(match.group(1))] if match else []
+
+    def ids(self):
+        match = NAMES.search(self.text)
+        return {n: int(i) for n, i in NAME.findall(match.group(1))} if match else {}
+
+    def enums(self):
+        match = ENUMS.search(self.text)
+        return match.group(1).strip('\n') if match else ''
+
+    def version(self):
+        match = VERSION.search(self.text)
+        return int(match.group(1)) if match else 2
+
+    def header(self, message):
+        """Path of a message's header relative to the generated dialect."""
+        file = f'mavlink_msg_{message.lower()}.h'
+        for d in self.chain():
+            if os.path.exists(os.path.join(d.directory, file)):
+                return f'../{d.name}/{file}'
+        return None
+
+
+def steps(n):
+    """Bisection steps of mavlink_get_msg_entry() over n entries."""
+    return math.ceil(math.log2(n)) if n > 1 else 0
+
+
+def xml_hash(text):
+    """Signed 64-bit hash like the ones mavgen derives from the XML."""
+    value = int.from_bytes(hashlib.sha256(text.encode()).digest()[:8], 'little')
+    return value - (1 << 64) if value >= 1 << 63 else value
+
+
+def render(name, source, messages, ids, entries):
+    guard = name.upper()
+    by_id = {e[0]: e for e in entries}
+    table = [by_id[ids[m]] for m in sorted(messages, key=lambda m: ids[m])]
+    dialect_hash = xml_hash(' '.join(f'{m}:{ids[m]}:{by_id[ids[m]][1]}' for m in sorted(messages)))
+    headers = [source.header(m) for m in sorted(messages)]
+
+    crcs = ', '.join('{' + ', '.join(str(v) for v in e) + '}' for e in table)
+    info = ', '.join(f'MAVLINK_MESSAGE_INFO_{m}' for m in sorted(messages, key=lambda m: ids[m]))
+    names = ', '.join(f'{{ "{m}", {ids[m]} }}' for m in sorted(messages))
+    enums = '\n\n'.join(d.enums() for d in source.chain() if d.enums())
+    includes = '\n'.join(f'#include "{h}"' for h in headers)
+    payload = max(e[3] for e in table)
+
+    dialect_h = f'''/** @file
+ *  @brief MAVLink comm protocol pruned from {source.name}.xml by tools/mavlink_dialect.py
+ *  @see http://mavlink.org
+ *
+ *  Generated, do not edit: change custom_mavlink_messages in platformio.ini.
+ *  Messages: {' '.join(sorted(messages))}
+ */
+#pragma once
+#ifndef MAVLINK_{guard}_H
+#define MAVLINK_{guard}_H
+
+#ifndef MAVLINK_H
+    #error Wrong include order: MAVLINK_{guard}.H MUST NOT BE DIRECTLY USED. Include mavlink.h from the same directory instead or set ALL AND EVERY defines from MAVLINK.H manually accordingly, including the #define MAVLINK_H call.
+#endif
+
+#define MAVLINK_{guard}_XML_HASH {dialect_hash}
+
+#ifdef __cplusplus
+extern "C" {{
+#endif
+
+// MESSAGE LENGTHS AND CRCS
+
+#ifndef MAVLINK_MESSAGE_LENGTHS
+#define MAVLINK_MESSAGE_LENGTHS {{}}
+#endif
+
+#ifndef MAVLINK_MESSAGE_CRCS
+#define MAVLINK_MESSAGE_CRCS {{{crcs}}}
+#endif
+
+#include "../protocol.h"
+
+#define MAVLINK_ENABLED_{guard}
+
+// ENUM DEFINITIONS
+
+{enums}
+
+// MAVLINK VERSION
+
+#ifndef MAVLINK_VERSION
+#define MAVLINK_VERSION {source.version()}
+#endif
+
+#if (MAVLINK_VERSION == 0)
+#undef MAVLINK_VERSION
+#define MAVLINK_VERSION {source.version()}
+#endif
+
+// MESSAGE DEFINITIONS
+{includes}
+
+
+#if MAVLINK_{guard}_XML_HASH == MAVLINK_PRIMARY_XML_HASH
+# define MAVLINK_MESSAGE_INFO {{{info}}}
+# define MAVLINK_MESSAGE_NAMES {{{names}}}
+# if MAVLINK_COMMAND_24BIT
+#  include "../mavlink_get_info.h"
+# endif
+#endif
+
+#ifdef __cplusplus
+}}
+#endif // __cplusplus
+#endif // MAVLINK_{guard}_H
+'''
+
+    with open(os.path.join(source.directory, 'mavlink.h')) as f:
+        mavlink_h = f.read()
+    mavlink_h = mavlink_h.replace(f'built from {source.name}.xml', f'pruned from {source.name}.xml')
+    mavlink_h = re.sub(r'MAVLINK_PRIMARY_XML_HASH -?\d+', f'MAVLINK_PRIMARY_XML_HASH {dialect_hash}', mavlink_h)
+    mavlink_h = mavlink_h.replace(f'#include "{source.name}.h"', f'#include "{name}.h"')
+
+    with open(os.path.join(source.directory, 'version.h')) as f:
+        version_h = f.read()
+    version_h = version_h.replace(f'built from {source.name}.xml', f'pruned from {source.name}.xml')
+    version_h = re.sub(r'MAVLINK_MAX_DIALECT_PAYLOAD_SIZE \d+', f'MAVLINK_MAX_DIALECT_PAYLOAD_SIZE {payload}', version_h)
+
+    return {'mavlink.h': mavlink_h, f'{name}.h': dialect_h, 'version.h': version_h}
+
+
+def write(directory, files):
+    """Writes `files` into `directory`; returns the names that changed."""
+    os.makedirs(directory, exist_ok=True)
+    changed = []
+    for name, text in files.items():
+        path = os.path.join(directory, name)
+        if os.path.exists(path):
+            with open(path) as f:
+                if f.read() == text:
+                    continue
+        with open(path, 'w', newline='\n') as f:
+            f.write(text)
+        changed.append(name)
+    return changed
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('messages', nargs='+', metavar='MESSAGE', help='message name, e.g. HEARTBEAT')
+    parser.add_argument('--source', default='common', help='dialect to prune, default common')
+    parser.add_argument('--name', default='lumina', help='name of the generated dialect, default lumina')
+    parser.add_argument('--mavlink', default=MAVLINK, help='directory of the generated C library')
+    parser.add_argument('--quiet', action='store_true', help='print only the summary line')
+    args = parser.parse_args()
+
+    source = dialect(args.mavlink, args.source)
+    ids = source.ids()
+    entries = source.entries()
+    crcs = {e[0] for e in entries}
+
+    messages = {m.upper() for m in args.messages}
+    unknown = sorted(m for m in messages if m not in ids or ids[m] not in crcs or not source.header(m))
+    if unknown:
+        sys.exit(f'{args.source} has no message {", ".join(unknown)}')
+
+    files = render(args.name, source, messages, ids, entries)
+    changed = write(os.path.join(args.mavlink, args.name), files)
+
+    full, pruned = len(entries), len(messages)
+    summary = (f'{args.name}: {pruned} of {full} {args.source} messages, CRC table {pruned * ENTRY_SIZE} instead of '
+               f'{full * ENTRY_SIZE} bytes, {steps(pruned)} instead of {steps(full)} bisection steps'
+               + (f', wrote {", ".join(changed)}' if changed else ', up to date'))
+    print(summary)
+    if args.quiet:
+        return 0
+
+    headers = sum(1 for f in os.listdir(source.directory) if f.startswith('mavlink_msg_') and f.endswith('.h'))
+    print(f'  headers included   {pruned:>6} instead of {headers}')
+    print(f'  info table entries {pruned:>6} instead of {full}')
+    for m in sorted(messages, key=lambda m: ids[m]):
+        print(f'  {ids[m]:>6}  {m}')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,20 @@
+"""PlatformIO pre-build hook that regenerates the pruned MAVLink dialect in
+include/mavlink/lumina from the messages listed in platformio.ini:
+
+    extra_scripts = pre:tools/pio_mavlink.py
+    custom_mavlink_messages =
+        HEARTBEAT
+        STATUSTEXT
+"""
+
+import os
+
+Import('env')  # noqa: F821 - provided by PlatformIO
+
+messages = env.GetProjectOption('custom_mavlink_messages', '').split()  # noqa: F821
+if not messages:
+    print('mavlink: custom_mavlink_messages is empty, keeping include/mavlink/lumina')
+else:
+    script = os.path.join(env.subst('$PROJECT_DIR'), 'tools', 'mavlink_dialect.py')  # noqa: F821
+    if env.Execute(f'"$PYTHONEXE" "{script}" --quiet {" ".join(messages)}'):  # noqa: F821
+        env.Exit(1)  # noqa: F821
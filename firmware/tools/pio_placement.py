@@ -0,0 +1,25 @@
+"""PlatformIO post-build hook that prints tools/placement.py's report for the
+linker map of every firmware build. Enabled in platformio.ini:
+
+    extra_scripts = post:tools/pio_placement.py
+"""
+
+import glob
+import os
+
+Import('env')  # noqa: F821 - provided by PlatformIO
+
+
+def report(source, target, env):
+    elf = target[0].get_abspath()
+    maps = [os.path.splitext(elf)[0] + '.map'] + sorted(glob.glob(os.path.join(env.subst('$BUILD_DIR'), '*.map')))
+    found = [m for m in maps if os.path.exists(m)]
+    if not found:
+        print('placement: no linker map next to', elf)
+        return
+
+    script = os.path.join(env.subst('$PROJECT_DIR'), 'tools', 'placement.py')
+    env.Execute(env.VerboseAction(f'"$PYTHONEXE" "{script}" "{found[0]}"', 'Checking hot path placement'))
+
+
+env.AddPostAction('$BUILD_DIR/${PROGNAME}.elf', report)  # noqa: F821
@@ -0,0 +1,207 @@
+#!/usr/bin/env python3
+"""Reports where the real-time path ended up in an ESP-IDF linker map.
+
+Hot symbols are the functions and tables that include/placement.hpp and
+src/placement.lf mean to keep out of flash, matched by the patterns in HOT
+against demangled names. The report totals them per memory and lists every
+one that still sits in flash, largest first, e.g. a template instance that
+lost its attribute or a libm object the fragment no longer matches.
+
+    tools/placement.py .pio/build/seeed_xiao_esp32s3/firmware.map
+    tools/placement.py firmware.map --check
+
+With --check the exit status is 1 if more than --budget bytes of hot code
+and data are left in flash.
+"""
+
+import argparse
+import re
+import shutil
+import subprocess
+import sys
+
+# Output sections of the ESP32-S3 linker script by memory.
+MEMORY = {
+    '.iram0.vectors': 'IRAM',
+    '.iram0.text': 'IRAM',
+    '.dram0.data': 'DRAM',
+    '.dram0.bss': 'DRAM',
+    '.flash.text': 'flash',
+    '.flash.rodata': 'flash',
+}
+
+HOT = [
+    r'\bcontrol_task\b',
+    r'\blumina::crsf::(crc8|unpack|parser::(feed|_parse|_drop)|receiver::_run)\b',
+    r'\blumina::crsf::detail::CRC8_TABLE\b',
+    r'\blumina::dshot::',
+    r'\blumina::esc(_group<\w+>)?::(throttle|write)\b',
+    r'\blumina::imu::(driver<.*>::_run|fifo::\w+::parse|clock::update)\b',
+    r'\blumina::spi_device::(read|_transfer)\b',
+    r'\blumina::(biquad|pt1|ptn|filter_bank<.*>)::(operator\(\)|_step|process)',
+    r'\blumina::(rpm_filter<\w+>|dynamic_notch<.*>)::(operator\(\)|update)',
+    r'\blumina::(mahony|madgwick)::update\b',
+    r'\blumina::ekf<.*>::(update|_advance|_integrate|_predict)\b',
+    r'\blumina::(pid|rate_controller|angle_controller)::update\b',
+    r'\blumina::(tpa|thrust_curve)::operator\(\)',
+    r'\blumina::(mixer<\w+>::mix|thrust_stage<\w+>::apply)\b',
+    r'\blumina::(ring<.*>::(push|pop)|seqlock<.*>::(write|read|sequence)|topic<.*>::(publish|read|sequence))\b',
+    r'\blumina::subscriber<.*>::update\b',
+    r'\blumina::(trace::record|profile::probe::record)\b',
+    r'\b(esp_heap_trace_alloc_hook|lumina::memory::(check_allocation|current_task))\b',
+    r'^(sinf|cosf|atanf|atan2f|asinf|acosf|sqrtf|__ieee754_\w+f|__kernel_\w+f)$',
+]
+
+# Input sections named after the symbol they hold, as -ffunction-sections
+# and -fdata-sections emit them.
+NAMED = re.compile(r'^\.(?:text|literal|rodata|data|bss|sbss|sdata)\.(.+)$')
+
+OUTPUT = re.compile(r'^(\.\S+)(?:\s+0x[0-9a-f]+\s+0x[0-9a-f]+)?')
+INPUT = re.compile(r'^ (\.\S+)(?:\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*))?$')
+PLACED = re.compile(r'^\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*)$')
+SYMBOL = re.compile(r'^\s+0x([0-9a-f]+)\s+(\S.*)$')
+
+
+class section:
+
+    def __init__(self, memory, name):
+        self.memory = memory
+        self.name = name
+        self.size = 0
+        self.source = ''
+        self.symbols = []
+
+    def kind(self):
+        code = self.name.startswith(('.text', '.literal', '.iram1'))
+        return 'code' if code else 'data'
+
+
+def parse(lines):
+    """Returns the input sections placed in the memories of MEMORY."""
+    sections = []
+    memory = None
+    current = None
+    started = False
+
+    for line in lines:
+        line = line.rstrip('\n')
+        if not started:
+            started = line.startswith('Linker script and memory map')
+            continue
+
+        if line.startswith('.'):
+            match = OUTPUT.match(line)
+            memory = MEMORY.get(match.group(1)) if match else None
+            current = None
+            continue
+        if memory is None:
+            continue
+
+        match = INPUT.match(line)
+        if match:
+            current = section(memory, match.group(1))
+            if match.group(2):
+                current.size = int(match.group(3), 16)
+                current.source = match.group(4)
+            sections.append(current)
+            continue
+        if current is None:
+            continue
+
+        match = PLACED.match(line)
+        if match and not current.size and not current.source:
+            current.size = int(match.group(2), 16)
+            current.source = match.group(3)
+            continue
+
+        match = SYMBOL.match(line)
+        if match and not match.group(2).startswith(('0x', '*', '.')):
+            current.symbols.append(match.group(2).strip())
+
+    return [s for s in sections if s.size]
+
+
+def demangle(names, tool):
+    """Maps mangled names to demangled ones; unchanged without a c++filt."""
+    if not tool or not names:
+        return {name: name for name in names}
+    result = subprocess.run([tool], input='\n'.join(names), capture_output=True, text=True, check=True)
+    return dict(zip(names, result.stdout.splitlines()))
+
+
+def find_cxxfilt(requested):
+    for tool in ([requested] if requested else ['xtensa-esp32s3-elf-c++filt', 'xtensa-esp-elf-c++filt', 'c++filt']):
+        if shutil.which(tool):
+            return tool
+    return None
+
+
+def classify(sections, patterns, cxxfilt):
+    """Returns (name, section) for every hot section."""
+    # IRAM and DRAM sections are named .iram1.N and .dram1.N, so those are
+    # only known by the symbols they define.
+    mangled = {m.group(1) for s in sections for m in [NAMED.match(s.name)] if m}
+    mangled |= {name for s in sections for name in s.symbols}
+    names = demangle(sorted(mangled), cxxfilt)
+
+    hot = []
+    for s in sections:
+        # Prefer the section's own name so that a function's text and
+        # literals add up under one entry.
+        match = NAMED.match(s.name)
+        candidates = [names.get(match.group(1), match.group(1))] if match else []
+        candidates += [names.get(name, name) for name in s.symbols]
+        for name in candidates:
+            if any(p.search(name) for p in patterns):
+                hot.append((name, s))
+                break
+    return hot
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('map', help='linker map of the firmware ELF')
+    parser.add_argument('--hot', action='append', default=[], metavar='REGEX', help='additional hot symbol pattern')
+    parser.add_argument('--cxxfilt', help='demangler, found on PATH by default')
+    parser.add_argument('--check', action='store_true', help='fail if hot symbols are left in flash')
+    parser.add_argument('--budget', type=int, default=0, help='bytes of hot symbols allowed in flash with --check')
+    args = parser.parse_args()
+
+    with open(args.map, errors='replace') as f:
+        sections = parse(f)
+    if not sections:
+        sys.exit(f'{args.map}: no sections of {", ".join(MEMORY)} found')
+
+    patterns = [re.compile(p) for p in HOT + args.hot]
+    hot = classify(sections, patterns, find_cxxfilt(args.cxxfilt))
+
+    print(f'Hot path placement in {args.map}')
+    for memory in ('IRAM', 'DRAM', 'flash'):
+        placed = [s for _, s in hot if s.memory == memory]
+        total = sum(s.size for s in placed)
+        used = sum(s.size for s in sections if s.memory == memory)
+        print(f'  {memory:<6}{total:>9} bytes in {len(placed):>4} sections   ({used} bytes used in total)')
+
+    left = {}
+    for name, s in hot:
+        if s.memory == 'flash':
+            key = (name, s.kind())
+            left[key] = left.get(key, 0) + s.size
+
+    if not left:
+        print('No hot symbols in flash.')
+        return 0
+
+    print('Hot symbols in flash:')
+    for (name, kind), size in sorted(left.items(), key=lambda item: -item[1]):
+        print(f'  {size:>7}  {kind}  {name}')
+
+    flash = sum(left.values())
+    if args.check and flash > args.budget:
+        print(f'{flash} bytes of hot symbols in flash, budget is {args.budget}', file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+"""Converts a lumina trace dump to Chrome Trace Event JSON.
+
+The input is either the raw binary written by lumina::trace::dump() or a
+console log containing the hex dump printed by lumina::trace::print(), in
+which case the last LTRC-BEGIN/LTRC-END block is used. Open the output in
+chrome://tracing or https://ui.perfetto.dev.
+
+    tools/trace2json.py monitor.log -o trace.json
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+EVENT = struct.Struct('<IHcB')
+MAGIC = b'LTRC\x01\x00'  # "LTRC" and u16 version 1
+
+
+def extract(data):
+    # A console log may start with the "LTRC-BEGIN" line itself.
+    if data[:len(MAGIC)] == MAGIC:
+        return data
+
+    lines = data.decode('utf-8', 'replace').splitlines()
+    begins = [i for i, line in enumerate(lines) if line.strip().endswith('LTRC-BEGIN')]
+    if not begins:
+        sys.exit('no trace dump found')
+
+    hex_lines = []
+    for line in lines[begins[-1] + 1:]:
+        line = line.strip()
+        if line.endswith('LTRC-END'):
+            return bytes.fromhex(''.join(hex_lines))
+        hex_lines.append(line)
+    sys.exit('trace dump is truncated')
+
+
+class reader:
+
+    def __init__(self, data):
+        self.data = data
+        self.offset = 0
+
+    def take(self, fmt):
+        values = struct.unpack_from(fmt, self.data, self.offset)
+        self.offset += struct.calcsize(fmt)
+        return values if len(values) > 1 else values[0]
+
+    def strings(self):
+        result = []
+        for _ in range(self.take('<H')):
+            length = self.take('<B')
+            result.append(self.data[self.offset:self.offset + length].decode('utf-8', 'replace'))
+            self.offset += length
+        return result
+
+
+def parse(data):
+    """Returns (names, tasks, events) with events as (core, time_us, name, phase, task)."""
+    r = reader(data)
+    magic, version, cores, _, cycles_per_us = r.take('<4sHBBI')
+    if magic != b'LTRC' or version != 1:
+        sys.exit('not a version 1 trace')
+
+    names = r.strings()
+    tasks = r.strings()
+
+    events = []
+    for core in range(cores):
+        anchor_cycles, anchor_us, count = r.take('<IqI')
+        for _ in range(count):
+            cycles, name, phase, task = EVENT.unpack_from(data, r.offset)
+            r.offset += EVENT.size
+            age = (anchor_cycles - cycles) & 0xFFFFFFFF
+            events.append((core, anchor_us - age / cycles_per_us, name, phase.decode(), task))
+
+    return names, tasks, events
+
+
+def convert(names, tasks, events):
+    trace = []
+    cores = sorted({e[0] for e in events})
+    for core in cores:
+        trace.append({'name': 'process_name', 'ph': 'M', 'pid': core, 'args': {'name': f'core {core}'}})
+        for task in sorted({e[4] for e in events if e[0] == core}):
+            label = tasks[task] if task < len(tasks) else f'task {task}'
+            trace.append({'name': 'thread_name', 'ph': 'M', 'pid': core, 'tid': task, 'args': {'name': label}})
+
+    # The rings overwrite their oldest events, so a dump can open with the
+    # ends of spans whose beginnings are gone; drop those.
+    depth = {}
+    start = min((e[1] for e in events), default=0)
+    for core, time_us, name, phase, task in sorted(events, key=lambda e: e[1]):
+        if phase == 'B':
+            depth[core, task] = depth.get((core, task), 0) + 1
+        elif phase == 'E':
+            if not depth.get((core, task)):
+                continue
+            depth[core, task] -= 1
+
+        event = {
+            'name': names[name] if name < len(names) else f'#{name}',
+            'ph': phase,
+            'ts': round(time_us - start, 3),
+            'pid': core,
+            'tid': task,
+        }
+        if phase == 'i':
+            event['s'] = 't'
+        trace.append(event)
+
+    return {'traceEvents': trace, 'displayTimeUnit': 'ns'}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('input', help='binary dump or console log')
+    parser.add_argument('-o', '--output', help='JSON file, stdout by default')
+    args = parser.parse_args()
+
+    with open(args.input, 'rb') as f:
+        names, tasks, events = parse(extract(f.read()))
+
+    result = json.dumps(convert(names, tasks, events))
+    if args.output:
+        with open(args.output, 'w') as f:
+            f.write(result)
+    else:
+        print(result)
+
+
+if __name__ == '__main__':
+    main()